@@ -0,0 +1,400 @@
+/**
+ * @file alloc_trace.c the event ring, the per-site table, the console
+ * output and, with ALLOC_TRACE_WRAP, the heap wraps
+ *
+ * Writers claim a slot by moving head forward with a compare-and-swap,
+ * fill it and then publish it by storing its sequence number (the claimed
+ * head + 1) with release ordering. The one reader takes slots in order and
+ * stops at the first one not yet published, so a writer preempted halfway
+ * holds up the drain but never hands it half an event.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE // dl_iterate_phdr()
+#endif
+
+#include "alloc_trace.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __XTENSA__
+#include "esp_cpu.h"
+#include "esp_debug_helpers.h"
+#endif
+
+#ifdef __linux__
+#include <link.h>
+#endif
+
+_Static_assert((ALLOC_TRACE_RING_LEN & (ALLOC_TRACE_RING_LEN - 1)) == 0,
+               "ALLOC_TRACE_RING_LEN must be a power of two");
+_Static_assert((ALLOC_TRACE_MAX_LIVE & (ALLOC_TRACE_MAX_LIVE - 1)) == 0,
+               "ALLOC_TRACE_MAX_LIVE must be a power of two");
+
+#define MAX_WALK 16 // frames searched for the call site
+
+typedef struct {
+  uint32_t seq; // head + 1 once the event is complete
+  alloc_trace_event_t event;
+} slot_t;
+
+static slot_t s_ring[ALLOC_TRACE_RING_LEN];
+static uint32_t s_head; // claimed by writers
+static uint32_t s_tail; // the reader's
+static uint32_t s_dropped;
+static uint32_t s_active;
+
+// console output, the drain task's
+static bool s_announced;
+static uint32_t s_reported_drops;
+static uint32_t s_period_ms;
+
+bool alloc_trace_enabled(void) {
+#if ALLOC_TRACE_WRAP
+  return true;
+#else
+  return false;
+#endif
+}
+
+void alloc_trace_start(void) {
+  s_announced = false;
+  __atomic_store_n(&s_active, 1, __ATOMIC_RELEASE);
+}
+
+void alloc_trace_stop(void) {
+  __atomic_store_n(&s_active, 0, __ATOMIC_RELEASE);
+}
+
+bool alloc_trace_active(void) {
+  return __atomic_load_n(&s_active, __ATOMIC_ACQUIRE);
+}
+
+// -------- Recording --------
+
+// A return address as a PC inside the call instruction, so addr2line
+// names the line of the call rather than the one after it
+static uintptr_t call_pc(void *ra) {
+#ifdef __XTENSA__
+  return esp_cpu_process_stack_pc((uint32_t)ra); // window bits off, -3
+#else
+  return (uintptr_t)ra - 1;
+#endif
+}
+
+// The callers above the call site: walk up to it, then keep going
+static int walk_stack(uintptr_t site, uintptr_t *stack, int max) {
+#ifdef __XTENSA__
+  esp_backtrace_frame_t frame;
+  bool found = false;
+  int depth = 0;
+
+  esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+  for (int i = 0; i < MAX_WALK && depth < max && frame.next_pc; i++) {
+    if (!esp_backtrace_get_next_frame(&frame))
+      break;
+    uintptr_t pc = esp_cpu_process_stack_pc(frame.pc);
+    if (found)
+      stack[depth++] = pc;
+    else if (pc == site)
+      found = true;
+  }
+  return depth;
+#else
+  return 0; // no frame chain to follow without frame pointers
+#endif
+}
+
+void alloc_trace_record(alloc_trace_kind_t kind, const void *ptr, size_t size,
+                        void *ra) {
+  if (!__atomic_load_n(&s_active, __ATOMIC_RELAXED))
+    return;
+
+  uint32_t head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+  do {
+    if (head - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE) >=
+        ALLOC_TRACE_RING_LEN) {
+      __atomic_add_fetch(&s_dropped, 1, __ATOMIC_RELAXED);
+      return;
+    }
+  } while (!__atomic_compare_exchange_n(&s_head, &head, head + 1, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+  slot_t *slot = &s_ring[head & (ALLOC_TRACE_RING_LEN - 1)];
+  alloc_trace_event_t *e = &slot->event;
+  e->time_us = (uint32_t)esp_timer_get_time();
+  e->kind = kind;
+  e->ptr = (uintptr_t)ptr;
+  e->size = (uint32_t)size;
+  e->stack[0] = call_pc(ra);
+  e->depth = 1 + walk_stack(e->stack[0], e->stack + 1, ALLOC_TRACE_DEPTH - 1);
+  __atomic_store_n(&slot->seq, head + 1, __ATOMIC_RELEASE);
+}
+
+int alloc_trace_drain(alloc_trace_sink_t sink, void *ctx, int max) {
+  uint32_t tail = s_tail;
+  int n = 0;
+
+  while (n < max) {
+    slot_t *slot = &s_ring[tail & (ALLOC_TRACE_RING_LEN - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1)
+      break; // empty, or still being written
+    alloc_trace_event_t e = slot->event;
+    // the slot is free for writers once tail moves past it
+    __atomic_store_n(&s_tail, ++tail, __ATOMIC_RELEASE);
+    sink(&e, ctx);
+    n++;
+  }
+  return n;
+}
+
+uint32_t alloc_trace_dropped(void) {
+  return __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+}
+
+void alloc_trace_reset(void) {
+  memset(s_ring, 0, sizeof(s_ring));
+  s_head = s_tail = 0;
+  s_dropped = s_reported_drops = 0;
+}
+
+// -------- Per-site table --------
+
+void alloc_trace_table_reset(alloc_trace_table_t *table) {
+  memset(table, 0, sizeof(*table));
+}
+
+static uint32_t block_hash(uintptr_t ptr) {
+  return ((uint32_t)(ptr >> 3) * 2654435761u) & (ALLOC_TRACE_MAX_LIVE - 1);
+}
+
+static int find_block(const alloc_trace_table_t *table, uintptr_t ptr) {
+  for (uint32_t i = block_hash(ptr), n = 0; n < ALLOC_TRACE_MAX_LIVE;
+       i = (i + 1) & (ALLOC_TRACE_MAX_LIVE - 1), n++) {
+    if (table->live[i].ptr == ptr)
+      return (int)i;
+    if (table->live[i].ptr == 0)
+      return -1;
+  }
+  return -1;
+}
+
+// Empty slot i, moving later entries of its probe run back so lookups
+// never stop at a hole in the middle of a run
+static void remove_block(alloc_trace_table_t *table, uint32_t i) {
+  const uint32_t mask = ALLOC_TRACE_MAX_LIVE - 1;
+
+  for (uint32_t j = (i + 1) & mask; table->live[j].ptr; j = (j + 1) & mask) {
+    uint32_t home = block_hash(table->live[j].ptr);
+    // j may fill i unless its home lies cyclically in (i, j]
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      table->live[i] = table->live[j];
+      i = j;
+    }
+  }
+  table->live[i].ptr = 0;
+}
+
+static int site_index(alloc_trace_table_t *table, uintptr_t site) {
+  for (int i = 0; i < table->num_sites; i++)
+    if (table->sites[i].site == site)
+      return i;
+  if (table->num_sites == ALLOC_TRACE_MAX_SITES)
+    return -1;
+  table->sites[table->num_sites].site = site;
+  return table->num_sites++;
+}
+
+void alloc_trace_table_add(const alloc_trace_event_t *event, void *ctx) {
+  alloc_trace_table_t *table = ctx;
+
+  if (event->kind == ALLOC_TRACE_FREE) {
+    int b = find_block(table, event->ptr);
+    if (b < 0) {
+      table->unknown_frees++;
+      return;
+    }
+    alloc_trace_site_t *s = &table->sites[table->live[b].site];
+    s->frees++;
+    s->live_blocks--;
+    s->live_bytes -= table->live[b].size;
+    remove_block(table, (uint32_t)b);
+    return;
+  }
+
+  int site = site_index(table, event->stack[0]);
+  uint32_t i = block_hash(event->ptr);
+  for (int n = 0; table->live[i].ptr && n < ALLOC_TRACE_MAX_LIVE; n++)
+    i = (i + 1) & (ALLOC_TRACE_MAX_LIVE - 1);
+  if (site < 0 || table->live[i].ptr) {
+    table->overflows++;
+    return;
+  }
+
+  table->live[i] = (alloc_trace_block_t){
+      .ptr = event->ptr, .size = event->size, .site = (uint16_t)site};
+  alloc_trace_site_t *s = &table->sites[site];
+  s->allocs++;
+  s->live_blocks++;
+  s->live_bytes += event->size;
+  s->total_bytes += event->size;
+  if (s->live_bytes > s->peak_bytes)
+    s->peak_bytes = s->live_bytes;
+}
+
+const alloc_trace_site_t *alloc_trace_table_site(const alloc_trace_table_t *table,
+                                                 uintptr_t site) {
+  for (int i = 0; i < table->num_sites; i++)
+    if (table->sites[i].site == site)
+      return &table->sites[i];
+  return NULL;
+}
+
+size_t alloc_trace_table_live_bytes(const alloc_trace_table_t *table) {
+  size_t bytes = 0;
+  for (int i = 0; i < table->num_sites; i++)
+    bytes += table->sites[i].live_bytes;
+  return bytes;
+}
+
+// -------- Console output --------
+
+#ifdef __linux__
+// The first object is the executable; its bias is 0 unless it is PIE
+static int first_object(struct dl_phdr_info *info, size_t size, void *out) {
+  *(uintptr_t *)out = info->dlpi_addr;
+  return 1;
+}
+#endif
+
+static uintptr_t load_address(void) {
+  uintptr_t base = 0;
+#ifdef __linux__
+  dl_iterate_phdr(first_object, &base);
+#endif
+  return base;
+}
+
+static void print_event(const alloc_trace_event_t *e, void *ctx) {
+  printf(ALLOC_TRACE_PREFIX ",%c,%u,%lx,%u,%lx", e->kind, (unsigned)e->time_us,
+         (unsigned long)e->ptr, (unsigned)e->size, (unsigned long)e->stack[0]);
+  for (int i = 1; i < e->depth; i++)
+    printf(":%lx", (unsigned long)e->stack[i]);
+  putchar('\n');
+}
+
+void alloc_trace_flush(void) {
+  // one block of lines even with other tasks printing
+  flockfile(stdout);
+  if (!s_announced) {
+    s_announced = true;
+    printf(ALLOC_TRACE_PREFIX ",start,%lx\n", (unsigned long)load_address());
+  }
+  while (alloc_trace_drain(print_event, NULL, ALLOC_TRACE_RING_LEN) > 0) {
+  }
+  uint32_t dropped = alloc_trace_dropped();
+  if (dropped != s_reported_drops) {
+    printf(ALLOC_TRACE_PREFIX ",dropped,%u\n",
+           (unsigned)(dropped - s_reported_drops));
+    s_reported_drops = dropped;
+  }
+  funlockfile(stdout);
+  fflush(stdout);
+}
+
+static void alloc_trace_task(void *arg) {
+  while (1) {
+    alloc_trace_flush();
+    vTaskDelay(pdMS_TO_TICKS(s_period_ms));
+  }
+}
+
+void alloc_trace_task_create(uint32_t period_ms, UBaseType_t priority) {
+  s_period_ms = period_ms;
+  xTaskCreate(alloc_trace_task, "alloc_trace", 2560, NULL, priority, NULL);
+}
+
+// -------- Heap wraps --------
+
+#if ALLOC_TRACE_WRAP
+#include "esp_heap_caps.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_heap_caps_malloc(size_t size, uint32_t caps);
+void *__real_heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void *__real_heap_caps_realloc(void *ptr, size_t size, uint32_t caps);
+void __real_heap_caps_free(void *ptr);
+
+// A realloc is the old block freed and the new one allocated, unless it
+// failed and the old block is still there
+static void record_realloc(void *old, void *ptr, size_t size, void *ra) {
+  if (!ptr && size)
+    return;
+  if (old)
+    alloc_trace_record(ALLOC_TRACE_FREE, old, 0, ra);
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, size, ra);
+}
+
+void *__wrap_malloc(size_t size) {
+  void *ptr = __real_malloc(size);
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, size,
+                       __builtin_return_address(0));
+  return ptr;
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+  void *ptr = __real_calloc(n, size);
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, n * size,
+                       __builtin_return_address(0));
+  return ptr;
+}
+
+void *__wrap_realloc(void *old, size_t size) {
+  void *ptr = __real_realloc(old, size);
+  record_realloc(old, ptr, size, __builtin_return_address(0));
+  return ptr;
+}
+
+// free() is heap_caps_free() in IDF's newlib glue; calling the latter
+// directly keeps one free from being recorded twice
+void __wrap_free(void *ptr) {
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_FREE, ptr, 0, __builtin_return_address(0));
+  __real_heap_caps_free(ptr);
+}
+
+void *__wrap_heap_caps_malloc(size_t size, uint32_t caps) {
+  void *ptr = __real_heap_caps_malloc(size, caps);
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, size,
+                       __builtin_return_address(0));
+  return ptr;
+}
+
+void *__wrap_heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+  void *ptr = __real_heap_caps_calloc(n, size, caps);
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, n * size,
+                       __builtin_return_address(0));
+  return ptr;
+}
+
+void *__wrap_heap_caps_realloc(void *old, size_t size, uint32_t caps) {
+  void *ptr = __real_heap_caps_realloc(old, size, caps);
+  record_realloc(old, ptr, size, __builtin_return_address(0));
+  return ptr;
+}
+
+void __wrap_heap_caps_free(void *ptr) {
+  if (ptr)
+    alloc_trace_record(ALLOC_TRACE_FREE, ptr, 0, __builtin_return_address(0));
+  __real_heap_caps_free(ptr);
+}
+#endif // ALLOC_TRACE_WRAP
@@ -0,0 +1,130 @@
+/**
+ * @file alloc_trace.h per-call-site heap tracing into a lock-free ring
+ *
+ * With ALLOC_TRACE enabled in the project, the linker routes malloc,
+ * calloc, realloc, free and their heap_caps_* forms through this component
+ * (--wrap). While alloc_trace_start() is in effect every call adds an event
+ * to a fixed ring: alloc or free, the block, its size, the time and the
+ * call site. On Xtensa the next ALLOC_TRACE_DEPTH - 1 return addresses
+ * follow the call site; elsewhere the call site is the whole stack.
+ *
+ * Any task may record; claiming a slot is one compare-and-swap, with no
+ * lock and no allocation. A full ring drops the event and counts it. One
+ * task drains the ring, either into an alloc_trace_table_t that matches
+ * frees to their allocations and keeps live bytes per call site, or as
+ * text lines for tools/alloc_trace_report.py, which symbolizes the
+ * addresses against the ELF and prints per-site tables and folded stacks
+ * for flamegraph.pl.
+ *
+ * On the linux target there is no heap_caps_*; host_test records from its
+ * own malloc wraps through alloc_trace_record().
+ */
+
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ALLOC_TRACE_RING_LEN
+#define ALLOC_TRACE_RING_LEN 128 // events, a power of two
+#endif
+#define ALLOC_TRACE_DEPTH 4       // return addresses per event
+#define ALLOC_TRACE_MAX_SITES 32  // call sites per table
+#define ALLOC_TRACE_MAX_LIVE 256  // blocks a table can match to a free
+#define ALLOC_TRACE_PREFIX "alloc_trace" // start of every printed line
+
+typedef enum {
+  ALLOC_TRACE_ALLOC = 'a',
+  ALLOC_TRACE_FREE = 'f',
+} alloc_trace_kind_t;
+
+typedef struct {
+  uint32_t time_us; // low 32 bits of esp_timer_get_time()
+  uint8_t kind;     // alloc_trace_kind_t
+  uint8_t depth;    // valid entries in stack, at least 1
+  uintptr_t ptr;
+  uint32_t size;                       // 0 for a free
+  uintptr_t stack[ALLOC_TRACE_DEPTH]; // stack[0] is the call site
+} alloc_trace_event_t;
+
+typedef struct {
+  uintptr_t site; // call site, stack[0] of its events
+  uint32_t allocs;
+  uint32_t frees;
+  uint32_t live_blocks;
+  size_t live_bytes;
+  size_t peak_bytes; // highest live_bytes
+  size_t total_bytes; // everything allocated here
+} alloc_trace_site_t;
+
+typedef struct {
+  uintptr_t ptr; // 0: empty
+  uint32_t size;
+  uint16_t site; // index into sites
+} alloc_trace_block_t;
+
+typedef struct {
+  alloc_trace_site_t sites[ALLOC_TRACE_MAX_SITES];
+  int num_sites;
+  alloc_trace_block_t live[ALLOC_TRACE_MAX_LIVE]; // open addressing on ptr
+  uint32_t unknown_frees; // blocks allocated before the trace started
+  uint32_t overflows;     // events that found the sites or blocks full
+} alloc_trace_table_t;
+
+// Called by alloc_trace_drain() for every event, in order
+typedef void (*alloc_trace_sink_t)(const alloc_trace_event_t *event,
+                                   void *ctx);
+
+// True when the heap calls are wrapped (ALLOC_TRACE set for the build)
+bool alloc_trace_enabled(void);
+
+// Record from now on / stop recording. Starting again keeps what is queued.
+void alloc_trace_start(void);
+void alloc_trace_stop(void);
+bool alloc_trace_active(void);
+
+// The wraps' entry point: ra is __builtin_return_address(0) of the heap
+// call. Does nothing while the trace is stopped.
+void alloc_trace_record(alloc_trace_kind_t kind, const void *ptr, size_t size,
+                        void *ra);
+
+// Hand up to max queued events to sink, oldest first. Returns how many.
+// Stops early at an event whose writer has not finished it yet.
+int alloc_trace_drain(alloc_trace_sink_t sink, void *ctx, int max);
+
+// Events that found the ring full since the last reset
+uint32_t alloc_trace_dropped(void);
+
+// Empty the ring and clear the drop count (host tests)
+void alloc_trace_reset(void);
+
+// -------- Per-site table --------
+
+void alloc_trace_table_reset(alloc_trace_table_t *table);
+
+// An alloc_trace_sink_t: ctx is the table
+void alloc_trace_table_add(const alloc_trace_event_t *event, void *table);
+
+// The site with this call site address, or NULL
+const alloc_trace_site_t *alloc_trace_table_site(const alloc_trace_table_t *table,
+                                                 uintptr_t site);
+
+// Sum over all sites
+size_t alloc_trace_table_live_bytes(const alloc_trace_table_t *table);
+
+// -------- Console output --------
+
+// Print every queued event as one line for tools/alloc_trace_report.py:
+//   alloc_trace,<a|f>,<time_us>,<ptr hex>,<size>,<pc hex>[:<pc hex>...]
+// After a start the first call also prints alloc_trace,start,<load address
+// hex> (non-zero only for a position-independent host binary), and drops
+// show up as alloc_trace,dropped,<count>.
+void alloc_trace_flush(void);
+
+// Drain task: alloc_trace_flush() every period_ms
+void alloc_trace_task_create(uint32_t period_ms, UBaseType_t priority);
+
+#endif // ALLOC_TRACE_H
@@ -0,0 +1,193 @@
+"""
+Per-call-site heap report from an alloc_trace console capture.
+
+alloc_trace_flush() writes one "alloc_trace,..." line per malloc or free,
+mixed with any other output:
+    python alloc_trace_report.py capture.log --elf build/app.elf
+The events are replayed in order: every free is matched to the allocation
+of the same block, and the table lists each call site with the bytes it
+still holds, its peak and how often it allocated, largest holder first.
+Frees of blocks allocated before the trace started are counted apart.
+
+Addresses are turned into "function file:line" with addr2line against the
+ELF (--addr2line picks the binary, xtensa-esp32-elf-addr2line by default;
+plain addr2line for a host build). Without --elf they stay hex.
+
+--folded FILE writes the live blocks as folded stacks, outermost frame
+first, weighted by bytes, for flamegraph.pl or speedscope:
+    python alloc_trace_report.py capture.log --elf app.elf --folded live.txt
+    flamegraph.pl live.txt > live.svg
+--all-allocs weighs every allocation instead of only what is still live.
+"""
+
+import argparse
+import subprocess
+import sys
+from collections import defaultdict
+
+PREFIX = "alloc_trace,"  # ALLOC_TRACE_PREFIX
+
+
+def parse(path):
+    """(load address, events, dropped) from the capture, in order.
+
+    Each event is (kind, time_us, ptr, size, stack), stack[0] the call site.
+    """
+    base, events, dropped = 0, [], 0
+    with open(path, errors="replace") as f:
+        for line in f:
+            # the line may follow a log prefix or other text on the console
+            start = line.find(PREFIX)
+            if start < 0:
+                continue
+            fields = line[start + len(PREFIX):].strip().split(",")
+            try:
+                if fields[0] == "start":
+                    base = int(fields[1], 16)
+                elif fields[0] == "dropped":
+                    dropped += int(fields[1])
+                elif fields[0] in ("a", "f") and len(fields) == 5:
+                    stack = [int(pc, 16) for pc in fields[4].split(":")]
+                    events.append((fields[0], int(fields[1]),
+                                   int(fields[2], 16), int(fields[3]), stack))
+            except (ValueError, IndexError):
+                continue  # a line cut short by a reset
+    return base, events, dropped
+
+
+class Site:
+    def __init__(self):
+        self.allocs = 0
+        self.frees = 0
+        self.live_blocks = 0
+        self.live_bytes = 0
+        self.peak_bytes = 0
+        self.total_bytes = 0
+
+
+def replay(events, names):
+    """Per-site counters, the blocks still live and the unmatched frees.
+
+    Sites are keyed by name, so calls on one line (an unrolled loop) share
+    a row once symbolized.
+    """
+    sites = defaultdict(Site)
+    live = {}  # ptr -> (size, stack)
+    unknown_frees = 0
+    for kind, _, ptr, size, stack in events:
+        if kind == "a":
+            site = sites[names[stack[0]]]
+            site.allocs += 1
+            site.live_blocks += 1
+            site.live_bytes += size
+            site.total_bytes += size
+            site.peak_bytes = max(site.peak_bytes, site.live_bytes)
+            live[ptr] = (size, stack)
+            continue
+        block = live.pop(ptr, None)
+        if block is None:
+            unknown_frees += 1
+            continue
+        site = sites[names[block[1][0]]]
+        site.frees += 1
+        site.live_blocks -= 1
+        site.live_bytes -= block[0]
+    return sites, live, unknown_frees
+
+
+def symbolize(addresses, elf, addr2line, base):
+    """Address -> "function file:line", hex where addr2line has no answer."""
+    names = {pc: "0x%x" % pc for pc in addresses}
+    if not elf or not addresses:
+        return names
+    ordered = sorted(addresses)
+    cmd = [addr2line, "-f", "-C", "-e", elf]
+    cmd += ["0x%x" % (pc - base) for pc in ordered]
+    try:
+        out = subprocess.run(cmd, capture_output=True, text=True,
+                             check=True).stdout.splitlines()
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("addr2line failed (%s), addresses stay hex" % e, file=sys.stderr)
+        return names
+    # two lines per address: the function, then file:line
+    for pc, func, where in zip(ordered, out[0::2], out[1::2]):
+        if func == "??":
+            continue
+        where = where.split(" (discriminator")[0]
+        file_line = where.rsplit("/", 1)[-1]
+        names[pc] = func if file_line.startswith("??") else \
+            "%s %s" % (func, file_line)
+    return names
+
+
+def frame(name):
+    # folded stacks split frames on ';' and the weight on the last ' '
+    return name.replace(";", ":").replace(" ", "@")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Per-call-site heap report from an alloc_trace capture")
+    parser.add_argument("capture", help="console output with alloc_trace lines")
+    parser.add_argument("--elf", help="firmware ELF for symbols")
+    parser.add_argument("--addr2line", default="xtensa-esp32-elf-addr2line",
+                        help="addr2line of the toolchain that built the ELF")
+    parser.add_argument("--folded", metavar="FILE",
+                        help="write folded stacks for flamegraph.pl")
+    parser.add_argument("--all-allocs", action="store_true",
+                        help="fold every allocation, not only live blocks")
+    parser.add_argument("--top", type=int, default=20,
+                        help="sites in the table (default 20, 0 for all)")
+    args = parser.parse_args()
+
+    base, events, dropped = parse(args.capture)
+    if not events:
+        print("no alloc_trace events in %s" % args.capture, file=sys.stderr)
+        return 1
+    addresses = set()
+    for _, _, _, _, stack in events:
+        addresses.update(stack)
+    names = symbolize(addresses, args.elf, args.addr2line, base)
+    sites, live, unknown_frees = replay(events, names)
+
+    span_s = (events[-1][1] - events[0][1]) % (1 << 32) / 1e6
+    print("%d events over %.1f s, %d call sites, %d bytes live in %d blocks"
+          % (len(events), span_s, len(sites),
+             sum(size for size, _ in live.values()), len(live)))
+    if dropped:
+        print("%d events dropped: the ring overflowed, counts are low"
+              % dropped)
+    if unknown_frees:
+        print("%d frees of blocks allocated before the trace" % unknown_frees)
+    print()
+
+    ranked = sorted(sites.items(),
+                    key=lambda item: (-item[1].live_bytes,
+                                      -item[1].total_bytes))
+    if args.top:
+        ranked = ranked[:args.top]
+    print("%10s %7s %10s %8s %8s %10s  %s" % (
+        "live B", "blocks", "peak B", "allocs", "frees", "total B", "site"))
+    for name, s in ranked:
+        print("%10d %7d %10d %8d %8d %10d  %s" % (
+            s.live_bytes, s.live_blocks, s.peak_bytes, s.allocs, s.frees,
+            s.total_bytes, name))
+
+    if args.folded:
+        weights = defaultdict(int)
+        if args.all_allocs:
+            blocks = [(size, stack) for kind, _, _, size, stack in events
+                      if kind == "a"]
+        else:
+            blocks = live.values()
+        for size, stack in blocks:
+            weights[";".join(frame(names[pc]) for pc in reversed(stack))] += size
+        with open(args.folded, "w") as f:
+            for stack, weight in sorted(weights.items()):
+                if weight:
+                    f.write("%s %d\n" % (stack, weight))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
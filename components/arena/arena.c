@@ -0,0 +1,61 @@
+/**
+ * @file arena.c bump allocation over one region
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+// the host has one heap; the capabilities only matter on the chip
+#define heap_caps_malloc(size, caps) ((void)(caps), malloc(size))
+#define heap_caps_free(ptr) free(ptr)
+#endif
+
+esp_err_t arena_init_static(arena_t *arena, void *buf, size_t size) {
+  if (!arena || !buf || size == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  *arena = (arena_t){.base = buf, .size = size};
+  return ESP_OK;
+}
+
+esp_err_t arena_init(arena_t *arena, size_t size, uint32_t caps) {
+  if (!arena || size == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  void *buf = heap_caps_malloc(size, caps);
+  if (!buf)
+    return ESP_ERR_NO_MEM;
+
+  arena_init_static(arena, buf, size);
+  arena->owns_storage = true;
+  return ESP_OK;
+}
+
+void arena_deinit(arena_t *arena) {
+  if (arena->owns_storage)
+    heap_caps_free(arena->base);
+  memset(arena, 0, sizeof(*arena));
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  // align the address, not the offset: a static buffer may be unaligned
+  uintptr_t start = ((uintptr_t)arena->base + arena->used + ARENA_ALIGN - 1) &
+                    ~(uintptr_t)(ARENA_ALIGN - 1);
+  size_t offset = start - (uintptr_t)arena->base;
+
+  if (offset > arena->size || size > arena->size - offset) {
+    arena->fails++;
+    return NULL;
+  }
+  arena->used = offset + size;
+  if (arena->used > arena->peak)
+    arena->peak = arena->used;
+  return arena->base + offset;
+}
+
+void arena_release(arena_t *arena, arena_mark_t mark) {
+  if (mark < arena->used)
+    arena->used = mark;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file arena.h bump-pointer scratch memory with mark and release
+ *
+ * An arena hands out memory by moving one offset forward, so an
+ * allocation is an add and a compare. Nothing is freed on its own: the
+ * caller takes a mark, allocates what one piece of work needs, and
+ * releases everything past the mark at once. A processing window gets its
+ * scratch buffers this way and gives them all back when it is done.
+ *
+ * The storage is taken once, from the heap region the capabilities select
+ * (internal DRAM, DMA-capable, PSRAM, ...) or from a caller buffer. An
+ * arena has no lock; it belongs to one task.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_ALIGN 8 // every allocation, enough for double and int64_t
+
+// Internal DRAM, the default for CPU scratch
+#define ARENA_CAPS_DRAM (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+
+typedef size_t arena_mark_t;
+
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+  size_t peak;    // most ever used, to size the arena
+  uint32_t fails; // allocations that did not fit
+  bool owns_storage;
+} arena_t;
+
+// size bytes from heap_caps_malloc(size, caps), e.g. ARENA_CAPS_DRAM
+esp_err_t arena_init(arena_t *arena, size_t size, uint32_t caps);
+// buf is used as is; it should be ARENA_ALIGN aligned
+esp_err_t arena_init_static(arena_t *arena, void *buf, size_t size);
+void arena_deinit(arena_t *arena);
+
+// ARENA_ALIGN aligned; NULL, and counted, when the rest is too small
+void *arena_alloc(arena_t *arena, size_t size);
+
+static inline arena_mark_t arena_mark(const arena_t *arena) {
+  return arena->used;
+}
+// Drop every allocation made since mark
+void arena_release(arena_t *arena, arena_mark_t mark);
+static inline void arena_reset(arena_t *arena) { arena_release(arena, 0); }
+
+static inline size_t arena_remaining(const arena_t *arena) {
+  return arena->size - arena->used;
+}
+
+#endif // ARENA_H
@@ -0,0 +1,166 @@
+/**
+ * @file block_pool.c intrusive free list and the allocation bitmap
+ */
+
+#include "block_pool.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+// glibc's malloc already aligns to 16, and the host tests count malloc calls
+#define heap_caps_aligned_alloc(align, size, caps)                             \
+  ((void)(align), (void)(caps), malloc(size))
+#define heap_caps_free(ptr) free(ptr)
+#endif
+
+static size_t bitmap_bytes(uint32_t num_blocks) {
+  return sizeof(uint32_t) * ((num_blocks + 31) / 32);
+}
+
+// -------- Setup --------
+
+esp_err_t block_pool_init_static(block_pool_t *pool, void *buf,
+                                 size_t buf_size, size_t block_size,
+                                 uint32_t num_blocks) {
+  if (!pool || !buf || block_size == 0 || num_blocks == 0 ||
+      (uintptr_t)buf % BLOCK_POOL_ALIGN ||
+      buf_size < BLOCK_POOL_BUF_SIZE(block_size, num_blocks) ||
+      num_blocks > INT32_MAX)
+    return ESP_ERR_INVALID_ARG;
+
+  *pool = (block_pool_t){.storage = buf,
+                         .stride = BLOCK_POOL_STRIDE(block_size),
+                         .num_blocks = num_blocks};
+  pool->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  pool->used = (uint32_t *)(pool->storage + pool->stride * num_blocks);
+  memset(pool->used, 0, bitmap_bytes(num_blocks));
+
+  // chain the blocks in address order, the last one ends the list
+  for (uint32_t i = 0; i < num_blocks; i++) {
+    uint8_t *block = pool->storage + pool->stride * i;
+    void *next = i + 1 < num_blocks ? block + pool->stride : NULL;
+    memcpy(block, &next, sizeof(next));
+  }
+  pool->free_head = pool->storage;
+  return ESP_OK;
+}
+
+esp_err_t block_pool_init(block_pool_t *pool, size_t block_size,
+                          uint32_t num_blocks) {
+  if (!pool || block_size == 0 || num_blocks == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  size_t size = BLOCK_POOL_BUF_SIZE(block_size, num_blocks);
+  // the chip's malloc only promises 4-byte alignment
+  void *buf = heap_caps_aligned_alloc(BLOCK_POOL_ALIGN, size,
+                                      MALLOC_CAP_DEFAULT);
+  if (!buf)
+    return ESP_ERR_NO_MEM;
+
+  esp_err_t err =
+      block_pool_init_static(pool, buf, size, block_size, num_blocks);
+  if (err != ESP_OK) {
+    heap_caps_free(buf);
+    return err;
+  }
+  pool->owns_storage = true;
+  return ESP_OK;
+}
+
+void block_pool_deinit(block_pool_t *pool) {
+  if (pool->owns_storage)
+    heap_caps_free(pool->storage);
+  pool->storage = NULL;
+  pool->free_head = NULL;
+  pool->num_blocks = 0;
+}
+
+// -------- Alloc and free --------
+
+int32_t block_pool_index(const block_pool_t *pool, const void *ptr) {
+  // unsigned, so a pointer below the storage wraps past the end
+  uintptr_t offset = (uintptr_t)ptr - (uintptr_t)pool->storage;
+  if (offset >= pool->stride * pool->num_blocks || offset % pool->stride)
+    return -1;
+  return (int32_t)(offset / pool->stride);
+}
+
+// Both with the lock held
+static void *take_locked(block_pool_t *pool) {
+  uint8_t *block = pool->free_head;
+  if (!block) {
+    pool->stats.alloc_fails++;
+    return NULL;
+  }
+  memcpy(&pool->free_head, block, sizeof(void *));
+  uint32_t i = (block - pool->storage) / pool->stride;
+  pool->used[i / 32] |= 1u << (i % 32);
+  pool->stats.allocs++;
+  if (++pool->stats.in_use > pool->stats.peak_in_use)
+    pool->stats.peak_in_use = pool->stats.in_use;
+  return block;
+}
+
+static bool give_locked(block_pool_t *pool, void *block, int32_t i) {
+  if (i < 0 || !(pool->used[i / 32] & (1u << (i % 32)))) {
+    pool->stats.bad_frees++;
+    return false;
+  }
+  pool->used[i / 32] &= ~(1u << (i % 32));
+  memcpy(block, &pool->free_head, sizeof(void *));
+  pool->free_head = block;
+  pool->stats.frees++;
+  pool->stats.in_use--;
+  return true;
+}
+
+void *block_pool_alloc(block_pool_t *pool) {
+  portENTER_CRITICAL_SAFE(&pool->lock);
+  void *block = take_locked(pool);
+  portEXIT_CRITICAL_SAFE(&pool->lock);
+  return block;
+}
+
+bool block_pool_free(block_pool_t *pool, void *block) {
+  int32_t i = block_pool_index(pool, block);
+
+  portENTER_CRITICAL_SAFE(&pool->lock);
+  bool ok = give_locked(pool, block, i);
+  portEXIT_CRITICAL_SAFE(&pool->lock);
+  return ok;
+}
+
+int block_pool_alloc_n(block_pool_t *pool, void **blocks, int n) {
+  int taken = 0;
+
+  portENTER_CRITICAL_SAFE(&pool->lock);
+  while (taken < n && (blocks[taken] = take_locked(pool)))
+    taken++;
+  portEXIT_CRITICAL_SAFE(&pool->lock);
+  return taken;
+}
+
+int block_pool_free_n(block_pool_t *pool, void *const *blocks, int n) {
+  int freed = 0;
+
+  portENTER_CRITICAL_SAFE(&pool->lock);
+  for (int k = 0; k < n; k++)
+    freed += give_locked(pool, blocks[k], block_pool_index(pool, blocks[k]));
+  portEXIT_CRITICAL_SAFE(&pool->lock);
+  return freed;
+}
+
+uint32_t block_pool_available(block_pool_t *pool) {
+  portENTER_CRITICAL_SAFE(&pool->lock);
+  uint32_t n = pool->num_blocks - pool->stats.in_use;
+  portEXIT_CRITICAL_SAFE(&pool->lock);
+  return n;
+}
+
+block_pool_stats_t block_pool_get_stats(block_pool_t *pool) {
+  portENTER_CRITICAL_SAFE(&pool->lock);
+  block_pool_stats_t stats = pool->stats;
+  portEXIT_CRITICAL_SAFE(&pool->lock);
+  return stats;
+}
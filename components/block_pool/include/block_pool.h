@@ -0,0 +1,86 @@
+/**
+ * @file block_pool.h fixed-size blocks with O(1) alloc and free
+ *
+ * Free blocks are chained through their own first word, so taking or
+ * returning a block is a pointer swap under a short critical section,
+ * whatever the pool size. One bit per block marks the blocks handed out.
+ * block_pool_free() checks a pointer by arithmetic (inside the storage, on
+ * a block boundary) and by that bit, so a stray or double free is refused
+ * and counted instead of corrupting the free list.
+ *
+ * Alloc and free are safe from tasks and ISRs alike.
+ */
+
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BLOCK_POOL_ALIGN 8 // every block, and the static buffer
+
+// Bytes per block: the size rounded up to the alignment, a pointer at least
+#define BLOCK_POOL_STRIDE(block_size)                                          \
+  ((((block_size) < sizeof(void *) ? sizeof(void *) : (block_size)) +          \
+    BLOCK_POOL_ALIGN - 1) &                                                    \
+   ~(size_t)(BLOCK_POOL_ALIGN - 1))
+
+// Buffer for block_pool_init_static(): the blocks, then the bitmap
+#define BLOCK_POOL_BUF_SIZE(block_size, num_blocks)                            \
+  (BLOCK_POOL_STRIDE(block_size) * (num_blocks) +                              \
+   sizeof(uint32_t) * (((num_blocks) + 31) / 32))
+
+typedef struct {
+  uint32_t allocs;
+  uint32_t frees;
+  uint32_t alloc_fails; // pool empty
+  uint32_t bad_frees;   // not a block of this pool, or already free
+  uint32_t in_use;
+  uint32_t peak_in_use;
+} block_pool_stats_t;
+
+typedef struct {
+  uint8_t *storage;
+  size_t stride;
+  uint32_t num_blocks;
+  void *free_head;
+  uint32_t *used; // bit i set: block i is handed out
+  bool owns_storage;
+  portMUX_TYPE lock;
+  block_pool_stats_t stats;
+} block_pool_t;
+
+// Blocks and bitmap from one heap allocation
+esp_err_t block_pool_init(block_pool_t *pool, size_t block_size,
+                          uint32_t num_blocks);
+// No heap: buf holds BLOCK_POOL_BUF_SIZE() bytes, aligned to
+// BLOCK_POOL_ALIGN, and outlives the pool
+esp_err_t block_pool_init_static(block_pool_t *pool, void *buf,
+                                 size_t buf_size, size_t block_size,
+                                 uint32_t num_blocks);
+void block_pool_deinit(block_pool_t *pool);
+
+// A free block, NULL when the pool is empty. Its content is undefined.
+void *block_pool_alloc(block_pool_t *pool);
+// false (and counted) when block is not a handed-out block of this pool
+bool block_pool_free(block_pool_t *pool, void *block);
+
+// Up to n blocks under one critical section (per-task caches). Returns how
+// many were taken, fewer when the pool runs out.
+int block_pool_alloc_n(block_pool_t *pool, void **blocks, int n);
+// Return n blocks under one critical section. Returns how many were taken
+// back; the others are counted as bad frees.
+int block_pool_free_n(block_pool_t *pool, void *const *blocks, int n);
+
+// Free blocks right now
+uint32_t block_pool_available(block_pool_t *pool);
+
+// Index of the block holding ptr, -1 when ptr is not a block start
+int32_t block_pool_index(const block_pool_t *pool, const void *ptr);
+
+block_pool_stats_t block_pool_get_stats(block_pool_t *pool);
+
+#endif // BLOCK_POOL_H
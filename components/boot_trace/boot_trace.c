@@ -0,0 +1,82 @@
+/**
+ * @file boot_trace.c checkpoint buffer and the one-time dump
+ */
+
+#include "boot_trace.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+
+#ifndef __linux__
+#include "esp_cpu.h"
+#endif
+
+static boot_trace_entry_t s_entries[BOOT_TRACE_MAX];
+static int s_count;
+static uint32_t s_dropped;
+static bool s_dumped;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t cycle_count(void) {
+#ifdef __linux__
+  return 0;
+#else
+  return esp_cpu_get_cycle_count();
+#endif
+}
+
+void boot_trace_mark(const char *name) {
+  boot_trace_entry_t e = {.name = name,
+                          .time_us = esp_timer_get_time(),
+                          .cycles = cycle_count()};
+
+  portENTER_CRITICAL_SAFE(&s_lock);
+  if (s_count < BOOT_TRACE_MAX)
+    s_entries[s_count++] = e;
+  else
+    s_dropped++;
+  portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+// Runs with the other constructors in the startup code, before app_main()
+__attribute__((constructor)) static void boot_trace_app_start(void) {
+  boot_trace_mark("app start");
+}
+
+int boot_trace_count(void) { return s_count; }
+
+const boot_trace_entry_t *boot_trace_entry(int index) {
+  return index >= 0 && index < s_count ? &s_entries[index] : NULL;
+}
+
+uint32_t boot_trace_dropped(void) { return s_dropped; }
+
+bool boot_trace_dump(void) {
+  portENTER_CRITICAL(&s_lock);
+  bool first = !s_dumped;
+  s_dumped = true;
+  int count = s_count;
+  portEXIT_CRITICAL(&s_lock);
+  if (!first)
+    return false;
+
+  // entries below count no longer change, print outside the lock
+  for (int i = 0; i < count; i++) {
+    const boot_trace_entry_t *e = &s_entries[i];
+    int64_t since = i ? e->time_us - s_entries[i - 1].time_us : 0;
+    printf(BOOT_TRACE_PREFIX ",%d,%s,%lld,%lld,%u\n", i, e->name,
+           (long long)e->time_us, (long long)since, (unsigned)e->cycles);
+  }
+  if (s_dropped)
+    printf(BOOT_TRACE_PREFIX ",dropped,%u\n", (unsigned)s_dropped);
+  fflush(stdout);
+  return true;
+}
+
+void boot_trace_reset(void) {
+  portENTER_CRITICAL(&s_lock);
+  s_count = 0;
+  s_dropped = 0;
+  s_dumped = false;
+  portEXIT_CRITICAL(&s_lock);
+}
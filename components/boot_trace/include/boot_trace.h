@@ -0,0 +1,47 @@
+/**
+ * @file boot_trace.h named boot checkpoints in a fixed buffer, dumped once
+ *
+ * boot_trace_mark("nvs ready") stores the checkpoint name with
+ * esp_timer_get_time() and the CPU cycle count. Nothing is printed until
+ * boot_trace_dump(), which writes every checkpoint as one line for
+ * tools/boot_trace_diff.py to compare between builds. A constructor marks
+ * "app start" before app_main(), after the esp_timer is up; esp_timer
+ * starts during the app's startup, so the ROM and the bootloader are not
+ * in the trace.
+ *
+ * The name must be a string literal (only its address is kept). A full
+ * buffer ignores further checkpoints and counts them.
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOOT_TRACE_MAX 16
+#define BOOT_TRACE_PREFIX "boot_trace" // start of every dumped line
+
+typedef struct {
+  const char *name;
+  int64_t time_us; // esp_timer_get_time()
+  uint32_t cycles; // CPU cycle counter, 0 on the host
+} boot_trace_entry_t;
+
+// Record a checkpoint; safe from tasks and ISRs
+void boot_trace_mark(const char *name);
+
+// Checkpoints so far, in order, and how many did not fit
+int boot_trace_count(void);
+const boot_trace_entry_t *boot_trace_entry(int index);
+uint32_t boot_trace_dropped(void);
+
+// Print the trace once, one line per checkpoint:
+//   boot_trace,<index>,<name>,<time_us>,<since previous us>,<cycles>
+// Later calls print nothing and return false.
+bool boot_trace_dump(void);
+
+// Forget the checkpoints, "app start" included (host tests)
+void boot_trace_reset(void);
+
+#endif // BOOT_TRACE_H
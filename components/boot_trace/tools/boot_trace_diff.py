@@ -0,0 +1,138 @@
+"""
+Compare boot traces between two builds.
+
+Each file is a console capture holding the lines boot_trace_dump() prints,
+mixed with any other output:
+    python boot_trace_diff.py before.log after.log
+A capture may hold several boots (reset the board a few times, or log
+every deep-sleep wake); each checkpoint then takes the median over the
+boots, so one slow flash read does not look like a regression.
+
+Checkpoints are matched by name. For every one the tool prints when it was
+reached and how long the phase leading to it took, in both builds. A phase
+that got slower by more than --threshold-us and --threshold-pct is
+flagged, and the exit status is 1 so a CI job can fail on it. With a
+single file it prints that trace.
+"""
+
+import argparse
+import statistics
+import sys
+
+PREFIX = "boot_trace,"  # BOOT_TRACE_PREFIX
+
+
+def parse(path):
+    """Boots in a capture, each a list of (name, time_us)."""
+    boots = []
+    with open(path, errors="replace") as f:
+        for line in f:
+            # the line may follow a log prefix or other text on the console
+            start = line.find(PREFIX)
+            if start < 0:
+                continue
+            fields = line[start + len(PREFIX):].strip().split(",")
+            if len(fields) != 5 or not fields[0].isdigit():
+                continue  # the dropped count, or a damaged line
+            index, name, time_us = int(fields[0]), fields[1], int(fields[2])
+            if index == 0 or not boots:
+                boots.append([])
+            boots[-1].append((name, time_us))
+    return boots
+
+
+def summarize(boots):
+    """Median time of every checkpoint, in the order of the first boot."""
+    order, times = [], {}
+    for boot in boots:
+        for name, time_us in boot:
+            if name not in times:
+                order.append(name)
+                times[name] = []
+            times[name].append(time_us)
+    return [(name, statistics.median(times[name])) for name in order]
+
+
+def phases(trace):
+    """Checkpoint -> (time reached, time since the previous checkpoint)."""
+    out, prev = {}, None
+    for name, time_us in trace:
+        out[name] = (time_us, time_us - prev if prev is not None else 0)
+        prev = time_us
+    return out
+
+
+def print_trace(trace, boots):
+    print("%d boot(s)" % boots)
+    print("%-24s %10s %10s" % ("checkpoint", "at us", "phase us"))
+    for name, (at, phase) in phases(trace).items():
+        print("%-24s %10.0f %10.0f" % (name, at, phase))
+
+
+def print_diff(base, new, args):
+    old, cur = phases(base), phases(new)
+    regressions = []
+
+    print("%-24s %10s %10s %10s %10s %10s" %
+          ("checkpoint", "base at", "new at", "base phase", "new phase",
+           "delta"))
+    for name, _ in new:
+        if name not in old:
+            print("%-24s %10s %10.0f %10s %10.0f %10s  new checkpoint" %
+                  (name, "-", cur[name][0], "-", cur[name][1], "-"))
+            continue
+        delta = cur[name][1] - old[name][1]
+        slower = (delta > args.threshold_us and
+                  delta > old[name][1] * args.threshold_pct / 100)
+        if slower:
+            regressions.append(name)
+        print("%-24s %10.0f %10.0f %10.0f %10.0f %+10.0f%s" %
+              (name, old[name][0], cur[name][0], old[name][1], cur[name][1],
+               delta, "  SLOWER" if slower else ""))
+    for name, _ in base:
+        if name not in cur:
+            print("%-24s %10.0f %10s %10.0f %10s %10s  gone" %
+                  (name, old[name][0], "-", old[name][1], "-", "-"))
+
+    common = [name for name, _ in new if name in old]
+    if common:
+        last = common[-1]
+        print("\nto '%s': %.0f -> %.0f us (%+.0f)" %
+              (last, old[last][0], cur[last][0],
+               cur[last][0] - old[last][0]))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare boot_trace captures between two builds.")
+    parser.add_argument("base", help="capture from the reference build")
+    parser.add_argument("new", nargs="?", help="capture from the new build")
+    parser.add_argument("--threshold-us", type=float, default=200,
+                        help="smallest phase slowdown to flag (default 200)")
+    parser.add_argument("--threshold-pct", type=float, default=10,
+                        help="and at least this much slower (default 10)")
+    args = parser.parse_args()
+
+    base_boots = parse(args.base)
+    if not base_boots:
+        sys.exit("%s: no boot_trace lines" % args.base)
+    if args.new is None:
+        print_trace(summarize(base_boots), len(base_boots))
+        return 0
+
+    new_boots = parse(args.new)
+    if not new_boots:
+        sys.exit("%s: no boot_trace lines" % args.new)
+    print("base: %d boot(s), new: %d boot(s)\n" %
+          (len(base_boots), len(new_boots)))
+    regressions = print_diff(summarize(base_boots), summarize(new_boots),
+                             args)
+    if regressions:
+        print("slower phases: %s" % ", ".join(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
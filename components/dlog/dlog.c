@@ -0,0 +1,302 @@
+/**
+ * @file dlog.c ring buffer, drain, on-target rendering and binary frames
+ */
+
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+esp_log_level_t dlog_level = ESP_LOG_INFO;
+
+static dlog_entry_t *s_ring;
+static uint32_t s_mask;
+static uint32_t s_head; // next entry written
+static uint32_t s_tail; // next entry drained
+static uint32_t s_reported_drops;
+static dlog_stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const TAG = "DLOG";
+
+// Binary frames need stdout to pass every byte through; the CR and CRLF
+// line endings add or swap bytes around each 0x0A
+#if CONFIG_NEWLIB_STDOUT_LINE_ENDING_CRLF || CONFIG_NEWLIB_STDOUT_LINE_ENDING_CR
+#define DLOG_STDOUT_RAW 0
+#else
+#define DLOG_STDOUT_RAW 1
+#endif
+static const char *const DROPPED_FMT = "%u entries dropped, ring full";
+
+// -------- Ring --------
+
+esp_err_t dlog_init(size_t capacity) {
+  if (capacity < 2 || (capacity & (capacity - 1)) || capacity > UINT16_MAX)
+    return ESP_ERR_INVALID_ARG;
+
+  dlog_entry_t *ring = calloc(capacity, sizeof(dlog_entry_t));
+  if (!ring)
+    return ESP_ERR_NO_MEM;
+
+  portENTER_CRITICAL(&s_lock);
+  dlog_entry_t *old = s_ring;
+  s_ring = ring;
+  s_mask = capacity - 1;
+  s_head = s_tail = 0;
+  s_reported_drops = 0;
+  s_stats = (dlog_stats_t){0};
+  portEXIT_CRITICAL(&s_lock);
+
+  free(old);
+  return ESP_OK;
+}
+
+void dlog_deinit(void) {
+  portENTER_CRITICAL(&s_lock);
+  dlog_entry_t *old = s_ring;
+  s_ring = NULL;
+  portEXIT_CRITICAL(&s_lock);
+  free(old);
+}
+
+void dlog_set_level(esp_log_level_t level) { dlog_level = level; }
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                int num_args, const uint64_t *args) {
+  uint32_t now = (uint32_t)esp_timer_get_time();
+
+  if (num_args > DLOG_MAX_ARGS)
+    num_args = DLOG_MAX_ARGS;
+
+  // the copy is a few words; formatting happens after the lock, elsewhere
+  portENTER_CRITICAL_SAFE(&s_lock);
+  if (!s_ring || s_head - s_tail > s_mask) {
+    s_stats.dropped++;
+  } else {
+    dlog_entry_t *e = &s_ring[s_head & s_mask];
+    e->timestamp_us = now;
+    e->level = level;
+    e->num_args = num_args;
+    e->tag = tag;
+    e->fmt = fmt;
+    for (int i = 0; i < num_args; i++)
+      e->args[i] = args[i];
+    s_head++;
+    s_stats.written++;
+    if (s_head - s_tail > s_stats.peak_used)
+      s_stats.peak_used = s_head - s_tail;
+  }
+  portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+int dlog_drain(dlog_sink_t sink, void *ctx, int max) {
+  dlog_entry_t entry;
+  int n = 0;
+
+  while (n < max) {
+    portENTER_CRITICAL(&s_lock);
+    uint32_t drops = s_stats.dropped - s_reported_drops;
+    bool have = s_ring && s_tail != s_head;
+    if (drops) {
+      s_reported_drops += drops;
+    } else if (have) {
+      entry = s_ring[s_tail & s_mask];
+      s_tail++;
+      s_stats.drained++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (drops) {
+      // a literal, so the host tool can decode it like any other entry
+      entry = (dlog_entry_t){.timestamp_us = (uint32_t)esp_timer_get_time(),
+                             .level = ESP_LOG_WARN,
+                             .num_args = 1,
+                             .tag = TAG,
+                             .fmt = DROPPED_FMT,
+                             .args = {drops}};
+    } else if (!have) {
+      break;
+    }
+    sink(&entry, ctx);
+    n++;
+  }
+  return n;
+}
+
+dlog_stats_t dlog_get_stats(void) {
+  portENTER_CRITICAL(&s_lock);
+  dlog_stats_t stats = s_stats;
+  portEXIT_CRITICAL(&s_lock);
+  return stats;
+}
+
+// -------- Rendering --------
+
+// Bits an integer conversion reads; arguments were stored sign-extended
+static int int_bits(const char *length) {
+  if (length[0] == 'h')
+    return length[1] == 'h' ? 8 : 16;
+  if ((length[0] == 'l' && length[1] == 'l') || length[0] == 'j')
+    return 64;
+  if (length[0] == 'l' || length[0] == 'z' || length[0] == 't')
+    return 8 * sizeof(long);
+  return 32;
+}
+
+int dlog_render(const dlog_entry_t *entry, char *buf, size_t size) {
+  static const char levels[] = "NEWIDV";
+  size_t n = 0;
+  int arg = 0;
+
+#define PUT(...)                                                               \
+  do {                                                                         \
+    int w = snprintf(buf + (n < size ? n : size), n < size ? size - n : 0,    \
+                     __VA_ARGS__);                                             \
+    if (w > 0)                                                                 \
+      n += w;                                                                  \
+  } while (0)
+
+  PUT("%c (%u) %s: ", levels[entry->level < 6 ? entry->level : 0],
+      (unsigned)(entry->timestamp_us / 1000), entry->tag);
+
+  for (const char *p = entry->fmt; *p;) {
+    if (*p != '%' || p[1] == '%') {
+      PUT("%c", *p);
+      p += *p == '%' ? 2 : 1;
+      continue;
+    }
+
+    // one conversion: %[flags][width][.precision][length]type
+    char spec[24], length[3] = {0};
+    size_t len = 0;
+    const char *start = p++;
+    while (*p && strchr("-+ #0123456789.", *p))
+      p++;
+    while (*p && strchr("hljzt", *p) && len < 2)
+      length[len++] = *p++;
+    char type = *p ? *p++ : 0;
+    size_t flags_len = (p - start) - len - 1;
+    if (!type || flags_len + 4 > sizeof(spec) || arg == entry->num_args) {
+      PUT("<?>");
+      continue;
+    }
+    memcpy(spec, start, flags_len);
+
+    uint64_t v = entry->args[arg++];
+    int bits = int_bits(length);
+    uint64_t mask = bits == 64 ? UINT64_MAX : (1ULL << bits) - 1;
+    switch (type) {
+    case 'd':
+    case 'i': {
+      int64_t s = (int64_t)(v << (64 - bits)) >> (64 - bits);
+      memcpy(spec + flags_len, "lld", 4);
+      PUT(spec, (long long)s);
+      break;
+    }
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      memcpy(spec + flags_len, "ll", 2);
+      spec[flags_len + 2] = type;
+      spec[flags_len + 3] = 0;
+      PUT(spec, (unsigned long long)(v & mask));
+      break;
+    case 'c':
+      memcpy(spec + flags_len, "c", 2);
+      PUT(spec, (int)(v & 0xff));
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G': {
+      double d;
+      memcpy(&d, &v, sizeof(d));
+      spec[flags_len] = type;
+      spec[flags_len + 1] = 0;
+      PUT(spec, d);
+      break;
+    }
+    case 's':
+      memcpy(spec + flags_len, "s", 2);
+      PUT(spec, (const char *)(uintptr_t)v);
+      break;
+    case 'p':
+      PUT("%p", (void *)(uintptr_t)v);
+      break;
+    default:
+      PUT("<?>");
+      break;
+    }
+  }
+#undef PUT
+  return (int)n;
+}
+
+// -------- Binary frames --------
+
+static uint8_t *put_le(uint8_t *p, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    *p++ = v >> (8 * i);
+  return p;
+}
+
+size_t dlog_encode(const dlog_entry_t *entry, uint8_t *frame) {
+  uint8_t *p = put_le(frame, DLOG_FRAME_MAGIC, 2);
+  *p++ = entry->level;
+  *p++ = entry->num_args;
+  p = put_le(p, entry->timestamp_us, 4);
+  // addresses in the firmware image, 32 bits on the target
+  p = put_le(p, (uintptr_t)entry->tag, 4);
+  p = put_le(p, (uintptr_t)entry->fmt, 4);
+  for (int i = 0; i < entry->num_args; i++)
+    p = put_le(p, entry->args[i], 8);
+  return p - frame;
+}
+
+// -------- Drain task --------
+
+typedef struct {
+  bool binary;
+  uint32_t period_ms;
+} drain_config_t;
+
+static drain_config_t s_drain;
+
+static void print_entry(const dlog_entry_t *entry, void *ctx) {
+  if (s_drain.binary) {
+    uint8_t frame[DLOG_FRAME_MAX];
+    fwrite(frame, 1, dlog_encode(entry, frame), stdout);
+  } else {
+    char line[160];
+    dlog_render(entry, line, sizeof(line));
+    puts(line);
+  }
+}
+
+void dlog_flush(void) {
+  if (dlog_drain(print_entry, NULL, INT32_MAX))
+    fflush(stdout);
+}
+
+static void dlog_task(void *arg) {
+  while (1) {
+    dlog_flush();
+    vTaskDelay(pdMS_TO_TICKS(s_drain.period_ms));
+  }
+}
+
+void dlog_task_create(bool binary, uint32_t period_ms, UBaseType_t priority) {
+  if (binary && !DLOG_STDOUT_RAW) {
+    ESP_LOGE(TAG, "Binary frames need CONFIG_NEWLIB_STDOUT_LINE_ENDING_LF, "
+                  "writing text");
+    binary = false;
+  }
+  s_drain = (drain_config_t){.binary = binary, .period_ms = period_ms};
+  xTaskCreate(dlog_task, "dlog_task",
+              3072, // text mode formats here, with floats
+              NULL, priority, NULL);
+}
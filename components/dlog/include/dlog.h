@@ -0,0 +1,139 @@
+/**
+ * @file dlog.h deferred-format logging: format ID and raw arguments into a
+ * RAM ring, formatted later or on the host
+ *
+ * DLOGI(TAG, "x=%d", x) costs a timestamp, a short critical section and a
+ * copy of the arguments into a fixed ring. Nothing is formatted and nothing
+ * waits for the UART; a full ring drops the entry and counts it. A
+ * low-priority task drains the ring, either as text (dlog_render()) or as
+ * binary frames that tools/dlog_decode.py turns back into log lines using
+ * the format strings in the firmware ELF.
+ *
+ * The format ID is the address of the format string, so the tag, the
+ * format and any %s argument must be string literals (or live as long as
+ * the firmware). Every argument is kept as 64 bits: floats as doubles,
+ * integers sign-extended. At most DLOG_MAX_ARGS arguments.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DLOG_MAX_ARGS 6
+#define DLOG_FRAME_MAGIC 0x4c44 // "DL"
+#define DLOG_FRAME_HEADER_LEN 16
+#define DLOG_FRAME_MAX (DLOG_FRAME_HEADER_LEN + 8 * DLOG_MAX_ARGS)
+
+typedef struct {
+  uint32_t timestamp_us; // low 32 bits of esp_timer_get_time()
+  uint8_t level;         // esp_log_level_t
+  uint8_t num_args;
+  const char *tag;
+  const char *fmt;
+  uint64_t args[DLOG_MAX_ARGS];
+} dlog_entry_t;
+
+typedef struct {
+  uint32_t written;
+  uint32_t dropped; // ring full
+  uint32_t drained;
+  uint16_t peak_used;
+} dlog_stats_t;
+
+// Called by dlog_drain() for every entry, in order
+typedef void (*dlog_sink_t)(const dlog_entry_t *entry, void *ctx);
+
+// The only heap use: the ring, capacity a power of two
+esp_err_t dlog_init(size_t capacity);
+void dlog_deinit(void);
+
+// Entries above this level are not recorded (ESP_LOG_INFO by default)
+void dlog_set_level(esp_log_level_t level);
+extern esp_log_level_t dlog_level;
+
+// Fast path behind the DLOGx macros; safe from tasks and ISRs
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                int num_args, const uint64_t *args);
+
+// Hand up to max queued entries to sink, oldest first. Returns how many.
+// A drop since the last call shows up as an entry of its own.
+int dlog_drain(dlog_sink_t sink, void *ctx, int max);
+
+dlog_stats_t dlog_get_stats(void);
+
+// Format an entry like ESP_LOG would, "I (1234) TAG: text". Returns the
+// length snprintf() would give.
+int dlog_render(const dlog_entry_t *entry, char *buf, size_t size);
+
+// Encode an entry as one binary frame for tools/dlog_decode.py, little
+// endian: magic u16, level u8, num_args u8, timestamp u32, tag u32, fmt u32,
+// then the arguments as u64. Returns the frame length.
+size_t dlog_encode(const dlog_entry_t *entry, uint8_t *frame);
+
+// Drain task: every period_ms, writes the ring to stdout as text lines or
+// binary frames. Binary frames need CONFIG_NEWLIB_STDOUT_LINE_ENDING_LF in
+// the project's sdkconfig; with any other line ending the task writes text.
+void dlog_task_create(bool binary, uint32_t period_ms, UBaseType_t priority);
+
+// Write out everything queued now, the way the drain task would (before
+// deep sleep, or on a crash path)
+void dlog_flush(void);
+
+// -------- Argument capture --------
+
+static inline uint64_t dlog_arg_f(double v) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+static inline uint64_t dlog_arg_i(int64_t v) { return (uint64_t)v; }
+static inline uint64_t dlog_arg_u(uint64_t v) { return v; }
+static inline uint64_t dlog_arg_p(const void *v) { return (uintptr_t)v; }
+
+#define DLOG_ARG(x)                                                            \
+  _Generic((x),                                                                \
+      float: dlog_arg_f,                                                       \
+      double: dlog_arg_f,                                                      \
+      unsigned long long: dlog_arg_u,                                          \
+      char *: dlog_arg_p,                                                      \
+      const char *: dlog_arg_p,                                                \
+      void *: dlog_arg_p,                                                      \
+      const void *: dlog_arg_p,                                                \
+      default: dlog_arg_i)(x)
+
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define DLOG_NARGS(...) DLOG_NARGS_(_, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+
+#define DLOG_MAP_0(...)
+#define DLOG_MAP_1(a) DLOG_ARG(a)
+#define DLOG_MAP_2(a, ...) DLOG_ARG(a), DLOG_MAP_1(__VA_ARGS__)
+#define DLOG_MAP_3(a, ...) DLOG_ARG(a), DLOG_MAP_2(__VA_ARGS__)
+#define DLOG_MAP_4(a, ...) DLOG_ARG(a), DLOG_MAP_3(__VA_ARGS__)
+#define DLOG_MAP_5(a, ...) DLOG_ARG(a), DLOG_MAP_4(__VA_ARGS__)
+#define DLOG_MAP_6(a, ...) DLOG_ARG(a), DLOG_MAP_5(__VA_ARGS__)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_MAP(...)                                                          \
+  DLOG_CAT(DLOG_MAP_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+#define DLOG(level, tag, fmt, ...)                                             \
+  do {                                                                         \
+    if ((level) <= dlog_level)                                                 \
+      dlog_write((level), (tag), (fmt), DLOG_NARGS(__VA_ARGS__),               \
+                 (const uint64_t[DLOG_NARGS(__VA_ARGS__) + 1]){               \
+                     DLOG_MAP(__VA_ARGS__)});                                  \
+  } while (0)
+
+#define DLOGE(tag, fmt, ...) DLOG(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#endif // DLOG_H
@@ -0,0 +1,141 @@
+"""
+Turn dlog binary frames back into log lines, using the firmware ELF.
+
+A frame carries the addresses of its tag and format string, not the text.
+This tool reads those strings from the ELF that produced the capture, so the
+ELF must match the firmware that ran:
+    python dlog_decode.py build/app.elf capture.bin
+Anything in the capture that is not a valid frame (boot text, ESP_LOG
+lines) is skipped. A frame is valid when its magic matches, its tag and
+format resolve to strings in the ELF, and the format takes as many
+arguments as the frame carries.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"\x44\x4c"  # DLOG_FRAME_MAGIC, little endian
+HEADER = struct.Struct("<HBBIII")  # magic, level, num_args, ts, tag, fmt
+MAX_ARGS = 6
+LEVELS = "NEWIDV"
+# %[flags][width][.precision][length]type, as dlog_render() parses it
+CONVERSION = re.compile(r"%([-+ #0-9.]*)(hh|h|ll|l|j|z|t)?([diuxXocfFeEgGsp%])")
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class Elf:
+    """Loaded sections of an ELF file, to read strings by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        is64 = self.data[4] == 2
+        if is64:
+            shoff, = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x3A)
+            entry = struct.Struct("<IIQQQQ")
+        else:
+            shoff, = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+            entry = struct.Struct("<IIIIII")
+
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, addr, offset, size = entry.unpack_from(
+                self.data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and kind != SHT_NOBITS and size:
+                self.sections.append((addr, size, offset))
+
+    def string(self, addr):
+        for start, size, offset in self.sections:
+            if start <= addr < start + size:
+                pos = offset + addr - start
+                end = self.data.find(b"\0", pos, offset + size)
+                if end < 0:
+                    return None
+                return self.data[pos:end].decode("utf-8", "replace")
+        return None
+
+
+def render(fmt, args, elf):
+    """The message, as dlog_render() would print it on the target."""
+    out = []
+    last = 0
+    it = iter(args)
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, length, kind = m.groups()
+        if kind == "%":
+            out.append("%")
+            continue
+        v = next(it)
+        # the target's long and size_t are 32 bits
+        bits = {"hh": 8, "h": 16, "ll": 64, "j": 64}.get(length, 32)
+        mask = (1 << bits) - 1
+        if kind in "di":
+            v &= mask
+            if v >> (bits - 1):
+                v -= 1 << bits
+            out.append(("%" + flags + "d") % v)
+        elif kind in "uxXo":
+            out.append(("%" + flags + kind.replace("u", "d")) % (v & mask))
+        elif kind == "c":
+            out.append(("%" + flags + "c") % chr(v & 0xFF))
+        elif kind in "fFeEgG":
+            out.append(("%" + flags + kind) % struct.unpack("<d", struct.pack("<Q", v))[0])
+        elif kind == "s":
+            s = elf.string(v & 0xFFFFFFFF)
+            out.append(("%" + flags + "s") % (s if s is not None else "<0x%08x>" % v))
+        else:  # p
+            out.append("0x%x" % (v & 0xFFFFFFFF))
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def conversions(fmt):
+    return sum(1 for m in CONVERSION.finditer(fmt) if m.group(3) != "%")
+
+
+def decode(buf, elf):
+    """Log lines for every valid frame in a capture."""
+    pos = 0
+    while True:
+        pos = buf.find(MAGIC, pos)
+        if pos < 0 or len(buf) - pos < HEADER.size:
+            return
+        _, level, num_args, ts, tag_addr, fmt_addr = HEADER.unpack_from(buf, pos)
+        end = pos + HEADER.size + 8 * num_args
+        tag = elf.string(tag_addr)
+        fmt = elf.string(fmt_addr)
+        if (num_args > MAX_ARGS or end > len(buf) or tag is None or
+                fmt is None or conversions(fmt) != num_args):
+            pos += 1
+            continue
+        args = struct.unpack_from("<%dQ" % num_args, buf, pos + HEADER.size)
+        level_char = LEVELS[level] if level < len(LEVELS) else "?"
+        yield "%s (%d) %s: %s" % (level_char, ts // 1000, tag,
+                                  render(fmt, args, elf))
+        pos = end
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF that produced the capture")
+    parser.add_argument("capture", help="raw console capture")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    with open(args.capture, "rb") as f:
+        for line in decode(f.read(), elf):
+            sys.stdout.write(line + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,267 @@
+/**
+ * @file gpio_mock.c pin levels, scheduled edges and ISR dispatch for host builds
+ */
+
+#include "gpio_mock.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+typedef struct {
+  gpio_mode_t mode;
+  gpio_int_type_t intr_type;
+  int level;
+  gpio_isr_t isr;
+  void *isr_arg;
+} pin_t;
+
+typedef struct {
+  gpio_num_t pin;
+  int level;
+  int64_t at_us;
+} event_t;
+
+typedef struct {
+  gpio_num_t pin;
+  gpio_mock_output_cb_t cb;
+  void *ctx;
+} watcher_t;
+
+static pin_t pins[GPIO_NUM_MAX];
+static event_t events[GPIO_MOCK_MAX_EVENTS];
+static int num_events;
+static watcher_t watchers[GPIO_MOCK_MAX_WATCHERS];
+static int num_watchers;
+static bool isr_service;
+static bool in_isr;
+static int64_t now_us;
+static int64_t poll_cost_us;
+static gpio_mock_stats_t stats;
+
+// the test task advances the clock while the firmware task triggers
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool valid_pin(gpio_num_t pin) { return pin >= 0 && pin < GPIO_NUM_MAX; }
+
+static bool edge_fires(gpio_int_type_t type, int level) {
+  switch (type) {
+  case GPIO_INTR_POSEDGE:
+  case GPIO_INTR_HIGH_LEVEL:
+    return level;
+  case GPIO_INTR_NEGEDGE:
+  case GPIO_INTR_LOW_LEVEL:
+    return !level;
+  case GPIO_INTR_ANYEDGE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// -------- Clock and edges --------
+
+void gpio_mock_reset(void) {
+  portENTER_CRITICAL(&lock);
+  memset(pins, 0, sizeof(pins));
+  num_events = 0;
+  num_watchers = 0;
+  isr_service = false;
+  now_us = 0;
+  poll_cost_us = 0;
+  memset(&stats, 0, sizeof(stats));
+  portEXIT_CRITICAL(&lock);
+}
+
+int64_t gpio_mock_now_us(void) { return now_us; }
+
+int64_t esp_timer_get_time(void) { return now_us; }
+
+esp_err_t gpio_mock_schedule(gpio_num_t pin, int level, int64_t at_us) {
+  if (!valid_pin(pin))
+    return ESP_ERR_INVALID_ARG;
+
+  esp_err_t ret = ESP_OK;
+  portENTER_CRITICAL(&lock);
+  if (num_events == GPIO_MOCK_MAX_EVENTS)
+    ret = ESP_ERR_NO_MEM;
+  else
+    events[num_events++] = (event_t){
+        .pin = pin, .level = level, .at_us = at_us < now_us ? now_us : at_us};
+  portEXIT_CRITICAL(&lock);
+  return ret;
+}
+
+void gpio_mock_cancel(gpio_num_t pin) {
+  portENTER_CRITICAL(&lock);
+  for (int i = num_events - 1; i >= 0; i--) {
+    if (events[i].pin == pin)
+      events[i] = events[--num_events];
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+// Index of the earliest pending edge, -1 if none (lock held)
+static int earliest_event(void) {
+  int best = -1;
+  for (int i = 0; i < num_events; i++) {
+    if (best < 0 || events[i].at_us < events[best].at_us)
+      best = i;
+  }
+  return best;
+}
+
+int64_t gpio_mock_next_event_us(void) {
+  portENTER_CRITICAL(&lock);
+  int i = earliest_event();
+  int64_t at_us = i < 0 ? -1 : events[i].at_us;
+  portEXIT_CRITICAL(&lock);
+  return at_us;
+}
+
+static void run_until(int64_t end_us) {
+  while (1) {
+    gpio_isr_t isr = NULL;
+    void *arg = NULL;
+
+    portENTER_CRITICAL(&lock);
+    int i = earliest_event();
+    if (i < 0 || events[i].at_us > end_us) {
+      if (end_us > now_us)
+        now_us = end_us;
+      portEXIT_CRITICAL(&lock);
+      return;
+    }
+
+    event_t ev = events[i];
+    events[i] = events[--num_events];
+    now_us = ev.at_us;
+
+    pin_t *pin = &pins[ev.pin];
+    if (pin->level != ev.level) {
+      pin->level = ev.level;
+      stats.edges++;
+      if (isr_service && pin->isr && edge_fires(pin->intr_type, ev.level)) {
+        isr = pin->isr;
+        arg = pin->isr_arg;
+        stats.isr_calls++;
+      }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    // outside the lock: the handler may notify a task and yield
+    if (isr) {
+      in_isr = true;
+      isr(arg);
+      in_isr = false;
+    }
+  }
+}
+
+void gpio_mock_advance_us(int64_t us) { run_until(now_us + us); }
+
+esp_err_t gpio_mock_watch_output(gpio_num_t pin, gpio_mock_output_cb_t cb,
+                                 void *ctx) {
+  if (!valid_pin(pin) || !cb)
+    return ESP_ERR_INVALID_ARG;
+  if (num_watchers == GPIO_MOCK_MAX_WATCHERS)
+    return ESP_ERR_NO_MEM;
+
+  watchers[num_watchers++] = (watcher_t){.pin = pin, .cb = cb, .ctx = ctx};
+  return ESP_OK;
+}
+
+void gpio_mock_set_poll_cost_us(int64_t us) { poll_cost_us = us; }
+
+void gpio_mock_get_stats(gpio_mock_stats_t *out) { *out = stats; }
+
+void gpio_mock_clear_stats(void) { memset(&stats, 0, sizeof(stats)); }
+
+// -------- Driver API --------
+
+esp_err_t gpio_config(const gpio_config_t *conf) {
+  if (!conf || conf->pin_bit_mask == 0 ||
+      conf->pin_bit_mask >> GPIO_NUM_MAX != 0)
+    return ESP_ERR_INVALID_ARG;
+
+  for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+    if (conf->pin_bit_mask & (1ULL << pin)) {
+      pins[pin].mode = conf->mode;
+      pins[pin].intr_type = conf->intr_type;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+  if (!valid_pin(gpio_num))
+    return ESP_ERR_INVALID_ARG;
+
+  pins[gpio_num] = (pin_t){0};
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+  if (!valid_pin(gpio_num))
+    return ESP_ERR_INVALID_ARG;
+
+  pin_t *pin = &pins[gpio_num];
+  int old = pin->level;
+  pin->level = level ? 1 : 0;
+  if (!(pin->mode & GPIO_MODE_OUTPUT) || old == pin->level)
+    return ESP_OK;
+
+  for (int i = 0; i < num_watchers; i++) {
+    if (watchers[i].pin == gpio_num)
+      watchers[i].cb(watchers[i].ctx, gpio_num, pin->level);
+  }
+  return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+  if (!valid_pin(gpio_num))
+    return 0;
+
+  if (!in_isr) {
+    stats.level_reads++;
+    if (poll_cost_us)
+      gpio_mock_advance_us(poll_cost_us);
+  }
+  return pins[gpio_num].level;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+  if (!valid_pin(gpio_num))
+    return ESP_ERR_INVALID_ARG;
+
+  pins[gpio_num].intr_type = intr_type;
+  return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+  (void)intr_alloc_flags;
+
+  if (isr_service)
+    return ESP_ERR_INVALID_STATE;
+  isr_service = true;
+  return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void) { isr_service = false; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler,
+                               void *args) {
+  if (!valid_pin(gpio_num))
+    return ESP_ERR_INVALID_ARG;
+  if (!isr_service)
+    return ESP_ERR_INVALID_STATE;
+
+  portENTER_CRITICAL(&lock);
+  pins[gpio_num].isr = isr_handler;
+  pins[gpio_num].isr_arg = args;
+  portEXIT_CRITICAL(&lock);
+  return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+  return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
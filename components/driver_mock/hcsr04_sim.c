@@ -0,0 +1,97 @@
+/**
+ * @file hcsr04_sim.c trigger watcher and echo pulse generator
+ */
+
+#include "hcsr04_sim.h"
+#include <string.h>
+
+int64_t hcsr04_sim_pulse_us(float distance_cm) {
+  return (int64_t)(distance_cm * HCSR04_SIM_US_PER_CM + 0.5f);
+}
+
+// Cut the echo of sim short if a burst reaches it while it listens
+static bool hear(hcsr04_sim_t *sim, int64_t arrival_us) {
+  if (sim->rise_us < 0 || arrival_us <= sim->rise_us ||
+      arrival_us >= sim->fall_us)
+    return false;
+
+  sim->fall_us = arrival_us;
+  sim->crosstalk++;
+  return true;
+}
+
+static void schedule_echo(hcsr04_sim_t *sim) {
+  gpio_mock_cancel(sim->echo_pin);
+  if (sim->rise_us >= gpio_mock_now_us())
+    gpio_mock_schedule(sim->echo_pin, 1, sim->rise_us);
+  gpio_mock_schedule(sim->echo_pin, 0, sim->fall_us);
+}
+
+static void on_trigger(void *ctx, gpio_num_t pin, int level) {
+  hcsr04_sim_t *sim = ctx;
+  (void)pin;
+
+  if (level)
+    return; // the burst starts on the falling edge of the trigger pulse
+
+  sim->pings++;
+  sim->rise_us = -1;
+  sim->fall_us = -1;
+  if (sim->no_echo)
+    return;
+
+  sim->rise_us = gpio_mock_now_us() + sim->latency_us;
+  sim->fall_us = sim->rise_us + hcsr04_sim_pulse_us(sim->distance_cm);
+
+  // bursts already on their way to us
+  for (int i = 0; i < sim->num_peers; i++) {
+    const hcsr04_sim_t *peer = sim->peers[i];
+    if (peer->rise_us >= 0)
+      hear(sim, peer->rise_us + sim->peer_delay_us[i]);
+  }
+  schedule_echo(sim);
+}
+
+void hcsr04_sim_init(hcsr04_sim_t *sim, gpio_num_t trig_pin,
+                     gpio_num_t echo_pin, float distance_cm) {
+  memset(sim, 0, sizeof(*sim));
+  sim->trig_pin = trig_pin;
+  sim->echo_pin = echo_pin;
+  sim->distance_cm = distance_cm;
+  sim->latency_us = HCSR04_SIM_LATENCY_US;
+  sim->rise_us = -1;
+  sim->fall_us = -1;
+}
+
+esp_err_t hcsr04_sim_attach(hcsr04_sim_t *sim) {
+  return gpio_mock_watch_output(sim->trig_pin, on_trigger, sim);
+}
+
+// Coupling is one-way, so the source's trigger watcher must see it too
+static void on_peer_trigger(void *ctx, gpio_num_t pin, int level) {
+  hcsr04_sim_t *listener = ctx;
+
+  if (level)
+    return;
+
+  for (int i = 0; i < listener->num_peers; i++) {
+    hcsr04_sim_t *source = listener->peers[i];
+    if (source->trig_pin != pin || source->rise_us < 0)
+      continue;
+    if (hear(listener, source->rise_us + listener->peer_delay_us[i]))
+      schedule_echo(listener);
+  }
+}
+
+esp_err_t hcsr04_sim_couple(hcsr04_sim_t *listener, hcsr04_sim_t *source,
+                            int64_t delay_us) {
+  if (listener->num_peers == HCSR04_SIM_MAX_PEERS)
+    return ESP_ERR_NO_MEM;
+
+  int i = listener->num_peers++;
+  listener->peers[i] = source;
+  listener->peer_delay_us[i] = delay_us;
+
+  // registered after source's own watcher, so its new burst time is known
+  return gpio_mock_watch_output(source->trig_pin, on_peer_trigger, listener);
+}
@@ -0,0 +1,436 @@
+/**
+ * @file i2c_mock.c command link recording and replay for host builds
+ */
+
+#include "i2c_mock.h"
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+  CMD_START,
+  CMD_WRITE,
+  CMD_READ,
+  CMD_STOP,
+} cmd_type_t;
+
+// One node per i2c_master_* call, like the real driver
+typedef struct cmd_node {
+  cmd_type_t type;
+  uint8_t byte; // single byte writes are copied
+  const uint8_t *data;
+  uint8_t *dest;
+  size_t len;
+  bool ack_en;
+  i2c_ack_type_t ack;
+  struct cmd_node *next;
+} cmd_node_t;
+
+typedef struct {
+  cmd_node_t *head;
+  cmd_node_t *tail;
+
+  // static links carve their nodes out of the caller's buffer
+  uint8_t *free_ptr;
+  size_t free_len;
+  bool is_static;
+} cmd_link_t;
+
+_Static_assert(sizeof(cmd_node_t) <= I2C_INTERNAL_STRUCT_SIZE,
+               "I2C_LINK_RECOMMENDED_SIZE would be too small");
+_Static_assert(sizeof(cmd_link_t) <= I2C_INTERNAL_STRUCT_SIZE,
+               "I2C_LINK_RECOMMENDED_SIZE would be too small");
+
+typedef struct {
+  uint8_t addr;
+  const i2c_mock_device_ops_t *ops;
+  void *ctx;
+
+  i2c_mock_fault_t fault;
+  uint32_t fault_skip;
+  uint32_t fault_count;
+} device_t;
+
+typedef struct {
+  bool installed;
+  uint32_t clk_speed;
+  device_t devices[I2C_MOCK_MAX_DEVICES];
+  int num_devices;
+  i2c_mock_stats_t stats;
+} bus_t;
+
+static bus_t buses[I2C_NUM_MAX];
+
+static bool valid_port(i2c_port_t port) {
+  return port >= 0 && port < I2C_NUM_MAX;
+}
+
+static device_t *find_device(bus_t *bus, uint8_t addr) {
+  for (int i = 0; i < bus->num_devices; i++) {
+    if (bus->devices[i].addr == addr)
+      return &bus->devices[i];
+  }
+  return NULL;
+}
+
+// -------- Device registry --------
+
+esp_err_t i2c_mock_attach(i2c_port_t port, uint8_t addr,
+                          const i2c_mock_device_ops_t *ops, void *ctx) {
+  if (!valid_port(port) || !ops)
+    return ESP_ERR_INVALID_ARG;
+
+  bus_t *bus = &buses[port];
+  device_t *dev = find_device(bus, addr);
+  if (!dev) {
+    if (bus->num_devices == I2C_MOCK_MAX_DEVICES)
+      return ESP_ERR_NO_MEM;
+    dev = &bus->devices[bus->num_devices++];
+  }
+
+  *dev = (device_t){.addr = addr, .ops = ops, .ctx = ctx};
+  return ESP_OK;
+}
+
+void i2c_mock_detach(i2c_port_t port, uint8_t addr) {
+  if (!valid_port(port))
+    return;
+
+  bus_t *bus = &buses[port];
+  device_t *dev = find_device(bus, addr);
+  if (dev)
+    *dev = bus->devices[--bus->num_devices];
+}
+
+esp_err_t i2c_mock_inject_fault(i2c_port_t port, uint8_t addr,
+                                i2c_mock_fault_t fault, uint32_t skip,
+                                uint32_t count) {
+  if (!valid_port(port))
+    return ESP_ERR_INVALID_ARG;
+
+  device_t *dev = find_device(&buses[port], addr);
+  if (!dev)
+    return ESP_ERR_NOT_FOUND;
+
+  dev->fault = fault;
+  dev->fault_skip = skip;
+  dev->fault_count = count;
+  return ESP_OK;
+}
+
+// Fault to apply to this transaction, counted once per transaction
+static i2c_mock_fault_t take_fault(device_t *dev) {
+  if (dev->fault == I2C_MOCK_FAULT_NONE || dev->fault_count == 0)
+    return I2C_MOCK_FAULT_NONE;
+  if (dev->fault_skip > 0) {
+    dev->fault_skip--;
+    return I2C_MOCK_FAULT_NONE;
+  }
+  dev->fault_count--;
+  return dev->fault;
+}
+
+void i2c_mock_reset(void) { memset(buses, 0, sizeof(buses)); }
+
+void i2c_mock_get_stats(i2c_port_t port, i2c_mock_stats_t *stats) {
+  if (valid_port(port))
+    *stats = buses[port].stats;
+}
+
+void i2c_mock_clear_stats(i2c_port_t port) {
+  if (valid_port(port))
+    memset(&buses[port].stats, 0, sizeof(buses[port].stats));
+}
+
+// -------- Driver setup --------
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf) {
+  if (!valid_port(i2c_num) || !i2c_conf)
+    return ESP_ERR_INVALID_ARG;
+
+  buses[i2c_num].clk_speed = i2c_conf->master.clk_speed;
+  return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode,
+                             size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags) {
+  (void)slv_rx_buf_len;
+  (void)slv_tx_buf_len;
+  (void)intr_alloc_flags;
+
+  if (!valid_port(i2c_num) || mode != I2C_MODE_MASTER)
+    return ESP_ERR_INVALID_ARG;
+  if (buses[i2c_num].installed)
+    return ESP_FAIL;
+
+  buses[i2c_num].installed = true;
+  return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num) {
+  if (!valid_port(i2c_num) || !buses[i2c_num].installed)
+    return ESP_ERR_INVALID_ARG;
+
+  buses[i2c_num].installed = false;
+  return ESP_OK;
+}
+
+// -------- Command links --------
+
+i2c_cmd_handle_t i2c_cmd_link_create(void) {
+  return calloc(1, sizeof(cmd_link_t));
+}
+
+// Next aligned chunk of a static link's buffer, NULL when it is used up
+static void *carve(uint8_t **ptr, size_t *len, size_t size) {
+  size_t pad = (alignof(max_align_t) - (uintptr_t)*ptr % alignof(max_align_t)) %
+               alignof(max_align_t);
+  if (*len < pad + size)
+    return NULL;
+
+  void *chunk = *ptr + pad;
+  *ptr += pad + size;
+  *len -= pad + size;
+  return chunk;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size) {
+  uint8_t *ptr = buffer;
+  size_t len = size;
+
+  if (!buffer)
+    return NULL;
+
+  cmd_link_t *link = carve(&ptr, &len, sizeof(*link));
+  if (!link)
+    return NULL;
+
+  *link = (cmd_link_t){.free_ptr = ptr, .free_len = len, .is_static = true};
+  return link;
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle) {
+  // everything lives in the caller's buffer, nothing to free
+  (void)cmd_handle;
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle) {
+  cmd_link_t *link = cmd_handle;
+  if (!link || link->is_static)
+    return;
+
+  for (cmd_node_t *node = link->head; node;) {
+    cmd_node_t *next = node->next;
+    free(node);
+    node = next;
+  }
+  free(link);
+}
+
+static esp_err_t append(i2c_cmd_handle_t cmd_handle, cmd_node_t cmd) {
+  cmd_link_t *link = cmd_handle;
+  if (!link)
+    return ESP_ERR_INVALID_ARG;
+
+  cmd_node_t *node = link->is_static
+                         ? carve(&link->free_ptr, &link->free_len, sizeof(*node))
+                         : malloc(sizeof(*node));
+  if (!node)
+    return ESP_ERR_NO_MEM;
+
+  *node = cmd;
+  node->next = NULL;
+  if (link->tail)
+    link->tail->next = node;
+  else
+    link->head = node;
+  link->tail = node;
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle) {
+  return append(cmd_handle, (cmd_node_t){.type = CMD_START});
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data,
+                                bool ack_en) {
+  return append(cmd_handle, (cmd_node_t){.type = CMD_WRITE,
+                                         .byte = data,
+                                         .len = 1,
+                                         .ack_en = ack_en});
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data,
+                           size_t data_len, bool ack_en) {
+  if (!data || data_len == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  // the buffer is referenced, not copied: it must outlive cmd_begin
+  return append(cmd_handle, (cmd_node_t){.type = CMD_WRITE,
+                                         .data = data,
+                                         .len = data_len,
+                                         .ack_en = ack_en});
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd_handle, uint8_t *data,
+                               i2c_ack_type_t ack) {
+  return i2c_master_read(cmd_handle, data, 1,
+                         ack == I2C_MASTER_LAST_NACK ? I2C_MASTER_NACK : ack);
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data,
+                          size_t data_len, i2c_ack_type_t ack) {
+  if (!data || data_len == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  return append(cmd_handle, (cmd_node_t){.type = CMD_READ,
+                                         .dest = data,
+                                         .len = data_len,
+                                         .ack = ack});
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle) {
+  return append(cmd_handle, (cmd_node_t){.type = CMD_STOP});
+}
+
+// -------- Bus replay --------
+
+static esp_err_t run_link(bus_t *bus, const cmd_link_t *link) {
+  device_t *active = NULL;
+  device_t *faulted = NULL; // device whose fault was drawn for this link
+  i2c_mock_fault_t fault = I2C_MOCK_FAULT_NONE;
+  bool expect_addr = false;
+
+  for (const cmd_node_t *cmd = link->head; cmd; cmd = cmd->next) {
+    switch (cmd->type) {
+    case CMD_START:
+      expect_addr = true;
+      break;
+
+    case CMD_WRITE:
+      for (size_t i = 0; i < cmd->len; i++) {
+        uint8_t byte = cmd->data ? cmd->data[i] : cmd->byte;
+        bool acked;
+
+        bus->stats.bytes_written++;
+        if (expect_addr) {
+          expect_addr = false;
+          active = find_device(bus, byte >> 1);
+          if (active && !faulted) {
+            faulted = active;
+            fault = take_fault(active);
+          }
+
+          if (active && fault == I2C_MOCK_FAULT_TIMEOUT)
+            return ESP_ERR_TIMEOUT;
+          acked = active && fault != I2C_MOCK_FAULT_NACK_ADDR &&
+                  active->ops->start(active->ctx, byte & 1);
+          if (!acked)
+            active = NULL;
+        } else if (fault == I2C_MOCK_FAULT_NACK_DATA && active) {
+          fault = I2C_MOCK_FAULT_NONE;
+          acked = false;
+        } else {
+          acked = active && active->ops->write(active->ctx, byte);
+        }
+
+        if (!acked && cmd->ack_en) {
+          // the controller aborts with a STOP on a NACK
+          if (active && active->ops->stop)
+            active->ops->stop(active->ctx);
+          return ESP_FAIL;
+        }
+      }
+      break;
+
+    case CMD_READ:
+      for (size_t i = 0; i < cmd->len; i++) {
+        cmd->dest[i] = active ? active->ops->read(active->ctx) : 0xFF;
+        bus->stats.bytes_read++;
+      }
+      break;
+
+    case CMD_STOP:
+      if (active && active->ops->stop)
+        active->ops->stop(active->ctx);
+      active = NULL;
+      break;
+    }
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle,
+                               TickType_t ticks_to_wait) {
+  (void)ticks_to_wait;
+
+  if (!valid_port(i2c_num) || !cmd_handle)
+    return ESP_ERR_INVALID_ARG;
+
+  bus_t *bus = &buses[i2c_num];
+  if (!bus->installed)
+    return ESP_ERR_INVALID_STATE;
+
+  bus->stats.transactions++;
+  esp_err_t ret = run_link(bus, cmd_handle);
+  if (ret != ESP_OK)
+    bus->stats.failed++;
+  return ret;
+}
+
+// -------- Convenience wrappers (same command sequences as the IDF) --------
+
+// Like the IDF, the helpers build their link on the stack, not the heap
+
+esp_err_t i2c_master_write_to_device(i2c_port_t i2c_num, uint8_t device_address,
+                                     const uint8_t *write_buffer,
+                                     size_t write_size,
+                                     TickType_t ticks_to_wait) {
+  uint8_t buffer[I2C_TRANS_BUF_MINIMUM_SIZE];
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(buffer, sizeof(buffer));
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (device_address << 1) | I2C_MASTER_WRITE, true);
+  i2c_master_write(cmd, write_buffer, write_size, true);
+  i2c_master_stop(cmd);
+  esp_err_t ret = i2c_master_cmd_begin(i2c_num, cmd, ticks_to_wait);
+  i2c_cmd_link_delete_static(cmd);
+  return ret;
+}
+
+esp_err_t i2c_master_read_from_device(i2c_port_t i2c_num,
+                                      uint8_t device_address,
+                                      uint8_t *read_buffer, size_t read_size,
+                                      TickType_t ticks_to_wait) {
+  uint8_t buffer[I2C_TRANS_BUF_MINIMUM_SIZE];
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(buffer, sizeof(buffer));
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (device_address << 1) | I2C_MASTER_READ, true);
+  i2c_master_read(cmd, read_buffer, read_size, I2C_MASTER_LAST_NACK);
+  i2c_master_stop(cmd);
+  esp_err_t ret = i2c_master_cmd_begin(i2c_num, cmd, ticks_to_wait);
+  i2c_cmd_link_delete_static(cmd);
+  return ret;
+}
+
+esp_err_t i2c_master_write_read_device(i2c_port_t i2c_num,
+                                       uint8_t device_address,
+                                       const uint8_t *write_buffer,
+                                       size_t write_size, uint8_t *read_buffer,
+                                       size_t read_size,
+                                       TickType_t ticks_to_wait) {
+  uint8_t buffer[I2C_TRANS_BUF_MINIMUM_SIZE];
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(buffer, sizeof(buffer));
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (device_address << 1) | I2C_MASTER_WRITE, true);
+  i2c_master_write(cmd, write_buffer, write_size, true);
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (device_address << 1) | I2C_MASTER_READ, true);
+  i2c_master_read(cmd, read_buffer, read_size, I2C_MASTER_LAST_NACK);
+  i2c_master_stop(cmd);
+  esp_err_t ret = i2c_master_cmd_begin(i2c_num, cmd, ticks_to_wait);
+  i2c_cmd_link_delete_static(cmd);
+  return ret;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file i2c.h host stand-in for the legacy ESP-IDF I2C master API
+ *
+ * Same types and calls as the real driver/i2c.h so driver code compiles
+ * unchanged. Command links are recorded and replayed by
+ * i2c_master_cmd_begin() against the devices attached with i2c_mock.h.
+ */
+
+#ifndef DRIVER_I2C_MOCK_H
+#define DRIVER_I2C_MOCK_H
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int i2c_port_t;
+#define I2C_NUM_0 0
+#define I2C_NUM_1 1
+#define I2C_NUM_MAX 2
+
+typedef enum {
+  I2C_MODE_SLAVE = 0,
+  I2C_MODE_MASTER,
+} i2c_mode_t;
+
+typedef enum {
+  I2C_MASTER_WRITE = 0,
+  I2C_MASTER_READ,
+} i2c_rw_t;
+
+typedef enum {
+  I2C_MASTER_ACK = 0,
+  I2C_MASTER_NACK = 1,
+  I2C_MASTER_LAST_NACK = 2,
+} i2c_ack_type_t;
+
+typedef struct {
+  i2c_mode_t mode;
+  int sda_io_num;
+  int scl_io_num;
+  bool sda_pullup_en;
+  bool scl_pullup_en;
+  union {
+    struct {
+      uint32_t clk_speed;
+    } master;
+    struct {
+      uint8_t addr_10bit_en;
+      uint16_t slave_addr;
+      uint32_t maximum_speed;
+    } slave;
+  };
+  uint32_t clk_flags;
+} i2c_config_t;
+
+typedef void *i2c_cmd_handle_t;
+
+// Size of one internal command node. The IDF value is 24 bytes on the ESP32;
+// the mock nodes hold host pointers, so the same formulas use a larger unit.
+#define I2C_INTERNAL_STRUCT_SIZE 64
+
+// Buffer for a static link of TRANSACTIONS user transfers (IDF formula)
+#define I2C_LINK_RECOMMENDED_SIZE(TRANSACTIONS)                              \
+  (2 * I2C_INTERNAL_STRUCT_SIZE + I2C_INTERNAL_STRUCT_SIZE * (5 * (TRANSACTIONS)))
+
+// Stack buffer the *_device helpers build their link in
+#define I2C_TRANS_BUF_MINIMUM_SIZE (9 * I2C_INTERNAL_STRUCT_SIZE)
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf);
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode,
+                             size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags);
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num);
+
+i2c_cmd_handle_t i2c_cmd_link_create(void);
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle);
+
+// Link whose commands are placed in buffer instead of the heap. NULL if the
+// buffer cannot even hold the link header; appending past the end of it
+// returns ESP_ERR_NO_MEM.
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size);
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle);
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle);
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data,
+                                bool ack_en);
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data,
+                           size_t data_len, bool ack_en);
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd_handle, uint8_t *data,
+                               i2c_ack_type_t ack);
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data,
+                          size_t data_len, i2c_ack_type_t ack);
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle);
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle,
+                               TickType_t ticks_to_wait);
+
+esp_err_t i2c_master_write_to_device(i2c_port_t i2c_num, uint8_t device_address,
+                                     const uint8_t *write_buffer,
+                                     size_t write_size,
+                                     TickType_t ticks_to_wait);
+esp_err_t i2c_master_read_from_device(i2c_port_t i2c_num,
+                                      uint8_t device_address,
+                                      uint8_t *read_buffer, size_t read_size,
+                                      TickType_t ticks_to_wait);
+esp_err_t i2c_master_write_read_device(i2c_port_t i2c_num,
+                                       uint8_t device_address,
+                                       const uint8_t *write_buffer,
+                                       size_t write_size, uint8_t *read_buffer,
+                                       size_t read_size,
+                                       TickType_t ticks_to_wait);
+
+#endif // DRIVER_I2C_MOCK_H
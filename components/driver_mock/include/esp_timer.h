@@ -0,0 +1,15 @@
+/**
+ * @file esp_timer.h host stand-in for esp_timer_get_time()
+ *
+ * Returns the simulated clock of gpio_mock.h, so edge timestamps taken by
+ * drivers match the times the test scheduled them at.
+ */
+
+#ifndef ESP_TIMER_MOCK_H
+#define ESP_TIMER_MOCK_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // ESP_TIMER_MOCK_H
@@ -0,0 +1,55 @@
+/**
+ * @file gpio_mock.h simulated pins, edges and clock behind the host GPIO driver
+ *
+ * Time only moves when the test calls gpio_mock_advance_us() (or, with a
+ * poll cost set, on every gpio_get_level()). Edges scheduled on input pins
+ * are applied in time order and run the pin's ISR handler in the context of
+ * the caller, like an interrupt would preempt it. esp_timer_get_time()
+ * returns the same clock, so drivers timestamp edges in simulated time.
+ */
+
+#ifndef GPIO_MOCK_H
+#define GPIO_MOCK_H
+
+#include "driver/gpio.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_MOCK_MAX_EVENTS 32
+#define GPIO_MOCK_MAX_WATCHERS 8
+
+// Called when the firmware drives an output pin to a new level
+typedef void (*gpio_mock_output_cb_t)(void *ctx, gpio_num_t pin, int level);
+
+typedef struct {
+  uint32_t level_reads; // gpio_get_level() calls outside ISR handlers
+  uint32_t isr_calls;   // handlers run for simulated edges
+  uint32_t edges;       // input level changes applied
+} gpio_mock_stats_t;
+
+// All pins low, no handlers, no pending edges, clock back to 0
+void gpio_mock_reset(void);
+
+int64_t gpio_mock_now_us(void);
+
+// Apply every edge due up to now + us, then set the clock to now + us
+void gpio_mock_advance_us(int64_t us);
+
+// Drive an input pin to level at simulated time at_us (>= now)
+esp_err_t gpio_mock_schedule(gpio_num_t pin, int level, int64_t at_us);
+// Drop the edges still pending on pin
+void gpio_mock_cancel(gpio_num_t pin);
+// Time of the next pending edge, or -1
+int64_t gpio_mock_next_event_us(void);
+
+// Watch an output pin, e.g. the trigger of a simulated sensor
+esp_err_t gpio_mock_watch_output(gpio_num_t pin, gpio_mock_output_cb_t cb,
+                                 void *ctx);
+
+// Simulated cost of one gpio_get_level() call, models a busy-wait loop
+void gpio_mock_set_poll_cost_us(int64_t us);
+
+void gpio_mock_get_stats(gpio_mock_stats_t *stats);
+void gpio_mock_clear_stats(void);
+
+#endif // GPIO_MOCK_H
@@ -0,0 +1,57 @@
+/**
+ * @file hcsr04_sim.h HC-SR04 ultrasonic ranger model for host tests
+ *
+ * Watches the trigger pin through gpio_mock.h. On the falling edge of the
+ * trigger pulse it schedules the echo pin high after latency_us and low
+ * again after the round trip of distance_cm at 343 m/s, the same constant
+ * the driver converts with.
+ *
+ * Sensors can be coupled: a sensor that hears another one's burst while it
+ * is listening ends its echo early, at the burst time plus the direct path
+ * delay, which is how crosstalk corrupts a reading on real hardware.
+ */
+
+#ifndef HCSR04_SIM_H
+#define HCSR04_SIM_H
+
+#include "gpio_mock.h"
+#include <stdbool.h>
+
+#define HCSR04_SIM_LATENCY_US 450 // 8-cycle 40 kHz burst plus settling
+#define HCSR04_SIM_US_PER_CM (2.0f / 0.0343f)
+#define HCSR04_SIM_MAX_PEERS 4
+
+typedef struct hcsr04_sim hcsr04_sim_t;
+
+struct hcsr04_sim {
+  gpio_num_t trig_pin;
+  gpio_num_t echo_pin;
+  float distance_cm;
+  int64_t latency_us;
+  bool no_echo; // nothing in range: the echo pin never rises
+
+  // sensors whose bursts this one hears, and after how long
+  hcsr04_sim_t *peers[HCSR04_SIM_MAX_PEERS];
+  int64_t peer_delay_us[HCSR04_SIM_MAX_PEERS];
+  int num_peers;
+
+  // current ping, -1 when none
+  int64_t rise_us;
+  int64_t fall_us;
+
+  uint32_t pings;     // trigger pulses seen
+  uint32_t crosstalk; // echoes cut short by a peer's burst
+};
+
+void hcsr04_sim_init(hcsr04_sim_t *sim, gpio_num_t trig_pin,
+                     gpio_num_t echo_pin, float distance_cm);
+esp_err_t hcsr04_sim_attach(hcsr04_sim_t *sim);
+
+// listener hears source's bursts delay_us after they start
+esp_err_t hcsr04_sim_couple(hcsr04_sim_t *listener, hcsr04_sim_t *source,
+                            int64_t delay_us);
+
+// Echo pulse width for distance_cm
+int64_t hcsr04_sim_pulse_us(float distance_cm);
+
+#endif // HCSR04_SIM_H
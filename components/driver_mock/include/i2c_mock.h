@@ -0,0 +1,55 @@
+/**
+ * @file i2c_mock.h simulated devices behind the host I2C driver
+ *
+ * A device is a set of callbacks for the bus events of one slave address.
+ * i2c_master_cmd_begin() plays each command link against them, so drivers
+ * see the same ACK/NACK and data behaviour they would on hardware.
+ */
+
+#ifndef I2C_MOCK_H
+#define I2C_MOCK_H
+
+#include "driver/i2c.h"
+
+#define I2C_MOCK_MAX_DEVICES 8
+
+typedef struct {
+  // START or repeated START addressed to the device, false NACKs the address
+  bool (*start)(void *ctx, bool read);
+  // byte sent by the master, false NACKs it
+  bool (*write)(void *ctx, uint8_t byte);
+  // byte requested by the master
+  uint8_t (*read)(void *ctx);
+  void (*stop)(void *ctx);
+} i2c_mock_device_ops_t;
+
+typedef enum {
+  I2C_MOCK_FAULT_NONE,
+  I2C_MOCK_FAULT_NACK_ADDR, // address byte not acknowledged
+  I2C_MOCK_FAULT_NACK_DATA, // first byte written after the address NACKed
+  I2C_MOCK_FAULT_TIMEOUT,   // SCL held low, cmd_begin gives up
+} i2c_mock_fault_t;
+
+typedef struct {
+  uint32_t transactions; // i2c_master_cmd_begin() calls
+  uint32_t failed;       // transactions that did not return ESP_OK
+  uint32_t bytes_written;
+  uint32_t bytes_read;
+} i2c_mock_stats_t;
+
+esp_err_t i2c_mock_attach(i2c_port_t port, uint8_t addr,
+                          const i2c_mock_device_ops_t *ops, void *ctx);
+void i2c_mock_detach(i2c_port_t port, uint8_t addr);
+
+// Let `skip` transactions to addr through, then fail the next `count` ones
+esp_err_t i2c_mock_inject_fault(i2c_port_t port, uint8_t addr,
+                                i2c_mock_fault_t fault, uint32_t skip,
+                                uint32_t count);
+
+// detach every device, uninstall the drivers and clear the statistics
+void i2c_mock_reset(void);
+
+void i2c_mock_get_stats(i2c_port_t port, i2c_mock_stats_t *stats);
+void i2c_mock_clear_stats(i2c_port_t port);
+
+#endif // I2C_MOCK_H
@@ -0,0 +1,85 @@
+/**
+ * @file mpu6050_sim.h register-level MPU-6050 model for host tests
+ *
+ * The model keeps the 128-byte register file, the register pointer
+ * auto-increment, the sample-rate divider and the 1024-byte FIFO with its
+ * overflow behaviour (oldest bytes overwritten, FIFO_OFLOW_INT raised).
+ * Time only moves when the test calls mpu6050_sim_advance_us(). Samples come
+ * from a source callback: a counter ramp by default, or a motion_data
+ * recording through mpu6050_sim_csv_source().
+ */
+
+#ifndef MPU6050_SIM_H
+#define MPU6050_SIM_H
+
+#include "driver/i2c.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MPU6050_SIM_FIFO_SIZE 1024
+#define MPU6050_SIM_TEMP_25C (-3920) // (25 - 36.53) * 340 LSB
+
+// One sample: accel x/y/z, temperature, gyro x/y/z in raw LSB
+typedef enum {
+  MPU6050_SIM_AX,
+  MPU6050_SIM_AY,
+  MPU6050_SIM_AZ,
+  MPU6050_SIM_TEMP,
+  MPU6050_SIM_GX,
+  MPU6050_SIM_GY,
+  MPU6050_SIM_GZ,
+  MPU6050_SIM_NUM_CHANNELS
+} mpu6050_sim_channel_t;
+
+// Produces sample number `index`, taken at t_us of simulated time
+typedef void (*mpu6050_sim_source_t)(void *ctx, uint32_t index, int64_t t_us,
+                                     int16_t out[MPU6050_SIM_NUM_CHANNELS]);
+
+typedef struct {
+  uint8_t regs[128];
+  uint8_t reg_ptr;
+  bool reg_ptr_pending; // next written byte is the register address
+
+  uint8_t fifo[MPU6050_SIM_FIFO_SIZE];
+  int fifo_head;
+  int fifo_len;
+
+  int64_t now_us;
+  int64_t next_sample_us;
+  uint32_t samples; // samples produced since init, also while sleeping
+  uint32_t fifo_overflows;
+
+  mpu6050_sim_source_t source;
+  void *source_ctx;
+} mpu6050_sim_t;
+
+// Power-on state: asleep, WHO_AM_I = 0x68, default sample counter source
+void mpu6050_sim_init(mpu6050_sim_t *sim);
+esp_err_t mpu6050_sim_attach(mpu6050_sim_t *sim, i2c_port_t port,
+                             uint8_t addr);
+void mpu6050_sim_set_source(mpu6050_sim_t *sim, mpu6050_sim_source_t source,
+                            void *ctx);
+
+// Run the sample clock; produces every sample due in the interval
+void mpu6050_sim_advance_us(mpu6050_sim_t *sim, int64_t us);
+int64_t mpu6050_sim_sample_period_us(const mpu6050_sim_t *sim);
+
+// -------- motion_data recordings --------
+
+typedef struct {
+  int16_t (*rows)[MPU6050_SIM_NUM_CHANNELS];
+  int num_rows;
+} mpu6050_sim_csv_t;
+
+/**
+ * Load a time_ms,accel_mag_g,gyro_mag_dps recording. Each magnitude is
+ * spread evenly over the three axes, so the engine computes it back.
+ */
+esp_err_t mpu6050_sim_csv_load(mpu6050_sim_csv_t *csv, const char *path);
+void mpu6050_sim_csv_free(mpu6050_sim_csv_t *csv);
+
+// Source callback (ctx = mpu6050_sim_csv_t *): one row per sample, looping
+void mpu6050_sim_csv_source(void *ctx, uint32_t index, int64_t t_us,
+                            int16_t out[MPU6050_SIM_NUM_CHANNELS]);
+
+#endif // MPU6050_SIM_H
@@ -0,0 +1,261 @@
+/**
+ * @file mpu6050_sim.c MPU-6050 register file, sample clock and FIFO model
+ */
+
+#include "mpu6050_sim.h"
+#include "i2c_mock.h"
+#include <string.h>
+
+// Register map (MPU-6000/6050 register map rev 4.2)
+#define REG_SMPLRT_DIV 0x19
+#define REG_CONFIG 0x1A
+#define REG_FIFO_EN 0x23
+#define REG_INT_ENABLE 0x38
+#define REG_INT_STATUS 0x3A
+#define REG_ACCEL_XOUT_H 0x3B
+#define REG_GYRO_ZOUT_L 0x48
+#define REG_USER_CTRL 0x6A
+#define REG_PWR_MGMT_1 0x6B
+#define REG_FIFO_COUNTH 0x72
+#define REG_FIFO_COUNTL 0x73
+#define REG_FIFO_R_W 0x74
+#define REG_WHO_AM_I 0x75
+
+#define FIFO_EN_TEMP 0x80
+#define FIFO_EN_XG 0x40
+#define FIFO_EN_YG 0x20
+#define FIFO_EN_ZG 0x10
+#define FIFO_EN_ACCEL 0x08
+
+#define INT_FIFO_OFLOW 0x10
+#define INT_DATA_RDY 0x01
+
+#define USER_CTRL_FIFO_EN 0x40
+#define USER_CTRL_FIFO_RESET 0x04
+
+#define PWR_DEVICE_RESET 0x80
+#define PWR_SLEEP 0x40
+
+// Default source: a ramp on accel X so tests can check ordering, 1 g on Z
+static void counter_source(void *ctx, uint32_t index, int64_t t_us,
+                           int16_t out[MPU6050_SIM_NUM_CHANNELS]) {
+  (void)ctx;
+  (void)t_us;
+
+  memset(out, 0, MPU6050_SIM_NUM_CHANNELS * sizeof(out[0]));
+  out[MPU6050_SIM_AX] = (int16_t)index;
+  out[MPU6050_SIM_AZ] = 16384;
+  out[MPU6050_SIM_TEMP] = MPU6050_SIM_TEMP_25C;
+  out[MPU6050_SIM_GX] = (int16_t)-index;
+}
+
+static void reset_registers(mpu6050_sim_t *sim) {
+  memset(sim->regs, 0, sizeof(sim->regs));
+  sim->regs[REG_PWR_MGMT_1] = PWR_SLEEP;
+  sim->regs[REG_WHO_AM_I] = 0x68;
+  sim->fifo_head = 0;
+  sim->fifo_len = 0;
+}
+
+void mpu6050_sim_init(mpu6050_sim_t *sim) {
+  memset(sim, 0, sizeof(*sim));
+  reset_registers(sim);
+  sim->source = counter_source;
+  sim->next_sample_us = mpu6050_sim_sample_period_us(sim);
+}
+
+void mpu6050_sim_set_source(mpu6050_sim_t *sim, mpu6050_sim_source_t source,
+                            void *ctx) {
+  sim->source = source ? source : counter_source;
+  sim->source_ctx = ctx;
+}
+
+int64_t mpu6050_sim_sample_period_us(const mpu6050_sim_t *sim) {
+  // gyro output rate is 8 kHz with the DLPF off (DLPF_CFG 0 or 7), else 1 kHz
+  int dlpf = sim->regs[REG_CONFIG] & 0x07;
+  int64_t base_us = (dlpf == 0 || dlpf == 7) ? 125 : 1000;
+  return base_us * (1 + sim->regs[REG_SMPLRT_DIV]);
+}
+
+// -------- FIFO --------
+
+static void fifo_push(mpu6050_sim_t *sim, uint8_t byte) {
+  int tail = (sim->fifo_head + sim->fifo_len) % MPU6050_SIM_FIFO_SIZE;
+
+  sim->fifo[tail] = byte;
+  if (sim->fifo_len < MPU6050_SIM_FIFO_SIZE) {
+    sim->fifo_len++;
+    return;
+  }
+
+  // full: the new byte replaced the oldest one
+  sim->fifo_head = (sim->fifo_head + 1) % MPU6050_SIM_FIFO_SIZE;
+  if (!(sim->regs[REG_INT_STATUS] & INT_FIFO_OFLOW))
+    sim->fifo_overflows++;
+  sim->regs[REG_INT_STATUS] |= INT_FIFO_OFLOW;
+}
+
+static uint8_t fifo_pop(mpu6050_sim_t *sim) {
+  if (sim->fifo_len == 0)
+    return 0xFF;
+
+  uint8_t byte = sim->fifo[sim->fifo_head];
+  sim->fifo_head = (sim->fifo_head + 1) % MPU6050_SIM_FIFO_SIZE;
+  sim->fifo_len--;
+  return byte;
+}
+
+// -------- Sample clock --------
+
+static void produce_sample(mpu6050_sim_t *sim) {
+  int16_t values[MPU6050_SIM_NUM_CHANNELS];
+  uint8_t *out = &sim->regs[REG_ACCEL_XOUT_H];
+
+  sim->source(sim->source_ctx, sim->samples++, sim->next_sample_us, values);
+  if (sim->regs[REG_PWR_MGMT_1] & PWR_SLEEP)
+    return;
+
+  // output registers are big-endian and laid out in channel order
+  for (int c = 0; c < MPU6050_SIM_NUM_CHANNELS; c++) {
+    out[2 * c] = (uint8_t)((uint16_t)values[c] >> 8);
+    out[2 * c + 1] = (uint8_t)values[c];
+  }
+  sim->regs[REG_INT_STATUS] |= INT_DATA_RDY;
+
+  if (!(sim->regs[REG_USER_CTRL] & USER_CTRL_FIFO_EN))
+    return;
+
+  // FIFO order follows the register addresses: accel, temp, gyro x/y/z
+  uint8_t enabled = sim->regs[REG_FIFO_EN];
+  static const struct {
+    uint8_t mask;
+    int first;
+    int bytes;
+  } groups[] = {
+      {FIFO_EN_ACCEL, 0, 6}, {FIFO_EN_TEMP, 6, 2}, {FIFO_EN_XG, 8, 2},
+      {FIFO_EN_YG, 10, 2},   {FIFO_EN_ZG, 12, 2},
+  };
+  for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++) {
+    if (!(enabled & groups[g].mask))
+      continue;
+    for (int b = 0; b < groups[g].bytes; b++)
+      fifo_push(sim, out[groups[g].first + b]);
+  }
+}
+
+void mpu6050_sim_advance_us(mpu6050_sim_t *sim, int64_t us) {
+  int64_t end = sim->now_us + us;
+
+  while (sim->next_sample_us <= end) {
+    sim->now_us = sim->next_sample_us;
+    produce_sample(sim);
+    // the divider is re-read every sample, like the hardware
+    sim->next_sample_us += mpu6050_sim_sample_period_us(sim);
+  }
+  sim->now_us = end;
+}
+
+// -------- Register access --------
+
+static void write_register(mpu6050_sim_t *sim, uint8_t reg, uint8_t value) {
+  switch (reg) {
+  case REG_INT_STATUS:
+  case REG_FIFO_COUNTH:
+  case REG_FIFO_COUNTL:
+  case REG_WHO_AM_I:
+    return; // read-only
+
+  case REG_FIFO_R_W:
+    fifo_push(sim, value);
+    return;
+
+  case REG_USER_CTRL:
+    if (value & USER_CTRL_FIFO_RESET) {
+      sim->fifo_head = 0;
+      sim->fifo_len = 0;
+    }
+    sim->regs[reg] = value & ~USER_CTRL_FIFO_RESET; // self-clearing
+    return;
+
+  case REG_PWR_MGMT_1:
+    if (value & PWR_DEVICE_RESET) {
+      reset_registers(sim);
+      return;
+    }
+    break;
+
+  default:
+    if (reg >= REG_ACCEL_XOUT_H && reg <= REG_GYRO_ZOUT_L)
+      return; // sensor outputs
+    break;
+  }
+
+  sim->regs[reg] = value;
+}
+
+static uint8_t read_register(mpu6050_sim_t *sim, uint8_t reg) {
+  uint8_t value;
+
+  switch (reg) {
+  case REG_INT_STATUS:
+    value = sim->regs[reg];
+    sim->regs[reg] = 0; // cleared on read
+    return value;
+
+  case REG_FIFO_COUNTH:
+    return (uint8_t)(sim->fifo_len >> 8);
+
+  case REG_FIFO_COUNTL:
+    return (uint8_t)sim->fifo_len;
+
+  case REG_FIFO_R_W:
+    return fifo_pop(sim);
+
+  default:
+    return sim->regs[reg];
+  }
+}
+
+// -------- Bus callbacks --------
+
+static bool sim_start(void *ctx, bool read) {
+  mpu6050_sim_t *sim = ctx;
+  sim->reg_ptr_pending = !read;
+  return true;
+}
+
+static bool sim_write(void *ctx, uint8_t byte) {
+  mpu6050_sim_t *sim = ctx;
+
+  if (sim->reg_ptr_pending) {
+    sim->reg_ptr = byte & 0x7F;
+    sim->reg_ptr_pending = false;
+    return true;
+  }
+
+  write_register(sim, sim->reg_ptr, byte);
+  if (sim->reg_ptr != REG_FIFO_R_W)
+    sim->reg_ptr = (sim->reg_ptr + 1) & 0x7F;
+  return true;
+}
+
+static uint8_t sim_read(void *ctx) {
+  mpu6050_sim_t *sim = ctx;
+  uint8_t value = read_register(sim, sim->reg_ptr);
+
+  // burst reads of FIFO_R_W keep draining the FIFO
+  if (sim->reg_ptr != REG_FIFO_R_W)
+    sim->reg_ptr = (sim->reg_ptr + 1) & 0x7F;
+  return value;
+}
+
+static const i2c_mock_device_ops_t sim_ops = {
+    .start = sim_start,
+    .write = sim_write,
+    .read = sim_read,
+};
+
+esp_err_t mpu6050_sim_attach(mpu6050_sim_t *sim, i2c_port_t port,
+                             uint8_t addr) {
+  return i2c_mock_attach(port, addr, &sim_ops, sim);
+}
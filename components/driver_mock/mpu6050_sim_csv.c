@@ -0,0 +1,84 @@
+/**
+ * @file mpu6050_sim_csv.c motion_data recordings as MPU-6050 sample source
+ */
+
+#include "mpu6050_sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ACCEL_LSB_PER_G 16384.0f
+#define GYRO_LSB_PER_DPS 131.0f
+
+static int16_t to_lsb(float value) {
+  long v = lroundf(value);
+  if (v > INT16_MAX)
+    return INT16_MAX;
+  if (v < INT16_MIN)
+    return INT16_MIN;
+  return (int16_t)v;
+}
+
+esp_err_t mpu6050_sim_csv_load(mpu6050_sim_csv_t *csv, const char *path) {
+  const float axis = 1.0f / sqrtf(3.0f);
+  int capacity = 1024;
+  char line[128];
+
+  memset(csv, 0, sizeof(*csv));
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return ESP_ERR_NOT_FOUND;
+
+  csv->rows = malloc(capacity * sizeof(csv->rows[0]));
+  if (!csv->rows) {
+    fclose(f);
+    return ESP_ERR_NO_MEM;
+  }
+
+  while (fgets(line, sizeof(line), f)) {
+    float time_ms, accel_g, gyro_dps;
+    if (sscanf(line, "%f,%f,%f", &time_ms, &accel_g, &gyro_dps) != 3)
+      continue; // header or blank line
+
+    if (csv->num_rows == capacity) {
+      void *grown = realloc(csv->rows, 2 * capacity * sizeof(csv->rows[0]));
+      if (!grown) {
+        fclose(f);
+        mpu6050_sim_csv_free(csv);
+        return ESP_ERR_NO_MEM;
+      }
+      csv->rows = grown;
+      capacity *= 2;
+    }
+
+    int16_t *row = csv->rows[csv->num_rows++];
+    int16_t a = to_lsb(accel_g * ACCEL_LSB_PER_G * axis);
+    int16_t g = to_lsb(gyro_dps * GYRO_LSB_PER_DPS * axis);
+    row[MPU6050_SIM_AX] = row[MPU6050_SIM_AY] = row[MPU6050_SIM_AZ] = a;
+    row[MPU6050_SIM_TEMP] = MPU6050_SIM_TEMP_25C;
+    row[MPU6050_SIM_GX] = row[MPU6050_SIM_GY] = row[MPU6050_SIM_GZ] = g;
+  }
+
+  fclose(f);
+  if (csv->num_rows == 0) {
+    mpu6050_sim_csv_free(csv);
+    return ESP_ERR_INVALID_SIZE;
+  }
+  return ESP_OK;
+}
+
+void mpu6050_sim_csv_free(mpu6050_sim_csv_t *csv) {
+  free(csv->rows);
+  csv->rows = NULL;
+  csv->num_rows = 0;
+}
+
+void mpu6050_sim_csv_source(void *ctx, uint32_t index, int64_t t_us,
+                            int16_t out[MPU6050_SIM_NUM_CHANNELS]) {
+  const mpu6050_sim_csv_t *csv = ctx;
+  (void)t_us;
+
+  memcpy(out, csv->rows[index % csv->num_rows],
+         MPU6050_SIM_NUM_CHANNELS * sizeof(out[0]));
+}
@@ -0,0 +1,229 @@
+/**
+ * @file heap_telemetry.c slot folding, the least-squares slope, alerts and
+ * the snapshot encoding
+ */
+
+#include "heap_telemetry.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const uint32_t default_caps[HEAP_TELEMETRY_MAX_CAPS] = {
+    MALLOC_CAP_DEFAULT, MALLOC_CAP_DMA,    MALLOC_CAP_8BIT,
+    MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM,
+};
+
+static void probe_heap_caps(uint32_t caps, heap_telemetry_reading_t *out,
+                            void *ctx) {
+  out->free = heap_caps_get_free_size(caps);
+  out->largest = heap_caps_get_largest_free_block(caps);
+  out->min_free = heap_caps_get_minimum_free_size(caps);
+  out->total = heap_caps_get_total_size(caps);
+}
+
+static uint32_t now_ms(void) {
+  return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+uint16_t heap_telemetry_frag_permille(size_t free, size_t largest) {
+  if (free == 0 || largest >= free)
+    return 0;
+  return (uint16_t)(1000 - (uint64_t)largest * 1000 / free);
+}
+
+// -------- Setup --------
+
+esp_err_t heap_telemetry_init(heap_telemetry_t *tm,
+                              const heap_telemetry_config_t *config) {
+  if (!tm || !config || config->num_caps < 0 ||
+      config->num_caps > HEAP_TELEMETRY_MAX_CAPS)
+    return ESP_ERR_INVALID_ARG;
+
+  memset(tm, 0, sizeof(*tm));
+  tm->config = *config;
+  if (!tm->config.probe)
+    tm->config.probe = probe_heap_caps;
+  if (tm->config.num_caps == 0) {
+    memcpy(tm->config.caps, default_caps, sizeof(default_caps));
+    tm->config.num_caps = HEAP_TELEMETRY_MAX_CAPS;
+  }
+
+  // keep the capabilities this chip has memory for
+  int kept = 0;
+  for (int i = 0; i < tm->config.num_caps; i++) {
+    heap_telemetry_reading_t r;
+    tm->config.probe(tm->config.caps[i], &r, tm->config.probe_ctx);
+    if (r.total == 0)
+      continue;
+    tm->config.caps[kept] = tm->config.caps[i];
+    tm->trends[kept].caps = tm->config.caps[i];
+    tm->trends[kept].total = r.total;
+    kept++;
+  }
+  tm->config.num_caps = kept;
+  return kept ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+// -------- Trends --------
+
+// Least squares over the ring, in integers so the sums stay exact: times
+// relative to the oldest slot in ms, sizes in bytes
+static float slope_bytes_per_min(const heap_telemetry_t *tm, int cap) {
+  if (tm->count < 2)
+    return 0;
+
+  uint32_t t0 = tm->ring[tm->head].time_ms;
+  int64_t n = tm->count, st = 0, sf = 0, stt = 0, stf = 0;
+  for (int i = 0; i < tm->count; i++) {
+    const heap_telemetry_slot_t *s =
+        &tm->ring[(tm->head + i) % HEAP_TELEMETRY_RING_LEN];
+    int64_t t = (uint32_t)(s->time_ms - t0);
+    int64_t f = s->caps[cap].free;
+    st += t;
+    sf += f;
+    stt += t * t;
+    stf += t * f;
+  }
+
+  int64_t denom = n * stt - st * st;
+  if (denom == 0)
+    return 0;
+  return (float)(n * stf - st * sf) / (float)denom * 60000.0f;
+}
+
+static uint8_t check(const heap_telemetry_t *tm,
+                     const heap_telemetry_trend_t *trend) {
+  const heap_telemetry_config_t *c = &tm->config;
+  uint8_t alerts = 0;
+
+  if (c->low_free_bytes && trend->last.free < c->low_free_bytes)
+    alerts |= HEAP_ALERT_LOW_FREE;
+  if (c->frag_permille && trend->last.frag_permille > c->frag_permille)
+    alerts |= HEAP_ALERT_FRAGMENTED;
+  if (c->leak_bytes_per_min > 0 && tm->count >= c->min_slots &&
+      trend->slope_bytes_per_min < -c->leak_bytes_per_min)
+    alerts |= HEAP_ALERT_LEAK;
+  return alerts;
+}
+
+static void close_slot(heap_telemetry_t *tm) {
+  int tail = (tm->head + tm->count) % HEAP_TELEMETRY_RING_LEN;
+
+  tm->ring[tail] = tm->pending;
+  if (tm->count == HEAP_TELEMETRY_RING_LEN)
+    tm->head = (tm->head + 1) % HEAP_TELEMETRY_RING_LEN;
+  else
+    tm->count++;
+  tm->slots++;
+  tm->pending_samples = 0;
+
+  for (int i = 0; i < tm->config.num_caps; i++) {
+    heap_telemetry_trend_t *trend = &tm->trends[i];
+    trend->last = tm->ring[tail].caps[i];
+    trend->slope_bytes_per_min = slope_bytes_per_min(tm, i);
+
+    uint8_t alerts = check(tm, trend);
+    uint8_t raised = alerts & ~trend->alerts;
+    trend->alerts = alerts;
+    if (raised && tm->config.on_alert)
+      tm->config.on_alert(trend, raised, tm->config.alert_ctx);
+  }
+}
+
+void heap_telemetry_sample(heap_telemetry_t *tm) {
+  uint32_t now = now_ms();
+
+  if (tm->pending_samples &&
+      (uint32_t)(now - tm->pending_start_ms) >= tm->config.slot_ms)
+    close_slot(tm);
+  if (tm->pending_samples == 0)
+    tm->pending_start_ms = now;
+
+  for (int i = 0; i < tm->config.num_caps; i++) {
+    heap_telemetry_reading_t r;
+    tm->config.probe(tm->config.caps[i], &r, tm->config.probe_ctx);
+
+    heap_telemetry_point_t *p = &tm->pending.caps[i];
+    uint16_t frag = heap_telemetry_frag_permille(r.free, r.largest);
+    if (tm->pending_samples == 0 || r.free < p->free)
+      p->free = r.free;
+    if (tm->pending_samples == 0 || r.largest < p->largest)
+      p->largest = r.largest;
+    if (tm->pending_samples == 0 || frag > p->frag_permille)
+      p->frag_permille = frag;
+    tm->trends[i].min_free = r.min_free;
+  }
+  tm->pending.time_ms = now;
+  tm->pending_samples++;
+}
+
+int heap_telemetry_num_caps(const heap_telemetry_t *tm) {
+  return tm->config.num_caps;
+}
+
+const heap_telemetry_trend_t *heap_telemetry_trend(const heap_telemetry_t *tm,
+                                                   int index) {
+  if (index < 0 || index >= tm->config.num_caps)
+    return NULL;
+  return &tm->trends[index];
+}
+
+// -------- Snapshot --------
+
+static uint8_t *put_le(uint8_t *p, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    *p++ = v >> (8 * i);
+  return p;
+}
+
+size_t heap_telemetry_snapshot(const heap_telemetry_t *tm, uint8_t *buf,
+                               size_t size) {
+  int num_caps = tm->config.num_caps;
+  size_t len = HEAP_TELEMETRY_HEADER_LEN + num_caps * HEAP_TELEMETRY_CAP_LEN +
+               tm->count * HEAP_TELEMETRY_SLOT_LEN(num_caps);
+  if (size < len)
+    return 0;
+
+  uint8_t *p = put_le(buf, HEAP_TELEMETRY_MAGIC, 2);
+  *p++ = HEAP_TELEMETRY_VERSION;
+  *p++ = num_caps;
+  p = put_le(p, tm->count, 2);
+  p = put_le(p, tm->config.slot_ms / 1000, 2);
+
+  for (int i = 0; i < num_caps; i++) {
+    const heap_telemetry_trend_t *t = &tm->trends[i];
+    p = put_le(p, t->caps, 4);
+    p = put_le(p, t->total, 4);
+    p = put_le(p, t->min_free, 4);
+    // whole bytes per hour keep a slow leak visible in an integer
+    p = put_le(p, (uint32_t)(int32_t)(t->slope_bytes_per_min * 60), 4);
+    p = put_le(p, t->last.frag_permille, 2);
+    *p++ = t->alerts;
+  }
+
+  for (int k = 0; k < tm->count; k++) {
+    const heap_telemetry_slot_t *s =
+        &tm->ring[(tm->head + k) % HEAP_TELEMETRY_RING_LEN];
+    p = put_le(p, s->time_ms, 4);
+    for (int i = 0; i < num_caps; i++) {
+      p = put_le(p, s->caps[i].free, 4);
+      p = put_le(p, s->caps[i].largest, 4);
+      p = put_le(p, s->caps[i].frag_permille, 2);
+    }
+  }
+  return p - buf;
+}
+
+void heap_telemetry_print(const heap_telemetry_t *tm) {
+  static uint8_t buf[HEAP_TELEMETRY_SNAPSHOT_MAX]; // off the caller's stack
+  size_t len = heap_telemetry_snapshot(tm, buf, sizeof(buf));
+
+  // one line even with other tasks printing
+  flockfile(stdout);
+  fputs(HEAP_TELEMETRY_PREFIX ",", stdout);
+  for (size_t i = 0; i < len; i++)
+    printf("%02x", buf[i]);
+  putchar('\n');
+  funlockfile(stdout);
+}
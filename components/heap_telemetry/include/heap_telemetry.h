@@ -0,0 +1,139 @@
+/**
+ * @file heap_telemetry.h heap trends per capability in a fixed ring, with
+ * alerts and a binary snapshot
+ *
+ * heap_telemetry_sample() reads free size, largest free block and the
+ * fragmentation index of every tracked capability (DEFAULT, DMA, 8BIT,
+ * INTERNAL, SPIRAM). Nothing is formatted. Samples fold into slots of
+ * slot_ms: a slot keeps the lowest free size, the lowest largest block and
+ * the worst fragmentation seen in it, so a task that allocates and frees
+ * in a cycle shorter than a slot shows up as a flat floor rather than as
+ * noise. Each closed slot goes into a ring of HEAP_TELEMETRY_RING_LEN.
+ *
+ * When a slot closes, a least-squares line through the ring's free sizes
+ * gives the leak slope in bytes per minute, and the thresholds are checked.
+ * on_alert is called when an alert starts; it clears once the condition is
+ * gone. The ring spans RING_LEN slots, so a minute slot fits a leak
+ * over the last hour.
+ *
+ * heap_telemetry_snapshot() packs the trends and the ring into a few KB of
+ * little-endian bytes for tools/heap_telemetry_decode.py. Sampling, trends
+ * and snapshot belong to one task.
+ */
+
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HEAP_TELEMETRY_MAX_CAPS 5
+#define HEAP_TELEMETRY_RING_LEN 60
+#define HEAP_TELEMETRY_MAGIC 0x5448 // "HT"
+#define HEAP_TELEMETRY_VERSION 1
+#define HEAP_TELEMETRY_PREFIX "heap_telemetry" // start of a hex snapshot line
+
+// magic u16, version u8, num_caps u8, count u16, slot_s u16
+#define HEAP_TELEMETRY_HEADER_LEN 8
+// caps u32, total u32, min_free u32, slope (bytes/h) i32, frag u16, alerts u8
+#define HEAP_TELEMETRY_CAP_LEN 19
+// end time_ms u32, then per cap free u32, largest u32, frag u16
+#define HEAP_TELEMETRY_SLOT_LEN(num_caps) (4 + 10 * (num_caps))
+#define HEAP_TELEMETRY_SNAPSHOT_MAX                                            \
+  (HEAP_TELEMETRY_HEADER_LEN +                                                 \
+   HEAP_TELEMETRY_MAX_CAPS * HEAP_TELEMETRY_CAP_LEN +                          \
+   HEAP_TELEMETRY_RING_LEN * HEAP_TELEMETRY_SLOT_LEN(HEAP_TELEMETRY_MAX_CAPS))
+
+typedef enum {
+  HEAP_ALERT_LOW_FREE = 1 << 0,   // free below low_free_bytes
+  HEAP_ALERT_FRAGMENTED = 1 << 1, // fragmentation above frag_permille
+  HEAP_ALERT_LEAK = 1 << 2,       // free falling faster than the leak rate
+} heap_alert_t;
+
+typedef struct {
+  size_t free;
+  size_t largest;  // largest free block
+  size_t min_free; // lowest since boot
+  size_t total;
+} heap_telemetry_reading_t;
+
+typedef struct {
+  uint32_t free;          // lowest in the slot
+  uint32_t largest;       // lowest in the slot
+  uint16_t frag_permille; // worst in the slot
+} heap_telemetry_point_t;
+
+typedef struct {
+  uint32_t time_ms; // last sample of the slot, ms since boot
+  heap_telemetry_point_t caps[HEAP_TELEMETRY_MAX_CAPS];
+} heap_telemetry_slot_t;
+
+typedef struct {
+  uint32_t caps;
+  uint32_t total;
+  uint32_t min_free;
+  heap_telemetry_point_t last;  // the latest closed slot
+  float slope_bytes_per_min;    // over the ring, negative when shrinking
+  uint8_t alerts;               // heap_alert_t bits active now
+} heap_telemetry_trend_t;
+
+// Reads one capability; heap_caps_* when the config leaves it NULL
+typedef void (*heap_telemetry_probe_t)(uint32_t caps,
+                                       heap_telemetry_reading_t *out,
+                                       void *ctx);
+// raised: the heap_alert_t bits that just became active
+typedef void (*heap_telemetry_alert_t)(const heap_telemetry_trend_t *trend,
+                                       uint8_t raised, void *ctx);
+
+typedef struct {
+  uint32_t caps[HEAP_TELEMETRY_MAX_CAPS]; // num_caps 0: all five
+  int num_caps;
+  uint32_t slot_ms;
+  // 0 turns a check off
+  uint32_t low_free_bytes;
+  uint16_t frag_permille;
+  float leak_bytes_per_min;
+  int min_slots; // slots in the fit before a leak can be called
+  heap_telemetry_probe_t probe;
+  void *probe_ctx;
+  heap_telemetry_alert_t on_alert;
+  void *alert_ctx;
+} heap_telemetry_config_t;
+
+typedef struct {
+  heap_telemetry_config_t config; // caps without a heap dropped
+  heap_telemetry_slot_t ring[HEAP_TELEMETRY_RING_LEN];
+  int head; // oldest slot
+  int count;
+  uint32_t slots; // closed since init
+  heap_telemetry_slot_t pending; // the slot being filled
+  uint32_t pending_start_ms;
+  int pending_samples;
+  heap_telemetry_trend_t trends[HEAP_TELEMETRY_MAX_CAPS];
+} heap_telemetry_t;
+
+// Capabilities with no heap on this chip (no PSRAM) are dropped
+esp_err_t heap_telemetry_init(heap_telemetry_t *tm,
+                              const heap_telemetry_config_t *config);
+
+// Read every capability; closes the slot once slot_ms has passed
+void heap_telemetry_sample(heap_telemetry_t *tm);
+
+int heap_telemetry_num_caps(const heap_telemetry_t *tm);
+const heap_telemetry_trend_t *heap_telemetry_trend(const heap_telemetry_t *tm,
+                                                   int index);
+
+// 1000 * (1 - largest / free), 0 when nothing is free
+uint16_t heap_telemetry_frag_permille(size_t free, size_t largest);
+
+// Pack header, trends and ring, oldest slot first. Returns the length, 0
+// when size is too small (HEAP_TELEMETRY_SNAPSHOT_MAX always fits).
+size_t heap_telemetry_snapshot(const heap_telemetry_t *tm, uint8_t *buf,
+                               size_t size);
+
+// The snapshot as one hex line, "heap_telemetry,<hex>", on stdout
+void heap_telemetry_print(const heap_telemetry_t *tm);
+
+#endif // HEAP_TELEMETRY_H
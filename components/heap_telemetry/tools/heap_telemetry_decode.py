@@ -0,0 +1,146 @@
+"""
+Decode heap_telemetry snapshots from a console capture.
+
+heap_telemetry_print() writes a snapshot as one line of hex after the
+"heap_telemetry," prefix, mixed with any other output:
+    python heap_telemetry_decode.py capture.log
+For every capability the tool prints the latest slot, the leak slope and,
+when free memory is falling, how long until it runs out at that rate.
+--slots adds the ring, oldest slot first; --csv writes the ring as CSV
+instead, one row per slot and capability, for plotting. Only the last
+snapshot in the capture is decoded unless --all is given.
+"""
+
+import argparse
+import struct
+import sys
+
+PREFIX = "heap_telemetry,"  # HEAP_TELEMETRY_PREFIX
+MAGIC = 0x5448  # HEAP_TELEMETRY_MAGIC
+VERSION = 1
+HEADER = struct.Struct("<HBBHH")  # magic, version, num_caps, count, slot_s
+CAP = struct.Struct("<IIIiHB")  # caps, total, min_free, slope B/h, frag, alerts
+POINT = struct.Struct("<IIH")  # free, largest, frag
+ALERTS = ((1, "LOW_FREE"), (2, "FRAGMENTED"), (4, "LEAK"))
+# esp_heap_caps.h bits, named in the order the firmware tracks them
+CAP_NAMES = ((1 << 12, "DEFAULT"), (1 << 3, "DMA"), (1 << 2, "8BIT"),
+             (1 << 11, "INTERNAL"), (1 << 10, "SPIRAM"))
+
+
+def cap_name(caps):
+    names = [name for bit, name in CAP_NAMES if caps & bit]
+    return "|".join(names) if names else "0x%x" % caps
+
+
+def alert_names(bits):
+    return ",".join(name for bit, name in ALERTS if bits & bit) or "-"
+
+
+def decode(data):
+    """The snapshot as (slot_s, caps, slots), or None when damaged."""
+    if len(data) < HEADER.size:
+        return None
+    magic, version, num_caps, count, slot_s = HEADER.unpack_from(data)
+    slot_len = 4 + POINT.size * num_caps
+    if (magic != MAGIC or version != VERSION or
+            len(data) != HEADER.size + num_caps * CAP.size + count * slot_len):
+        return None
+
+    caps, pos = [], HEADER.size
+    for _ in range(num_caps):
+        bits, total, min_free, slope_h, frag, alerts = CAP.unpack_from(data, pos)
+        caps.append({"caps": bits, "total": total, "min_free": min_free,
+                     "slope": slope_h / 60.0, "frag": frag,
+                     "alerts": alerts})
+        pos += CAP.size
+
+    slots = []
+    for _ in range(count):
+        time_ms, = struct.unpack_from("<I", data, pos)
+        pos += 4
+        points = []
+        for _ in range(num_caps):
+            points.append(POINT.unpack_from(data, pos))
+            pos += POINT.size
+        slots.append((time_ms, points))
+    return slot_s, caps, slots
+
+
+def parse(path):
+    """Every snapshot in the capture, in order."""
+    snapshots = []
+    with open(path, errors="replace") as f:
+        for line in f:
+            # the line may follow a log prefix or other text on the console
+            start = line.find(PREFIX)
+            if start < 0:
+                continue
+            try:
+                data = bytes.fromhex(line[start + len(PREFIX):].strip())
+            except ValueError:
+                continue  # cut short
+            snapshot = decode(data)
+            if snapshot:
+                snapshots.append(snapshot)
+    return snapshots
+
+
+def print_summary(snapshot, show_slots):
+    slot_s, caps, slots = snapshot
+    span = (slots[-1][0] - slots[0][0]) / 60000.0 if len(slots) > 1 else 0
+    print("%d slot(s) of %d s, %.0f min" % (len(slots), slot_s, span))
+    print("%-10s %9s %9s %9s %9s %6s %10s %9s  %s" %
+          ("caps", "total", "free", "largest", "min free", "frag",
+           "B/min", "to empty", "alerts"))
+    for i, c in enumerate(caps):
+        free, largest, frag = slots[-1][1][i] if slots else (0, 0, c["frag"])
+        to_empty = "-"
+        if c["slope"] < 0:
+            to_empty = "%.1f h" % (free / -c["slope"] / 60)
+        print("%-10s %9d %9d %9d %9d %5.1f%% %+10.1f %9s  %s" %
+              (cap_name(c["caps"]), c["total"], free, largest, c["min_free"],
+               frag / 10.0, c["slope"], to_empty, alert_names(c["alerts"])))
+
+    if show_slots:
+        for time_ms, points in slots:
+            print("%10.1f s  " % (time_ms / 1000.0) +
+                  "  ".join("%d/%d" % (free, largest)
+                            for free, largest, _ in points))
+
+
+def print_csv(snapshot):
+    _, caps, slots = snapshot
+    print("time_ms,caps,free,largest,frag_permille")
+    for time_ms, points in slots:
+        for c, (free, largest, frag) in zip(caps, points):
+            print("%d,%s,%d,%d,%d" % (time_ms, cap_name(c["caps"]), free,
+                                      largest, frag))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode heap_telemetry snapshots from a capture.")
+    parser.add_argument("capture", help="console capture")
+    parser.add_argument("--all", action="store_true",
+                        help="every snapshot, not just the last one")
+    parser.add_argument("--slots", action="store_true",
+                        help="also print the ring, free/largest per slot")
+    parser.add_argument("--csv", action="store_true",
+                        help="the ring as CSV instead of the summary")
+    args = parser.parse_args()
+
+    snapshots = parse(args.capture)
+    if not snapshots:
+        sys.exit("%s: no heap_telemetry snapshot" % args.capture)
+    for i, snapshot in enumerate(snapshots if args.all else snapshots[-1:]):
+        if args.csv:
+            print_csv(snapshot)
+            continue
+        if i:
+            print()
+        print_summary(snapshot, args.slots)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,133 @@
+/**
+ * @file i2c_async.c bus task and submission queue
+ */
+
+#include "i2c_async.h"
+
+#define TIMEOUT_TICKS (I2C_ASYNC_TIMEOUT_MS / portTICK_PERIOD_MS)
+
+static esp_err_t execute(i2c_port_t port, const i2c_async_txn_t *txn) {
+  if (txn->cmd)
+    return i2c_master_cmd_begin(port, txn->cmd, TIMEOUT_TICKS);
+
+  if (txn->write_len && txn->read_len)
+    return i2c_master_write_read_device(port, txn->addr, txn->write_buf,
+                                        txn->write_len, txn->read_buf,
+                                        txn->read_len, TIMEOUT_TICKS);
+  if (txn->read_len)
+    return i2c_master_read_from_device(port, txn->addr, txn->read_buf,
+                                       txn->read_len, TIMEOUT_TICKS);
+  if (txn->write_len)
+    return i2c_master_write_to_device(port, txn->addr, txn->write_buf,
+                                      txn->write_len, TIMEOUT_TICKS);
+  return ESP_ERR_INVALID_ARG;
+}
+
+static void bus_task(void *arg) {
+  i2c_async_t *bus = arg;
+  i2c_async_txn_t *txn;
+
+  while (xQueueReceive(bus->queue, &txn, portMAX_DELAY) == pdTRUE) {
+    if (!txn)
+      break; // stop request, everything before it has run
+
+    txn->result = execute(bus->port, txn);
+    if (txn->result == ESP_OK)
+      bus->completed++;
+    else
+      bus->failed++;
+
+    // notify last: the submitter may reuse txn as soon as it wakes up
+    i2c_async_cb_t callback = txn->callback;
+    TaskHandle_t notify = txn->notify;
+    if (callback)
+      callback(txn, txn->cb_arg);
+    __atomic_store_n(&txn->done, true, __ATOMIC_RELEASE);
+    if (notify)
+      xTaskNotifyGive(notify);
+  }
+
+  TaskHandle_t stopper = bus->stopper;
+  __atomic_store_n(&bus->stopped, true, __ATOMIC_RELEASE);
+  xTaskNotifyGive(stopper);
+  vTaskDelete(NULL);
+}
+
+esp_err_t i2c_async_start(i2c_async_t *bus, i2c_port_t port, int queue_len,
+                          UBaseType_t priority) {
+  *bus = (i2c_async_t){.port = port};
+
+  bus->queue = xQueueCreate(queue_len, sizeof(i2c_async_txn_t *));
+  if (!bus->queue)
+    return ESP_ERR_NO_MEM;
+
+  if (xTaskCreate(bus_task, "i2c_async", I2C_ASYNC_TASK_STACK, bus, priority,
+                  &bus->task) != pdPASS) {
+    vQueueDelete(bus->queue);
+    bus->queue = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+void i2c_async_stop(i2c_async_t *bus) {
+  i2c_async_txn_t *stop = NULL;
+
+  if (!bus->queue)
+    return;
+
+  bus->stopper = xTaskGetCurrentTaskHandle();
+  xQueueSend(bus->queue, &stop, portMAX_DELAY);
+  while (!__atomic_load_n(&bus->stopped, __ATOMIC_ACQUIRE))
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+  vQueueDelete(bus->queue);
+  bus->queue = NULL;
+  bus->task = NULL;
+}
+
+void i2c_async_txn_read_regs(i2c_async_txn_t *txn, uint8_t addr,
+                             const uint8_t *reg, uint8_t *data, size_t len) {
+  *txn = (i2c_async_txn_t){
+      .addr = addr,
+      .write_buf = reg,
+      .write_len = 1,
+      .read_buf = data,
+      .read_len = len,
+  };
+}
+
+esp_err_t i2c_async_submit(i2c_async_t *bus, i2c_async_txn_t *txn,
+                           TickType_t wait) {
+  if (!bus->queue || !txn)
+    return ESP_ERR_INVALID_STATE;
+
+  txn->done = false;
+  txn->result = ESP_ERR_INVALID_STATE;
+  if (xQueueSend(bus->queue, &txn, wait) != pdTRUE)
+    return ESP_ERR_TIMEOUT;
+  return ESP_OK;
+}
+
+esp_err_t i2c_async_wait(i2c_async_txn_t *txn, TickType_t wait) {
+  TickType_t start = xTaskGetTickCount();
+
+  // other transactions of the same task may notify first: count them out
+  while (!__atomic_load_n(&txn->done, __ATOMIC_ACQUIRE)) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (wait != portMAX_DELAY && elapsed >= wait)
+      return ESP_ERR_TIMEOUT;
+    ulTaskNotifyTake(pdFALSE, wait == portMAX_DELAY ? wait : wait - elapsed);
+  }
+  return txn->result;
+}
+
+esp_err_t i2c_async_transfer(i2c_async_t *bus, i2c_async_txn_t *txn,
+                             TickType_t wait) {
+  txn->notify = xTaskGetCurrentTaskHandle();
+
+  esp_err_t ret = i2c_async_submit(bus, txn, wait);
+  if (ret != ESP_OK)
+    return ret;
+  return i2c_async_wait(txn, portMAX_DELAY);
+}
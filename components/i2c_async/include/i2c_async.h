@@ -0,0 +1,80 @@
+/**
+ * @file i2c_async.h asynchronous I2C transactions through a bus task
+ *
+ * One task owns the port and runs transactions in submission order, so
+ * every device on the bus gets its turn and the submitting tasks keep
+ * computing while their transfer is on the wire. Completion is reported by
+ * callback (in the bus task) and/or a task notification to the submitter.
+ */
+
+#ifndef I2C_ASYNC_H
+#define I2C_ASYNC_H
+
+#include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define I2C_ASYNC_TASK_STACK 3072
+#define I2C_ASYNC_TIMEOUT_MS 100 // per transaction, inside the bus task
+
+typedef struct i2c_async_txn i2c_async_txn_t;
+typedef void (*i2c_async_cb_t)(i2c_async_txn_t *txn, void *arg);
+
+/**
+ * One transfer. Either a prebuilt command link (cmd), or a write of
+ * write_len bytes followed by a repeated-START read of read_len bytes;
+ * either length may be 0. The descriptor and its buffers belong to the
+ * bus task from submit until completion.
+ */
+struct i2c_async_txn {
+  uint8_t addr;
+  const uint8_t *write_buf;
+  size_t write_len;
+  uint8_t *read_buf;
+  size_t read_len;
+  i2c_cmd_handle_t cmd;
+
+  i2c_async_cb_t callback; // runs in the bus task, short and no resubmit
+  void *cb_arg;
+  TaskHandle_t notify; // receives xTaskNotifyGive() when done
+
+  esp_err_t result;
+  volatile bool done;
+};
+
+typedef struct {
+  i2c_port_t port;
+  QueueHandle_t queue; // i2c_async_txn_t *, NULL asks the task to exit
+  TaskHandle_t task;
+  TaskHandle_t stopper;
+  volatile bool stopped;
+
+  uint32_t completed;
+  uint32_t failed;
+} i2c_async_t;
+
+// The I2C driver must already be installed on port
+esp_err_t i2c_async_start(i2c_async_t *bus, i2c_port_t port, int queue_len,
+                          UBaseType_t priority);
+// Finishes the queued transactions, then deletes the task and the queue
+void i2c_async_stop(i2c_async_t *bus);
+
+// Register read as one transaction: write reg, repeated START, read len
+void i2c_async_txn_read_regs(i2c_async_txn_t *txn, uint8_t addr,
+                             const uint8_t *reg, uint8_t *data, size_t len);
+
+// ESP_ERR_TIMEOUT when the queue stayed full for `wait` ticks
+esp_err_t i2c_async_submit(i2c_async_t *bus, i2c_async_txn_t *txn,
+                           TickType_t wait);
+
+// Block the submitter until txn is done (needs txn->notify set to it)
+esp_err_t i2c_async_wait(i2c_async_txn_t *txn, TickType_t wait);
+
+// Submit and wait, for callers that have nothing to overlap
+esp_err_t i2c_async_transfer(i2c_async_t *bus, i2c_async_txn_t *txn,
+                             TickType_t wait);
+
+#endif // I2C_ASYNC_H
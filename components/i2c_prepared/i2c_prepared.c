@@ -0,0 +1,74 @@
+/**
+ * @file i2c_prepared.c static command links for repeated transactions
+ */
+
+#include "i2c_prepared.h"
+
+// txn may be uninitialised: an old link in link_buf is simply overwritten
+static esp_err_t begin(i2c_prepared_t *txn, i2c_port_t port, uint8_t addr) {
+  txn->port = port;
+  txn->addr = addr;
+  txn->cmd = i2c_cmd_link_create_static(txn->link_buf, sizeof(txn->link_buf));
+  return txn->cmd ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// Keep the descriptor unbuilt if any command did not fit
+static esp_err_t finish(i2c_prepared_t *txn, esp_err_t ret) {
+  if (ret != ESP_OK)
+    i2c_prepared_release(txn);
+  return ret;
+}
+
+esp_err_t i2c_prepared_probe(i2c_prepared_t *txn, i2c_port_t port,
+                             uint8_t addr) {
+  esp_err_t ret = begin(txn, port, addr);
+
+  if (ret == ESP_OK)
+    ret = i2c_master_start(txn->cmd);
+  if (ret == ESP_OK)
+    ret = i2c_master_write_byte(txn->cmd, (addr << 1) | I2C_MASTER_WRITE,
+                                true);
+  if (ret == ESP_OK)
+    ret = i2c_master_stop(txn->cmd);
+  return finish(txn, ret);
+}
+
+esp_err_t i2c_prepared_read_regs(i2c_prepared_t *txn, i2c_port_t port,
+                                 uint8_t addr, uint8_t reg, uint8_t *data,
+                                 size_t len) {
+  // bad arguments still go through finish(): callers release txn either way
+  esp_err_t ret = begin(txn, port, addr);
+  if (ret == ESP_OK && (!data || len == 0))
+    ret = ESP_ERR_INVALID_ARG;
+
+  // register address, then repeated START into the read phase
+  if (ret == ESP_OK)
+    ret = i2c_master_start(txn->cmd);
+  if (ret == ESP_OK)
+    ret = i2c_master_write_byte(txn->cmd, (addr << 1) | I2C_MASTER_WRITE,
+                                true);
+  if (ret == ESP_OK)
+    ret = i2c_master_write_byte(txn->cmd, reg, true);
+  if (ret == ESP_OK)
+    ret = i2c_master_start(txn->cmd);
+  if (ret == ESP_OK)
+    ret = i2c_master_write_byte(txn->cmd, (addr << 1) | I2C_MASTER_READ,
+                                true);
+  if (ret == ESP_OK)
+    ret = i2c_master_read(txn->cmd, data, len, I2C_MASTER_LAST_NACK);
+  if (ret == ESP_OK)
+    ret = i2c_master_stop(txn->cmd);
+  return finish(txn, ret);
+}
+
+esp_err_t i2c_prepared_run(const i2c_prepared_t *txn, TickType_t wait) {
+  if (!txn->cmd)
+    return ESP_ERR_INVALID_STATE;
+  return i2c_master_cmd_begin(txn->port, txn->cmd, wait);
+}
+
+void i2c_prepared_release(i2c_prepared_t *txn) {
+  if (txn->cmd)
+    i2c_cmd_link_delete_static(txn->cmd);
+  txn->cmd = NULL;
+}
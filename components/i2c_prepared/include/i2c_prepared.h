@@ -0,0 +1,52 @@
+/**
+ * @file i2c_prepared.h I2C transactions built once and run many times
+ *
+ * The command link of a prepared transaction lives in a buffer inside the
+ * descriptor (i2c_cmd_link_create_static), so neither building nor running
+ * it touches the heap. Build the descriptor outside the sampling loop, then
+ * call i2c_prepared_run() once per sample: the read lands in the buffer
+ * given at build time.
+ *
+ * The link points into the descriptor: build it where it stays (static or
+ * a long-lived struct) and do not copy it afterwards.
+ */
+
+#ifndef I2C_PREPARED_H
+#define I2C_PREPARED_H
+
+#include "driver/i2c.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// register select plus repeated-START read, with room to spare
+#define I2C_PREPARED_LINK_SIZE I2C_LINK_RECOMMENDED_SIZE(2)
+
+typedef struct {
+  i2c_port_t port;
+  uint8_t addr;
+  i2c_cmd_handle_t cmd; // NULL until built
+  uint8_t link_buf[I2C_PREPARED_LINK_SIZE];
+} i2c_prepared_t;
+
+// The builders accept an uninitialised txn. On failure it is left unbuilt,
+// so i2c_prepared_release() is always safe afterwards.
+
+// START, address + write, STOP: ESP_OK when the device ACKs
+esp_err_t i2c_prepared_probe(i2c_prepared_t *txn, i2c_port_t port,
+                             uint8_t addr);
+
+// Write reg, repeated START, read len bytes into data. data must outlive txn.
+esp_err_t i2c_prepared_read_regs(i2c_prepared_t *txn, i2c_port_t port,
+                                 uint8_t addr, uint8_t reg, uint8_t *data,
+                                 size_t len);
+
+static inline bool i2c_prepared_ready(const i2c_prepared_t *txn) {
+  return txn->cmd != NULL;
+}
+
+esp_err_t i2c_prepared_run(const i2c_prepared_t *txn, TickType_t wait);
+
+// Forget the link, the descriptor can be built again afterwards
+void i2c_prepared_release(i2c_prepared_t *txn);
+
+#endif // I2C_PREPARED_H
@@ -0,0 +1,413 @@
+/**
+ * @file i2c_profiler.c I2C driver call wrappers and statistics
+ *
+ * With I2C_PROFILER_WRAP the linker sends every i2c_master_* call here
+ * (__wrap_*) before the driver (__real_*). The commands appended to a link
+ * are tallied per handle, so a link built once and executed many times is
+ * still attributed to its device.
+ */
+
+#include "i2c_profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <time.h>
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#define PROF_LOCK() pthread_mutex_lock(&lock)
+#define PROF_UNLOCK() pthread_mutex_unlock(&lock)
+
+static inline int64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#else
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+#define PROF_LOCK() taskENTER_CRITICAL(&lock)
+#define PROF_UNLOCK() taskEXIT_CRITICAL(&lock)
+
+static inline int64_t now_us(void) { return esp_timer_get_time(); }
+#endif
+
+#define CLOCKS_PER_BYTE 9 // 8 data bits + ACK
+#define CLOCKS_START 1
+#define CLOCKS_STOP 1
+#define DEFAULT_CLK_HZ 100000
+
+// What one command link puts on the bus each time it runs
+typedef struct {
+  i2c_cmd_handle_t handle;
+  uint8_t addr;
+  bool expect_addr;
+  uint32_t bytes_written;
+  uint32_t bytes_read;
+  uint32_t clocks;
+} link_info_t;
+
+static i2c_prof_device_t devices[I2C_PROF_MAX_DEVICES];
+static int num_devices;
+static i2c_prof_device_t other; // devices past the table size
+
+static uint32_t clk_hz[I2C_NUM_MAX] = {DEFAULT_CLK_HZ, DEFAULT_CLK_HZ};
+
+// -------- Public API --------
+
+bool i2c_prof_enabled(void) {
+#if I2C_PROFILER_WRAP
+  return true;
+#else
+  return false;
+#endif
+}
+
+void i2c_prof_set_clock(i2c_port_t port, uint32_t hz) {
+  if (port >= 0 && port < I2C_NUM_MAX)
+    clk_hz[port] = hz;
+}
+
+bool i2c_prof_get(i2c_port_t port, uint8_t addr, i2c_prof_device_t *out) {
+  bool found = false;
+
+  PROF_LOCK();
+  for (int i = 0; i < num_devices && !found; i++) {
+    if (devices[i].port == port && devices[i].addr == addr) {
+      *out = devices[i];
+      found = true;
+    }
+  }
+  PROF_UNLOCK();
+  return found;
+}
+
+void i2c_prof_reset(void) {
+  PROF_LOCK();
+  memset(devices, 0, sizeof(devices));
+  memset(&other, 0, sizeof(other));
+  num_devices = 0;
+  PROF_UNLOCK();
+}
+
+static void print_row(const char *name, const i2c_prof_device_t *d) {
+  printf("%-9s %6lu %5lu %9lu %9lu %11.2f %8lu %8lu\n", name,
+         (unsigned long)d->transactions, (unsigned long)d->failed,
+         (unsigned long)d->bytes_written, (unsigned long)d->bytes_read,
+         d->bus_time_us / 1000.0,
+         (unsigned long)(d->transactions ? d->latency_us / d->transactions
+                                         : 0),
+         (unsigned long)d->max_latency_us);
+}
+
+void i2c_prof_dump(void) {
+  static i2c_prof_device_t snapshot[I2C_PROF_MAX_DEVICES + 1];
+  i2c_prof_device_t total = {0};
+  char name[16];
+
+  PROF_LOCK();
+  int n = num_devices;
+  memcpy(snapshot, devices, n * sizeof(devices[0]));
+  snapshot[n] = other;
+  PROF_UNLOCK();
+
+  printf("I2C profile%s\n", i2c_prof_enabled() ? "" : " (disabled)");
+  printf("%-9s %6s %5s %9s %9s %11s %8s %8s\n", "port/addr", "txns", "fail",
+         "wr bytes", "rd bytes", "bus ms est", "avg us", "max us");
+
+  for (int i = 0; i <= n; i++) {
+    const i2c_prof_device_t *d = &snapshot[i];
+    if (d->transactions == 0)
+      continue;
+
+    if (i == n)
+      snprintf(name, sizeof(name), "other");
+    else if (d->addr == I2C_PROF_ADDR_NONE)
+      snprintf(name, sizeof(name), "%d/--", d->port);
+    else
+      snprintf(name, sizeof(name), "%d/0x%02x", d->port, d->addr);
+    print_row(name, d);
+
+    total.transactions += d->transactions;
+    total.failed += d->failed;
+    total.bytes_written += d->bytes_written;
+    total.bytes_read += d->bytes_read;
+    total.bus_time_us += d->bus_time_us;
+    total.latency_us += d->latency_us;
+    if (d->max_latency_us > total.max_latency_us)
+      total.max_latency_us = d->max_latency_us;
+  }
+  print_row("total", &total);
+}
+
+#if I2C_PROFILER_WRAP
+
+// -------- Bookkeeping (called with the lock held) --------
+
+static link_info_t links[I2C_PROF_MAX_LINKS];
+static int next_evict;
+
+static link_info_t *find_link(i2c_cmd_handle_t handle, bool create) {
+  for (int i = 0; i < I2C_PROF_MAX_LINKS; i++) {
+    if (links[i].handle == handle)
+      return &links[i];
+  }
+  if (!create)
+    return NULL;
+
+  link_info_t *link = NULL;
+  for (int i = 0; i < I2C_PROF_MAX_LINKS && !link; i++) {
+    if (!links[i].handle)
+      link = &links[i];
+  }
+  if (!link) {
+    // more links in flight than slots: forget the oldest one
+    link = &links[next_evict];
+    next_evict = (next_evict + 1) % I2C_PROF_MAX_LINKS;
+  }
+
+  *link = (link_info_t){.handle = handle, .addr = I2C_PROF_ADDR_NONE};
+  return link;
+}
+
+static i2c_prof_device_t *find_device(i2c_port_t port, uint8_t addr) {
+  for (int i = 0; i < num_devices; i++) {
+    if (devices[i].port == port && devices[i].addr == addr)
+      return &devices[i];
+  }
+  if (num_devices == I2C_PROF_MAX_DEVICES)
+    return &other;
+
+  i2c_prof_device_t *dev = &devices[num_devices++];
+  *dev = (i2c_prof_device_t){.port = port, .addr = addr};
+  return dev;
+}
+
+static void record(i2c_port_t port, uint8_t addr, uint32_t bytes_written,
+                   uint32_t bytes_read, uint32_t clocks, int64_t latency_us,
+                   esp_err_t ret) {
+  uint32_t hz = (port >= 0 && port < I2C_NUM_MAX) ? clk_hz[port] : 0;
+  i2c_prof_device_t *dev = find_device(port, addr);
+
+  dev->transactions++;
+  dev->failed += ret != ESP_OK;
+  dev->bytes_written += bytes_written;
+  dev->bytes_read += bytes_read;
+  dev->bus_clocks += clocks;
+  dev->bus_time_us = hz ? dev->bus_clocks * 1000000 / hz : 0;
+  dev->latency_us += latency_us;
+  if (latency_us > dev->max_latency_us)
+    dev->max_latency_us = latency_us;
+}
+
+// -------- Driver wrappers --------
+
+esp_err_t __real_i2c_param_config(i2c_port_t i2c_num,
+                                  const i2c_config_t *i2c_conf);
+void __real_i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle);
+i2c_cmd_handle_t __real_i2c_cmd_link_create_static(uint8_t *buffer,
+                                                   uint32_t size);
+void __real_i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle);
+esp_err_t __real_i2c_master_start(i2c_cmd_handle_t cmd_handle);
+esp_err_t __real_i2c_master_write_byte(i2c_cmd_handle_t cmd_handle,
+                                       uint8_t data, bool ack_en);
+esp_err_t __real_i2c_master_write(i2c_cmd_handle_t cmd_handle,
+                                  const uint8_t *data, size_t data_len,
+                                  bool ack_en);
+esp_err_t __real_i2c_master_read_byte(i2c_cmd_handle_t cmd_handle,
+                                      uint8_t *data, i2c_ack_type_t ack);
+esp_err_t __real_i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data,
+                                 size_t data_len, i2c_ack_type_t ack);
+esp_err_t __real_i2c_master_stop(i2c_cmd_handle_t cmd_handle);
+esp_err_t __real_i2c_master_cmd_begin(i2c_port_t i2c_num,
+                                      i2c_cmd_handle_t cmd_handle,
+                                      TickType_t ticks_to_wait);
+esp_err_t __real_i2c_master_write_to_device(i2c_port_t i2c_num,
+                                            uint8_t device_address,
+                                            const uint8_t *write_buffer,
+                                            size_t write_size,
+                                            TickType_t ticks_to_wait);
+esp_err_t __real_i2c_master_read_from_device(i2c_port_t i2c_num,
+                                             uint8_t device_address,
+                                             uint8_t *read_buffer,
+                                             size_t read_size,
+                                             TickType_t ticks_to_wait);
+esp_err_t __real_i2c_master_write_read_device(
+    i2c_port_t i2c_num, uint8_t device_address, const uint8_t *write_buffer,
+    size_t write_size, uint8_t *read_buffer, size_t read_size,
+    TickType_t ticks_to_wait);
+
+esp_err_t __wrap_i2c_param_config(i2c_port_t i2c_num,
+                                  const i2c_config_t *i2c_conf) {
+  if (i2c_conf && i2c_conf->mode == I2C_MODE_MASTER)
+    i2c_prof_set_clock(i2c_num, i2c_conf->master.clk_speed);
+  return __real_i2c_param_config(i2c_num, i2c_conf);
+}
+
+static void forget_link(i2c_cmd_handle_t cmd_handle) {
+  PROF_LOCK();
+  link_info_t *link = find_link(cmd_handle, false);
+  if (link)
+    link->handle = NULL;
+  PROF_UNLOCK();
+}
+
+void __wrap_i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle) {
+  forget_link(cmd_handle);
+  __real_i2c_cmd_link_delete(cmd_handle);
+}
+
+// Static links reuse their buffer address: a rebuilt link starts from zero
+i2c_cmd_handle_t __wrap_i2c_cmd_link_create_static(uint8_t *buffer,
+                                                   uint32_t size) {
+  i2c_cmd_handle_t cmd_handle = __real_i2c_cmd_link_create_static(buffer, size);
+  if (cmd_handle)
+    forget_link(cmd_handle);
+  return cmd_handle;
+}
+
+void __wrap_i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle) {
+  forget_link(cmd_handle);
+  __real_i2c_cmd_link_delete_static(cmd_handle);
+}
+
+esp_err_t __wrap_i2c_master_start(i2c_cmd_handle_t cmd_handle) {
+  PROF_LOCK();
+  link_info_t *link = find_link(cmd_handle, true);
+  link->clocks += CLOCKS_START;
+  link->expect_addr = true;
+  PROF_UNLOCK();
+  return __real_i2c_master_start(cmd_handle);
+}
+
+static void tally_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data,
+                        size_t len) {
+  PROF_LOCK();
+  link_info_t *link = find_link(cmd_handle, true);
+  if (link->expect_addr && len > 0) {
+    // first address byte of the link names the device
+    if (link->addr == I2C_PROF_ADDR_NONE)
+      link->addr = data[0] >> 1;
+    link->expect_addr = false;
+  }
+  link->bytes_written += len;
+  link->clocks += len * CLOCKS_PER_BYTE;
+  PROF_UNLOCK();
+}
+
+static void tally_read(i2c_cmd_handle_t cmd_handle, size_t len) {
+  PROF_LOCK();
+  link_info_t *link = find_link(cmd_handle, true);
+  link->bytes_read += len;
+  link->clocks += len * CLOCKS_PER_BYTE;
+  PROF_UNLOCK();
+}
+
+esp_err_t __wrap_i2c_master_write_byte(i2c_cmd_handle_t cmd_handle,
+                                       uint8_t data, bool ack_en) {
+  tally_write(cmd_handle, &data, 1);
+  return __real_i2c_master_write_byte(cmd_handle, data, ack_en);
+}
+
+esp_err_t __wrap_i2c_master_write(i2c_cmd_handle_t cmd_handle,
+                                  const uint8_t *data, size_t data_len,
+                                  bool ack_en) {
+  if (data && data_len > 0)
+    tally_write(cmd_handle, data, data_len);
+  return __real_i2c_master_write(cmd_handle, data, data_len, ack_en);
+}
+
+esp_err_t __wrap_i2c_master_read_byte(i2c_cmd_handle_t cmd_handle,
+                                      uint8_t *data, i2c_ack_type_t ack) {
+  tally_read(cmd_handle, 1);
+  return __real_i2c_master_read_byte(cmd_handle, data, ack);
+}
+
+esp_err_t __wrap_i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data,
+                                 size_t data_len, i2c_ack_type_t ack) {
+  tally_read(cmd_handle, data_len);
+  return __real_i2c_master_read(cmd_handle, data, data_len, ack);
+}
+
+esp_err_t __wrap_i2c_master_stop(i2c_cmd_handle_t cmd_handle) {
+  PROF_LOCK();
+  find_link(cmd_handle, true)->clocks += CLOCKS_STOP;
+  PROF_UNLOCK();
+  return __real_i2c_master_stop(cmd_handle);
+}
+
+esp_err_t __wrap_i2c_master_cmd_begin(i2c_port_t i2c_num,
+                                      i2c_cmd_handle_t cmd_handle,
+                                      TickType_t ticks_to_wait) {
+  int64_t start = now_us();
+  esp_err_t ret = __real_i2c_master_cmd_begin(i2c_num, cmd_handle,
+                                              ticks_to_wait);
+  int64_t latency = now_us() - start;
+
+  PROF_LOCK();
+  link_info_t *link = find_link(cmd_handle, false);
+  if (link)
+    record(i2c_num, link->addr, link->bytes_written, link->bytes_read,
+           link->clocks, latency, ret);
+  else
+    record(i2c_num, I2C_PROF_ADDR_NONE, 0, 0, 0, latency, ret);
+  PROF_UNLOCK();
+  return ret;
+}
+
+// The helpers build their link inside the driver, account them as a whole
+static void record_helper(i2c_port_t port, uint8_t addr, size_t write_size,
+                          size_t read_size, int starts, int64_t latency,
+                          esp_err_t ret) {
+  uint32_t written = starts + write_size; // one address byte per START
+  uint32_t clocks = starts * CLOCKS_START + CLOCKS_STOP +
+                    (written + read_size) * CLOCKS_PER_BYTE;
+
+  PROF_LOCK();
+  record(port, addr, written, read_size, clocks, latency, ret);
+  PROF_UNLOCK();
+}
+
+esp_err_t __wrap_i2c_master_write_to_device(i2c_port_t i2c_num,
+                                            uint8_t device_address,
+                                            const uint8_t *write_buffer,
+                                            size_t write_size,
+                                            TickType_t ticks_to_wait) {
+  int64_t start = now_us();
+  esp_err_t ret = __real_i2c_master_write_to_device(
+      i2c_num, device_address, write_buffer, write_size, ticks_to_wait);
+  record_helper(i2c_num, device_address, write_size, 0, 1, now_us() - start,
+                ret);
+  return ret;
+}
+
+esp_err_t __wrap_i2c_master_read_from_device(i2c_port_t i2c_num,
+                                             uint8_t device_address,
+                                             uint8_t *read_buffer,
+                                             size_t read_size,
+                                             TickType_t ticks_to_wait) {
+  int64_t start = now_us();
+  esp_err_t ret = __real_i2c_master_read_from_device(
+      i2c_num, device_address, read_buffer, read_size, ticks_to_wait);
+  record_helper(i2c_num, device_address, 0, read_size, 1, now_us() - start,
+                ret);
+  return ret;
+}
+
+esp_err_t __wrap_i2c_master_write_read_device(
+    i2c_port_t i2c_num, uint8_t device_address, const uint8_t *write_buffer,
+    size_t write_size, uint8_t *read_buffer, size_t read_size,
+    TickType_t ticks_to_wait) {
+  int64_t start = now_us();
+  esp_err_t ret = __real_i2c_master_write_read_device(
+      i2c_num, device_address, write_buffer, write_size, read_buffer,
+      read_size, ticks_to_wait);
+  record_helper(i2c_num, device_address, write_size, read_size, 2,
+                now_us() - start, ret);
+  return ret;
+}
+
+#endif // I2C_PROFILER_WRAP
@@ -0,0 +1,47 @@
+/**
+ * @file i2c_profiler.h per-device I2C transaction statistics
+ *
+ * Counts what each device costs on the bus: transactions, bytes each way,
+ * the bus time those bytes take at the configured SCL clock (9 clocks per
+ * byte plus START/STOP) and the wall-clock latency of i2c_master_cmd_begin(),
+ * including the worst case. Works on target and against the host I2C mock.
+ */
+
+#ifndef I2C_PROFILER_H
+#define I2C_PROFILER_H
+
+#include "driver/i2c.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define I2C_PROF_MAX_DEVICES 16
+#define I2C_PROF_MAX_LINKS 16 // command links being built at the same time
+#define I2C_PROF_ADDR_NONE 0xFF // links that never addressed a device
+
+typedef struct {
+  i2c_port_t port;
+  uint8_t addr;
+  uint32_t transactions;
+  uint32_t failed;
+  uint32_t bytes_written; // address bytes included
+  uint32_t bytes_read;
+  uint64_t bus_clocks;    // SCL clocks of all transactions
+  uint64_t bus_time_us;   // bus_clocks at the port's clock
+  uint64_t latency_us;    // time spent inside the driver call
+  uint32_t max_latency_us;
+} i2c_prof_device_t;
+
+// true when the build routes the driver calls through the profiler
+bool i2c_prof_enabled(void);
+
+// Clock used for the bus time estimate, taken from i2c_param_config()
+void i2c_prof_set_clock(i2c_port_t port, uint32_t clk_hz);
+
+// Statistics of one device, false if it was never addressed
+bool i2c_prof_get(i2c_port_t port, uint8_t addr, i2c_prof_device_t *out);
+void i2c_prof_reset(void);
+
+// Print one line per device plus a total
+void i2c_prof_dump(void);
+
+#endif // I2C_PROFILER_H
@@ -0,0 +1,174 @@
+/**
+ * @file feature_kernels.c scalar kernels and backend dispatch
+ */
+
+#include "feature_kernels.h"
+#include <math.h>
+#include <stddef.h>
+
+#define SIGN(x) (((x) > 0) - ((x) < 0))
+
+// -------- Scalar backend (ESP32 and fallback) --------
+
+static float scalar_sum(const float *x, int n) {
+  float sum = 0;
+  for (int i = 0; i < n; i++)
+    sum += x[i];
+  return sum;
+}
+
+static float scalar_sum_sq(const float *x, int n) {
+  float sum = 0;
+  for (int i = 0; i < n; i++)
+    sum += x[i] * x[i];
+  return sum;
+}
+
+static float scalar_peak_abs(const float *x, int n) {
+  float peak = 0;
+  for (int i = 0; i < n; i++) {
+    float val = fabsf(x[i]);
+    if (val > peak)
+      peak = val;
+  }
+  return peak;
+}
+
+static void scalar_min_max(const float *x, int n, float *min, float *max) {
+  float lo = n > 0 ? x[0] : 0;
+  float hi = lo;
+  for (int i = 1; i < n; i++) {
+    if (x[i] < lo)
+      lo = x[i];
+    if (x[i] > hi)
+      hi = x[i];
+  }
+  *min = lo;
+  *max = hi;
+}
+
+static int scalar_crossings(const float *x, int n, float level) {
+  int count = 0;
+  for (int i = 1; i < n; i++)
+    count += SIGN(x[i] - level) != SIGN(x[i - 1] - level);
+  return count;
+}
+
+static const fk_ops_t scalar_ops = {
+    .sum = scalar_sum,
+    .sum_sq = scalar_sum_sq,
+    .peak_abs = scalar_peak_abs,
+    .min_max = scalar_min_max,
+    .crossings = scalar_crossings,
+};
+
+// -------- Dispatch --------
+
+static const fk_ops_t *backend_ops(fk_backend_t backend) {
+  switch (backend) {
+  case FK_BACKEND_SCALAR:
+    return &scalar_ops;
+#if defined(__x86_64__) || defined(__i386__)
+  case FK_BACKEND_SSE2:
+    return __builtin_cpu_supports("sse2") ? &fk_sse2_ops : NULL;
+  case FK_BACKEND_AVX2:
+    return __builtin_cpu_supports("avx2") ? &fk_avx2_ops : NULL;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+static const fk_ops_t *ops;
+static fk_backend_t current = FK_BACKEND_SCALAR;
+
+static const fk_ops_t *active(void) {
+  if (!ops) {
+    // first call: take the widest backend this CPU supports
+    for (int b = FK_NUM_BACKENDS - 1; b >= 0 && !ops; b--) {
+      ops = backend_ops(b);
+      current = b;
+    }
+  }
+  return ops;
+}
+
+bool fk_backend_available(fk_backend_t backend) {
+  return backend_ops(backend) != NULL;
+}
+
+bool fk_set_backend(fk_backend_t backend) {
+  const fk_ops_t *selected = backend_ops(backend);
+  if (!selected)
+    return false;
+
+  ops = selected;
+  current = backend;
+  return true;
+}
+
+fk_backend_t fk_get_backend(void) {
+  active();
+  return current;
+}
+
+const char *fk_backend_name(fk_backend_t backend) {
+  static const char *const names[FK_NUM_BACKENDS] = {
+      [FK_BACKEND_SCALAR] = "scalar",
+      [FK_BACKEND_SSE2] = "sse2",
+      [FK_BACKEND_AVX2] = "avx2",
+  };
+  if (backend < 0 || backend >= FK_NUM_BACKENDS)
+    return "unknown";
+  return names[backend];
+}
+
+// -------- Public kernels --------
+
+float fk_sum(const float *x, int n) { return active()->sum(x, n); }
+
+float fk_sum_sq(const float *x, int n) { return active()->sum_sq(x, n); }
+
+float fk_peak_abs(const float *x, int n) { return active()->peak_abs(x, n); }
+
+void fk_min_max(const float *x, int n, float *min, float *max) {
+  active()->min_max(x, n, min, max);
+}
+
+int fk_crossings(const float *x, int n, float level) {
+  return active()->crossings(x, n, level);
+}
+
+void fk_mean_var(const float *x, int n, float *mean, float *var) {
+  if (n <= 0) {
+    *mean = 0;
+    *var = 0;
+    return;
+  }
+
+  const fk_ops_t *k = active();
+  float m = k->sum(x, n) / n;
+  float v = k->sum_sq(x, n) / n - m * m;
+
+  *mean = m;
+  *var = v > 0 ? v : 0;
+}
+
+void motion_block_features(const float *x, int n, motion_features_t *out) {
+  if (n <= 0) {
+    *out = (motion_features_t){0};
+    return;
+  }
+
+  const fk_ops_t *k = active();
+  float mean = k->sum(x, n) / n;
+  float mean_sq = k->sum_sq(x, n) / n;
+  float var = mean_sq - mean * mean;
+
+  out->rms = sqrtf(mean_sq);
+  out->var = var > 0 ? var : 0;
+  out->peak = k->peak_abs(x, n);
+  out->zcr = (float)k->crossings(x, n, 0) / n;
+  out->mean_crossing_rate = (float)k->crossings(x, n, mean) / n;
+  k->min_max(x, n, &out->min, &out->max);
+}
@@ -0,0 +1,270 @@
+/**
+ * @file feature_kernels_x86.c SSE2 and AVX2 backends for the host tools
+ *
+ * Only built for the linux target on x86. Functions carry their own target
+ * attribute so the file needs no special compiler flags; feature_kernels.c
+ * checks the CPU before handing out the AVX2 table.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "feature_kernels.h"
+#include <immintrin.h>
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+#define SIGN(x) (((x) > 0) - ((x) < 0))
+
+// Tails shorter than one vector go through the same scalar rules
+static float tail_sum(const float *x, int i, int n, float acc) {
+  for (; i < n; i++)
+    acc += x[i];
+  return acc;
+}
+
+static float tail_sum_sq(const float *x, int i, int n, float acc) {
+  for (; i < n; i++)
+    acc += x[i] * x[i];
+  return acc;
+}
+
+static float tail_peak(const float *x, int i, int n, float peak) {
+  for (; i < n; i++) {
+    float val = x[i] < 0 ? -x[i] : x[i];
+    if (val > peak)
+      peak = val;
+  }
+  return peak;
+}
+
+static void tail_min_max(const float *x, int i, int n, float *lo, float *hi) {
+  for (; i < n; i++) {
+    if (x[i] < *lo)
+      *lo = x[i];
+    if (x[i] > *hi)
+      *hi = x[i];
+  }
+}
+
+static int tail_crossings(const float *x, int i, int n, float level) {
+  int count = 0;
+  for (; i < n; i++)
+    count += SIGN(x[i] - level) != SIGN(x[i - 1] - level);
+  return count;
+}
+
+// ======================== SSE2 (4 lanes) ========================
+
+SSE2 static float hsum_128(__m128 v) {
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+SSE2 static float hmax_128(__m128 v) {
+  v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+  return _mm_cvtss_f32(v);
+}
+
+SSE2 static float hmin_128(__m128 v) {
+  v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+  return _mm_cvtss_f32(v);
+}
+
+SSE2 static float sse2_sum(const float *x, int n) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_loadu_ps(x + i));
+    acc1 = _mm_add_ps(acc1, _mm_loadu_ps(x + i + 4));
+  }
+  for (; i + 4 <= n; i += 4)
+    acc0 = _mm_add_ps(acc0, _mm_loadu_ps(x + i));
+
+  return tail_sum(x, i, n, hsum_128(_mm_add_ps(acc0, acc1)));
+}
+
+SSE2 static float sse2_sum_sq(const float *x, int n) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m128 a = _mm_loadu_ps(x + i);
+    __m128 b = _mm_loadu_ps(x + i + 4);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+  }
+  for (; i + 4 <= n; i += 4) {
+    __m128 a = _mm_loadu_ps(x + i);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+  }
+
+  return tail_sum_sq(x, i, n, hsum_128(_mm_add_ps(acc0, acc1)));
+}
+
+SSE2 static float sse2_peak_abs(const float *x, int n) {
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 peak = _mm_setzero_ps();
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    peak = _mm_max_ps(peak, _mm_andnot_ps(sign, _mm_loadu_ps(x + i)));
+
+  return tail_peak(x, i, n, hmax_128(peak));
+}
+
+SSE2 static void sse2_min_max(const float *x, int n, float *min, float *max) {
+  if (n <= 0) {
+    *min = *max = 0;
+    return;
+  }
+
+  __m128 lo = _mm_set1_ps(x[0]);
+  __m128 hi = lo;
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(x + i);
+    lo = _mm_min_ps(lo, v);
+    hi = _mm_max_ps(hi, v);
+  }
+
+  *min = hmin_128(lo);
+  *max = hmax_128(hi);
+  tail_min_max(x, i, n, min, max);
+}
+
+SSE2 static int sse2_crossings(const float *x, int n, float level) {
+  const __m128 lvl = _mm_set1_ps(level);
+  int count = 0;
+  int i = 1;
+
+  // compare x[i..i+3] with x[i-1..i+2]: a change of either sign mask counts
+  for (; i + 4 <= n; i += 4) {
+    __m128 cur = _mm_loadu_ps(x + i);
+    __m128 prev = _mm_loadu_ps(x + i - 1);
+    __m128 gt = _mm_xor_ps(_mm_cmpgt_ps(cur, lvl), _mm_cmpgt_ps(prev, lvl));
+    __m128 lt = _mm_xor_ps(_mm_cmplt_ps(cur, lvl), _mm_cmplt_ps(prev, lvl));
+    count += __builtin_popcount(_mm_movemask_ps(_mm_or_ps(gt, lt)));
+  }
+
+  return count + tail_crossings(x, i, n, level);
+}
+
+const fk_ops_t fk_sse2_ops = {
+    .sum = sse2_sum,
+    .sum_sq = sse2_sum_sq,
+    .peak_abs = sse2_peak_abs,
+    .min_max = sse2_min_max,
+    .crossings = sse2_crossings,
+};
+
+// ======================== AVX2 (8 lanes) ========================
+
+AVX2 static __m128 fold_256(__m256 v, int max) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  return max > 0 ? _mm_max_ps(lo, hi) : max < 0 ? _mm_min_ps(lo, hi)
+                                                 : _mm_add_ps(lo, hi);
+}
+
+AVX2 static float avx2_sum(const float *x, int n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(x + i));
+    acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(x + i + 8));
+  }
+  for (; i + 8 <= n; i += 8)
+    acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(x + i));
+
+  return tail_sum(x, i, n, hsum_128(fold_256(_mm256_add_ps(acc0, acc1), 0)));
+}
+
+AVX2 static float avx2_sum_sq(const float *x, int n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256 a = _mm256_loadu_ps(x + i);
+    __m256 b = _mm256_loadu_ps(x + i + 8);
+    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(a, a));
+    acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(b, b));
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m256 a = _mm256_loadu_ps(x + i);
+    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(a, a));
+  }
+
+  return tail_sum_sq(x, i, n,
+                     hsum_128(fold_256(_mm256_add_ps(acc0, acc1), 0)));
+}
+
+AVX2 static float avx2_peak_abs(const float *x, int n) {
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 peak = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, _mm256_loadu_ps(x + i)));
+
+  return tail_peak(x, i, n, hmax_128(fold_256(peak, 1)));
+}
+
+AVX2 static void avx2_min_max(const float *x, int n, float *min, float *max) {
+  if (n <= 0) {
+    *min = *max = 0;
+    return;
+  }
+
+  __m256 lo = _mm256_set1_ps(x[0]);
+  __m256 hi = lo;
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_loadu_ps(x + i);
+    lo = _mm256_min_ps(lo, v);
+    hi = _mm256_max_ps(hi, v);
+  }
+
+  *min = hmin_128(fold_256(lo, -1));
+  *max = hmax_128(fold_256(hi, 1));
+  tail_min_max(x, i, n, min, max);
+}
+
+AVX2 static int avx2_crossings(const float *x, int n, float level) {
+  const __m256 lvl = _mm256_set1_ps(level);
+  int count = 0;
+  int i = 1;
+
+  for (; i + 8 <= n; i += 8) {
+    __m256 cur = _mm256_loadu_ps(x + i);
+    __m256 prev = _mm256_loadu_ps(x + i - 1);
+    __m256 gt = _mm256_xor_ps(_mm256_cmp_ps(cur, lvl, _CMP_GT_OQ),
+                              _mm256_cmp_ps(prev, lvl, _CMP_GT_OQ));
+    __m256 lt = _mm256_xor_ps(_mm256_cmp_ps(cur, lvl, _CMP_LT_OQ),
+                              _mm256_cmp_ps(prev, lvl, _CMP_LT_OQ));
+    count += __builtin_popcount(_mm256_movemask_ps(_mm256_or_ps(gt, lt)));
+  }
+
+  return count + tail_crossings(x, i, n, level);
+}
+
+const fk_ops_t fk_avx2_ops = {
+    .sum = avx2_sum,
+    .sum_sq = avx2_sum_sq,
+    .peak_abs = avx2_peak_abs,
+    .min_max = avx2_min_max,
+    .crossings = avx2_crossings,
+};
+
+#endif // __x86_64__ || __i386__
@@ -0,0 +1,110 @@
+/**
+ * @file feature_window.c constant-time sliding window statistics
+ */
+
+#include "feature_window.h"
+#include <math.h>
+#include <string.h>
+
+#define SIGN(x) (((x) > 0) - ((x) < 0))
+
+void feature_window_init(feature_window_t *fw, int size) {
+  memset(fw, 0, sizeof(*fw));
+
+  if (size < 1)
+    size = 1;
+  if (size > FEATURE_WINDOW_MAX)
+    size = FEATURE_WINDOW_MAX;
+  fw->size = size;
+}
+
+// Running float sums drift as values enter and leave; recomputing them once
+// per window length keeps the error bounded at an amortized O(1) cost.
+static void resync_sums(feature_window_t *fw) {
+  float sum = 0;
+  float sum_sq = 0;
+
+  for (int i = 0; i < fw->count; i++) {
+    sum += fw->samples[i];
+    sum_sq += fw->samples[i] * fw->samples[i];
+  }
+
+  fw->sum = sum;
+  fw->sum_sq = sum_sq;
+  fw->since_resync = 0;
+}
+
+void feature_window_push(feature_window_t *fw, float x) {
+  // -------- running sums --------
+  if (fw->count == fw->size) {
+    float old = fw->samples[fw->pos];
+    fw->sum -= old;
+    fw->sum_sq -= old * old;
+    fw->crossings -= fw->crossing[fw->pos];
+  } else {
+    fw->count++;
+  }
+
+  // -------- zero crossings (same sign convention as np.sign) --------
+  int sign = SIGN(x);
+  uint8_t crossed = fw->seq > 0 && sign != fw->last_sign;
+  fw->crossing[fw->pos] = crossed;
+  fw->crossings += crossed;
+  fw->last_sign = sign;
+
+  fw->samples[fw->pos] = x;
+  fw->pos = (fw->pos + 1) % fw->size;
+  fw->sum += x;
+  fw->sum_sq += x * x;
+
+  if (++fw->since_resync >= fw->size)
+    resync_sums(fw);
+
+  // -------- peak deque --------
+  PEAK_DEQUE_PUSH(&fw->peak, fabsf(x), fw->seq++, fw->size);
+}
+
+float feature_window_mean(const feature_window_t *fw) {
+  if (fw->count == 0)
+    return 0;
+  return fw->sum / fw->count;
+}
+
+float feature_window_rms(const feature_window_t *fw) {
+  if (fw->count == 0)
+    return 0;
+
+  float mean_sq = fw->sum_sq / fw->count;
+  return mean_sq > 0 ? sqrtf(mean_sq) : 0;
+}
+
+float feature_window_variance(const feature_window_t *fw) {
+  if (fw->count == 0)
+    return 0;
+
+  float mean = fw->sum / fw->count;
+  float var = fw->sum_sq / fw->count - mean * mean;
+  return var > 0 ? var : 0; // cancellation can dip just below zero
+}
+
+float feature_window_peak(const feature_window_t *fw) {
+  return PEAK_DEQUE_PEAK(&fw->peak);
+}
+
+float feature_window_zcr(const feature_window_t *fw) {
+  if (fw->count == 0)
+    return 0;
+
+  // the oldest sample's flag refers to a pair that already left the window
+  int oldest = fw->count == fw->size ? fw->pos : 0;
+  return (float)(fw->crossings - fw->crossing[oldest]) / fw->count;
+}
+
+int feature_window_copy(const feature_window_t *fw, float *out) {
+  // until the ring wraps, the oldest sample is the first one
+  int oldest = fw->count == fw->size ? fw->pos : 0;
+
+  for (int i = 0; i < fw->count; i++)
+    out[i] = fw->samples[(oldest + i) % fw->size];
+  return fw->count;
+}
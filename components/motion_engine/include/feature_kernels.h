@@ -0,0 +1,62 @@
+/**
+ * @file feature_kernels.h block feature kernels with scalar and SIMD backends
+ *
+ * Each kernel works on a whole block of samples. The portable scalar backend
+ * is what the ESP32 runs; on x86 hosts SSE2 and AVX2 backends are picked at
+ * runtime so the offline tools get through recordings faster with the same
+ * entry points the firmware uses.
+ */
+
+#ifndef FEATURE_KERNELS_H
+#define FEATURE_KERNELS_H
+
+#include <stdbool.h>
+
+typedef enum {
+  FK_BACKEND_SCALAR,
+  FK_BACKEND_SSE2,
+  FK_BACKEND_AVX2,
+  FK_NUM_BACKENDS
+} fk_backend_t;
+
+typedef struct {
+  float (*sum)(const float *x, int n);
+  float (*sum_sq)(const float *x, int n);
+  float (*peak_abs)(const float *x, int n);
+  void (*min_max)(const float *x, int n, float *min, float *max);
+  int (*crossings)(const float *x, int n, float level);
+} fk_ops_t;
+
+// Per-window feature vector, same columns as motion_data/features.csv
+typedef struct {
+  float rms;
+  float var;
+  float peak;
+  float zcr;
+  float min;
+  float max;
+  float mean_crossing_rate;
+} motion_features_t;
+
+// Backend selection: the best available one is used by default
+bool fk_backend_available(fk_backend_t backend);
+bool fk_set_backend(fk_backend_t backend);
+fk_backend_t fk_get_backend(void);
+const char *fk_backend_name(fk_backend_t backend);
+
+float fk_sum(const float *x, int n);
+float fk_sum_sq(const float *x, int n);
+float fk_peak_abs(const float *x, int n);
+void fk_mean_var(const float *x, int n, float *mean, float *var);
+void fk_min_max(const float *x, int n, float *min, float *max);
+// sign changes of (x - level) between consecutive samples (np.sign rules)
+int fk_crossings(const float *x, int n, float level);
+
+void motion_block_features(const float *x, int n, motion_features_t *out);
+
+#if defined(__x86_64__) || defined(__i386__)
+extern const fk_ops_t fk_sse2_ops;
+extern const fk_ops_t fk_avx2_ops;
+#endif
+
+#endif // FEATURE_KERNELS_H
@@ -0,0 +1,59 @@
+/**
+ * @file feature_window.h sliding window with O(1) RMS, variance and peak
+ *
+ * Running sums give mean/RMS/variance, a monotonic deque of sample indices
+ * gives the peak of |x| and per-sample sign-change flags give the
+ * zero-crossing rate. Every push is constant time, so the window can be
+ * evaluated after each sample (any hop size) for the cost of one update.
+ */
+
+#ifndef FEATURE_WINDOW_H
+#define FEATURE_WINDOW_H
+
+#include "peak_deque.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FEATURE_WINDOW_MAX 64
+
+typedef struct {
+  float samples[FEATURE_WINDOW_MAX]; // ring of the last `size` samples
+  int pos;                           // next write position in samples[]
+
+  // peak candidates: |x| strictly decreasing from head to tail
+  PEAK_DEQUE_T(float, FEATURE_WINDOW_MAX) peak;
+
+  int size;     // window length
+  int count;    // samples currently in the window (<= size)
+  uint32_t seq; // total samples pushed (wraps safely)
+
+  float sum;
+  float sum_sq;
+  int since_resync; // pushes since the sums were last recomputed
+
+  // crossing[i] is set when samples[i] changed sign from its predecessor
+  uint8_t crossing[FEATURE_WINDOW_MAX];
+  int crossings;
+  int last_sign;
+} feature_window_t;
+
+// size is clamped to [1, FEATURE_WINDOW_MAX]
+void feature_window_init(feature_window_t *fw, int size);
+void feature_window_push(feature_window_t *fw, float x);
+
+static inline bool feature_window_full(const feature_window_t *fw) {
+  return fw->count == fw->size;
+}
+
+float feature_window_mean(const feature_window_t *fw);
+float feature_window_rms(const feature_window_t *fw);
+float feature_window_variance(const feature_window_t *fw);
+float feature_window_peak(const feature_window_t *fw);
+// sign changes between consecutive samples of the window, divided by count
+float feature_window_zcr(const feature_window_t *fw);
+
+// The window's samples oldest first, for the block kernels; out holds
+// fw->count floats. Returns fw->count.
+int feature_window_copy(const feature_window_t *fw, float *out);
+
+#endif // FEATURE_WINDOW_H
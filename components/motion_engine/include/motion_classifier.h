@@ -0,0 +1,34 @@
+/**
+ * @file motion_classifier.h compile-time choice between float and fixed point
+ *
+ * Firmware code uses the motion_classifier_* names; building with
+ * MOTION_ENGINE_FIXED_POINT=1 maps them onto the integer-only engine.
+ */
+
+#ifndef MOTION_CLASSIFIER_H
+#define MOTION_CLASSIFIER_H
+
+#include "motion_engine.h"
+#include "motion_fixed.h"
+
+#ifndef MOTION_ENGINE_FIXED_POINT
+#define MOTION_ENGINE_FIXED_POINT 0
+#endif
+
+#if MOTION_ENGINE_FIXED_POINT
+typedef motion_q_engine_t motion_classifier_t;
+typedef motion_q_decision_t motion_classifier_decision_t;
+#define motion_classifier_init motion_q_engine_init
+#define motion_classifier_push_raw motion_q_engine_push_raw
+#define motion_classifier_push_raw_block motion_q_engine_push_raw_block
+#define motion_classifier_pop_decision motion_q_engine_pop_decision
+#else
+typedef motion_engine_t motion_classifier_t;
+typedef motion_decision_t motion_classifier_decision_t;
+#define motion_classifier_init motion_engine_init
+#define motion_classifier_push_raw motion_engine_push_raw
+#define motion_classifier_push_raw_block motion_engine_push_raw_block
+#define motion_classifier_pop_decision motion_engine_pop_decision
+#endif
+
+#endif // MOTION_CLASSIFIER_H
@@ -0,0 +1,105 @@
+/**
+ * @file motion_engine.h portable streaming motion classifier
+ *
+ * The engine holds no hardware or RTOS dependency: the firmware pushes raw
+ * MPU-6050 frames (or magnitudes) one by one and pops a decision every
+ * hop_size samples once the window is full. The same code is built by
+ * ESP-IDF and by a plain host compiler so recorded sessions can be replayed
+ * off-target.
+ */
+
+#ifndef MOTION_ENGINE_H
+#define MOTION_ENGINE_H
+
+#include "feature_window.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MOTION_FS 100          // sampling rate (Hz)
+#define MOTION_WINDOW_SIZE 50  // 0.5 s at 100 Hz
+#define MOTION_HOP_SIZE MOTION_WINDOW_SIZE // default: non-overlapping windows
+#define MOTION_LPF_ALPHA 0.38f // 10 Hz cutoff at 100 Hz sampling
+
+#define MOTION_RAW_FRAME_LEN 14 // ACCEL_XOUT_H .. GYRO_ZOUT_L
+#define MOTION_ACCEL_LSB_PER_G 16384.0f // AFS_SEL = 0
+#define MOTION_GYRO_LSB_PER_DPS 131.0f  // FS_SEL = 0
+
+// Classification thresholds (see README, Day 5)
+#define MOTION_IMPACT_ACC_PEAK 2.5f
+#define MOTION_FAST_ACC_RMS 0.8f
+#define MOTION_SLOW_GYRO_RMS 10.0f
+
+#define MOTION_DECISION_QUEUE_LEN 4
+
+typedef enum {
+  MOTION_STATIONARY,
+  MOTION_SLOW,
+  MOTION_FAST,
+  MOTION_IMPACT,
+  MOTION_NUM_CLASSES
+} motion_class_t;
+
+typedef struct {
+  int window_size; // samples per window, up to FEATURE_WINDOW_MAX
+  int hop_size;    // samples between two decisions once the window is full
+} motion_engine_config_t;
+
+typedef struct {
+  motion_class_t label;
+  float acc_rms;
+  float acc_peak;
+  float acc_var;
+  float acc_zcr;
+  float gyro_rms;
+  float gyro_var;
+  float gyro_zcr;
+  int64_t timestamp_ms; // timestamp of the sample that closed the window
+} motion_decision_t;
+
+typedef struct {
+  float acc_filtered;
+  float gyro_filtered;
+
+  feature_window_t acc_window;
+  feature_window_t gyro_window;
+  int hop_size;
+  int since_decision; // samples pushed since the last decision
+
+  // decisions not yet popped by the caller
+  motion_decision_t decisions[MOTION_DECISION_QUEUE_LEN];
+  int head;
+  int count;
+  uint32_t dropped;
+} motion_engine_t;
+
+// config may be NULL for MOTION_WINDOW_SIZE / MOTION_HOP_SIZE
+void motion_engine_init(motion_engine_t *engine,
+                        const motion_engine_config_t *config);
+
+// Convert a 14-byte accel+temp+gyro frame to magnitudes in g and deg/s
+void motion_decode_raw(const uint8_t *raw, float *accel_mag, float *gyro_mag);
+
+// Feed one sample; returns true when the sample produced a decision
+bool motion_engine_push_raw(motion_engine_t *engine, const uint8_t *raw,
+                            int64_t timestamp_ms);
+bool motion_engine_push_sample(motion_engine_t *engine, float accel_mag,
+                               float gyro_mag, int64_t timestamp_ms);
+// Feed a burst of back-to-back frames (e.g. a FIFO read), the first one taken
+// at timestamp_ms; returns the number of decisions produced
+int motion_engine_push_raw_block(motion_engine_t *engine, const uint8_t *frames,
+                                 int count, int64_t timestamp_ms,
+                                 int period_ms);
+
+// Take the oldest pending decision; returns false if none is available
+bool motion_engine_pop_decision(motion_engine_t *engine,
+                                motion_decision_t *decision);
+
+motion_class_t motion_classify(float acc_rms, float acc_peak, float gyro_rms);
+const char *motion_class_to_str(motion_class_t label);
+
+// Signal helpers shared with the offline tools (see feature_kernels.h)
+float lowpass_filter(float input, float prev_output, float alpha);
+float compute_rms(const float *buffer, int size);
+float compute_peak(const float *buffer, int size);
+
+#endif // MOTION_ENGINE_H
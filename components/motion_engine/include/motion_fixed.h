@@ -0,0 +1,100 @@
+/**
+ * @file motion_fixed.h integer-only variant of the motion classifier
+ *
+ * Signals stay in sensor LSB units (16384 LSB = 1 g, 131 LSB = 1 deg/s):
+ * magnitudes use an integer square root, the low-pass filter uses a Q15
+ * coefficient and the window keeps exact 64-bit sums. RMS thresholds are
+ * compared against the mean square, so no sqrt is taken per window either.
+ * Conversion to engineering units is only done on request for reporting.
+ */
+
+#ifndef MOTION_FIXED_H
+#define MOTION_FIXED_H
+
+#include "motion_engine.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MOTION_Q_ACC_ONE_G 16384 // accel LSB per g
+#define MOTION_Q_GYRO_ONE_DPS 131 // gyro LSB per deg/s
+#define MOTION_Q_LPF_ALPHA ((int32_t)(MOTION_LPF_ALPHA * 32768.0f + 0.5f)) // Q15
+
+// Thresholds of motion_classify() in LSB units
+#define MOTION_Q_IMPACT_ACC_PEAK                                               \
+  ((int32_t)(MOTION_IMPACT_ACC_PEAK * MOTION_Q_ACC_ONE_G))
+#define MOTION_Q_FAST_ACC_RMS ((int32_t)(MOTION_FAST_ACC_RMS * MOTION_Q_ACC_ONE_G))
+#define MOTION_Q_SLOW_GYRO_RMS                                                 \
+  ((int32_t)(MOTION_SLOW_GYRO_RMS * MOTION_Q_GYRO_ONE_DPS))
+
+typedef struct {
+  int32_t samples[FEATURE_WINDOW_MAX];
+  int pos;
+
+  PEAK_DEQUE_T(int32_t, FEATURE_WINDOW_MAX) peak;
+
+  int size;
+  int count;
+  uint32_t seq;
+
+  int64_t sum; // exact, no resync needed
+  int64_t sum_sq;
+
+  uint8_t crossing[FEATURE_WINDOW_MAX];
+  int crossings;
+  int last_sign;
+} motion_q_window_t;
+
+typedef struct {
+  motion_class_t label;
+  int32_t acc_peak;      // LSB
+  int64_t acc_sum;       // window sums, divide by window_size for moments
+  int64_t acc_sum_sq;
+  int acc_crossings;
+  int64_t gyro_sum;
+  int64_t gyro_sum_sq;
+  int32_t gyro_peak;
+  int gyro_crossings;
+  int window_size;
+  int64_t timestamp_ms;
+} motion_q_decision_t;
+
+typedef struct {
+  int32_t acc_filtered; // LSB, gravity removed
+  int32_t gyro_filtered;
+
+  motion_q_window_t acc_window;
+  motion_q_window_t gyro_window;
+  int hop_size;
+  int since_decision;
+
+  motion_q_decision_t decisions[MOTION_DECISION_QUEUE_LEN];
+  int head;
+  int count;
+  uint32_t dropped;
+} motion_q_engine_t;
+
+uint32_t motion_q_isqrt(uint32_t x);
+
+void motion_q_window_init(motion_q_window_t *w, int size);
+void motion_q_window_push(motion_q_window_t *w, int32_t x);
+
+// config may be NULL for MOTION_WINDOW_SIZE / MOTION_HOP_SIZE
+void motion_q_engine_init(motion_q_engine_t *engine,
+                          const motion_engine_config_t *config);
+
+// Magnitudes already expressed in LSB (accel including gravity)
+bool motion_q_engine_push_mag(motion_q_engine_t *engine, int32_t accel_mag,
+                              int32_t gyro_mag, int64_t timestamp_ms);
+bool motion_q_engine_push_raw(motion_q_engine_t *engine, const uint8_t *raw,
+                              int64_t timestamp_ms);
+int motion_q_engine_push_raw_block(motion_q_engine_t *engine,
+                                   const uint8_t *frames, int count,
+                                   int64_t timestamp_ms, int period_ms);
+bool motion_q_engine_pop_decision(motion_q_engine_t *engine,
+                                  motion_q_decision_t *decision);
+
+// Reporting helper, uses float: keep it off the sampling path
+void motion_q_decision_to_float(const motion_q_decision_t *q,
+                                motion_decision_t *decision);
+
+#endif // MOTION_FIXED_H
@@ -0,0 +1,57 @@
+/**
+ * @file peak_deque.h running peak of |x| over a sliding window
+ *
+ * A monotonic deque of (sample number, |x|) pairs with |x| strictly
+ * decreasing from head to tail, so the head is the peak of the window.
+ * Every sample enters and leaves once: a push is amortized O(1). The float
+ * window (feature_window.h) and the Q15 one (motion_fixed.h) share it;
+ * PEAK_DEQUE_T() declares the storage for one magnitude type and the
+ * macros below work on either.
+ *
+ * Window sizes go up to the capacity. The expired head leaves before the
+ * new sample goes in, so a window whose every sample is still a candidate
+ * never needs more than capacity entries.
+ */
+
+#ifndef PEAK_DEQUE_H
+#define PEAK_DEQUE_H
+
+#include <stdint.h>
+
+#define PEAK_DEQUE_T(type, capacity)                                           \
+  struct {                                                                     \
+    uint32_t seq[capacity]; /* sample number of each candidate */             \
+    type abs[capacity];                                                        \
+    int head;                                                                  \
+    int len;                                                                   \
+  }
+
+#define PEAK_DEQUE_CAPACITY(dq)                                                \
+  ((int)(sizeof((dq)->seq) / sizeof((dq)->seq[0])))
+#define PEAK_DEQUE_AT(dq, i) (((dq)->head + (i)) % PEAK_DEQUE_CAPACITY(dq))
+
+// Add sample number n with magnitude ax to a window of the last size
+// samples. dq is evaluated more than once.
+#define PEAK_DEQUE_PUSH(dq, ax, n, size)                                       \
+  do {                                                                         \
+    uint32_t n_ = (n);                                                         \
+    __typeof__((dq)->abs[0]) ax_ = (ax);                                       \
+    /* the head leaves once it slides out of the window */                     \
+    if ((dq)->len > 0 && n_ - (dq)->seq[(dq)->head] >= (uint32_t)(size)) {    \
+      (dq)->head = PEAK_DEQUE_AT(dq, 1);                                       \
+      (dq)->len--;                                                             \
+    }                                                                          \
+    /* candidates no larger than the new one can never be the peak again */   \
+    while ((dq)->len > 0 &&                                                    \
+           (dq)->abs[PEAK_DEQUE_AT(dq, (dq)->len - 1)] <= ax_)                 \
+      (dq)->len--;                                                             \
+    int tail_ = PEAK_DEQUE_AT(dq, (dq)->len);                                  \
+    (dq)->seq[tail_] = n_;                                                     \
+    (dq)->abs[tail_] = ax_;                                                    \
+    (dq)->len++;                                                               \
+  } while (0)
+
+// The peak of the window, 0 before the first sample
+#define PEAK_DEQUE_PEAK(dq) ((dq)->len > 0 ? (dq)->abs[(dq)->head] : 0)
+
+#endif // PEAK_DEQUE_H
@@ -0,0 +1,166 @@
+/**
+ * @file motion_engine.c implementation of the streaming motion classifier
+ */
+
+#include "motion_engine.h"
+#include "feature_kernels.h"
+#include <math.h>
+#include <string.h>
+
+static const char *const class_names[MOTION_NUM_CLASSES] = {
+    [MOTION_STATIONARY] = "Stationary",
+    [MOTION_SLOW] = "Slow movement",
+    [MOTION_FAST] = "Fast movement / Vibration",
+    [MOTION_IMPACT] = "Impact",
+};
+
+float lowpass_filter(float input, float prev_output, float alpha) {
+  return alpha * input + (1 - alpha) * prev_output;
+}
+
+float compute_rms(const float *buffer, int size) {
+  return sqrtf(fk_sum_sq(buffer, size) / size);
+}
+
+float compute_peak(const float *buffer, int size) {
+  return fk_peak_abs(buffer, size);
+}
+
+motion_class_t motion_classify(float acc_rms, float acc_peak, float gyro_rms) {
+  if (acc_peak > MOTION_IMPACT_ACC_PEAK)
+    return MOTION_IMPACT;
+  if (acc_rms > MOTION_FAST_ACC_RMS)
+    return MOTION_FAST;
+  if (gyro_rms > MOTION_SLOW_GYRO_RMS)
+    return MOTION_SLOW;
+  return MOTION_STATIONARY;
+}
+
+const char *motion_class_to_str(motion_class_t label) {
+  if (label < 0 || label >= MOTION_NUM_CLASSES)
+    return "Unknown";
+  return class_names[label];
+}
+
+void motion_engine_init(motion_engine_t *engine,
+                        const motion_engine_config_t *config) {
+  int window_size = config ? config->window_size : MOTION_WINDOW_SIZE;
+  int hop_size = config ? config->hop_size : MOTION_HOP_SIZE;
+
+  memset(engine, 0, sizeof(*engine));
+  feature_window_init(&engine->acc_window, window_size);
+  feature_window_init(&engine->gyro_window, window_size);
+  engine->hop_size = hop_size > 0 ? hop_size : 1;
+}
+
+void motion_decode_raw(const uint8_t *raw, float *accel_mag, float *gyro_mag) {
+  // -------- Accelerometer --------
+  int16_t ax = (raw[0] << 8) | raw[1];
+  int16_t ay = (raw[2] << 8) | raw[3];
+  int16_t az = (raw[4] << 8) | raw[5];
+
+  float ax_g = ax / MOTION_ACCEL_LSB_PER_G;
+  float ay_g = ay / MOTION_ACCEL_LSB_PER_G;
+  float az_g = az / MOTION_ACCEL_LSB_PER_G;
+
+  // -------- Gyroscope (raw[6..7] is temperature) --------
+  int16_t gx = (raw[8] << 8) | raw[9];
+  int16_t gy = (raw[10] << 8) | raw[11];
+  int16_t gz = (raw[12] << 8) | raw[13];
+
+  float gx_dps = gx / MOTION_GYRO_LSB_PER_DPS;
+  float gy_dps = gy / MOTION_GYRO_LSB_PER_DPS;
+  float gz_dps = gz / MOTION_GYRO_LSB_PER_DPS;
+
+  *accel_mag = sqrtf(ax_g * ax_g + ay_g * ay_g + az_g * az_g);
+  *gyro_mag = sqrtf(gx_dps * gx_dps + gy_dps * gy_dps + gz_dps * gz_dps);
+}
+
+static void publish_decision(motion_engine_t *engine,
+                             const motion_decision_t *decision) {
+  if (engine->count == MOTION_DECISION_QUEUE_LEN) {
+    // caller is not keeping up: drop the oldest decision
+    engine->head = (engine->head + 1) % MOTION_DECISION_QUEUE_LEN;
+    engine->count--;
+    engine->dropped++;
+  }
+
+  int tail = (engine->head + engine->count) % MOTION_DECISION_QUEUE_LEN;
+  engine->decisions[tail] = *decision;
+  engine->count++;
+}
+
+bool motion_engine_push_sample(motion_engine_t *engine, float accel_mag,
+                               float gyro_mag, int64_t timestamp_ms) {
+  // -------- Preprocessing --------
+  float acc_motion = accel_mag - 1.0f; // remove gravity
+
+  engine->acc_filtered =
+      lowpass_filter(acc_motion, engine->acc_filtered, MOTION_LPF_ALPHA);
+  engine->gyro_filtered =
+      lowpass_filter(gyro_mag, engine->gyro_filtered, MOTION_LPF_ALPHA);
+
+  // -------- Update sliding windows --------
+  feature_window_push(&engine->acc_window, engine->acc_filtered);
+  feature_window_push(&engine->gyro_window, engine->gyro_filtered);
+
+  if (!feature_window_full(&engine->acc_window))
+    return false;
+
+  // first decision as soon as the window fills, then one every hop
+  if (engine->since_decision > 0 &&
+      engine->since_decision < engine->hop_size) {
+    engine->since_decision++;
+    return false;
+  }
+  engine->since_decision = 1;
+
+  // -------- Features + classification --------
+  motion_decision_t decision = {
+      .acc_rms = feature_window_rms(&engine->acc_window),
+      .acc_peak = feature_window_peak(&engine->acc_window),
+      .acc_var = feature_window_variance(&engine->acc_window),
+      .acc_zcr = feature_window_zcr(&engine->acc_window),
+      .gyro_rms = feature_window_rms(&engine->gyro_window),
+      .gyro_var = feature_window_variance(&engine->gyro_window),
+      .gyro_zcr = feature_window_zcr(&engine->gyro_window),
+      .timestamp_ms = timestamp_ms,
+  };
+  decision.label =
+      motion_classify(decision.acc_rms, decision.acc_peak, decision.gyro_rms);
+
+  publish_decision(engine, &decision);
+  return true;
+}
+
+bool motion_engine_push_raw(motion_engine_t *engine, const uint8_t *raw,
+                            int64_t timestamp_ms) {
+  float accel_mag;
+  float gyro_mag;
+
+  motion_decode_raw(raw, &accel_mag, &gyro_mag);
+  return motion_engine_push_sample(engine, accel_mag, gyro_mag, timestamp_ms);
+}
+
+int motion_engine_push_raw_block(motion_engine_t *engine, const uint8_t *frames,
+                                 int count, int64_t timestamp_ms,
+                                 int period_ms) {
+  int decisions = 0;
+
+  for (int i = 0; i < count; i++)
+    decisions +=
+        motion_engine_push_raw(engine, frames + i * MOTION_RAW_FRAME_LEN,
+                               timestamp_ms + (int64_t)i * period_ms);
+  return decisions;
+}
+
+bool motion_engine_pop_decision(motion_engine_t *engine,
+                                motion_decision_t *decision) {
+  if (engine->count == 0)
+    return false;
+
+  *decision = engine->decisions[engine->head];
+  engine->head = (engine->head + 1) % MOTION_DECISION_QUEUE_LEN;
+  engine->count--;
+  return true;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file motion_fixed.c integer-only motion classifier
+ */
+
+#include "motion_fixed.h"
+#include <math.h>
+#include <string.h>
+
+#define SIGN(x) (((x) > 0) - ((x) < 0))
+
+// Bit-by-bit square root: 16 shift/add/compare steps, no multiply and no
+// data-dependent branch (the compare becomes a mask)
+uint32_t motion_q_isqrt(uint32_t x) {
+  if (x == 0)
+    return 0;
+
+  uint32_t root = 0;
+  uint32_t bit = 1UL << ((31 - __builtin_clz(x)) & ~1); // highest power of 4
+
+  while (bit != 0) {
+    uint32_t trial = root + bit;
+    uint32_t mask = -(uint32_t)(x >= trial);
+    x -= trial & mask;
+    root = (root >> 1) + (bit & mask);
+    bit >>= 2;
+  }
+  return root;
+}
+
+// y += alpha * (x - y), alpha in Q15, rounded to nearest.
+// |x - y| stays below 2^17 for 16-bit sensor magnitudes, so the product
+// fits comfortably in 32 bits.
+static inline int32_t lowpass_q15(int32_t input, int32_t prev_output) {
+  return prev_output +
+         ((MOTION_Q_LPF_ALPHA * (input - prev_output) + (1 << 14)) >> 15);
+}
+
+void motion_q_window_init(motion_q_window_t *w, int size) {
+  memset(w, 0, sizeof(*w));
+
+  if (size < 1)
+    size = 1;
+  if (size > FEATURE_WINDOW_MAX)
+    size = FEATURE_WINDOW_MAX;
+  w->size = size;
+}
+
+void motion_q_window_push(motion_q_window_t *w, int32_t x) {
+  if (w->count == w->size) {
+    int32_t old = w->samples[w->pos];
+    w->sum -= old;
+    w->sum_sq -= (int64_t)old * old;
+    w->crossings -= w->crossing[w->pos];
+  } else {
+    w->count++;
+  }
+
+  int sign = SIGN(x);
+  uint8_t crossed = w->seq > 0 && sign != w->last_sign;
+  w->crossing[w->pos] = crossed;
+  w->crossings += crossed;
+  w->last_sign = sign;
+
+  w->samples[w->pos] = x;
+  w->pos = (w->pos + 1) % w->size;
+  w->sum += x;
+  w->sum_sq += (int64_t)x * x;
+
+  PEAK_DEQUE_PUSH(&w->peak, x < 0 ? -x : x, w->seq++, w->size);
+}
+
+static int window_crossings(const motion_q_window_t *w) {
+  int oldest = w->count == w->size ? w->pos : 0;
+  return w->crossings - w->crossing[oldest];
+}
+
+// Same rules as motion_classify(), RMS compared as sum of squares
+static motion_class_t classify_q(const motion_q_decision_t *d) {
+  const int64_t n = d->window_size;
+
+  if (d->acc_peak > MOTION_Q_IMPACT_ACC_PEAK)
+    return MOTION_IMPACT;
+  if (d->acc_sum_sq >
+      (int64_t)MOTION_Q_FAST_ACC_RMS * MOTION_Q_FAST_ACC_RMS * n)
+    return MOTION_FAST;
+  if (d->gyro_sum_sq >
+      (int64_t)MOTION_Q_SLOW_GYRO_RMS * MOTION_Q_SLOW_GYRO_RMS * n)
+    return MOTION_SLOW;
+  return MOTION_STATIONARY;
+}
+
+void motion_q_engine_init(motion_q_engine_t *engine,
+                          const motion_engine_config_t *config) {
+  int window_size = config ? config->window_size : MOTION_WINDOW_SIZE;
+  int hop_size = config ? config->hop_size : MOTION_HOP_SIZE;
+
+  memset(engine, 0, sizeof(*engine));
+  motion_q_window_init(&engine->acc_window, window_size);
+  motion_q_window_init(&engine->gyro_window, window_size);
+  engine->hop_size = hop_size > 0 ? hop_size : 1;
+}
+
+static void publish_decision(motion_q_engine_t *engine,
+                             const motion_q_decision_t *decision) {
+  if (engine->count == MOTION_DECISION_QUEUE_LEN) {
+    engine->head = (engine->head + 1) % MOTION_DECISION_QUEUE_LEN;
+    engine->count--;
+    engine->dropped++;
+  }
+
+  int tail = (engine->head + engine->count) % MOTION_DECISION_QUEUE_LEN;
+  engine->decisions[tail] = *decision;
+  engine->count++;
+}
+
+bool motion_q_engine_push_mag(motion_q_engine_t *engine, int32_t accel_mag,
+                              int32_t gyro_mag, int64_t timestamp_ms) {
+  // -------- Preprocessing --------
+  int32_t acc_motion = accel_mag - MOTION_Q_ACC_ONE_G; // remove gravity
+
+  engine->acc_filtered = lowpass_q15(acc_motion, engine->acc_filtered);
+  engine->gyro_filtered = lowpass_q15(gyro_mag, engine->gyro_filtered);
+
+  // -------- Update sliding windows --------
+  motion_q_window_push(&engine->acc_window, engine->acc_filtered);
+  motion_q_window_push(&engine->gyro_window, engine->gyro_filtered);
+
+  if (engine->acc_window.count < engine->acc_window.size)
+    return false;
+
+  if (engine->since_decision > 0 &&
+      engine->since_decision < engine->hop_size) {
+    engine->since_decision++;
+    return false;
+  }
+  engine->since_decision = 1;
+
+  // -------- Features + classification --------
+  const motion_q_window_t *acc = &engine->acc_window;
+  const motion_q_window_t *gyro = &engine->gyro_window;
+  motion_q_decision_t decision = {
+      .acc_peak = PEAK_DEQUE_PEAK(&acc->peak),
+      .acc_sum = acc->sum,
+      .acc_sum_sq = acc->sum_sq,
+      .acc_crossings = window_crossings(acc),
+      .gyro_sum = gyro->sum,
+      .gyro_sum_sq = gyro->sum_sq,
+      .gyro_peak = PEAK_DEQUE_PEAK(&gyro->peak),
+      .gyro_crossings = window_crossings(gyro),
+      .window_size = acc->count,
+      .timestamp_ms = timestamp_ms,
+  };
+  decision.label = classify_q(&decision);
+
+  publish_decision(engine, &decision);
+  return true;
+}
+
+bool motion_q_engine_push_raw(motion_q_engine_t *engine, const uint8_t *raw,
+                              int64_t timestamp_ms) {
+  int32_t ax = (int16_t)((raw[0] << 8) | raw[1]);
+  int32_t ay = (int16_t)((raw[2] << 8) | raw[3]);
+  int32_t az = (int16_t)((raw[4] << 8) | raw[5]);
+
+  int32_t gx = (int16_t)((raw[8] << 8) | raw[9]);
+  int32_t gy = (int16_t)((raw[10] << 8) | raw[11]);
+  int32_t gz = (int16_t)((raw[12] << 8) | raw[13]);
+
+  // 3 * 32768^2 still fits in an unsigned 32-bit sum
+  uint32_t acc_sq = (uint32_t)(ax * ax) + (uint32_t)(ay * ay) +
+                    (uint32_t)(az * az);
+  uint32_t gyro_sq = (uint32_t)(gx * gx) + (uint32_t)(gy * gy) +
+                     (uint32_t)(gz * gz);
+
+  return motion_q_engine_push_mag(engine, (int32_t)motion_q_isqrt(acc_sq),
+                                  (int32_t)motion_q_isqrt(gyro_sq),
+                                  timestamp_ms);
+}
+
+int motion_q_engine_push_raw_block(motion_q_engine_t *engine,
+                                   const uint8_t *frames, int count,
+                                   int64_t timestamp_ms, int period_ms) {
+  int decisions = 0;
+
+  for (int i = 0; i < count; i++)
+    decisions += motion_q_engine_push_raw(
+        engine, frames + i * MOTION_RAW_FRAME_LEN,
+        timestamp_ms + (int64_t)i * period_ms);
+  return decisions;
+}
+
+bool motion_q_engine_pop_decision(motion_q_engine_t *engine,
+                                  motion_q_decision_t *decision) {
+  if (engine->count == 0)
+    return false;
+
+  *decision = engine->decisions[engine->head];
+  engine->head = (engine->head + 1) % MOTION_DECISION_QUEUE_LEN;
+  engine->count--;
+  return true;
+}
+
+void motion_q_decision_to_float(const motion_q_decision_t *q,
+                                motion_decision_t *decision) {
+  const int64_t n = q->window_size;
+  const float acc_scale = 1.0f / MOTION_Q_ACC_ONE_G;
+  const float gyro_scale = 1.0f / MOTION_Q_GYRO_ONE_DPS;
+
+  // n^2 * variance, exact in 64 bits (no cancellation)
+  int64_t acc_var = n * q->acc_sum_sq - q->acc_sum * q->acc_sum;
+  int64_t gyro_var = n * q->gyro_sum_sq - q->gyro_sum * q->gyro_sum;
+
+  decision->label = q->label;
+  decision->acc_rms = sqrtf((float)q->acc_sum_sq / n) * acc_scale;
+  decision->acc_peak = q->acc_peak * acc_scale;
+  decision->acc_var = (float)acc_var / (n * n) * acc_scale * acc_scale;
+  decision->acc_zcr = (float)q->acc_crossings / n;
+  decision->gyro_rms = sqrtf((float)q->gyro_sum_sq / n) * gyro_scale;
+  decision->gyro_var = (float)gyro_var / (n * n) * gyro_scale * gyro_scale;
+  decision->gyro_zcr = (float)q->gyro_crossings / n;
+  decision->timestamp_ms = q->timestamp_ms;
+}
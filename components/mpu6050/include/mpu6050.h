@@ -0,0 +1,83 @@
+/**
+ * @file mpu6050.h MPU-6050 register access and FIFO burst acquisition
+ *
+ * Direct mode reads the 14 output registers once per sample. FIFO mode lets
+ * the sensor's own clock sample into its 1024-byte FIFO and the host drains
+ * whole blocks of frames in one transaction, so the read rate no longer sets
+ * the sample timing.
+ */
+
+#ifndef MPU6050_H
+#define MPU6050_H
+
+#include "driver/i2c.h"
+#include "i2c_prepared.h"
+#include <stdint.h>
+
+#define MPU6050_ADDR 0x68 // AD0 low
+#define MPU6050_WHO_AM_I_VALUE 0x68
+
+// Registers
+#define MPU6050_REG_SMPLRT_DIV 0x19
+#define MPU6050_REG_CONFIG 0x1A
+#define MPU6050_REG_FIFO_EN 0x23
+#define MPU6050_REG_INT_ENABLE 0x38
+#define MPU6050_REG_INT_STATUS 0x3A
+#define MPU6050_REG_ACCEL_XOUT_H 0x3B
+#define MPU6050_REG_TEMP_OUT_H 0x41
+#define MPU6050_REG_GYRO_XOUT_H 0x43
+#define MPU6050_REG_USER_CTRL 0x6A
+#define MPU6050_REG_PWR_MGMT_1 0x6B
+#define MPU6050_REG_FIFO_COUNTH 0x72
+#define MPU6050_REG_FIFO_R_W 0x74
+#define MPU6050_REG_WHO_AM_I 0x75
+
+// Register bits
+#define MPU6050_FIFO_EN_ALL 0xF8 // temp, gyro x/y/z, accel
+#define MPU6050_INT_FIFO_OFLOW 0x10
+#define MPU6050_USER_CTRL_FIFO_EN 0x40
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04
+#define MPU6050_PWR_SLEEP 0x40
+
+// accel, temp and gyro: same 14-byte layout as the output registers
+#define MPU6050_FRAME_LEN 14
+#define MPU6050_FIFO_SIZE 1024
+#define MPU6050_FIFO_MAX_FRAMES (MPU6050_FIFO_SIZE / MPU6050_FRAME_LEN)
+
+#define MPU6050_TIMEOUT_MS 1000
+
+typedef struct {
+  i2c_port_t port;
+  uint8_t addr;
+} mpu6050_t;
+
+esp_err_t mpu6050_read_regs(const mpu6050_t *dev, uint8_t reg, uint8_t *data,
+                            size_t len);
+esp_err_t mpu6050_write_reg(const mpu6050_t *dev, uint8_t reg, uint8_t value);
+
+esp_err_t mpu6050_who_am_i(const mpu6050_t *dev, uint8_t *who_am_i);
+// clear the sleep bit, internal 8 MHz oscillator
+esp_err_t mpu6050_wake_up(const mpu6050_t *dev);
+// one 14-byte frame from the output registers
+esp_err_t mpu6050_read_frame(const mpu6050_t *dev, uint8_t *frame);
+// Same read as a prepared transaction: each i2c_prepared_run() refills frame
+esp_err_t mpu6050_prepare_frame_read(const mpu6050_t *dev, i2c_prepared_t *txn,
+                                     uint8_t *frame);
+
+// Sample into the FIFO at rate_hz (DLPF on, 1 kHz / (1 + SMPLRT_DIV))
+esp_err_t mpu6050_fifo_start(const mpu6050_t *dev, int rate_hz);
+esp_err_t mpu6050_fifo_stop(const mpu6050_t *dev);
+esp_err_t mpu6050_fifo_reset(const mpu6050_t *dev);
+esp_err_t mpu6050_fifo_count(const mpu6050_t *dev, int *bytes);
+
+/**
+ * Drain up to max_frames whole frames in a single burst.
+ *
+ * On overflow the sensor has overwritten the oldest bytes and frame alignment
+ * is lost: the FIFO is reset, *count is 0 and ESP_ERR_INVALID_STATE is
+ * returned so the caller can restart its windows.
+ */
+esp_err_t mpu6050_fifo_read(const mpu6050_t *dev, uint8_t *frames,
+                            int max_frames, int *count);
+
+#endif // MPU6050_H
@@ -0,0 +1,140 @@
+/**
+ * @file mpu6050.c MPU-6050 register access and FIFO burst acquisition
+ */
+
+#include "mpu6050.h"
+
+#define TIMEOUT_TICKS (MPU6050_TIMEOUT_MS / portTICK_PERIOD_MS)
+#define DLPF_44HZ 3 // gyro output rate 1 kHz, enough for a 100 Hz FIFO rate
+
+// one-off links are built on the stack, no heap traffic per register access
+#define LINK_SIZE I2C_LINK_RECOMMENDED_SIZE(2)
+
+esp_err_t mpu6050_read_regs(const mpu6050_t *dev, uint8_t reg, uint8_t *data,
+                            size_t len) {
+  uint8_t link_buf[LINK_SIZE];
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buf, sizeof(link_buf));
+
+  // register address, then repeated START into the read phase
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (dev->addr << 1) | I2C_MASTER_WRITE, true);
+  i2c_master_write_byte(cmd, reg, true);
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (dev->addr << 1) | I2C_MASTER_READ, true);
+  i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
+  i2c_master_stop(cmd);
+
+  esp_err_t ret = i2c_master_cmd_begin(dev->port, cmd, TIMEOUT_TICKS);
+  i2c_cmd_link_delete_static(cmd);
+  return ret;
+}
+
+esp_err_t mpu6050_write_reg(const mpu6050_t *dev, uint8_t reg, uint8_t value) {
+  uint8_t link_buf[LINK_SIZE];
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buf, sizeof(link_buf));
+
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (dev->addr << 1) | I2C_MASTER_WRITE, true);
+  i2c_master_write_byte(cmd, reg, true);
+  i2c_master_write_byte(cmd, value, true);
+  i2c_master_stop(cmd);
+
+  esp_err_t ret = i2c_master_cmd_begin(dev->port, cmd, TIMEOUT_TICKS);
+  i2c_cmd_link_delete_static(cmd);
+  return ret;
+}
+
+esp_err_t mpu6050_who_am_i(const mpu6050_t *dev, uint8_t *who_am_i) {
+  return mpu6050_read_regs(dev, MPU6050_REG_WHO_AM_I, who_am_i, 1);
+}
+
+esp_err_t mpu6050_wake_up(const mpu6050_t *dev) {
+  return mpu6050_write_reg(dev, MPU6050_REG_PWR_MGMT_1, 0x00);
+}
+
+esp_err_t mpu6050_read_frame(const mpu6050_t *dev, uint8_t *frame) {
+  return mpu6050_read_regs(dev, MPU6050_REG_ACCEL_XOUT_H, frame,
+                           MPU6050_FRAME_LEN);
+}
+
+esp_err_t mpu6050_prepare_frame_read(const mpu6050_t *dev, i2c_prepared_t *txn,
+                                     uint8_t *frame) {
+  return i2c_prepared_read_regs(txn, dev->port, dev->addr,
+                                MPU6050_REG_ACCEL_XOUT_H, frame,
+                                MPU6050_FRAME_LEN);
+}
+
+// -------- FIFO --------
+
+esp_err_t mpu6050_fifo_start(const mpu6050_t *dev, int rate_hz) {
+  if (rate_hz < 4 || rate_hz > 1000)
+    return ESP_ERR_INVALID_ARG; // SMPLRT_DIV is 8 bits
+
+  esp_err_t ret = mpu6050_write_reg(dev, MPU6050_REG_CONFIG, DLPF_44HZ);
+  if (ret == ESP_OK)
+    ret = mpu6050_write_reg(dev, MPU6050_REG_SMPLRT_DIV, 1000 / rate_hz - 1);
+  if (ret == ESP_OK)
+    ret = mpu6050_write_reg(dev, MPU6050_REG_FIFO_EN, MPU6050_FIFO_EN_ALL);
+  if (ret == ESP_OK)
+    ret = mpu6050_write_reg(dev, MPU6050_REG_INT_ENABLE,
+                            MPU6050_INT_FIFO_OFLOW);
+  if (ret == ESP_OK)
+    ret = mpu6050_fifo_reset(dev);
+  return ret;
+}
+
+esp_err_t mpu6050_fifo_stop(const mpu6050_t *dev) {
+  esp_err_t ret = mpu6050_write_reg(dev, MPU6050_REG_USER_CTRL, 0);
+  if (ret == ESP_OK)
+    ret = mpu6050_write_reg(dev, MPU6050_REG_FIFO_EN, 0);
+  return ret;
+}
+
+esp_err_t mpu6050_fifo_reset(const mpu6050_t *dev) {
+  // the reset bit clears itself, FIFO_EN stays set in the same write
+  return mpu6050_write_reg(dev, MPU6050_REG_USER_CTRL,
+                           MPU6050_USER_CTRL_FIFO_EN |
+                               MPU6050_USER_CTRL_FIFO_RESET);
+}
+
+esp_err_t mpu6050_fifo_count(const mpu6050_t *dev, int *bytes) {
+  uint8_t count[2];
+
+  esp_err_t ret = mpu6050_read_regs(dev, MPU6050_REG_FIFO_COUNTH, count, 2);
+  *bytes = ret == ESP_OK ? (count[0] << 8) | count[1] : 0;
+  return ret;
+}
+
+esp_err_t mpu6050_fifo_read(const mpu6050_t *dev, uint8_t *frames,
+                            int max_frames, int *count) {
+  int bytes;
+
+  *count = 0;
+  esp_err_t ret = mpu6050_fifo_count(dev, &bytes);
+  if (ret != ESP_OK)
+    return ret;
+
+  // a partial frame is either being written or left over from an overflow
+  if (bytes % MPU6050_FRAME_LEN != 0) {
+    uint8_t status = 0;
+    ret = mpu6050_read_regs(dev, MPU6050_REG_INT_STATUS, &status, 1);
+    if (ret != ESP_OK)
+      return ret;
+
+    if (bytes >= MPU6050_FIFO_SIZE || (status & MPU6050_INT_FIFO_OFLOW)) {
+      ret = mpu6050_fifo_reset(dev);
+      return ret == ESP_OK ? ESP_ERR_INVALID_STATE : ret;
+    }
+  }
+
+  int available = bytes / MPU6050_FRAME_LEN;
+  int n = available < max_frames ? available : max_frames;
+  if (n == 0)
+    return ESP_OK;
+
+  ret = mpu6050_read_regs(dev, MPU6050_REG_FIFO_R_W, frames,
+                          (size_t)n * MPU6050_FRAME_LEN);
+  if (ret == ESP_OK)
+    *count = n;
+  return ret;
+}
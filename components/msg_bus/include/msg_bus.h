@@ -0,0 +1,69 @@
+/**
+ * @file msg_bus.h zero-copy messages: pooled blocks, reference counts and
+ * pointer queues
+ *
+ * A producer takes a block from a fixed pool, fills it in place and
+ * publishes it. The bus queues only the pointer, once per subscriber, and
+ * takes one reference per queue it lands in. Each consumer reads the block
+ * where it is and releases it, and the last release puts it back in the pool.
+ * The payload size therefore has no effect on queue memory or on the time
+ * spent in the queues.
+ *
+ * The pool is a block_pool whose blocks carry a small header (owning pool,
+ * reference count) in front of the payload.
+ */
+
+#ifndef MSG_BUS_H
+#define MSG_BUS_H
+
+#include "block_pool.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MSG_BUS_MAX_SUBSCRIBERS 4
+
+typedef struct msg_pool msg_pool_t;
+
+struct msg_pool {
+  block_pool_t blocks; // block header + payload each
+  size_t payload_size;
+};
+
+typedef struct {
+  msg_pool_t *pool;
+  QueueHandle_t subscribers[MSG_BUS_MAX_SUBSCRIBERS];
+  int num_subscribers;
+  uint32_t published;
+  uint32_t dropped; // deliveries lost to a full subscriber queue
+} msg_bus_t;
+
+// The only heap use of the pool: one block of storage, made here
+esp_err_t msg_pool_init(msg_pool_t *pool, size_t payload_size,
+                        uint16_t num_blocks);
+void msg_pool_deinit(msg_pool_t *pool);
+block_pool_stats_t msg_pool_get_stats(msg_pool_t *pool);
+
+// Payload of a free block holding one reference, NULL when the pool is empty
+void *msg_alloc(msg_pool_t *pool);
+void msg_ref(void *msg);
+// Drops one reference; the last one returns the block to its pool
+void msg_release(void *msg);
+uint16_t msg_refs(const void *msg);
+
+esp_err_t msg_bus_init(msg_bus_t *bus, msg_pool_t *pool);
+// New queue of depth pointers that receives every published message
+QueueHandle_t msg_bus_subscribe(msg_bus_t *bus, UBaseType_t depth);
+
+// Queue msg to every subscriber. Takes over the caller's reference, so
+// the caller must not touch msg afterwards. Returns the number of
+// subscribers reached. Each full queue costs a drop, not the whole publish.
+int msg_bus_publish(msg_bus_t *bus, void *msg, TickType_t wait);
+
+// Next message for one subscriber; release it when done with it
+bool msg_bus_receive(QueueHandle_t queue, void **msg, TickType_t wait);
+
+#endif // MSG_BUS_H
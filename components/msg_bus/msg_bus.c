@@ -0,0 +1,113 @@
+/**
+ * @file msg_bus.c fixed-block pool with embedded reference counts and the
+ * fan-out publish
+ */
+
+#include "msg_bus.h"
+
+// Stored right before each payload, so a payload pointer finds its block
+typedef struct {
+  msg_pool_t *pool;
+  uint16_t refs;
+} block_header_t;
+
+// keeps the payload on the block alignment
+#define HEADER_SIZE                                                            \
+  ((sizeof(block_header_t) + BLOCK_POOL_ALIGN - 1) & ~(BLOCK_POOL_ALIGN - 1))
+
+static block_header_t *header_of(const void *msg) {
+  return (block_header_t *)((uint8_t *)msg - HEADER_SIZE);
+}
+
+// -------- Pool --------
+
+esp_err_t msg_pool_init(msg_pool_t *pool, size_t payload_size,
+                        uint16_t num_blocks) {
+  if (!pool || payload_size == 0 || num_blocks == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  *pool = (msg_pool_t){.payload_size = payload_size};
+  return block_pool_init(&pool->blocks, HEADER_SIZE + payload_size,
+                         num_blocks);
+}
+
+void msg_pool_deinit(msg_pool_t *pool) { block_pool_deinit(&pool->blocks); }
+
+block_pool_stats_t msg_pool_get_stats(msg_pool_t *pool) {
+  return block_pool_get_stats(&pool->blocks);
+}
+
+void *msg_alloc(msg_pool_t *pool) {
+  // the free list used the first word: the header is written anew
+  block_header_t *block = block_pool_alloc(&pool->blocks);
+  if (!block)
+    return NULL;
+
+  block->pool = pool;
+  block->refs = 1;
+  return (uint8_t *)block + HEADER_SIZE;
+}
+
+void msg_ref(void *msg) {
+  __atomic_fetch_add(&header_of(msg)->refs, 1, __ATOMIC_RELAXED);
+}
+
+void msg_release(void *msg) {
+  block_header_t *block = header_of(msg);
+
+  // readers are done with the payload before their reference goes
+  if (__atomic_sub_fetch(&block->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    return;
+
+  block_pool_free(&block->pool->blocks, block);
+}
+
+uint16_t msg_refs(const void *msg) {
+  return __atomic_load_n(&header_of(msg)->refs, __ATOMIC_RELAXED);
+}
+
+// -------- Bus --------
+
+esp_err_t msg_bus_init(msg_bus_t *bus, msg_pool_t *pool) {
+  if (!bus || !pool)
+    return ESP_ERR_INVALID_ARG;
+
+  *bus = (msg_bus_t){.pool = pool};
+  return ESP_OK;
+}
+
+QueueHandle_t msg_bus_subscribe(msg_bus_t *bus, UBaseType_t depth) {
+  if (bus->num_subscribers == MSG_BUS_MAX_SUBSCRIBERS)
+    return NULL;
+
+  QueueHandle_t queue = xQueueCreate(depth, sizeof(void *));
+  if (queue)
+    bus->subscribers[bus->num_subscribers++] = queue;
+  return queue;
+}
+
+int msg_bus_publish(msg_bus_t *bus, void *msg, TickType_t wait) {
+  int delivered = 0;
+
+  // a reference per queue up front: a fast consumer may release its copy
+  // before the loop reaches the next queue
+  for (int i = 0; i < bus->num_subscribers; i++)
+    msg_ref(msg);
+
+  for (int i = 0; i < bus->num_subscribers; i++) {
+    if (xQueueSend(bus->subscribers[i], &msg, wait) == pdTRUE) {
+      delivered++;
+    } else {
+      __atomic_fetch_add(&bus->dropped, 1, __ATOMIC_RELAXED);
+      msg_release(msg);
+    }
+  }
+  __atomic_fetch_add(&bus->published, 1, __ATOMIC_RELAXED);
+
+  msg_release(msg); // the publisher's own reference
+  return delivered;
+}
+
+bool msg_bus_receive(QueueHandle_t queue, void **msg, TickType_t wait) {
+  return xQueueReceive(queue, msg, wait) == pdTRUE;
+}
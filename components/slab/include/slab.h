@@ -0,0 +1,100 @@
+/**
+ * @file slab.h size-class allocator over fixed-block pools, with per-task
+ * caches
+ *
+ * Each size class is a block_pool. A request takes a block of the smallest
+ * class that fits it, so blocks never split or merge and the pools cannot
+ * fragment. The cost is the rounding, counted as wasted bytes. The
+ * classes, and how many blocks each holds, are fixed at init.
+ *
+ * slab_alloc() and slab_free() take the class pool's lock on every call. A
+ * task that allocates often keeps a slab_cache_t instead: a small
+ * magazine of blocks per class that it alone touches, without a lock. An
+ * empty magazine refills, and a full one drains, half a magazine at a time
+ * under one lock. A cache belongs to one task; blocks from a cache may be
+ * freed anywhere in the slab.
+ *
+ * An empty class lends a block of the next larger class that has one. The
+ * block stays of its own class and goes back there when freed.
+ *
+ * slab_get_free_size() and slab_get_largest_free_block() answer like their
+ * heap_caps_ counterparts. Blocks sitting in caches count as free.
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "block_pool.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SLAB_MAX_CLASSES 8
+#define SLAB_MAX_CACHES 8
+#define SLAB_MAGAZINE_LEN 4 // blocks per class in a cache
+
+typedef struct {
+  size_t block_size;
+  uint32_t num_blocks;
+} slab_class_config_t;
+
+typedef struct {
+  size_t block_size;
+  uint32_t total;
+  uint32_t free; // in the pool or in a cache
+  uint32_t cached;
+  uint32_t peak_in_use;
+  uint32_t alloc_fails;
+} slab_class_info_t;
+
+typedef struct slab_cache slab_cache_t;
+
+typedef struct {
+  block_pool_t pools[SLAB_MAX_CLASSES]; // ascending block size
+  int num_classes;
+  slab_cache_t *caches[SLAB_MAX_CACHES];
+  int num_caches;
+  uint32_t too_large; // requests above the largest class
+  portMUX_TYPE lock;  // the cache list
+} slab_t;
+
+struct slab_cache {
+  slab_t *slab;
+  uint8_t count[SLAB_MAX_CLASSES];
+  void *blocks[SLAB_MAX_CLASSES][SLAB_MAGAZINE_LEN];
+  uint32_t hits;   // served by the magazine
+  uint32_t misses; // went to the pool
+};
+
+// classes in ascending block size; all blocks come from the heap here
+esp_err_t slab_init(slab_t *slab, const slab_class_config_t *classes,
+                    int num_classes);
+void slab_deinit(slab_t *slab);
+
+// A block of the smallest class that fits size, or of a larger one when
+// that class is empty. NULL above the largest class or when all are empty.
+void *slab_alloc(slab_t *slab, size_t size);
+// false, and counted as a bad free, for a pointer the slab did not give
+bool slab_free(slab_t *slab, void *ptr);
+
+// Class of ptr's block, -1 when ptr is not a block of the slab
+int slab_class_of(const slab_t *slab, const void *ptr);
+
+// One cache per task, registered with the slab for the stats
+esp_err_t slab_cache_init(slab_cache_t *cache, slab_t *slab);
+// Flush and unregister
+void slab_cache_deinit(slab_cache_t *cache);
+void *slab_cache_alloc(slab_cache_t *cache, size_t size);
+bool slab_cache_free(slab_cache_t *cache, void *ptr);
+// Give every cached block back to the pools
+void slab_cache_flush(slab_cache_t *cache);
+
+// heap_caps_get_free_size() / _largest_free_block() / _total_size()
+size_t slab_get_free_size(slab_t *slab);
+size_t slab_get_largest_free_block(slab_t *slab);
+size_t slab_get_total_size(const slab_t *slab);
+void slab_get_class_info(slab_t *slab, int cls, slab_class_info_t *info);
+
+#endif // SLAB_H
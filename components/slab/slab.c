@@ -0,0 +1,217 @@
+/**
+ * @file slab.c size classes, per-task magazines and the heap-style stats
+ */
+
+#include "slab.h"
+#include <string.h>
+
+#define REFILL (SLAB_MAGAZINE_LEN / 2) // blocks moved per lock
+
+// Smallest class that holds size, -1 when none does
+static int class_for(slab_t *slab, size_t size) {
+  for (int c = 0; c < slab->num_classes; c++)
+    if (size <= slab->pools[c].stride)
+      return c;
+  portENTER_CRITICAL_SAFE(&slab->lock);
+  slab->too_large++;
+  portEXIT_CRITICAL_SAFE(&slab->lock);
+  return -1;
+}
+
+// -------- Slab --------
+
+esp_err_t slab_init(slab_t *slab, const slab_class_config_t *classes,
+                    int num_classes) {
+  if (!slab || !classes || num_classes < 1 || num_classes > SLAB_MAX_CLASSES)
+    return ESP_ERR_INVALID_ARG;
+  for (int c = 1; c < num_classes; c++)
+    if (classes[c].block_size <= classes[c - 1].block_size)
+      return ESP_ERR_INVALID_ARG;
+
+  memset(slab, 0, sizeof(*slab));
+  slab->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  for (int c = 0; c < num_classes; c++) {
+    esp_err_t err = block_pool_init(&slab->pools[c], classes[c].block_size,
+                                    classes[c].num_blocks);
+    if (err != ESP_OK) {
+      slab_deinit(slab);
+      return err;
+    }
+    slab->num_classes = c + 1;
+  }
+  return ESP_OK;
+}
+
+void slab_deinit(slab_t *slab) {
+  for (int c = 0; c < slab->num_classes; c++)
+    block_pool_deinit(&slab->pools[c]);
+  slab->num_classes = 0;
+  slab->num_caches = 0;
+}
+
+int slab_class_of(const slab_t *slab, const void *ptr) {
+  for (int c = 0; c < slab->num_classes; c++)
+    if (block_pool_index(&slab->pools[c], ptr) >= 0)
+      return c;
+  return -1;
+}
+
+// An empty class borrows from the next larger one that has a block
+static void *alloc_from(slab_t *slab, int c) {
+  for (; c < slab->num_classes; c++) {
+    void *block = block_pool_alloc(&slab->pools[c]);
+    if (block)
+      return block;
+  }
+  return NULL;
+}
+
+void *slab_alloc(slab_t *slab, size_t size) {
+  int c = class_for(slab, size);
+  return c < 0 ? NULL : alloc_from(slab, c);
+}
+
+bool slab_free(slab_t *slab, void *ptr) {
+  int c = slab_class_of(slab, ptr);
+  if (c < 0) {
+    // not ours at all; the first pool counts it with its bad frees
+    block_pool_free(&slab->pools[0], ptr);
+    return false;
+  }
+  return block_pool_free(&slab->pools[c], ptr);
+}
+
+// -------- Per-task caches --------
+
+esp_err_t slab_cache_init(slab_cache_t *cache, slab_t *slab) {
+  memset(cache, 0, sizeof(*cache));
+  cache->slab = slab;
+
+  portENTER_CRITICAL(&slab->lock);
+  bool room = slab->num_caches < SLAB_MAX_CACHES;
+  if (room)
+    slab->caches[slab->num_caches++] = cache;
+  portEXIT_CRITICAL(&slab->lock);
+  return room ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void slab_cache_deinit(slab_cache_t *cache) {
+  slab_t *slab = cache->slab;
+
+  slab_cache_flush(cache);
+  portENTER_CRITICAL(&slab->lock);
+  for (int i = 0; i < slab->num_caches; i++) {
+    if (slab->caches[i] == cache) {
+      slab->caches[i] = slab->caches[--slab->num_caches];
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&slab->lock);
+}
+
+void *slab_cache_alloc(slab_cache_t *cache, size_t size) {
+  int c = class_for(cache->slab, size);
+  if (c < 0)
+    return NULL;
+
+  if (cache->count[c]) {
+    cache->hits++;
+    return cache->blocks[c][--cache->count[c]];
+  }
+
+  // one lock for this block and the next few
+  void *got[REFILL + 1];
+  int n = block_pool_alloc_n(&cache->slab->pools[c], got, REFILL + 1);
+  cache->misses++;
+  if (n == 0)
+    return alloc_from(cache->slab, c + 1);
+  for (int k = 1; k < n; k++)
+    cache->blocks[c][cache->count[c]++] = got[k];
+  return got[0];
+}
+
+bool slab_cache_free(slab_cache_t *cache, void *ptr) {
+  int c = slab_class_of(cache->slab, ptr);
+  if (c < 0)
+    return slab_free(cache->slab, ptr); // refused and counted
+
+  // a block already in the magazine is a double free; the pool's bitmap
+  // cannot see it, the block is still out as far as the pool knows
+  for (int k = 0; k < cache->count[c]; k++)
+    if (cache->blocks[c][k] == ptr)
+      return block_pool_free(&cache->slab->pools[c], NULL); // counts it
+
+  if (cache->count[c] == SLAB_MAGAZINE_LEN) {
+    // full: the oldest half goes back under one lock
+    block_pool_free_n(&cache->slab->pools[c], cache->blocks[c], REFILL);
+    memmove(cache->blocks[c], cache->blocks[c] + REFILL,
+            (SLAB_MAGAZINE_LEN - REFILL) * sizeof(void *));
+    cache->count[c] -= REFILL;
+  }
+  cache->blocks[c][cache->count[c]++] = ptr;
+  cache->hits++;
+  return true;
+}
+
+void slab_cache_flush(slab_cache_t *cache) {
+  for (int c = 0; c < cache->slab->num_classes; c++) {
+    block_pool_free_n(&cache->slab->pools[c], cache->blocks[c],
+                      cache->count[c]);
+    cache->count[c] = 0;
+  }
+}
+
+// -------- Stats --------
+
+// Blocks of class c held by caches; a snapshot, the owners do not lock
+static uint32_t cached_blocks(slab_t *slab, int c) {
+  uint32_t n = 0;
+
+  portENTER_CRITICAL(&slab->lock);
+  for (int i = 0; i < slab->num_caches; i++)
+    n += slab->caches[i]->count[c];
+  portEXIT_CRITICAL(&slab->lock);
+  return n;
+}
+
+void slab_get_class_info(slab_t *slab, int cls, slab_class_info_t *info) {
+  block_pool_t *pool = &slab->pools[cls];
+  block_pool_stats_t stats = block_pool_get_stats(pool);
+
+  info->block_size = pool->stride;
+  info->total = pool->num_blocks;
+  info->cached = cached_blocks(slab, cls);
+  info->free = pool->num_blocks - stats.in_use + info->cached;
+  info->peak_in_use = stats.peak_in_use;
+  info->alloc_fails = stats.alloc_fails;
+}
+
+size_t slab_get_free_size(slab_t *slab) {
+  size_t bytes = 0;
+  slab_class_info_t info;
+
+  for (int c = 0; c < slab->num_classes; c++) {
+    slab_get_class_info(slab, c, &info);
+    bytes += (size_t)info.free * info.block_size;
+  }
+  return bytes;
+}
+
+size_t slab_get_largest_free_block(slab_t *slab) {
+  slab_class_info_t info;
+
+  for (int c = slab->num_classes - 1; c >= 0; c--) {
+    slab_get_class_info(slab, c, &info);
+    if (info.free)
+      return info.block_size;
+  }
+  return 0;
+}
+
+size_t slab_get_total_size(const slab_t *slab) {
+  size_t bytes = 0;
+
+  for (int c = 0; c < slab->num_classes; c++)
+    bytes += (size_t)slab->pools[c].num_blocks * slab->pools[c].stride;
+  return bytes;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file spsc_ring.h lock-free single-producer single-consumer ring buffer
+ *
+ * One task pushes, one task pops, and neither takes a lock or enters the
+ * kernel while the ring has room and data. Only the index each side owns
+ * is written by that side, published with release and read with acquire
+ * ordering. The producer calls xTaskNotifyGive() only when the consumer
+ * has said it is about to sleep, so a busy consumer costs no kernel calls.
+ *
+ * A consumer that drains several rings arms all of them, checks them
+ * again and then sleeps on its task notification; a push to any of them
+ * wakes it.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint8_t *storage; // capacity * elem_size bytes, owned by the caller
+  size_t elem_size;
+  uint32_t mask; // capacity - 1, capacity is a power of two
+
+  // free-running counters, head written by the producer, tail by the consumer
+  uint32_t head;
+  uint32_t tail;
+
+  TaskHandle_t consumer;
+  uint32_t sleeping; // consumer armed, the next push notifies it
+
+  // producer side
+  uint32_t pushed;
+  uint32_t dropped; // items that found the ring full
+  uint32_t notifies;
+} spsc_ring_t;
+
+// capacity must be a power of two
+bool spsc_ring_init(spsc_ring_t *ring, void *storage, size_t elem_size,
+                    uint32_t capacity);
+
+// Producer: copy up to n items in, wake the consumer if it sleeps.
+// Returns how many fit; the rest count as dropped.
+uint32_t spsc_ring_push(spsc_ring_t *ring, const void *items, uint32_t n);
+
+// Consumer: copy up to max items out, never blocks
+uint32_t spsc_ring_pop(spsc_ring_t *ring, void *items, uint32_t max);
+
+// Consumer: pop, sleeping up to wait ticks for the first item. A wakeup
+// left over from an earlier wait can make it return 0 early.
+uint32_t spsc_ring_pop_wait(spsc_ring_t *ring, void *items, uint32_t max,
+                            TickType_t wait);
+
+// Consumer of several rings: arm each one, sleep on ulTaskNotifyTake()
+// only if every arm returned true (still empty), then disarm them all
+bool spsc_ring_arm(spsc_ring_t *ring);
+void spsc_ring_disarm(spsc_ring_t *ring);
+
+uint32_t spsc_ring_count(const spsc_ring_t *ring);
+
+#endif // SPSC_RING_H
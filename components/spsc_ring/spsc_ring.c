@@ -0,0 +1,112 @@
+/**
+ * @file spsc_ring.c index handling, batch copies and the sleep handshake
+ */
+
+#include "spsc_ring.h"
+#include <string.h>
+
+bool spsc_ring_init(spsc_ring_t *ring, void *storage, size_t elem_size,
+                    uint32_t capacity) {
+  if (!ring || !storage || elem_size == 0 || capacity == 0 ||
+      (capacity & (capacity - 1)) != 0)
+    return false;
+
+  *ring = (spsc_ring_t){
+      .storage = storage, .elem_size = elem_size, .mask = capacity - 1};
+  return true;
+}
+
+// Copy n items between the ring at index and buf, wrapping once if needed
+static void copy_in(spsc_ring_t *ring, uint32_t index, const uint8_t *buf,
+                    uint32_t n) {
+  uint32_t at = index & ring->mask;
+  uint32_t first = ring->mask + 1 - at;
+  if (first > n)
+    first = n;
+
+  memcpy(ring->storage + at * ring->elem_size, buf, first * ring->elem_size);
+  memcpy(ring->storage, buf + first * ring->elem_size,
+         (n - first) * ring->elem_size);
+}
+
+static void copy_out(const spsc_ring_t *ring, uint32_t index, uint8_t *buf,
+                     uint32_t n) {
+  uint32_t at = index & ring->mask;
+  uint32_t first = ring->mask + 1 - at;
+  if (first > n)
+    first = n;
+
+  memcpy(buf, ring->storage + at * ring->elem_size, first * ring->elem_size);
+  memcpy(buf + first * ring->elem_size, ring->storage,
+         (n - first) * ring->elem_size);
+}
+
+uint32_t spsc_ring_push(spsc_ring_t *ring, const void *items, uint32_t n) {
+  uint32_t head = ring->head; // only we write it
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  uint32_t space = ring->mask + 1 - (head - tail);
+
+  if (n > space) {
+    ring->dropped += n - space;
+    n = space;
+  }
+  if (n == 0)
+    return 0;
+
+  copy_in(ring, head, items, n);
+  __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+  ring->pushed += n;
+
+  // pairs with the fence in spsc_ring_arm(): either the consumer sees the
+  // new head when it checks again, or we see it armed here
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ring->sleeping, __ATOMIC_RELAXED) &&
+      __atomic_exchange_n(&ring->sleeping, 0, __ATOMIC_ACQ_REL)) {
+    ring->notifies++;
+    xTaskNotifyGive(ring->consumer);
+  }
+  return n;
+}
+
+uint32_t spsc_ring_pop(spsc_ring_t *ring, void *items, uint32_t max) {
+  uint32_t tail = ring->tail; // only we write it
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t n = head - tail;
+
+  if (n > max)
+    n = max;
+  if (n == 0)
+    return 0;
+
+  copy_out(ring, tail, items, n);
+  __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+  return n;
+}
+
+uint32_t spsc_ring_count(const spsc_ring_t *ring) {
+  return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+bool spsc_ring_arm(spsc_ring_t *ring) {
+  ring->consumer = xTaskGetCurrentTaskHandle();
+  __atomic_store_n(&ring->sleeping, 1, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return spsc_ring_count(ring) == 0;
+}
+
+void spsc_ring_disarm(spsc_ring_t *ring) {
+  __atomic_store_n(&ring->sleeping, 0, __ATOMIC_RELAXED);
+}
+
+uint32_t spsc_ring_pop_wait(spsc_ring_t *ring, void *items, uint32_t max,
+                            TickType_t wait) {
+  uint32_t n = spsc_ring_pop(ring, items, max);
+  if (n || wait == 0)
+    return n;
+
+  if (spsc_ring_arm(ring))
+    ulTaskNotifyTake(pdTRUE, wait);
+  spsc_ring_disarm(ring);
+  return spsc_ring_pop(ring, items, max);
+}
@@ -2,6 +2,7 @@
  * @file day03 learning how the board starts up
  */
 
+#include "boot_trace.h"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
 #include "esp_system.h"
@@ -12,11 +13,16 @@
  *  Build and flash at offset 0x(OTA_0 offset)
  */
 void app_main(void) {
+  boot_trace_mark("app_main");
   const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+  boot_trace_mark("partition found");
 
   ESP_LOGI("OTA", "From OTA_0 Switching to partition: %s", next->label);
   esp_ota_set_boot_partition(next);
+  boot_trace_mark("otadata written");
 
+  // every reboot adds one trace to the capture, see boot_trace_diff.py
+  boot_trace_dump();
   ESP_LOGI("OTA", "Rebooting...");
   esp_restart();
 }
@@ -26,11 +32,15 @@ void app_main(void) {
  *  Build and flash at offset 0x(OTA_1 offset)
  */
 // void app_main(void) {
+//   boot_trace_mark("app_main");
 //   const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+//   boot_trace_mark("partition found");
 
 //   ESP_LOGI("OTA", "From OTA_1 Switching to partition: %s", next->label);
 //   esp_ota_set_boot_partition(next);
+//   boot_trace_mark("otadata written");
 
+//   boot_trace_dump();
 //   ESP_LOGI("OTA", "Rebooting...");
 //   esp_restart();
 // }
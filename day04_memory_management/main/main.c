@@ -9,6 +9,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "block_pool.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_system.h"
@@ -99,33 +100,11 @@ void task_fn(void *arg) {
 #define POOL_SIZE 10  // number of blocks
 #define BLOCK_SIZE 64 // size of each block
 
-static uint8_t pool[POOL_SIZE][BLOCK_SIZE];
-static bool used[POOL_SIZE] = {0}; // false = free
-
-// Allocate a block from the pool
-void *pool_alloc(void) {
-  for (int i = 0; i < POOL_SIZE; i++) {
-    if (!used[i]) {
-      used[i] = true;
-      ESP_LOGI(TAG, "Allocated block %d at %p", i, pool[i]);
-      return pool[i];
-    }
-  }
-  ESP_LOGW(TAG, "Memory pool exhausted!");
-  return NULL; // No free blocks
-}
-
-// Free a block back to the pool
-void pool_free(void *ptr) {
-  for (int i = 0; i < POOL_SIZE; i++) {
-    if (ptr == pool[i]) {
-      used[i] = false;
-      ESP_LOGI(TAG, "Freed block %d at %p", i, pool[i]);
-      return;
-    }
-  }
-  ESP_LOGW(TAG, "Attempt to free invalid pointer: %p", ptr);
-}
+// O(1) alloc and free (components/block_pool), no heap: the blocks and
+// their bitmap live in this static buffer
+static uint8_t pool_buf[BLOCK_POOL_BUF_SIZE(BLOCK_SIZE, POOL_SIZE)]
+    __attribute__((aligned(BLOCK_POOL_ALIGN)));
+static block_pool_t pool;
 
 // Example task to test memory pool
 void uart_sim_task(void *arg) {
@@ -133,7 +112,7 @@ void uart_sim_task(void *arg) {
 
   while (1) {
     // Simulate receiving a message
-    void *buf = pool_alloc();
+    void *buf = block_pool_alloc(&pool);
     if (buf != NULL) {
       // Fill buffer with dummy message
       snprintf((char *)buf, BLOCK_SIZE, "Message #%d", msg_count++);
@@ -143,9 +122,13 @@ void uart_sim_task(void *arg) {
       vTaskDelay(pdMS_TO_TICKS(200));
 
       // Free buffer
-      // pool_free(buf);
+      // block_pool_free(&pool, buf);
     } else {
-      ESP_LOGW(TAG, "Pool exhausted! Cannot receive new message.");
+      block_pool_stats_t stats = block_pool_get_stats(&pool);
+      ESP_LOGW(TAG, "Pool exhausted! Cannot receive new message. "
+                    "(%u allocs, %u failed, peak %u)",
+               (unsigned)stats.allocs, (unsigned)stats.alloc_fails,
+               (unsigned)stats.peak_in_use);
       vTaskDelay(pdMS_TO_TICKS(500));
     }
   }
@@ -203,6 +186,8 @@ void app_main(void) {
 
   /*  ========== 5 Memory Pool ========== */
   ESP_LOGI(TAG, "Starting Memory Pool Experiment");
+  ESP_ERROR_CHECK(block_pool_init_static(&pool, pool_buf, sizeof(pool_buf),
+                                         BLOCK_SIZE, POOL_SIZE));
   print_heap("Before UART Simulation");
   xTaskCreate(uart_sim_task, "uart_task", 2048, NULL, 5, NULL);
   print_heap("After UART Simulation");
@@ -1,57 +1,118 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <stdio.h>
+#include <stdlib.h>
 
-#include "esp_heap_caps.h"
-#include "esp_log.h"
+#include "alloc_trace.h"
+#include "dlog.h"
+#include "heap_telemetry.h"
+#include "slab.h"
 
 static const char *TAG = "MEM_MON";
 
-static void render_bar(char *buf, size_t buf_len, int percent) {
-  const int BAR_WIDTH = 10;
-  int filled = (percent * BAR_WIDTH) / 100;
-
-  int idx = 0;
-  buf[idx++] = '[';
+#define LOG_RING_LEN 32 // deferred log entries
+
+// The heap is read every SAMPLE_MS without printing anything; the status
+// below comes once per telemetry slot, alerts as soon as a slot raises one
+#define SAMPLE_MS 5000
+#define SLOT_MS 60000           // one ring entry: the floor of 12 samples
+#define SNAPSHOT_EVERY_SLOTS 10 // hex line for heap_telemetry_decode.py
+#define LEAK_BYTES_PER_MIN 0    // >0: leak on purpose to see the alert
+#define ALLOC_TRACE_MS 2000     // alloc_trace lines for alloc_trace_report.py
+
+static heap_telemetry_t telemetry;
+
+// fragment_task's sizes, one block each, for slab_task
+static const slab_class_config_t slab_classes[] = {
+    {1024, 1}, {2048, 1}, {4096, 1}, {8192, 1}, {16384, 1},
+};
+static slab_t slab;
+
+// The bars are literals: deferred entries keep the pointer, not the text
+static const char *const bars[] = {
+    "[__________]", "[#_________]", "[##________]", "[###_______]",
+    "[####______]", "[#####_____]", "[######____]", "[#######___]",
+    "[########__]", "[#########_]", "[##########]",
+};
+
+static const char *bar_for(int percent) {
+  if (percent < 0)
+    percent = 0;
+  if (percent > 100)
+    percent = 100;
+  return bars[percent / 10];
+}
 
-  for (int i = 0; i < BAR_WIDTH; i++) {
-    buf[idx++] = (i < filled) ? '■' : '_';
-  }
+static void on_heap_alert(const heap_telemetry_trend_t *trend, uint8_t raised,
+                          void *ctx) {
+  if (raised & HEAP_ALERT_LOW_FREE)
+    DLOGW(TAG, "caps 0x%x: free down to %u bytes", (unsigned)trend->caps,
+          (unsigned)trend->last.free);
+  if (raised & HEAP_ALERT_FRAGMENTED)
+    DLOGW(TAG, "caps 0x%x: fragmented, index %u/1000", (unsigned)trend->caps,
+          (unsigned)trend->last.frag_permille);
+  if (raised & HEAP_ALERT_LEAK)
+    DLOGW(TAG, "caps 0x%x: leaking %.0f bytes/min", (unsigned)trend->caps,
+          -trend->slope_bytes_per_min);
+}
 
-  buf[idx++] = ']';
-  buf[idx] = '\0';
+// The slot that just closed, for MALLOC_CAP_DEFAULT (the first tracked cap)
+static void print_status(void) {
+  const heap_telemetry_trend_t *trend = heap_telemetry_trend(&telemetry, 0);
+  int free_pct = (int)((uint64_t)trend->last.free * 100 / trend->total);
+  int min_pct = (int)((uint64_t)trend->min_free * 100 / trend->total);
+
+  // recorded in a few words, formatted later by the dlog task
+  DLOGI(TAG, "Heap status:");
+  DLOGI(TAG, "  Free heap       %s %d%%", bar_for(free_pct), free_pct);
+  DLOGI(TAG, "  Min free (ever) %s %d%%", bar_for(min_pct), min_pct);
+  DLOGI(TAG, "  Largest block   %s %u KB", bar_for(0), // visual only
+        (unsigned)(trend->last.largest / 1024));
+  DLOGI(TAG, "  Fragmentation   %u/1000, trend %.0f bytes/min",
+        (unsigned)trend->last.frag_permille, trend->slope_bytes_per_min);
+  // the same pattern on the slab: the largest block stays whole
+  DLOGI(TAG, "  Slab free %u KB, largest %u KB",
+        (unsigned)(slab_get_free_size(&slab) / 1024),
+        (unsigned)(slab_get_largest_free_block(&slab) / 1024));
 }
 
 void mem_monitor_task(void *pvParameters) {
-  ESP_LOGI(TAG, "Memory monitor started");
-
-  const size_t total_heap = heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
-
-  char bar[16];
+  DLOGI(TAG, "Memory monitor started");
+
+  const heap_telemetry_config_t config = {
+      .slot_ms = SLOT_MS,
+      .low_free_bytes = 16 * 1024,
+      .frag_permille = 700,
+      .leak_bytes_per_min = 100,
+      .min_slots = 10,
+      .on_alert = on_heap_alert,
+  };
+  ESP_ERROR_CHECK(heap_telemetry_init(&telemetry, &config));
+  uint32_t reported = 0;
 
   while (1) {
-    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
-    size_t min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
-    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
-
-    int free_pct = (free_heap * 100) / total_heap;
-    int min_pct = (min_free * 100) / total_heap;
-
-    ESP_LOGI(TAG, "Heap status:");
-
-    render_bar(bar, sizeof(bar), free_pct);
-    ESP_LOGI(TAG, "  Free heap       %s %d%%", bar, free_pct);
-
-    render_bar(bar, sizeof(bar), min_pct);
-    ESP_LOGI(TAG, "  Min free (ever) %s %d%%", bar, min_pct);
-
-    render_bar(bar, sizeof(bar), 0); // visual only
-    ESP_LOGI(TAG, "  Largest block   %s %u KB", bar,
-             (unsigned)(largest / 1024));
+    heap_telemetry_sample(&telemetry);
+    if (telemetry.slots != reported) {
+      reported = telemetry.slots;
+      print_status(); // once per slot, not every sample
+      if (reported % SNAPSHOT_EVERY_SLOTS == 0) {
+        dlog_flush(); // the hex line after the status, not inside it
+        heap_telemetry_print(&telemetry);
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(SAMPLE_MS));
+  }
+}
 
-    vTaskDelay(pdMS_TO_TICKS(5000));
+#if LEAK_BYTES_PER_MIN
+// Never frees: the telemetry should call it out after min_slots slots
+void leak_task(void *pvParameters) {
+  while (1) {
+    (void)malloc(LEAK_BYTES_PER_MIN / 6);
+    vTaskDelay(pdMS_TO_TICKS(10000));
   }
 }
+#endif
 
 void fragment_task(void *pvParameters) {
   void *blocks[5];
@@ -78,6 +139,33 @@ void fragment_task(void *pvParameters) {
   }
 }
 
+// fragment_task's pattern through a slab cache: blocks come from size
+// classes set aside at init, so what the heap monitor sees does not move
+void slab_task(void *pvParameters) {
+  static const size_t sizes[5] = {1024, 2048, 4096, 8192, 16384};
+  slab_cache_t cache;
+  void *blocks[5];
+
+  ESP_ERROR_CHECK(slab_cache_init(&cache, &slab));
+  while (1) {
+    for (int i = 0; i < 5; i++)
+      blocks[i] = slab_cache_alloc(&cache, sizes[i]);
+
+    vTaskDelay(pdMS_TO_TICKS(2000));
+
+    slab_cache_free(&cache, blocks[1]);
+    slab_cache_free(&cache, blocks[3]);
+
+    vTaskDelay(pdMS_TO_TICKS(2000));
+
+    slab_cache_free(&cache, blocks[0]);
+    slab_cache_free(&cache, blocks[2]);
+    slab_cache_free(&cache, blocks[4]);
+
+    vTaskDelay(pdMS_TO_TICKS(5000));
+  }
+}
+
 void alloc_task(void *pvParameters) {
   const size_t alloc_size = 1024 * 10; // 10 KB
   void *ptr = NULL;
@@ -86,13 +174,13 @@ void alloc_task(void *pvParameters) {
     ptr = malloc(alloc_size);
 
     if (ptr != NULL) {
-      ESP_LOGI("ALLOC", "Allocated %u bytes", alloc_size);
+      DLOGI("ALLOC", "Allocated %u bytes", alloc_size);
       vTaskDelay(pdMS_TO_TICKS(3000));
 
       free(ptr);
-      ESP_LOGI("ALLOC", "Freed %u bytes", alloc_size);
+      DLOGI("ALLOC", "Freed %u bytes", alloc_size);
     } else {
-      ESP_LOGE("ALLOC", "Allocation failed!");
+      DLOGE("ALLOC", "Allocation failed!");
     }
 
     vTaskDelay(pdMS_TO_TICKS(3000));
@@ -100,7 +188,20 @@ void alloc_task(void *pvParameters) {
 }
 
 void app_main(void) {
-  xTaskCreate(mem_monitor_task, "memory_monitor", 2048, NULL, 5, NULL);
+  // from the first allocation on, so the boot-time owners show up too
+  if (alloc_trace_enabled()) {
+    alloc_trace_start();
+    alloc_trace_task_create(ALLOC_TRACE_MS, 1);
+  }
+  dlog_init(LOG_RING_LEN);
+  dlog_task_create(false, 500, 1); // true: binary frames for dlog_decode.py
+  ESP_ERROR_CHECK(slab_init(&slab, slab_classes,
+                            sizeof(slab_classes) / sizeof(slab_classes[0])));
+  xTaskCreate(mem_monitor_task, "memory_monitor", 3072, NULL, 5, NULL);
   xTaskCreate(alloc_task, "alloc_task", 2048, NULL, 5, NULL);
   xTaskCreate(fragment_task, "frag_task", 2048, NULL, 5, NULL);
+  xTaskCreate(slab_task, "slab_task", 2048, NULL, 5, NULL);
+#if LEAK_BYTES_PER_MIN
+  xTaskCreate(leak_task, "leak_task", 2048, NULL, 5, NULL);
+#endif
 }
@@ -0,0 +1,60 @@
+/**
+ * @file boot_time.c boot phase timestamps and the wake latency
+ */
+
+#include "boot_time.h"
+#include "boot_trace.h"
+#include "common/messages.h"
+#include "dlog.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+static const char *TAG = "BOOT";
+
+static boot_time_t boot;
+
+// checkpoint names in the boot trace, compared between builds by
+// boot_trace_diff.py
+static const char *const phase_names[BOOT_NUM_PHASES] = {
+    [BOOT_APP_MAIN] = "app_main",
+    [BOOT_SENSORS] = "sensors ready",
+    [BOOT_FIRST_SAMPLE] = "first sample",
+    [BOOT_PIPELINE] = "pipeline up",
+    [BOOT_FLUSHED] = "batch logged",
+};
+
+// acq_time_us() the sleep timer fires at, 0 before the first sleep
+RTC_DATA_ATTR static int64_t wake_due_us;
+
+void boot_time_start(bool warm) {
+  boot = (boot_time_t){.warm = warm, .wake_to_sample_us = -1};
+  boot.at_us[BOOT_APP_MAIN] = esp_timer_get_time();
+  boot_trace_mark(phase_names[BOOT_APP_MAIN]);
+  if (!warm)
+    wake_due_us = 0;
+}
+
+void boot_time_mark(boot_phase_t phase) {
+  if (boot.at_us[phase])
+    return;
+  boot.at_us[phase] = esp_timer_get_time();
+  boot_trace_mark(phase_names[phase]);
+  if (phase == BOOT_FIRST_SAMPLE && wake_due_us)
+    boot.wake_to_sample_us = acq_time_us() - wake_due_us;
+}
+
+const boot_time_t *boot_time_get(void) { return &boot; }
+
+void boot_time_sleep(uint32_t sleep_ms) {
+  const int64_t *t = boot.at_us;
+
+  // -1: that phase did not run on this wake
+  DLOGI(TAG, "%s wake: sensors %lld, first sample %lld, pipeline %lld us; "
+             "%lld us from timer to sample",
+        boot.warm ? "warm" : "cold",
+        t[BOOT_SENSORS] ? t[BOOT_SENSORS] : -1,
+        t[BOOT_FIRST_SAMPLE] ? t[BOOT_FIRST_SAMPLE] : -1,
+        t[BOOT_PIPELINE] ? t[BOOT_PIPELINE] : -1, boot.wake_to_sample_us);
+  boot_trace_dump();
+  wake_due_us = acq_time_us() + (int64_t)sleep_ms * 1000;
+}
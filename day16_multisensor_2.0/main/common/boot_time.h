@@ -0,0 +1,45 @@
+/**
+ * @file boot_time.h timestamps of the phases of one wake
+ *
+ * Each phase is stamped with esp_timer_get_time(), which starts with the
+ * app, so it does not see the ROM and the bootloader. The wake itself is
+ * timed on acq_time_us(): going to sleep records when the timer is due,
+ * and the first sample measures how long after that it was taken.
+ *
+ * The phases also go to components/boot_trace, dumped before every sleep,
+ * so boot_trace_diff.py can compare wakes between builds.
+ */
+
+#ifndef BOOT_TIME_H
+#define BOOT_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+  BOOT_APP_MAIN,     // app_main() entered
+  BOOT_SENSORS,      // drivers ready
+  BOOT_FIRST_SAMPLE, // first sensor read
+  BOOT_PIPELINE,     // config, pools and tasks up (flush wakes only)
+  BOOT_FLUSHED,      // batch logged (flush wakes only)
+  BOOT_NUM_PHASES
+} boot_phase_t;
+
+typedef struct {
+  bool warm;
+  int64_t at_us[BOOT_NUM_PHASES]; // esp_timer_get_time(), 0: not reached
+  int64_t wake_to_sample_us; // timer due to first sample, -1 on a cold boot
+} boot_time_t;
+
+void boot_time_start(bool warm);
+
+// The first call per phase counts
+void boot_time_mark(boot_phase_t phase);
+
+const boot_time_t *boot_time_get(void);
+
+// One log line with the phases and the boot trace dump, then note when
+// the next wake is due
+void boot_time_sleep(uint32_t sleep_ms);
+
+#endif // BOOT_TIME_H
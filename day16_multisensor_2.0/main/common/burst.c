@@ -0,0 +1,66 @@
+/**
+ * @file burst.c RTC sample ring and the per-wake decision
+ */
+
+#include "burst.h"
+#include <string.h>
+
+bool burst_valid(const burst_state_t *s) {
+  return s->magic == BURST_MAGIC && s->count <= BURST_RING_LEN &&
+         s->head < BURST_RING_LEN && s->flush_every > 0;
+}
+
+void burst_reset(burst_state_t *s, uint16_t flush_every) {
+  memset(s, 0, sizeof(*s));
+  s->magic = BURST_MAGIC;
+  s->flush_every = flush_every ? flush_every : 1;
+}
+
+void burst_add(burst_state_t *s, const sensor_msg_t *msg) {
+  if (s->count == BURST_RING_LEN) {
+    s->head = (s->head + 1) % BURST_RING_LEN;
+    s->count--;
+    s->stats.dropped++;
+  }
+  s->ring[(s->head + s->count) % BURST_RING_LEN] = *msg;
+  s->count++;
+  s->stats.samples++;
+}
+
+int burst_take(burst_state_t *s, sensor_msg_t *out, int max) {
+  int n = 0;
+
+  while (n < max && s->count) {
+    out[n++] = s->ring[s->head];
+    s->head = (s->head + 1) % BURST_RING_LEN;
+    s->count--;
+  }
+  s->stats.flushed += n;
+  return n;
+}
+
+bool burst_flush_due(const burst_state_t *s) {
+  // sample_ms is only known once the pipeline has read the config
+  return s->sample_ms == 0 || s->cycles >= s->flush_every ||
+         s->count > BURST_RING_LEN - BURST_MAX_PER_WAKE;
+}
+
+uint32_t burst_wake(burst_state_t *s, bool warm, uint16_t flush_every,
+                    const burst_ops_t *ops) {
+  // a cold boot (power on, reset, flash) starts a new ring
+  if (!warm || !burst_valid(s))
+    burst_reset(s, flush_every);
+
+  s->stats.wakes++;
+  s->cycles++;
+  ops->acquire(s, ops->ctx);
+  if (!burst_flush_due(s))
+    return s->sample_ms; // the short wake: sensors only
+
+  s->stats.pipeline_boots++;
+  s->sample_ms = ops->start_pipeline(ops->ctx);
+  s->flush_every = flush_every ? flush_every : 1;
+  ops->flush(s, ops->ctx);
+  s->cycles = 0;
+  return s->sample_ms;
+}
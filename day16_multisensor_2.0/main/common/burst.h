@@ -0,0 +1,73 @@
+/**
+ * @file burst.h burst-and-sleep acquisition: samples kept in RTC memory
+ * across deep sleep, the pipeline booted only to flush them
+ *
+ * Every wake reads the sensors straight into a ring that lives in RTC slow
+ * memory and goes back to sleep. Only every flush_every wakes (and on a
+ * cold boot, or when the ring is nearly full) does the wake start NVS, the
+ * pools and the tasks and hand them the whole batch.
+ *
+ * burst_wake() holds the decision; what a wake does is behind burst_ops_t,
+ * so main.c drives the hardware and the host model counts the work.
+ * No RTOS calls.
+ */
+
+#ifndef BURST_H
+#define BURST_H
+
+#include "common/messages.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BURST_MAGIC 0x42525354 // RTC memory survives deep sleep, not resets
+#define BURST_MAX_PER_WAKE NUM_SENSOR_LINKS // one sample per sensor
+// every sensor's samples of one batch fit its link to the aggregator
+#define BURST_RING_LEN (SENSOR_LINK_LEN * NUM_SENSOR_LINKS)
+
+typedef struct {
+  uint32_t wakes;
+  uint32_t pipeline_boots;
+  uint32_t samples;
+  uint32_t flushed;
+  uint32_t dropped; // overwritten before a flush
+} burst_stats_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t sample_ms;   // sleep between wakes, from NVS at the last boot
+  uint16_t flush_every; // wakes per pipeline boot
+  uint16_t cycles;      // wakes since the last flush
+  uint16_t head;        // oldest sample
+  uint16_t count;
+  burst_stats_t stats;
+  sensor_msg_t ring[BURST_RING_LEN];
+} burst_state_t;
+
+typedef struct {
+  // read this wake's samples with burst_add(), drivers only
+  void (*acquire)(burst_state_t *s, void *ctx);
+  // NVS, pools, tasks; returns the sample period (ms) from the config
+  uint32_t (*start_pipeline)(void *ctx);
+  // take the samples with burst_take() and wait until they are logged
+  void (*flush)(burst_state_t *s, void *ctx);
+  void *ctx;
+} burst_ops_t;
+
+// Still holds a ring from before the last deep sleep
+bool burst_valid(const burst_state_t *s);
+void burst_reset(burst_state_t *s, uint16_t flush_every);
+
+// Append one sample; a full ring overwrites the oldest
+void burst_add(burst_state_t *s, const sensor_msg_t *msg);
+// Oldest first, at most max; they leave the ring
+int burst_take(burst_state_t *s, sensor_msg_t *out, int max);
+
+// The pipeline has to run on this wake
+bool burst_flush_due(const burst_state_t *s);
+
+// One wake. warm: woken by the sleep timer with a valid ring. Returns how
+// long to sleep (ms).
+uint32_t burst_wake(burst_state_t *s, bool warm, uint16_t flush_every,
+                    const burst_ops_t *ops);
+
+#endif // BURST_H
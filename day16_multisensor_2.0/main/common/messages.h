@@ -4,13 +4,58 @@
 #ifndef MESSAGES_H
 #define MESSAGES_H
 
+#include "msg_bus.h"
+#include "spsc_ring.h"
 #include <stdio.h>
+#include <sys/time.h>
 
 typedef enum { SENSOR_IMU, SENSOR_ULTRASONIC } sensor_type_t;
 
+#define SENSOR_MSG_DATA_LEN 7 // IMU: accel xyz, temperature, gyro xyz
+
+// Acquisition timebase: the RTC-backed system time, which keeps running
+// through deep sleep, so samples from different wakes line up
+// (esp_timer_get_time() restarts at every boot)
+static inline int64_t acq_time_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 typedef struct {
   sensor_type_t type;
-  int64_t timestamp; // acquisition time
-  float data[4];
+  int64_t timestamp; // acquisition time, acq_time_us()
+  float data[SENSOR_MSG_DATA_LEN];
 } sensor_msg_t;
+
+#define NUM_SENSOR_LINKS 2 // one per sensor_type_t
+
+// One record per fusion tick: every sensor's value at the same instant
+typedef struct {
+  int64_t timestamp; // the tick, on the common timebase
+  uint32_t valid;    // bit (1 << sensor_type_t) set when that sensor has data
+  float data[NUM_SENSOR_LINKS][SENSOR_MSG_DATA_LEN];
+} fused_msg_t;
+
+// Messages live in a msg_bus pool, the queues only carry pointers
+#define SENSOR_LINK_LEN 16 // per sensor, a power of two
+#define AGG_TO_LOG_Q_LEN 50
+// the links full, plus one block held by each sensor task
+#define SENSOR_MSG_POOL_LEN (NUM_SENSOR_LINKS * (SENSOR_LINK_LEN + 1))
+// the logger queue full, plus one being built and one being printed
+#define FUSED_MSG_POOL_LEN (AGG_TO_LOG_Q_LEN + 2)
+
+// One sensor task -> aggregator link: lock-free, no kernel call while the
+// aggregator is awake
+typedef struct {
+  msg_pool_t *pool;
+  spsc_ring_t ring; // sensor_msg_t *
+  sensor_msg_t *slots[SENSOR_LINK_LEN];
+} sensor_link_t;
+
+static inline bool sensor_link_init(sensor_link_t *link, msg_pool_t *pool) {
+  link->pool = pool;
+  return spsc_ring_init(&link->ring, link->slots, sizeof(sensor_msg_t *),
+                        SENSOR_LINK_LEN);
+}
 #endif // MESSAGES_H
@@ -5,6 +5,7 @@
 #include "imu_driver.h"
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include <string.h>
 
 static const char *TAG = "IMU_DRIVER";
 
@@ -35,8 +36,8 @@ void i2c_scan(i2c_port_t i2c_num) {
   }
 }
 
-// Initialize I2C bus and IMU
-bool imu_init(imu_t *sensor) {
+// The ESP32 side of the bus; lost in deep sleep with the rest of the chip
+static void imu_bus_init(const imu_t *sensor) {
   i2c_config_t conf = {
       .mode = I2C_MODE_MASTER,
       .sda_io_num = sensor->sda_pin,
@@ -47,7 +48,10 @@ bool imu_init(imu_t *sensor) {
   };
   i2c_param_config(I2C_MASTER_NUM, &conf);
   i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0);
+}
 
+// Clear the sleep bit, keeping the rest of PWR_MGMT_1
+static bool imu_wake(imu_t *sensor) {
   uint8_t data = 0;
 
   // 1️⃣ Write PWR_MGMT_1 register address
@@ -103,49 +107,68 @@ bool imu_init(imu_t *sensor) {
   return true;
 }
 
-// Read gyro data
-bool imu_read_data(imu_t *sensor, float *data) {
-  uint8_t buf[6];
-  uint8_t reg_addr = GYRO_XOUT_H;
+// Initialize I2C bus and IMU
+bool imu_init(imu_t *sensor) {
+  imu_bus_init(sensor);
+  return imu_wake(sensor);
+}
 
-  // Write register first
-  i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-  i2c_master_start(cmd);
-  i2c_master_write_byte(cmd, MPU_ADDR(sensor->i2c_addr) | I2C_MASTER_WRITE,
-                        true);
-  i2c_master_write_byte(cmd, reg_addr, true);
-  i2c_master_stop(cmd);
-  if (i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 100 / portTICK_PERIOD_MS) !=
-      ESP_OK) {
-    ESP_LOGE(TAG, "Failed to select GYRO_XOUT_H register");
-    i2c_cmd_link_delete(cmd);
+bool imu_resume(imu_t *sensor) {
+  imu_bus_init(sensor);
+
+  // one transaction to check the sensor is still set up; a power cut
+  // would have left it in its reset state, asleep
+  uint8_t reg = PWR_MGMT_1, pwr = 0x40;
+  if (i2c_master_write_read_device(I2C_MASTER_NUM, sensor->i2c_addr, &reg, 1,
+                                   &pwr, 1, 100 / portTICK_PERIOD_MS) ==
+          ESP_OK &&
+      !(pwr & 0x40))
+    return true;
+
+  ESP_LOGW(TAG, "IMU lost its setup during sleep, waking it again");
+  return imu_wake(sensor);
+}
+
+// Read the 14-byte frame: register select, repeated START, burst read
+bool imu_read_frame(imu_t *sensor, uint8_t *frame) {
+  if (!i2c_prepared_ready(&sensor->frame_read) &&
+      i2c_prepared_read_regs(&sensor->frame_read, I2C_MASTER_NUM,
+                             sensor->i2c_addr, ACCEL_XOUT_H, sensor->frame,
+                             IMU_FRAME_LEN) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to build IMU frame read");
     return false;
   }
-  i2c_cmd_link_delete(cmd);
 
-  // Read 6 bytes
-  cmd = i2c_cmd_link_create();
-  i2c_master_start(cmd);
-  i2c_master_write_byte(cmd, MPU_ADDR(sensor->i2c_addr) | I2C_MASTER_READ,
-                        true);
-  i2c_master_read(cmd, buf, 6, I2C_MASTER_LAST_NACK);
-  i2c_master_stop(cmd);
-  if (i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 100 / portTICK_PERIOD_MS) !=
-      ESP_OK) {
-    ESP_LOGE(TAG, "Failed to read gyro");
-    i2c_cmd_link_delete(cmd);
+  esp_err_t ret = i2c_prepared_run(&sensor->frame_read,
+                                   100 / portTICK_PERIOD_MS);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to read IMU frame");
     return false;
   }
-  i2c_cmd_link_delete(cmd);
 
-  int16_t gx = (buf[0] << 8) | buf[1];
-  int16_t gy = (buf[2] << 8) | buf[3];
-  int16_t gz = (buf[4] << 8) | buf[5];
+  memcpy(frame, sensor->frame, IMU_FRAME_LEN);
+  return true;
+}
 
-  data[0] = gx / 131.0f;
-  data[1] = gy / 131.0f;
-  data[2] = gz / 131.0f;
-  data[3] = 0;
+// Read accel, temperature and gyro
+bool imu_read_data(imu_t *sensor, float *data) {
+  uint8_t buf[IMU_FRAME_LEN];
+
+  if (!imu_read_frame(sensor, buf))
+    return false;
+
+  // big-endian pairs: accel x/y/z, temp, gyro x/y/z
+  int16_t raw[IMU_DATA_LEN];
+  for (int i = 0; i < IMU_DATA_LEN; i++)
+    raw[i] = (int16_t)((buf[2 * i] << 8) | buf[2 * i + 1]);
+
+  data[IMU_AX] = raw[IMU_AX] / 16384.0f; // +-2 g
+  data[IMU_AY] = raw[IMU_AY] / 16384.0f;
+  data[IMU_AZ] = raw[IMU_AZ] / 16384.0f;
+  data[IMU_TEMP] = raw[IMU_TEMP] / 340.0f + 36.53f;
+  data[IMU_GX] = raw[IMU_GX] / 131.0f; // +-250 deg/s
+  data[IMU_GY] = raw[IMU_GY] / 131.0f;
+  data[IMU_GZ] = raw[IMU_GZ] / 131.0f;
 
   return true;
-}
\ No newline at end of file
+}
@@ -7,20 +7,46 @@
 
 #include "driver/gpio.h"
 #include "driver/i2c.h"
+#include "i2c_prepared.h"
 #include <stdbool.h>
 
+#define IMU_FRAME_LEN 14 // ACCEL_XOUT_H..GYRO_ZOUT_L
+
+// Layout of the values filled by imu_read_data()
+enum {
+  IMU_AX, // g
+  IMU_AY,
+  IMU_AZ,
+  IMU_TEMP, // deg C
+  IMU_GX,   // deg/s
+  IMU_GY,
+  IMU_GZ,
+  IMU_DATA_LEN
+};
+
 typedef struct {
   int i2c_addr;
   gpio_num_t sda_pin;
   gpio_num_t scl_pin;
+
+  // frame read built on first use and rerun for every sample
+  i2c_prepared_t frame_read;
+  uint8_t frame[IMU_FRAME_LEN];
 } imu_t;
 
 // initialize IMU
 bool imu_init(imu_t *sensor);
 
+// after a deep sleep wake: the I2C driver again, the sensor only if it
+// lost power (it keeps its registers while the ESP32 sleeps)
+bool imu_resume(imu_t *sensor);
+
 void i2c_scan(i2c_port_t i2c_num);
 
-// read data from sepecified IMU
+// read the raw accel, temp and gyro registers in one transaction
+bool imu_read_frame(imu_t *sensor, uint8_t *frame);
+
+// read data from sepecified IMU, data holds IMU_DATA_LEN values
 bool imu_read_data(imu_t *sensor, float *data);
 
 #endif // IMU_DRIVER_H
\ No newline at end of file
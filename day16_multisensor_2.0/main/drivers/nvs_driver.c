@@ -9,6 +9,18 @@
 #include "nvs.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_attr.h"
+
+#define CONFIG_CACHE_MAGIC 0x43464743 // "CFGC"
+
+// config as last loaded, kept in RTC memory through deep sleep
+typedef struct
+{
+    uint32_t magic;
+    app_config_t config;
+} config_cache_t;
+
+RTC_DATA_ATTR static config_cache_t config_cache;
 
 // Default values
 const app_config_t default_config = {
@@ -50,6 +62,7 @@ void save_config(const app_config_t *config)
     ESP_ERROR_CHECK(nvs_commit(nvs_handle));
 
     nvs_close(nvs_handle);
+    config_cache.config = *config; // the next warm wake uses the new values
 }
 
 void load_config(app_config_t *config)
@@ -85,3 +98,17 @@ void load_config(app_config_t *config)
 
     nvs_close(nvs_handle);
 }
+
+bool load_config_cached(app_config_t *config, bool warm)
+{
+    if (warm && config_cache.magic == CONFIG_CACHE_MAGIC) {
+        *config = config_cache.config;
+        return true;
+    }
+
+    init_nvs();
+    load_config(config);
+    config_cache.config = *config;
+    config_cache.magic = CONFIG_CACHE_MAGIC;
+    return false;
+}
@@ -5,6 +5,7 @@
 #ifndef NVS_DRIVER_H
 #define NVS_DRIVER_H
 
+#include <stdbool.h>
 #include <stdio.h>
 
 typedef struct
@@ -18,4 +19,8 @@ void init_nvs();
 void save_config(const app_config_t *config);
 void load_config(app_config_t *config);
 
+// warm (deep sleep wake): the copy kept in RTC memory, no NVS access.
+// Otherwise init_nvs() and load_config(). Returns true on a cache hit.
+bool load_config_cached(app_config_t *config, bool warm);
+
 #endif // NVS_DRIVER_H
\ No newline at end of file
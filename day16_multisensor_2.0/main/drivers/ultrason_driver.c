@@ -6,13 +6,27 @@
 
 #include "ultrason_driver.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "ULTRASON_DRIVER";
 
+// Convert to cm: speed of sound ~ 343 m/s, there and back
+float ultrason_pulse_to_cm(int64_t pulse_duration_us) {
+  return (pulse_duration_us / 2.0f) * 0.0343f;
+}
+
+void ultrason_trigger(const ultrason_t *sensor) {
+  // Trigger a 10µs pulse
+  gpio_set_level(sensor->trig_pin, 1);
+  esp_rom_delay_us(10);
+  gpio_set_level(sensor->trig_pin, 0);
+}
+
 bool ultrason_init(ultrason_t *sensor) {
   if (!sensor)
     return false;
@@ -37,18 +51,84 @@ bool ultrason_init(ultrason_t *sensor) {
   return true;
 }
 
+static void IRAM_ATTR echo_isr(void *arg) {
+  ultrason_t *sensor = arg;
+  int64_t now = esp_timer_get_time();
+
+  if (gpio_get_level(sensor->echo_pin)) {
+    sensor->rise_us = now;
+    return;
+  }
+
+  // a falling edge without its rise is the tail of an older echo
+  TaskHandle_t waiter = sensor->waiter;
+  if (sensor->rise_us == ULTRASON_NO_EDGE || !waiter)
+    return;
+
+  sensor->fall_us = now;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(waiter, &woken);
+  if (woken)
+    portYIELD_FROM_ISR();
+}
+
+bool ultrason_capture_init(ultrason_t *sensor) {
+  if (!sensor)
+    return false;
+
+  sensor->rise_us = ULTRASON_NO_EDGE;
+  sensor->fall_us = ULTRASON_NO_EDGE;
+  sensor->waiter = NULL;
+
+  // already installed by another driver is fine
+  esp_err_t ret = gpio_install_isr_service(0);
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    return false;
+
+  gpio_set_intr_type(sensor->echo_pin, GPIO_INTR_ANYEDGE);
+  if (gpio_isr_handler_add(sensor->echo_pin, echo_isr, sensor) != ESP_OK)
+    return false;
+
+  sensor->capture = true;
+  return true;
+}
+
+// Edge capture: the task sleeps until the ISR has seen both edges
+static bool read_captured(ultrason_t *sensor, float *distance) {
+  sensor->rise_us = ULTRASON_NO_EDGE;
+  sensor->fall_us = ULTRASON_NO_EDGE;
+  ulTaskNotifyTake(pdTRUE, 0); // drop a late wakeup from a timed-out reading
+  sensor->waiter = xTaskGetCurrentTaskHandle();
+
+  ultrason_trigger(sensor);
+
+  bool done = ulTaskNotifyTake(pdTRUE,
+                               pdMS_TO_TICKS(2 * ULTRASON_TIMEOUT_US / 1000));
+  sensor->waiter = NULL;
+
+  if (!done) {
+    if (sensor->rise_us == ULTRASON_NO_EDGE)
+      ESP_LOGE(TAG, "Echo timeout");
+    else
+      ESP_LOGW(TAG, "Echo pulse too long");
+    return false;
+  }
+
+  *distance = ultrason_pulse_to_cm(sensor->fall_us - sensor->rise_us);
+  return true;
+}
+
 bool ultrason_read_data(ultrason_t *sensor, float *distance) {
   if (!sensor || !distance)
     return false;
+  if (sensor->capture)
+    return read_captured(sensor, distance);
 
-  // Trigger a 10µs pulse
-  gpio_set_level(sensor->trig_pin, 1);
-  esp_rom_delay_us(10);
-  gpio_set_level(sensor->trig_pin, 0);
+  ultrason_trigger(sensor);
 
   // Wait for echo pin to go HIGH
   int64_t start_time = esp_timer_get_time();
-  int64_t timeout = 100000; // 30ms timeout (~5m distance)
+  int64_t timeout = ULTRASON_TIMEOUT_US;
   while (gpio_get_level(sensor->echo_pin) == 0) {
     if ((esp_timer_get_time() - start_time) > timeout) {
       ESP_LOGE(TAG, "Echo timeout");
@@ -66,10 +146,7 @@ bool ultrason_read_data(ultrason_t *sensor, float *distance) {
   }
   int64_t echo_end = esp_timer_get_time();
 
-  int64_t pulse_duration_us = echo_end - echo_start;
-
-  // Convert to cm: speed of sound ~ 343 m/s
-  *distance = (pulse_duration_us / 2.0f) * 0.0343f;
+  *distance = ultrason_pulse_to_cm(echo_end - echo_start);
 
   return true;
 }
@@ -7,15 +7,38 @@
 #define ULTRASON_DRIVER_H
 
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ULTRASON_TIMEOUT_US 100000 // wait for the echo, then for its end
+#define ULTRASON_NO_EDGE (-1)
 
 typedef struct {
   gpio_num_t trig_pin;
   gpio_num_t echo_pin;
+
+  // Edge capture (ultrason_capture_init): the echo ISR timestamps both
+  // edges and wakes the reading task instead of it spinning on the pin
+  bool capture;
+  TaskHandle_t waiter;
+  volatile int64_t rise_us;
+  volatile int64_t fall_us;
 } ultrason_t;
 
 // initialize ULTRASONIC
 bool ultrason_init(ultrason_t *sensor);
 
+// switch the echo pin to edge interrupts, after ultrason_init
+bool ultrason_capture_init(ultrason_t *sensor);
+
+// echo pulse width to distance in cm
+float ultrason_pulse_to_cm(int64_t pulse_duration_us);
+
+// send the 10 µs trigger pulse only, for callers that time the echo themselves
+void ultrason_trigger(const ultrason_t *sensor);
+
 // read data from sepecified IMU
 bool ultrason_read_data(ultrason_t *sensor, float *data);
 
@@ -0,0 +1,172 @@
+/**
+ * @file ultrason_ranging.c staggered triggers, per-sensor echo ISRs and
+ * crosstalk filter
+ */
+
+#include "ultrason_ranging.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "ULTRASON_RANGING";
+
+static void IRAM_ATTR echo_isr(void *arg) {
+  ranging_slot_t *slot = arg;
+  ultrason_ranging_t *r = slot->owner;
+  int64_t now = esp_timer_get_time();
+  TaskHandle_t task = NULL;
+
+  portENTER_CRITICAL_ISR(&r->lock);
+  if (gpio_get_level(slot->sensor->echo_pin)) {
+    if (slot->state == RANGING_SENT) {
+      slot->rise_us = now;
+      slot->state = RANGING_ECHO;
+    }
+  } else if (slot->state == RANGING_ECHO) {
+    slot->fall_us = now;
+    slot->state = RANGING_DONE;
+    task = r->task;
+  }
+  portEXIT_CRITICAL_ISR(&r->lock);
+
+  if (task) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    if (woken)
+      portYIELD_FROM_ISR();
+  }
+}
+
+bool ultrason_ranging_init(ultrason_ranging_t *r, ultrason_t *sensors,
+                           int num_sensors,
+                           const ultrason_ranging_config_t *config) {
+  if (!r || !sensors || !config || num_sensors < 1 ||
+      num_sensors > ULTRASON_RANGING_MAX_SENSORS || config->cycle_us <= 0)
+    return false;
+
+  memset(r, 0, sizeof(*r));
+  r->config = *config;
+  r->num_sensors = num_sensors;
+  r->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+
+  // already installed by another driver is fine
+  esp_err_t ret = gpio_install_isr_service(0);
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    return false;
+
+  int64_t now = esp_timer_get_time();
+  for (int i = 0; i < num_sensors; i++) {
+    ranging_slot_t *slot = &r->slots[i];
+
+    slot->owner = r;
+    slot->sensor = &sensors[i];
+    slot->state = RANGING_IDLE;
+    slot->rise_us = ULTRASON_NO_EDGE;
+    slot->fall_us = ULTRASON_NO_EDGE;
+    slot->last_burst_us = ULTRASON_NO_EDGE;
+    slot->next_trig_us = now + i * config->cycle_us / num_sensors;
+
+    gpio_set_intr_type(slot->sensor->echo_pin, GPIO_INTR_ANYEDGE);
+    if (gpio_isr_handler_add(slot->sensor->echo_pin, echo_isr, slot) != ESP_OK)
+      return false;
+  }
+  return true;
+}
+
+// Another sensor's burst started during our echo and the echo ended right
+// after it: we heard that burst, not our own reflection
+static bool heard_other_burst(const ultrason_ranging_t *r, int self,
+                              int64_t rise_us, int64_t fall_us) {
+  for (int j = 0; j < r->num_sensors; j++) {
+    if (j == self)
+      continue;
+
+    const ranging_slot_t *other = &r->slots[j];
+    int64_t bursts[2] = {other->rise_us, other->last_burst_us};
+    for (int k = 0; k < 2; k++) {
+      if (bursts[k] == ULTRASON_NO_EDGE)
+        continue;
+      if (bursts[k] > rise_us && bursts[k] <= fall_us &&
+          fall_us - bursts[k] < r->config.xtalk_window_us)
+        return true;
+    }
+  }
+  return false;
+}
+
+int ultrason_ranging_service(ultrason_ranging_t *r, ultrason_range_t *out,
+                             int max) {
+  int n = 0;
+  int64_t now = esp_timer_get_time();
+
+  for (int i = 0; i < r->num_sensors; i++) {
+    ranging_slot_t *slot = &r->slots[i];
+
+    portENTER_CRITICAL(&r->lock);
+    ranging_state_t state = slot->state;
+    int64_t rise_us = slot->rise_us;
+    int64_t fall_us = slot->fall_us;
+    bool expired = (state == RANGING_SENT || state == RANGING_ECHO) &&
+                   now - slot->trig_us > r->config.timeout_us;
+    if (expired)
+      slot->state = RANGING_IDLE;
+    portEXIT_CRITICAL(&r->lock);
+
+    if (expired) {
+      r->stats.timeouts++;
+      continue;
+    }
+    if (state != RANGING_DONE || n == max)
+      continue; // a full out[] leaves the reading for the next call
+
+    if (heard_other_burst(r, i, rise_us, fall_us)) {
+      r->stats.crosstalk++;
+      ESP_LOGD(TAG, "Sensor %d: echo cut by another burst, dropped", i);
+    } else {
+      out[n++] = (ultrason_range_t){
+          .sensor = i,
+          .distance_cm = ultrason_pulse_to_cm(fall_us - rise_us),
+          .timestamp_us = slot->trig_us};
+      r->stats.completed++;
+    }
+    slot->state = RANGING_IDLE;
+  }
+
+  // triggers keep their phase, a late service call skips cycles
+  for (int i = 0; i < r->num_sensors; i++) {
+    ranging_slot_t *slot = &r->slots[i];
+
+    if (slot->state != RANGING_IDLE || now < slot->next_trig_us)
+      continue;
+
+    while (slot->next_trig_us <= now)
+      slot->next_trig_us += r->config.cycle_us;
+
+    portENTER_CRITICAL(&r->lock);
+    if (slot->rise_us != ULTRASON_NO_EDGE)
+      slot->last_burst_us = slot->rise_us;
+    slot->rise_us = ULTRASON_NO_EDGE;
+    slot->fall_us = ULTRASON_NO_EDGE;
+    slot->state = RANGING_SENT;
+    portEXIT_CRITICAL(&r->lock);
+
+    slot->trig_us = esp_timer_get_time();
+    ultrason_trigger(slot->sensor);
+  }
+  return n;
+}
+
+int64_t ultrason_ranging_next_us(const ultrason_ranging_t *r) {
+  int64_t next = INT64_MAX;
+
+  for (int i = 0; i < r->num_sensors; i++) {
+    const ranging_slot_t *slot = &r->slots[i];
+    int64_t at = slot->state == RANGING_IDLE
+                     ? slot->next_trig_us
+                     : slot->trig_us + r->config.timeout_us + 1;
+    if (at < next)
+      next = at;
+  }
+  return next;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file ultrason_ranging.h pipelined ranging over several ultrasonic sensors
+ *
+ * Each sensor gets its own trigger cycle, offset by cycle_us / N from its
+ * neighbours, so the echoes of different sensors are in flight at the same
+ * time instead of one blocking reading after the other. Echo edges are
+ * timestamped by interrupt and the caller collects finished readings with
+ * ultrason_ranging_service(), which also fires the triggers that are due.
+ *
+ * An echo that ends shortly after another sensor's burst is most likely
+ * that burst heard directly, not the sensor's own echo, so it is dropped.
+ */
+
+#ifndef ULTRASON_RANGING_H
+#define ULTRASON_RANGING_H
+
+#include "ultrason_driver.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ULTRASON_RANGING_MAX_SENSORS 4
+
+typedef struct {
+  int64_t cycle_us;        // time between two triggers of the same sensor
+  int64_t timeout_us;      // give up on an echo this long after its trigger
+  int64_t xtalk_window_us; // echo end this close after a foreign burst
+} ultrason_ranging_config_t;
+
+// HC-SR04 datasheet: at least 60 ms between triggers, ~4 m range (24 ms)
+#define ULTRASON_RANGING_DEFAULT_CONFIG()                                      \
+  {.cycle_us = 60000, .timeout_us = 40000, .xtalk_window_us = 1500}
+
+typedef enum {
+  RANGING_IDLE,  // waiting for the next trigger
+  RANGING_SENT,  // triggered, echo not started
+  RANGING_ECHO,  // echo pin high
+  RANGING_DONE,  // both edges seen, not collected yet
+} ranging_state_t;
+
+typedef struct ultrason_ranging ultrason_ranging_t;
+
+typedef struct {
+  ultrason_ranging_t *owner;
+  ultrason_t *sensor;
+  volatile ranging_state_t state;
+  int64_t trig_us;
+  volatile int64_t rise_us; // start of the echo, i.e. of our burst
+  volatile int64_t fall_us;
+  int64_t last_burst_us;    // rise of the previous reading
+  int64_t next_trig_us;
+} ranging_slot_t;
+
+typedef struct {
+  int sensor; // index in the array given to ultrason_ranging_init()
+  float distance_cm;
+  int64_t timestamp_us; // trigger time
+} ultrason_range_t;
+
+typedef struct {
+  uint32_t completed;
+  uint32_t timeouts;
+  uint32_t crosstalk;
+} ultrason_ranging_stats_t;
+
+struct ultrason_ranging {
+  ultrason_ranging_config_t config;
+  ranging_slot_t slots[ULTRASON_RANGING_MAX_SENSORS];
+  int num_sensors;
+  TaskHandle_t task; // notified when an echo completes, may be NULL
+  portMUX_TYPE lock;
+  ultrason_ranging_stats_t stats;
+};
+
+// Sensors must already be set up with ultrason_init(). The first triggers
+// are due from now on, one every cycle_us / num_sensors.
+bool ultrason_ranging_init(ultrason_ranging_t *ranging, ultrason_t *sensors,
+                           int num_sensors,
+                           const ultrason_ranging_config_t *config);
+
+// Collect finished readings into out (at most max), expire lost echoes and
+// send due triggers. Returns the number of readings written.
+int ultrason_ranging_service(ultrason_ranging_t *ranging, ultrason_range_t *out,
+                             int max);
+
+// Earliest time service() has something to do without an interrupt
+int64_t ultrason_ranging_next_us(const ultrason_ranging_t *ranging);
+
+#endif // ULTRASON_RANGING_H
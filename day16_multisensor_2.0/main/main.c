@@ -1,9 +1,11 @@
 /**
  * @file main.c day11 project multisensor acquisition
  */
+#include "common/boot_time.h"
+#include "common/burst.h"
 #include "common/messages.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/task.h"
 #include "drivers/imu_driver.h"
 #include "drivers/ultrason_driver.h"
 #include "tasks/aggregator_task.h"
@@ -12,23 +14,41 @@
 #include "tasks/ultrason_task.h"
 #include <stdio.h>
 #include "drivers/nvs_driver.h"
+#include "esp_attr.h"
 #include "esp_sleep.h"
 #include "esp_log.h"
-
-#define SENSOR_TO_AGG_Q_LEN 12
-#define AGG_TO_LOG_Q_LEN 50
+#include "msg_bus.h"
+#include "dlog.h"
 
 #define LED_GPIO   GPIO_NUM_4
+#define LOG_RING_LEN 32 // deferred log entries
+#define BURST_CYCLES 10 // wakes per pipeline boot, 1: every wake boots it
+
+// a flush hands the aggregator one batch; it has to fit the links
+_Static_assert(BURST_CYCLES <= SENSOR_LINK_LEN,
+               "a burst does not fit the sensor links");
 
 static const char *TAG = "SLEEP";
-static uint32_t sample_ms;
 
-QueueHandle_t sensor_to_agg_q;
-QueueHandle_t agg_to_log_q;
+// samples of the wakes since the last flush, kept through deep sleep
+RTC_DATA_ATTR static burst_state_t burst;
+
+static msg_pool_t sensor_msg_pool;
+static msg_pool_t fused_msg_pool;
+
+// one record per 100 ms, a sample may be 50 ms off its tick and 50 ms late
+static const fusion_config_t fusion_config = {.period_us = 100000,
+                                              .tolerance_us = 50000,
+                                              .latency_us = 50000,
+                                              .mode = FUSION_NEAREST};
+sensor_link_t sensor_to_agg[NUM_SENSOR_LINKS]; // indexed by sensor_type_t
+msg_bus_t agg_to_log;
 
 app_config_t app_config;
 
 void go_to_sleep(uint32_t sleep_ms) {
+    boot_time_sleep(sleep_ms);
+    dlog_flush(); // the drain task does not get another turn
     ESP_LOGI(TAG, "Entering deep sleep for %u ms", sleep_ms);
     esp_sleep_enable_timer_wakeup(sleep_ms * 1000ULL); // microseconds
     esp_deep_sleep_start();
@@ -50,17 +70,84 @@ void led_init(void)
     (void)gpio_set_level(LED_GPIO, 0);
 }
 
-void app_main(void) {
+// -------- Burst wakes --------
 
-  gpio_set_level(LED_GPIO, 1);
+typedef struct {
+  imu_t *imu;
+  ultrason_t *ultrason;
+  bool warm;
+} burst_sensors_t;
 
-  // create queues
-  sensor_to_agg_q = xQueueCreate(SENSOR_TO_AGG_Q_LEN, sizeof(sensor_msg_t));
-  agg_to_log_q = xQueueCreate(AGG_TO_LOG_Q_LEN, sizeof(sensor_msg_t));
+static void burst_acquire(burst_state_t *s, void *ctx) {
+  burst_sensors_t *sensors = ctx;
+  sensor_msg_t msg;
 
-  aggregator_task_create(sensor_to_agg_q, agg_to_log_q, 7);
-  logger_task_create(agg_to_log_q, 1);
+  if (imu_task_sample(sensors->imu, &msg))
+    burst_add(s, &msg);
+  boot_time_mark(BOOT_FIRST_SAMPLE);
+  if (ultrason_task_sample(sensors->ultrason, &msg))
+    burst_add(s, &msg);
+}
 
+static uint32_t burst_start_pipeline(void *ctx) {
+  burst_sensors_t *sensors = ctx;
+
+  // NVS is only read after a cold boot; warm wakes keep the config in RTC
+  // memory
+  load_config_cached(&app_config, sensors->warm);
+
+  // deferred warnings from the sensor and aggregator paths, printed as
+  // text by a low-priority task (true: binary frames for dlog_decode.py);
+  // a wake without the pipeline has go_to_sleep() print them
+  dlog_task_create(false, 200, 1);
+
+  // create the message pools, the sensor links and the logger bus
+  msg_pool_init(&sensor_msg_pool, sizeof(sensor_msg_t), SENSOR_MSG_POOL_LEN);
+  msg_pool_init(&fused_msg_pool, sizeof(fused_msg_t), FUSED_MSG_POOL_LEN);
+  for (int i = 0; i < NUM_SENSOR_LINKS; i++)
+    sensor_link_init(&sensor_to_agg[i], &sensor_msg_pool);
+  msg_bus_init(&agg_to_log, &fused_msg_pool);
+
+  aggregator_task_create(sensor_to_agg, NUM_SENSOR_LINKS, &agg_to_log,
+                         &fusion_config, 7);
+  logger_task_create(&agg_to_log, 1);
+  boot_time_mark(BOOT_PIPELINE);
+  return app_config.sample_ms;
+}
+
+static void burst_flush(burst_state_t *s, void *ctx) {
+  sensor_msg_t msg;
+
+  // The whole batch goes in before the aggregator runs: fed a sample at a
+  // time it would emit the early ticks and then drop the rest as late
+  vTaskSuspendAll();
+  while (burst_take(s, &msg, 1)) {
+    sensor_msg_t *m = msg_alloc(&sensor_msg_pool);
+    if (!m)
+      break;
+    *m = msg;
+    if (spsc_ring_push(&sensor_to_agg[msg.type].ring, &m, 1) == 0)
+      msg_release(m);
+  }
+  xTaskResumeAll();
+
+  // every tick is in the past; give the aggregator its latency window,
+  // then wait for the logger to write the last, partial batch
+  vTaskDelay(pdMS_TO_TICKS(
+      (fusion_config.period_us + fusion_config.latency_us) / 1000 + 20));
+  if (!logger_task_sync(pdMS_TO_TICKS(1000)))
+    ESP_LOGW(TAG, "Logger did not flush before sleep");
+  boot_time_mark(BOOT_FLUSHED);
+}
+
+void app_main(void) {
+
+  // a timer wake finds RTC memory as it was left; anything else is a boot
+  bool warm = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+  boot_time_start(warm);
+
+  gpio_set_level(LED_GPIO, 1);
+  dlog_init(LOG_RING_LEN);
 
   // define sensors
   static imu_t imu1 = {
@@ -69,17 +156,25 @@ void app_main(void) {
   static ultrason_t ultrason1 = {.trig_pin = GPIO_NUM_16,
                                  .echo_pin = GPIO_NUM_17};
 
-  init_nvs();
   led_init();
   ultrason_init(&ultrason1);
-  imu_init(&imu1);
-
-  load_config(&app_config);
-  sample_ms = app_config.sample_ms;
-
-  imu_task(sensor_to_agg_q, &imu1);
-  ultrason_task(sensor_to_agg_q, &ultrason1);
+  ultrason_capture_init(&ultrason1); // echo edges by interrupt, no busy-wait
+  if (warm)
+    imu_resume(&imu1); // the MPU6050 stayed awake, only the I2C driver is new
+  else
+    imu_init(&imu1);
+  boot_time_mark(BOOT_SENSORS);
+
+  // Most wakes only read the sensors into RTC memory; every BURST_CYCLES
+  // wakes the pipeline starts and logs the batch
+  burst_sensors_t sensors = {
+      .imu = &imu1, .ultrason = &ultrason1, .warm = warm};
+  const burst_ops_t ops = {.acquire = burst_acquire,
+                           .start_pipeline = burst_start_pipeline,
+                           .flush = burst_flush,
+                           .ctx = &sensors};
+  uint32_t sleep_ms = burst_wake(&burst, warm, BURST_CYCLES, &ops);
 
   gpio_set_level(LED_GPIO, 0);
-  go_to_sleep(sample_ms); // enter deep sleep
+  go_to_sleep(sleep_ms); // enter deep sleep
 }
@@ -4,33 +4,111 @@
 
 #include "aggregator_task.h"
 #include "common/messages.h"
+#include "dlog.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/task.h"
 
 static const char *TAG = "AGGREGATOR_TASK";
 
-static QueueHandle_t sensor_queue;
-static QueueHandle_t logger_queue;
+#define AGG_BATCH 8 // messages taken from a link at once
+#define AGG_POOL_RETRY_MS 10 // back-off while the fused pool is empty
+
+static sensor_link_t *sensor_links;
+static int num_sensor_links;
+static msg_bus_t *out_bus;
+static fusion_t fusion;
+static bool pool_starved; // a due record is waiting for a fused block
+
+// Publish every tick whose late-sample window has closed
+static void emit_records(void) {
+  while (acq_time_us() >= fusion_next_us(&fusion)) {
+    fused_msg_t *rec = msg_alloc(out_bus->pool);
+    if (!rec) {
+      if (!pool_starved)
+        DLOGW(TAG, "Fused pool empty, record delayed");
+      pool_starved = true;
+      return;
+    }
+    pool_starved = false;
+    if (!fusion_poll(&fusion, acq_time_us(), rec)) {
+      msg_release(rec); // only empty ticks were due
+      return;
+    }
+    if (msg_bus_publish(out_bus, rec, 0) == 0) {
+      DLOGW(TAG, "Logger queue full, dropping record");
+    }
+  }
+}
+
+// Ticks to sleep until the next record is due, or a sensor pushes
+static TickType_t ticks_until_next_record(void) {
+  int64_t next = fusion_next_us(&fusion);
+  if (next == INT64_MAX)
+    return portMAX_DELAY;
+
+  int64_t wait_us = next - acq_time_us();
+  if (wait_us <= 0)
+    return 0;
+  return pdMS_TO_TICKS(wait_us / 1000) + 1;
+}
 
 static void aggregator_task(void *arg) {
-  sensor_msg_t msg;
+  sensor_msg_t *batch[AGG_BATCH];
 
   while (1) {
-    // 1. Wait for data from any sensor
-    if (xQueueReceive(sensor_queue, &msg, portMAX_DELAY) == pdTRUE) {
-      // 3. Forward to logger
-      if (xQueueSend(logger_queue, &msg, 0) != pdTRUE) {
-        ESP_LOGW(TAG, "Logger queue full, dropping message");
+    int moved = 0;
+
+    // 1. Take whatever the sensors have pushed, no kernel call
+    for (int i = 0; i < num_sensor_links; i++) {
+      uint32_t n;
+      while ((n = spsc_ring_pop(&sensor_links[i].ring, batch, AGG_BATCH))) {
+        moved += n;
+        // 2. Into the per-sensor buffers, the block goes back to the pool
+        for (uint32_t k = 0; k < n; k++) {
+          fusion_push(&fusion, batch[k]);
+          msg_release(batch[k]);
+        }
+      }
+    }
+
+    // 3. One record per tick to the logger (and any other subscriber)
+    emit_records();
+    if (moved)
+      continue;
+
+    // 4. Nothing left: sleep until a sensor pushes or the next tick is
+    // due. Arm every link before sleeping so a push that raced with the
+    // check above still wakes us
+    bool idle = true;
+    for (int i = 0; i < num_sensor_links; i++)
+      idle &= spsc_ring_arm(&sensor_links[i].ring);
+    if (idle) {
+      // an overdue tick would wake us at once, but the blocks only come
+      // back once the lower-priority logger runs: give it the CPU
+      TickType_t wait = ticks_until_next_record();
+      if (pool_starved) {
+        TickType_t retry = pdMS_TO_TICKS(AGG_POOL_RETRY_MS);
+        wait = retry > 0 ? retry : 1;
       }
+      ulTaskNotifyTake(pdTRUE, wait);
     }
+    for (int i = 0; i < num_sensor_links; i++)
+      spsc_ring_disarm(&sensor_links[i].ring);
   }
 }
 
-void aggregator_task_create(QueueHandle_t sensor_to_agg_q,
-                            QueueHandle_t agg_to_log_q, UBaseType_t priority) {
-  sensor_queue = sensor_to_agg_q;
-  logger_queue = agg_to_log_q;
+void aggregator_task_create(sensor_link_t *links, int num_links,
+                            msg_bus_t *agg_to_log,
+                            const fusion_config_t *fusion_config,
+                            UBaseType_t priority) {
+  if (!fusion_init(&fusion, fusion_config)) {
+    ESP_LOGE(TAG, "Invalid fusion config");
+    return;
+  }
+  sensor_links = links;
+  num_sensor_links = num_links;
+  out_bus = agg_to_log;
 
   xTaskCreate(aggregator_task, "aggregator_task", 2048, NULL, priority, NULL);
 }
\ No newline at end of file
@@ -7,9 +7,15 @@
 #define AGGREGATOR_TASK_H
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "common/messages.h"
+#include "msg_bus.h"
+#include "tasks/fusion.h"
 
-void aggregator_task_create(QueueHandle_t sensor_to_agg_q,
-                            QueueHandle_t agg_to_log_q, UBaseType_t priority);
+// drains every sensor link into the fusion buffers and publishes one
+// fused_msg_t per tick on agg_to_log (a bus over a fused_msg_t pool)
+void aggregator_task_create(sensor_link_t *links, int num_links,
+                            msg_bus_t *agg_to_log,
+                            const fusion_config_t *fusion_config,
+                            UBaseType_t priority);
 
 #endif // AGGREGATOR_TASK_H
\ No newline at end of file
@@ -0,0 +1,211 @@
+/**
+ * @file binlog.c batch encoder and decoder of the binary log
+ */
+
+#include "binlog.h"
+#include <string.h>
+
+const uint8_t binlog_num_values[NUM_SENSOR_LINKS] = {
+    [SENSOR_IMU] = 7,
+    [SENSOR_ULTRASONIC] = 1,
+};
+
+const float binlog_scales[NUM_SENSOR_LINKS][SENSOR_MSG_DATA_LEN] = {
+    // +-2 g, 340 LSB/deg C kept to 0.01 deg C, +-250 deg/s
+    [SENSOR_IMU] = {16384.0f, 16384.0f, 16384.0f, 100.0f, 131.0f, 131.0f,
+                    131.0f},
+    [SENSOR_ULTRASONIC] = {10.0f}, // mm, up to 32 m
+};
+
+// -------- Byte helpers --------
+
+static void put_u16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+
+static uint16_t get_u16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+static void put_i64(uint8_t *p, int64_t v) {
+  for (int i = 0; i < 8; i++)
+    p[i] = (uint64_t)v >> (8 * i);
+}
+
+static int64_t get_i64(const uint8_t *p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++)
+    v |= (uint64_t)p[i] << (8 * i);
+  return (int64_t)v;
+}
+
+// CRC-16/CCITT (poly 0x1021), a byte at a time
+static const uint16_t crc_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
+};
+
+uint16_t binlog_crc16(uint16_t crc, const uint8_t *data, size_t len) {
+  while (len--)
+    crc = (crc << 8) ^ crc_table[(crc >> 8) ^ *data++];
+  return crc;
+}
+
+// -------- Encoder --------
+
+void binlog_init(binlog_t *log) {
+  memset(log, 0, sizeof(*log));
+  log->len = BINLOG_HEADER_LEN;
+}
+
+static int16_t to_fixed(binlog_t *log, float value, float scale) {
+  float v = value * scale;
+  if (v >= INT16_MAX + 0.5f || v <= INT16_MIN - 0.5f || v != v) {
+    log->stats.saturated++;
+    return v < 0 ? INT16_MIN : INT16_MAX; // NaN clamps high
+  }
+  return (int16_t)(v < 0 ? v - 0.5f : v + 0.5f); // rounded, no libm call
+}
+
+bool binlog_add(binlog_t *log, const fused_msg_t *msg) {
+  if (log->sealed) {
+    log->sealed = false;
+    log->len = BINLOG_HEADER_LEN;
+    log->count = 0;
+    log->seq++;
+  }
+
+  uint8_t *p = log->batch + log->len;
+  int64_t delta = log->count ? msg->timestamp - log->last_us : 0;
+  if (log->count == 0)
+    put_i64(log->batch + 8, msg->timestamp); // batch base time
+
+  // zigzag so a step back in time stays short
+  uint64_t zz = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+  do {
+    *p++ = (zz & 0x7f) | (zz > 0x7f ? 0x80 : 0);
+    zz >>= 7;
+  } while (zz);
+
+  *p++ = msg->valid & ((1u << NUM_SENSOR_LINKS) - 1);
+  for (int s = 0; s < NUM_SENSOR_LINKS; s++) {
+    if (!(msg->valid & (1u << s)))
+      continue;
+    for (int i = 0; i < binlog_num_values[s]; i++) {
+      put_u16(p, (uint16_t)to_fixed(log, msg->data[s][i], binlog_scales[s][i]));
+      p += 2;
+    }
+  }
+
+  log->len = p - log->batch;
+  log->count++;
+  log->last_us = msg->timestamp;
+  log->stats.records++;
+  return log->count == UINT8_MAX ||
+         log->len + BINLOG_RECORD_MAX > BINLOG_BATCH_MAX;
+}
+
+size_t binlog_seal(binlog_t *log) {
+  if (log->sealed)
+    return log->len;
+  if (log->count == 0)
+    return 0;
+
+  uint8_t *h = log->batch;
+  put_u16(h, BINLOG_MAGIC);
+  h[2] = BINLOG_VERSION;
+  h[3] = log->count;
+  put_u16(h + 4, log->seq);
+  put_u16(h + 6, log->len - BINLOG_HEADER_LEN);
+  // base time already at h + 8
+
+  uint16_t crc = binlog_crc16(0xffff, h, 16);
+  crc = binlog_crc16(crc, h + BINLOG_HEADER_LEN, log->len - BINLOG_HEADER_LEN);
+  put_u16(h + 16, crc);
+
+  log->sealed = true;
+  log->stats.batches++;
+  log->stats.bytes += log->len;
+  return log->len;
+}
+
+// -------- Decoder --------
+
+size_t binlog_decode(const uint8_t *buf, size_t len, fused_msg_t *out, int max,
+                     int *num_records) {
+  *num_records = 0;
+  if (len < BINLOG_HEADER_LEN || get_u16(buf) != BINLOG_MAGIC ||
+      buf[2] != BINLOG_VERSION)
+    return 0;
+
+  size_t total = BINLOG_HEADER_LEN + get_u16(buf + 6);
+  if (total > len || total > BINLOG_BATCH_MAX)
+    return 0;
+
+  uint16_t crc = binlog_crc16(0xffff, buf, 16);
+  crc = binlog_crc16(crc, buf + BINLOG_HEADER_LEN, total - BINLOG_HEADER_LEN);
+  if (crc != get_u16(buf + 16))
+    return 0;
+
+  const uint8_t *p = buf + BINLOG_HEADER_LEN;
+  const uint8_t *end = buf + total;
+  int64_t t = get_i64(buf + 8);
+  int n = 0;
+
+  for (int r = 0; r < buf[3]; r++) {
+    uint64_t zz = 0;
+    int shift = 0;
+    do {
+      if (p == end || shift > 63)
+        return 0;
+      zz |= (uint64_t)(*p & 0x7f) << shift;
+      shift += 7;
+    } while (*p++ & 0x80);
+    t += (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+
+    if (p == end)
+      return 0;
+    fused_msg_t rec = {.timestamp = t, .valid = *p++};
+    for (int s = 0; s < NUM_SENSOR_LINKS; s++) {
+      if (!(rec.valid & (1u << s)))
+        continue;
+      if (end - p < 2 * binlog_num_values[s])
+        return 0;
+      for (int i = 0; i < binlog_num_values[s]; i++, p += 2)
+        rec.data[s][i] = (int16_t)get_u16(p) / binlog_scales[s][i];
+    }
+    if (n < max)
+      out[n++] = rec;
+  }
+  *num_records = n;
+  return total;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file binlog.h compact binary log of the fused records
+ *
+ * Records are packed into batches instead of being printed one by one. A
+ * record is the zigzag varint of its timestamp delta to the previous record
+ * (µs), the valid bits, then one int16 per value of every valid sensor,
+ * scaled by binlog_scales[]. The IMU scales are the MPU-6050 LSB sizes, so
+ * the log keeps the sensor's own resolution.
+ *
+ * A batch starts with an 18-byte little-endian header:
+ *   magic u16, version u8, record count u8, sequence u16, payload length u16,
+ *   timestamp of the first record i64, CRC-16/CCITT of the header and payload
+ * The magic and the CRC let a decoder find the batches in a console stream
+ * that also carries text logs, and skip damaged ones.
+ *
+ * No RTOS calls: the logger feeds it, the host tests drive it directly.
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include "common/messages.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BINLOG_MAGIC 0x4c42 // "BL"
+#define BINLOG_VERSION 1
+#define BINLOG_HEADER_LEN 18
+#define BINLOG_BATCH_MAX 512 // header included
+// widest record: 10-byte varint, valid bits, every value
+#define BINLOG_RECORD_MAX (10 + 1 + 2 * NUM_SENSOR_LINKS * SENSOR_MSG_DATA_LEN)
+
+// Values per sensor and their fixed-point scales (stored = value * scale)
+extern const uint8_t binlog_num_values[NUM_SENSOR_LINKS];
+extern const float binlog_scales[NUM_SENSOR_LINKS][SENSOR_MSG_DATA_LEN];
+
+typedef struct {
+  uint32_t records;
+  uint32_t batches;
+  uint32_t bytes;     // sealed batches, headers included
+  uint32_t saturated; // values clamped to the int16 range
+} binlog_stats_t;
+
+typedef struct {
+  uint8_t batch[BINLOG_BATCH_MAX];
+  size_t len; // bytes in batch, header included
+  uint8_t count;
+  uint16_t seq;
+  bool sealed;
+  int64_t last_us;
+  binlog_stats_t stats;
+} binlog_t;
+
+void binlog_init(binlog_t *log);
+
+// Append one record. Returns true when the batch cannot take another one
+// and should be sealed and written out.
+bool binlog_add(binlog_t *log, const fused_msg_t *msg);
+
+// Fill in the header and CRC, return the batch length (0 when empty). The
+// bytes stay in log->batch until the next binlog_add().
+size_t binlog_seal(binlog_t *log);
+
+// Decode the batch at the start of buf into at most max records. Returns the
+// batch length, or 0 when buf does not start with a complete, intact batch.
+size_t binlog_decode(const uint8_t *buf, size_t len, fused_msg_t *out, int max,
+                     int *num_records);
+
+uint16_t binlog_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+#endif // BINLOG_H
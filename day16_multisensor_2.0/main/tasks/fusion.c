@@ -0,0 +1,139 @@
+/**
+ * @file fusion.c per-sensor sample histories and tick interpolation
+ */
+
+#include "fusion.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool fusion_init(fusion_t *fusion, const fusion_config_t *config) {
+  if (!fusion || !config || config->period_us <= 0 ||
+      config->tolerance_us < 0 || config->latency_us < 0)
+    return false;
+
+  memset(fusion, 0, sizeof(*fusion));
+  fusion->config = *config;
+  return true;
+}
+
+// Ticks sit on multiples of the period, whatever the first timestamp
+static int64_t first_tick(int64_t timestamp, int64_t period) {
+  int64_t tick = timestamp / period * period;
+  return tick < timestamp ? tick + period : tick;
+}
+
+void fusion_push(fusion_t *fusion, const sensor_msg_t *msg) {
+  if ((unsigned)msg->type >= NUM_SENSOR_LINKS)
+    return;
+
+  if (!fusion->started) {
+    fusion->started = true;
+    fusion->next_tick_us = first_tick(msg->timestamp, fusion->config.period_us);
+  }
+
+  fusion->stats.samples++;
+  if (msg->timestamp < fusion->next_tick_us - fusion->config.tolerance_us) {
+    fusion->stats.late++;
+    return;
+  }
+
+  fusion_history_t *h = &fusion->history[msg->type];
+  if (h->count == FUSION_HISTORY) {
+    memmove(&h->samples[0], &h->samples[1],
+            (FUSION_HISTORY - 1) * sizeof(fusion_sample_t));
+    h->count--;
+    fusion->stats.overflow++;
+  }
+
+  // usually the newest: scan from the end, out-of-order samples slot in
+  int i = h->count;
+  while (i > 0 && h->samples[i - 1].timestamp > msg->timestamp)
+    i--;
+  memmove(&h->samples[i + 1], &h->samples[i],
+          (h->count - i) * sizeof(fusion_sample_t));
+  h->samples[i].timestamp = msg->timestamp;
+  memcpy(h->samples[i].data, msg->data, sizeof(msg->data));
+  h->count++;
+}
+
+// Value of one sensor at tick, false when no sample is close enough
+static bool sample_at(const fusion_t *fusion, const fusion_history_t *h,
+                      int64_t tick, float *out) {
+  const fusion_sample_t *before = NULL, *after = NULL;
+  int64_t tolerance = fusion->config.tolerance_us;
+
+  for (int i = 0; i < h->count; i++) {
+    if (h->samples[i].timestamp <= tick) {
+      before = &h->samples[i];
+    } else {
+      after = &h->samples[i];
+      break;
+    }
+  }
+
+  if (fusion->config.mode == FUSION_LINEAR && before && after &&
+      tick - before->timestamp <= tolerance &&
+      after->timestamp - tick <= tolerance) {
+    float w = (float)(tick - before->timestamp) /
+              (float)(after->timestamp - before->timestamp);
+    for (int k = 0; k < SENSOR_MSG_DATA_LEN; k++)
+      out[k] = before->data[k] + w * (after->data[k] - before->data[k]);
+    return true;
+  }
+
+  // nearest neighbour, ties go to the earlier sample
+  const fusion_sample_t *best = before;
+  if (after && (!before || after->timestamp - tick < tick - before->timestamp))
+    best = after;
+  if (!best || llabs(best->timestamp - tick) > tolerance)
+    return false;
+
+  memcpy(out, best->data, sizeof(best->data));
+  return true;
+}
+
+// Samples that cannot reach the next tick any more
+static void prune(fusion_t *fusion) {
+  int64_t oldest = fusion->next_tick_us - fusion->config.tolerance_us;
+
+  for (int s = 0; s < NUM_SENSOR_LINKS; s++) {
+    fusion_history_t *h = &fusion->history[s];
+    int n = 0;
+    while (n < h->count && h->samples[n].timestamp < oldest)
+      n++;
+    memmove(&h->samples[0], &h->samples[n],
+            (h->count - n) * sizeof(fusion_sample_t));
+    h->count -= n;
+  }
+}
+
+bool fusion_poll(fusion_t *fusion, int64_t now_us, fused_msg_t *out) {
+  while (fusion->started &&
+         now_us >= fusion->next_tick_us + fusion->config.latency_us) {
+    int64_t tick = fusion->next_tick_us;
+
+    out->timestamp = tick;
+    out->valid = 0;
+    for (int s = 0; s < NUM_SENSOR_LINKS; s++) {
+      if (sample_at(fusion, &fusion->history[s], tick, out->data[s]))
+        out->valid |= 1u << s;
+    }
+
+    fusion->next_tick_us += fusion->config.period_us;
+    prune(fusion);
+
+    if (out->valid) {
+      fusion->stats.records++;
+      fusion->stats.missing +=
+          NUM_SENSOR_LINKS - __builtin_popcount(out->valid);
+      return true;
+    }
+  }
+  return false;
+}
+
+int64_t fusion_next_us(const fusion_t *fusion) {
+  if (!fusion->started)
+    return INT64_MAX;
+  return fusion->next_tick_us + fusion->config.latency_us;
+}
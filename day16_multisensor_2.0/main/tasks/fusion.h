@@ -0,0 +1,75 @@
+/**
+ * @file fusion.h time alignment of the sensor streams onto one timebase
+ *
+ * Samples are kept per sensor, sorted by timestamp. Every period_us the
+ * aggregator asks for one fused record at the tick time, built from each
+ * sensor's samples around it by nearest neighbour or linear interpolation.
+ * A tick is only emitted latency_us after it has passed, so samples that
+ * arrive a little late (slow sensor, long echo) still count. A sample more
+ * than tolerance_us before the next tick can no longer change anything and
+ * is dropped as late. With latency_us at least tolerance_us plus the
+ * longest delivery delay, the records do not depend on arrival order.
+ *
+ * No RTOS calls: the aggregator feeds it, the host tests drive it directly.
+ */
+
+#ifndef FUSION_H
+#define FUSION_H
+
+#include "common/messages.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FUSION_HISTORY 16 // samples kept per sensor
+
+typedef enum {
+  FUSION_NEAREST, // closest sample within tolerance_us
+  FUSION_LINEAR,  // interpolate between the samples around the tick
+} fusion_mode_t;
+
+typedef struct {
+  int64_t period_us;    // one fused record per period
+  int64_t tolerance_us; // farthest a sample may be from the tick it feeds
+  int64_t latency_us;   // wait this long after a tick for late samples
+  fusion_mode_t mode;
+} fusion_config_t;
+
+typedef struct {
+  int64_t timestamp;
+  float data[SENSOR_MSG_DATA_LEN];
+} fusion_sample_t;
+
+typedef struct {
+  fusion_sample_t samples[FUSION_HISTORY];
+  int count;
+} fusion_history_t;
+
+typedef struct {
+  uint32_t samples;
+  uint32_t late;     // too old for the next tick, dropped
+  uint32_t overflow; // history full, oldest sample dropped
+  uint32_t records;
+  uint32_t missing; // sensor values absent from emitted records
+} fusion_stats_t;
+
+typedef struct {
+  fusion_config_t config;
+  fusion_history_t history[NUM_SENSOR_LINKS];
+  bool started;
+  int64_t next_tick_us;
+  fusion_stats_t stats;
+} fusion_t;
+
+bool fusion_init(fusion_t *fusion, const fusion_config_t *config);
+
+// Add one sensor sample; the first one sets the timebase
+void fusion_push(fusion_t *fusion, const sensor_msg_t *msg);
+
+// Fill out with the next tick that has data, once it is latency_us old.
+// Ticks where no sensor has a value are skipped.
+bool fusion_poll(fusion_t *fusion, int64_t now_us, fused_msg_t *out);
+
+// When fusion_poll() will next have a record, INT64_MAX before any sample
+int64_t fusion_next_us(const fusion_t *fusion);
+
+#endif // FUSION_H
@@ -6,12 +6,9 @@
 #define IMU_TASK_H
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "common/messages.h"
 #include "drivers/imu_driver.h"
 
-// queue handle provided by main.c
-void imu_task_create(QueueHandle_t sensor_to_agg_q, UBaseType_t priority,
-                     imu_t *sensor, uint32_t sample_ms);
-
-void imu_task(QueueHandle_t sensor_to_agg_q, imu_t *sensor);
+// read one sample into msg, no pool or link involved (burst wakes)
+bool imu_task_sample(imu_t *sensor, sensor_msg_t *msg);
 #endif // IMU_TASK_h
@@ -6,44 +6,96 @@
 #include "common/messages.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "tasks/binlog.h"
+#include <stdio.h>
+
+// stdout must pass the batches through byte for byte (sdkconfig.defaults)
+#if !CONFIG_NEWLIB_STDOUT_LINE_ENDING_LF
+#error "binary batches need CONFIG_NEWLIB_STDOUT_LINE_ENDING_LF"
+#endif
 
 static const char *TAG = "LOGGER";
 
+#define LOGGER_FLUSH_MS 1000 // longest a record waits in a partial batch
+
 static QueueHandle_t s_logger_queue;
+static msg_pool_t *s_pool;
+static binlog_t s_binlog;
+static TaskHandle_t s_sync_waiter;
 
-static void logger_task(void *arg) {
-  sensor_msg_t msg;
+static bool batch_pending(void) {
+  return s_binlog.count && !s_binlog.sealed;
+}
 
-  while (1) {
-    // Block forever waiting for data
-    if (xQueueReceive(s_logger_queue, &msg, portMAX_DELAY) == pdTRUE) {
+// One write per batch; the host decoder (tools/binlog2csv.py) resyncs on
+// the batch magic, so text logs on the same console do no harm
+static void write_batch(void) {
+  size_t len = binlog_seal(&s_binlog);
 
-      switch (msg.type) {
+  if (fwrite(s_binlog.batch, 1, len, stdout) != len)
+    ESP_LOGW(TAG, "Batch %u not written", s_binlog.seq);
+  fflush(stdout);
+}
 
-      case SENSOR_IMU:
-        ESP_LOGI(TAG, "[IMU] ts=%lld | ax=%.2f ay=%.2f az=%.2f", msg.timestamp,
-                 msg.data[0], msg.data[1], msg.data[2]);
-        break;
+static void logger_task(void *arg) {
+  const TickType_t flush_ticks = pdMS_TO_TICKS(LOGGER_FLUSH_MS);
+  const fused_msg_t *msg;
+  TickType_t batch_start = 0;
 
-      case SENSOR_ULTRASONIC:
-        ESP_LOGI(TAG, "[ULTRA] ts=%lld | distance=%.2f cm", msg.timestamp,
-                 msg.data[0]);
-        break;
+  while (1) {
+    // Wait for a record, one per fusion tick, but no longer than the
+    // oldest batched record may wait
+    TickType_t wait = portMAX_DELAY;
+    if (batch_pending()) {
+      TickType_t age = xTaskGetTickCount() - batch_start;
+      wait = age < flush_ticks ? flush_ticks - age : 0;
+    }
 
-      default:
-        ESP_LOGW(TAG, "Unknown sensor type (%d)", msg.type);
-        break;
+    if (msg_bus_receive(s_logger_queue, (void **)&msg, wait)) {
+      if (msg->valid == 0) {
+        // marker from logger_task_sync(): everything before it is in
+        msg_release((void *)msg);
+        if (batch_pending())
+          write_batch();
+        xTaskNotifyGive(s_sync_waiter);
+        continue;
       }
+      if (!batch_pending())
+        batch_start = xTaskGetTickCount();
+      bool full = binlog_add(&s_binlog, msg);
+      msg_release((void *)msg);
+      if (!full && xTaskGetTickCount() - batch_start < flush_ticks)
+        continue;
     }
+    if (batch_pending())
+      write_batch();
+  }
+}
+
+bool logger_task_sync(TickType_t wait) {
+  // fusion never emits a record without data, so valid == 0 is free
+  fused_msg_t *marker = msg_alloc(s_pool);
+  if (!marker)
+    return false;
+  marker->valid = 0;
+
+  s_sync_waiter = xTaskGetCurrentTaskHandle();
+  if (xQueueSend(s_logger_queue, &marker, wait) != pdTRUE) {
+    msg_release(marker);
+    return false;
   }
+  return ulTaskNotifyTake(pdTRUE, wait) > 0;
 }
 
-void logger_task_create(QueueHandle_t logger_queue, UBaseType_t priority) {
-  s_logger_queue = logger_queue;
+void logger_task_create(msg_bus_t *agg_to_log, UBaseType_t priority) {
+  s_logger_queue = msg_bus_subscribe(agg_to_log, AGG_TO_LOG_Q_LEN);
+  s_pool = agg_to_log->pool;
+  binlog_init(&s_binlog);
 
   xTaskCreate(logger_task, "logger_task",
-              4096, // Logging needs stack (printf, formatting)
+              2048, // no printf formatting any more, only fwrite
               NULL,
               priority, // LOW priority
               NULL);
@@ -6,8 +6,12 @@
 #define LOGGER_TASK_H
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "msg_bus.h"
 
-void logger_task_create(QueueHandle_t logger_queue, UBaseType_t priority);
+void logger_task_create(msg_bus_t *agg_to_log, UBaseType_t priority);
+
+// Wait until every record queued so far is written out, partial batch
+// included (before deep sleep)
+bool logger_task_sync(TickType_t wait);
 
 #endif // LOGGER_TASK_H
\ No newline at end of file
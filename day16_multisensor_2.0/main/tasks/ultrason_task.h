@@ -7,12 +7,10 @@
 #define ULTRASON_TASK_H
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "common/messages.h"
 #include "drivers/ultrason_driver.h"
 
-// queue handle provided by main.c
-void ultrason_task_create(QueueHandle_t sensor_to_agg_q, UBaseType_t priority,
-                          ultrason_t *sensor, uint32_t sample_ms);
-void ultrason_task(QueueHandle_t sensor_to_agg_q, ultrason_t *sensor);
+// read one sample into msg, no pool or link involved (burst wakes)
+bool ultrason_task_sample(ultrason_t *sensor, sensor_msg_t *msg);
 
 #endif // ULTRASON_TASK_H
\ No newline at end of file
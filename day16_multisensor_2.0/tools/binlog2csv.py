@@ -0,0 +1,141 @@
+"""
+Decode the logger's binary batches (main/tasks/binlog.h) back to CSV.
+
+The input is a raw capture of the console, e.g.
+    idf.py monitor | tee capture.log   (or any serial dump)
+Text log lines around the batches are skipped: the decoder looks for the
+batch magic and only keeps batches whose CRC matches.
+
+By default the output matches motion_data's recordings, one IMU record per
+line and no header:
+    time_ms,accel_mag,gyro_mag
+With --all, every field is written, with a header row.
+"""
+
+import argparse
+import math
+import struct
+import sys
+
+MAGIC = 0x4C42
+VERSION = 1
+HEADER = struct.Struct("<HBBHHqH")  # magic, version, count, seq, len, base, crc
+BATCH_MAX = 512
+
+SENSOR_IMU, SENSOR_ULTRASONIC = 0, 1
+# must follow binlog_num_values[] and binlog_scales[] in binlog.c
+SCALES = {
+    SENSOR_IMU: [16384.0, 16384.0, 16384.0, 100.0, 131.0, 131.0, 131.0],
+    SENSOR_ULTRASONIC: [10.0],
+}
+ALL_COLUMNS = ["time_us", "ax", "ay", "az", "temp", "gx", "gy", "gz",
+               "distance_cm"]
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def decode_batch(buf, pos):
+    """Records of the batch at buf[pos], and its length; None if invalid."""
+    if len(buf) - pos < HEADER.size:
+        return None
+    magic, version, count, seq, length, t, crc = HEADER.unpack_from(buf, pos)
+    total = HEADER.size + length
+    if magic != MAGIC or version != VERSION or total > BATCH_MAX:
+        return None
+    if pos + total > len(buf):
+        return None
+    body = buf[pos + HEADER.size:pos + total]
+    if crc16(body, crc16(buf[pos:pos + 16])) != crc:
+        return None
+
+    records = []
+    p = 0
+    try:
+        for _ in range(count):
+            zz = shift = 0
+            while True:
+                byte = body[p]
+                p += 1
+                zz |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    break
+            t += (zz >> 1) ^ -(zz & 1)
+
+            valid = body[p]
+            p += 1
+            values = {}
+            for sensor, scales in SCALES.items():
+                if valid & (1 << sensor):
+                    raw = struct.unpack_from("<%dh" % len(scales), body, p)
+                    p += 2 * len(scales)
+                    values[sensor] = [r / s for r, s in zip(raw, scales)]
+            records.append((t, values))
+    except (IndexError, struct.error):
+        return None
+    return records, seq, total
+
+
+def decode_stream(buf):
+    """Every intact batch in a capture, and how many sequence numbers are missing."""
+    records = []
+    pos = 0
+    last_seq = None
+    lost = 0
+    while True:
+        pos = buf.find(struct.pack("<H", MAGIC), pos)
+        if pos < 0:
+            break
+        batch = decode_batch(buf, pos)
+        if batch is None:
+            pos += 1  # a magic inside text or a damaged batch
+            continue
+        batch_records, seq, total = batch
+        if last_seq is not None:
+            lost += (seq - last_seq - 1) & 0xFFFF
+        last_seq = seq
+        records.extend(batch_records)
+        pos += total
+    return records, lost
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("capture", help="binary console capture")
+    parser.add_argument("-o", "--output", help="CSV file (default: stdout)")
+    parser.add_argument("--all", action="store_true",
+                        help="every field, with a header row")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as f:
+        records, lost = decode_stream(f.read())
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.all:
+        out.write(",".join(ALL_COLUMNS) + "\n")
+    for t, values in records:
+        imu = values.get(SENSOR_IMU)
+        if args.all:
+            fields = [str(t)]
+            fields += ["%.4f" % v for v in imu] if imu else [""] * 7
+            ultra = values.get(SENSOR_ULTRASONIC)
+            fields.append("%.1f" % ultra[0] if ultra else "")
+            out.write(",".join(fields) + "\n")
+        elif imu:
+            accel = math.sqrt(imu[0] ** 2 + imu[1] ** 2 + imu[2] ** 2)
+            gyro = math.sqrt(imu[4] ** 2 + imu[5] ** 2 + imu[6] ** 2)
+            out.write("%d,%.3f,%.3f\n" % (t // 1000, accel, gyro))
+    if out is not sys.stdout:
+        out.close()
+
+    print("%d records, %d batches lost" % (len(records), lost), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
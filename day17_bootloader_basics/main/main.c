@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include "boot_trace.h"
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
@@ -86,6 +87,8 @@ static const char *TAG = "FACTORY_APP_TO_OTA_0";
 
 void app_main(void)
 {
+    boot_trace_mark("app_main");
+
     // Get the running partition
     const esp_partition_t *running = esp_ota_get_running_partition();
     ESP_LOGI(TAG, "Running partition: %s", running->label);
@@ -98,6 +101,7 @@ void app_main(void)
     } else {
         ESP_LOGW(TAG, "Boot partition not found!");
     }
+    boot_trace_mark("partitions read");
 
     // Find the OTA_0 partition
     const esp_partition_t *ota_0_partition = esp_partition_find_first(
@@ -115,6 +119,7 @@ void app_main(void)
     } else {
         ESP_LOGE(TAG, "OTA_0 partition not found!");
     }
+    boot_trace_mark("boot partition set");
 
     // Get the boot partition (what the bootloader will select next)
     boot_partition = esp_ota_get_boot_partition();
@@ -125,6 +130,9 @@ void app_main(void)
         ESP_LOGW(TAG, "Boot partition not found!");
     }
 
+    // startup timing, for boot_trace_diff.py
+    boot_trace_dump();
+
     // Infinite loop for observation
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(2000));
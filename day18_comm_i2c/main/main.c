@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include "i2c_prepared.h"
 
 #define I2C_MASTER_SCL_IO           22      // change to your GPIO
 #define I2C_MASTER_SDA_IO           21      // change to your GPIO
@@ -19,36 +20,14 @@ static const char *TAG = "I2C_SCAN";
 
 esp_err_t imu_read_who_am_i(uint8_t *who_am_i)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-
-    // START
-    i2c_master_start(cmd);
-
-    // Address + Write
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_WRITE, true);
-
-    // Register address
-    i2c_master_write_byte(cmd, WHO_AM_I_REG, true);
-
-    // Repeated START
-    i2c_master_start(cmd);
-
-    // Address + Read
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_READ, true);
-
-    // Read 1 byte, then NACK
-    i2c_master_read_byte(cmd, who_am_i, I2C_MASTER_NACK);
-
-    // STOP
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(
-        I2C_MASTER_NUM,
-        cmd,
-        1000 / portTICK_PERIOD_MS
-    );
-
-    i2c_cmd_link_delete(cmd);
+    // START, address + write, register, repeated START, address + read,
+    // 1 byte then NACK, STOP. The link is built on the stack: no heap.
+    i2c_prepared_t txn;
+    esp_err_t ret = i2c_prepared_read_regs(&txn, I2C_MASTER_NUM, IMU_ADDR,
+                                           WHO_AM_I_REG, who_am_i, 1);
+    if (ret == ESP_OK)
+        ret = i2c_prepared_run(&txn, 1000 / portTICK_PERIOD_MS);
+    i2c_prepared_release(&txn);
     return ret;
 }
 
@@ -70,45 +49,23 @@ void i2c_master_init()
 
 esp_err_t i2c_probe(uint8_t addr)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+    i2c_prepared_t txn;
+    esp_err_t ret = i2c_prepared_probe(&txn, I2C_MASTER_NUM, addr);
+    if (ret == ESP_OK)
+        ret = i2c_prepared_run(&txn, 1000 / portTICK_PERIOD_MS);
+    i2c_prepared_release(&txn);
     return ret;
 }
 
 esp_err_t imu_read_bytes(uint8_t start_reg, uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-
-    // START + write phase
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, start_reg, true);
-
-    // Repeated START + read phase
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_READ, true);
-
-    // Read multiple bytes
-    if (len > 1) {
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
-    }
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-
-    // STOP
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(
-        I2C_MASTER_NUM,
-        cmd,
-        1000 / portTICK_PERIOD_MS
-    );
-
-    i2c_cmd_link_delete(cmd);
+    // register select, repeated START, len bytes with a NACK on the last
+    i2c_prepared_t txn;
+    esp_err_t ret = i2c_prepared_read_regs(&txn, I2C_MASTER_NUM, IMU_ADDR,
+                                           start_reg, data, len);
+    if (ret == ESP_OK)
+        ret = i2c_prepared_run(&txn, 1000 / portTICK_PERIOD_MS);
+    i2c_prepared_release(&txn);
     return ret;
 }
 
@@ -130,22 +87,25 @@ void app_main(void)
     ESP_LOGI(TAG, "Initializing I2C...");
     i2c_master_init();
     imu_wake_up();
-    uint8_t raw[READ_LEN];
+    static uint8_t raw[READ_LEN];
+    static i2c_prepared_t accel_read; // built once, rerun every loop
     for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_stop(cmd);
-        esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 100 / portTICK_PERIOD_MS);
-        i2c_cmd_link_delete(cmd);
-        if (ret == ESP_OK) {
+        if (i2c_probe(addr) == ESP_OK) {
             ESP_LOGI("I2C_SCAN", "Found device at 0x%02X", addr);
     }
 }
 
 
+    esp_err_t built = i2c_prepared_read_regs(&accel_read, I2C_MASTER_NUM,
+                                             IMU_ADDR, ACCEL_START_REG, raw,
+                                             READ_LEN);
+    if (built != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to build IMU read: %s", esp_err_to_name(built));
+        return;
+    }
+
     while (1) {
-        esp_err_t ret = imu_read_bytes(ACCEL_START_REG, raw, READ_LEN);
+        esp_err_t ret = i2c_prepared_run(&accel_read, 1000 / portTICK_PERIOD_MS);
         if (ret == ESP_OK) {
             int16_t ax = (raw[0] << 8) | raw[1];
             int16_t ay = (raw[2] << 8) | raw[3];
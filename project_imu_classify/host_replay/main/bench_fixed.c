@@ -0,0 +1,96 @@
+/**
+ * @file bench_fixed.c cycles per sample of the float and fixed-point engines
+ *
+ * The recordings only hold magnitudes, so each sample is turned back into a
+ * 14-byte register frame (magnitude spread evenly on the three axes) and both
+ * engines go through the complete chain: decode, magnitude, low-pass,
+ * window update and classification.
+ */
+
+#include "motion_engine.h"
+#include "motion_fixed.h"
+#include "replay.h"
+#include <math.h>
+#include <stdio.h>
+
+#define BENCH_PASSES 50
+#define BENCH_HOP_SIZE 5
+
+static uint8_t frames[4096][MOTION_RAW_FRAME_LEN];
+static motion_engine_t float_engine;
+static motion_q_engine_t fixed_engine;
+
+static void put_axis(uint8_t *dst, float value) {
+  long v = lroundf(value);
+  if (v > INT16_MAX)
+    v = INT16_MAX;
+  if (v < INT16_MIN)
+    v = INT16_MIN;
+  dst[0] = (uint8_t)((uint16_t)v >> 8);
+  dst[1] = (uint8_t)v;
+}
+
+static void build_frames(const motion_sample_t *data, int n) {
+  const float axis = 1.0f / sqrtf(3.0f);
+
+  for (int i = 0; i < n; i++) {
+    float a = data[i].accel_mag * MOTION_ACCEL_LSB_PER_G * axis;
+    float g = data[i].gyro_mag * MOTION_GYRO_LSB_PER_DPS * axis;
+
+    for (int k = 0; k < 3; k++) {
+      put_axis(&frames[i][2 * k], a);
+      put_axis(&frames[i][8 + 2 * k], g);
+    }
+    frames[i][6] = frames[i][7] = 0;
+  }
+}
+
+void bench_fixed(const char *name, const motion_sample_t *data, int n) {
+  const motion_engine_config_t config = {
+      .window_size = MOTION_WINDOW_SIZE,
+      .hop_size = BENCH_HOP_SIZE,
+  };
+  motion_decision_t f;
+  motion_q_decision_t q;
+  int mismatches = 0;
+
+  if (n > (int)(sizeof(frames) / sizeof(frames[0])))
+    n = sizeof(frames) / sizeof(frames[0]);
+  build_frames(data, n);
+
+  uint64_t start = cycles_now();
+  for (int pass = 0; pass < BENCH_PASSES; pass++) {
+    motion_engine_init(&float_engine, &config);
+    for (int i = 0; i < n; i++) {
+      motion_engine_push_raw(&float_engine, frames[i], data[i].timestamp_ms);
+      motion_engine_pop_decision(&float_engine, &f);
+    }
+  }
+  uint64_t float_cycles = cycles_now() - start;
+
+  start = cycles_now();
+  for (int pass = 0; pass < BENCH_PASSES; pass++) {
+    motion_q_engine_init(&fixed_engine, &config);
+    for (int i = 0; i < n; i++) {
+      motion_q_engine_push_raw(&fixed_engine, frames[i], data[i].timestamp_ms);
+      motion_q_engine_pop_decision(&fixed_engine, &q);
+    }
+  }
+  uint64_t fixed_cycles = cycles_now() - start;
+
+  // one untimed pass to compare the labels
+  motion_engine_init(&float_engine, &config);
+  motion_q_engine_init(&fixed_engine, &config);
+  for (int i = 0; i < n; i++) {
+    bool ready = motion_engine_push_raw(&float_engine, frames[i], 0);
+    motion_q_engine_push_raw(&fixed_engine, frames[i], 0);
+    if (ready && motion_engine_pop_decision(&float_engine, &f) &&
+        motion_q_engine_pop_decision(&fixed_engine, &q))
+      mismatches += f.label != q.label;
+  }
+
+  double samples = (double)n * BENCH_PASSES;
+  printf("%-16s raw   | float %6.1f cyc/sample | fixed %6.1f cyc/sample | "
+         "label mismatches %d\n",
+         name, float_cycles / samples, fixed_cycles / samples, mismatches);
+}
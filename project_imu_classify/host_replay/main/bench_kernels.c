@@ -0,0 +1,71 @@
+/**
+ * @file bench_kernels.c offline relabelling throughput per kernel backend
+ *
+ * Mirrors extract_feature.py: the recording is low-pass filtered once, cut
+ * into non-overlapping windows and every window is turned into a feature
+ * vector and a label. The same pass runs on each backend the host supports
+ * and the labels are checked against the scalar backend.
+ */
+
+#include "feature_kernels.h"
+#include "motion_engine.h"
+#include "replay.h"
+#include <stdio.h>
+
+#define BENCH_PASSES 2000
+#define BENCH_MAX_WINDOWS 128
+
+static float acc[4096];
+static float gyro[4096];
+static motion_class_t labels[FK_NUM_BACKENDS][BENCH_MAX_WINDOWS];
+
+static int relabel(int n, motion_class_t *out) {
+  motion_features_t a, g;
+  int windows = 0;
+
+  for (int i = 0; i + MOTION_WINDOW_SIZE <= n && windows < BENCH_MAX_WINDOWS;
+       i += MOTION_WINDOW_SIZE) {
+    motion_block_features(acc + i, MOTION_WINDOW_SIZE, &a);
+    motion_block_features(gyro + i, MOTION_WINDOW_SIZE, &g);
+    out[windows++] = motion_classify(a.rms, a.peak, g.rms);
+  }
+  return windows;
+}
+
+void bench_kernels(const char *name, const motion_sample_t *data, int n) {
+  fk_backend_t initial = fk_get_backend();
+  float acc_f = 0, gyro_f = 0;
+  int windows = 0;
+
+  if (n > (int)(sizeof(acc) / sizeof(acc[0])))
+    n = sizeof(acc) / sizeof(acc[0]);
+
+  // same gravity removal and smoothing as the engine
+  for (int i = 0; i < n; i++) {
+    acc_f = lowpass_filter(data[i].accel_mag - 1.0f, acc_f, MOTION_LPF_ALPHA);
+    gyro_f = lowpass_filter(data[i].gyro_mag, gyro_f, MOTION_LPF_ALPHA);
+    acc[i] = acc_f;
+    gyro[i] = gyro_f;
+  }
+
+  printf("%-16s relabel", name);
+  for (int b = 0; b < FK_NUM_BACKENDS; b++) {
+    if (!fk_set_backend(b))
+      continue;
+
+    int64_t start = now_ns();
+    for (int pass = 0; pass < BENCH_PASSES; pass++)
+      windows = relabel(n, labels[b]);
+    double elapsed_s = (now_ns() - start) / 1e9;
+
+    int mismatches = 0;
+    for (int w = 0; w < windows; w++)
+      mismatches += labels[b][w] != labels[FK_BACKEND_SCALAR][w];
+
+    printf(" | %s %.2f Mwin/s (%d diff)", fk_backend_name(b),
+           windows * (double)BENCH_PASSES / elapsed_s / 1e6, mismatches);
+  }
+  printf("\n");
+
+  fk_set_backend(initial);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file bench_window.c rescan vs incremental window features
+ *
+ * Both variants produce acc RMS, acc peak and gyro RMS after every sample
+ * (hop of 1 over a MOTION_WINDOW_SIZE window), which is the worst case for
+ * the rescan approach the firmware used before feature_window. The rescan
+ * runs on the scalar kernels, as that firmware did, whatever backend
+ * feature_kernels dispatches to on this host.
+ */
+
+#include "feature_kernels.h"
+#include "feature_window.h"
+#include "motion_engine.h"
+#include "replay.h"
+#include <math.h>
+#include <stdio.h>
+
+#define BENCH_PASSES 50
+
+static volatile double sink;
+
+static int64_t bench_rescan(const motion_sample_t *data, int n,
+                            double *checksum) {
+  float acc_buffer[MOTION_WINDOW_SIZE];
+  float gyro_buffer[MOTION_WINDOW_SIZE];
+  double sum = 0;
+  fk_backend_t initial = fk_get_backend();
+
+  fk_set_backend(FK_BACKEND_SCALAR);
+  int64_t start = now_ns();
+  for (int pass = 0; pass < BENCH_PASSES; pass++) {
+    float acc_filtered = 0;
+    float gyro_filtered = 0;
+    int filled = 0;
+    int index = 0;
+
+    for (int i = 0; i < n; i++) {
+      acc_filtered = lowpass_filter(data[i].accel_mag - 1.0f, acc_filtered,
+                                    MOTION_LPF_ALPHA);
+      gyro_filtered =
+          lowpass_filter(data[i].gyro_mag, gyro_filtered, MOTION_LPF_ALPHA);
+
+      acc_buffer[index] = acc_filtered;
+      gyro_buffer[index] = gyro_filtered;
+      index = (index + 1) % MOTION_WINDOW_SIZE;
+      if (filled < MOTION_WINDOW_SIZE) {
+        filled++;
+        continue;
+      }
+
+      float acc_rms = compute_rms(acc_buffer, MOTION_WINDOW_SIZE);
+      float acc_peak = compute_peak(acc_buffer, MOTION_WINDOW_SIZE);
+      float gyro_rms = compute_rms(gyro_buffer, MOTION_WINDOW_SIZE);
+      sum += acc_rms + acc_peak + gyro_rms;
+    }
+  }
+  int64_t elapsed = now_ns() - start;
+  fk_set_backend(initial);
+
+  sink = sum;
+  *checksum = sum;
+  return elapsed;
+}
+
+static int64_t bench_incremental(const motion_sample_t *data, int n,
+                                 double *checksum) {
+  feature_window_t acc_window;
+  feature_window_t gyro_window;
+  double sum = 0;
+
+  int64_t start = now_ns();
+  for (int pass = 0; pass < BENCH_PASSES; pass++) {
+    float acc_filtered = 0;
+    float gyro_filtered = 0;
+
+    feature_window_init(&acc_window, MOTION_WINDOW_SIZE);
+    feature_window_init(&gyro_window, MOTION_WINDOW_SIZE);
+
+    for (int i = 0; i < n; i++) {
+      acc_filtered = lowpass_filter(data[i].accel_mag - 1.0f, acc_filtered,
+                                    MOTION_LPF_ALPHA);
+      gyro_filtered =
+          lowpass_filter(data[i].gyro_mag, gyro_filtered, MOTION_LPF_ALPHA);
+
+      // same warm-up as the rescan loop: skip the sample that fills it
+      bool was_full = feature_window_full(&acc_window);
+      feature_window_push(&acc_window, acc_filtered);
+      feature_window_push(&gyro_window, gyro_filtered);
+      if (!was_full)
+        continue;
+
+      float acc_rms = feature_window_rms(&acc_window);
+      float acc_peak = feature_window_peak(&acc_window);
+      float gyro_rms = feature_window_rms(&gyro_window);
+      sum += acc_rms + acc_peak + gyro_rms;
+    }
+  }
+  int64_t elapsed = now_ns() - start;
+
+  sink = sum;
+  *checksum = sum;
+  return elapsed;
+}
+
+void bench_window(const char *name, const motion_sample_t *data, int n) {
+  double rescan_sum;
+  double incremental_sum;
+
+  int64_t rescan_ns = bench_rescan(data, n, &rescan_sum);
+  int64_t incremental_ns = bench_incremental(data, n, &incremental_sum);
+
+  double samples = (double)n * BENCH_PASSES;
+  double rel_err =
+      fabs(rescan_sum - incremental_sum) / (fabs(rescan_sum) + 1e-9);
+
+  printf("%-16s hop=1 | scalar rescan %6.1f ns/sample | incremental %6.1f "
+         "ns/sample | x%.1f | rel. diff %.1e\n",
+         name, rescan_ns / samples, incremental_ns / samples,
+         (double)rescan_ns / (double)(incremental_ns ? incremental_ns : 1),
+         rel_err);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file replay.h shared types for the host replay tools
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef struct {
+  int64_t timestamp_ms;
+  float accel_mag;
+  float gyro_mag;
+} motion_sample_t;
+
+int64_t now_ns(void);
+
+// TSC cycles on x86 hosts, nanoseconds elsewhere
+static inline uint64_t cycles_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return (uint64_t)now_ns();
+#endif
+}
+
+// sliding-window rescan vs incremental feature update, hop of one sample
+void bench_window(const char *name, const motion_sample_t *data, int n);
+
+// float vs fixed-point engine fed with raw register frames
+void bench_fixed(const char *name, const motion_sample_t *data, int n);
+
+// offline window relabelling on each feature kernel backend
+void bench_kernels(const char *name, const motion_sample_t *data, int n);
+
+#endif // REPLAY_H
@@ -0,0 +1,128 @@
+/**
+ * @file replay_main.c replays the motion_data recordings through the engine
+ *
+ * Runs on the linux target only. Every recording is loaded into memory first
+ * so the timed part measures the engine and nothing else.
+ * Run from the host_replay folder: ./build/host_replay.elf
+ * (set MOTION_DATA_DIR to replay recordings stored elsewhere)
+ */
+
+#include "motion_engine.h"
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_DATA_DIR "../motion_data"
+#define MAX_SAMPLES 4096
+#define REPLAY_PASSES 200
+
+static const char *const recordings[] = {
+    "stationary.csv",
+    "slow.csv",
+    "vibration.csv",
+    "tap.csv",
+};
+
+static motion_sample_t samples[MAX_SAMPLES];
+
+int64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Recordings are "time_ms,accel_mag,gyro_mag" without a header row
+static int load_csv(const char *path, motion_sample_t *out, int max) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    printf("cannot open %s\n", path);
+    return -1;
+  }
+
+  int n = 0;
+  long long t;
+  float a, g;
+  while (n < max && fscanf(f, "%lld,%f,%f", &t, &a, &g) == 3) {
+    out[n].timestamp_ms = t;
+    out[n].accel_mag = a;
+    out[n].gyro_mag = g;
+    n++;
+  }
+
+  fclose(f);
+  return n;
+}
+
+static void replay(const char *name, const motion_sample_t *data, int n) {
+  static motion_engine_t engine;
+  motion_decision_t decision;
+  int histogram[MOTION_NUM_CLASSES] = {0};
+  int windows = 0;
+  int64_t window_ns_total = 0;
+  int64_t window_ns_max = 0;
+
+  int64_t start = now_ns();
+
+  for (int pass = 0; pass < REPLAY_PASSES; pass++) {
+    motion_engine_init(&engine, NULL);
+
+    for (int i = 0; i < n; i++) {
+      int64_t t0 = now_ns();
+      bool closed = motion_engine_push_sample(&engine, data[i].accel_mag,
+                                              data[i].gyro_mag,
+                                              data[i].timestamp_ms);
+      if (!closed)
+        continue;
+
+      motion_engine_pop_decision(&engine, &decision);
+      int64_t dt = now_ns() - t0;
+
+      window_ns_total += dt;
+      if (dt > window_ns_max)
+        window_ns_max = dt;
+      windows++;
+
+      // the decisions are identical on every pass, count them once
+      if (pass == 0)
+        histogram[decision.label]++;
+    }
+  }
+
+  int64_t elapsed = now_ns() - start;
+  double samples_per_s =
+      (double)n * REPLAY_PASSES / ((double)elapsed / 1e9);
+
+  printf("%-16s %5d samples | %3d windows |", name, n,
+         windows / REPLAY_PASSES);
+  for (int c = 0; c < MOTION_NUM_CLASSES; c++)
+    printf(" %d", histogram[c]);
+  printf(" | %10.0f samples/s | window avg %lld ns max %lld ns\n",
+         samples_per_s, (long long)(windows ? window_ns_total / windows : 0),
+         (long long)window_ns_max);
+}
+
+void app_main(void) {
+  const char *dir = getenv("MOTION_DATA_DIR");
+  if (!dir)
+    dir = DEFAULT_DATA_DIR;
+
+  printf("Replaying %s (%d passes per file)\n", dir, REPLAY_PASSES);
+  printf("histogram order:");
+  for (int c = 0; c < MOTION_NUM_CLASSES; c++)
+    printf(" %s,", motion_class_to_str(c));
+  printf("\n");
+
+  for (size_t i = 0; i < sizeof(recordings) / sizeof(recordings[0]); i++) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, recordings[i]);
+
+    int n = load_csv(path, samples, MAX_SAMPLES);
+    if (n > 0) {
+      replay(recordings[i], samples, n);
+      bench_window(recordings[i], samples, n);
+      bench_fixed(recordings[i], samples, n);
+      bench_kernels(recordings[i], samples, n);
+    }
+  }
+}
@@ -0,0 +1,58 @@
+#include "test_alloc.h"
+#include "alloc_trace.h"
+#include <stddef.h>
+
+static uint32_t allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+// the wraps alloc_trace would install on the chip, fed from here
+void *__wrap_malloc(size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    void *ptr = __real_malloc(size);
+    if (ptr)
+        alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, size,
+                           __builtin_return_address(0));
+    return ptr;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    void *ptr = __real_calloc(n, size);
+    if (ptr)
+        alloc_trace_record(ALLOC_TRACE_ALLOC, ptr, n * size,
+                           __builtin_return_address(0));
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    void *moved = __real_realloc(ptr, size);
+    if (moved || !size) {
+        if (ptr)
+            alloc_trace_record(ALLOC_TRACE_FREE, ptr, 0,
+                               __builtin_return_address(0));
+        if (moved)
+            alloc_trace_record(ALLOC_TRACE_ALLOC, moved, size,
+                               __builtin_return_address(0));
+    }
+    return moved;
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr)
+        alloc_trace_record(ALLOC_TRACE_FREE, ptr, 0, __builtin_return_address(0));
+    __real_free(ptr);
+}
+
+uint32_t test_alloc_count(void)
+{
+    return __atomic_load_n(&allocs, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,17 @@
+/**
+ * @file test_alloc.h heap call counter for the host tests
+ *
+ * malloc, calloc, realloc and free are wrapped at link time (see
+ * CMakeLists.txt), so a test can check that a code path never reaches the
+ * heap. The wraps also feed alloc_trace while it is started.
+ */
+
+#ifndef TEST_ALLOC_H
+#define TEST_ALLOC_H
+
+#include <stdint.h>
+
+// heap allocations made through the wrapped calls since the program started
+uint32_t test_alloc_count(void);
+
+#endif // TEST_ALLOC_H
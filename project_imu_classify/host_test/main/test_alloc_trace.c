@@ -0,0 +1,319 @@
+#include "unity.h"
+#include "alloc_trace.h"
+#include "arena.h"
+#include "gpio_mock.h"
+#include "slab.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WRITERS 4
+#define EVENTS_PER_WRITER 20000
+#define BENCH_OPS 200000
+#define SITE_REACH 64 // bytes from a small function's entry to its call
+
+static alloc_trace_table_t table;
+static void *kept;
+static void *volatile held; // escapes, so the pairs are not optimized out
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void restart(void)
+{
+    alloc_trace_stop();
+    alloc_trace_reset();
+    alloc_trace_table_reset(&table);
+    alloc_trace_start();
+}
+
+static void drain_into_table(void)
+{
+    alloc_trace_stop();
+    while (alloc_trace_drain(alloc_trace_table_add, &table, ALLOC_TRACE_RING_LEN))
+        ;
+}
+
+// The site recorded for a heap call made near the start of fn: the
+// closest one after its entry, as the next function may follow right after
+static const alloc_trace_site_t *site_in(void (*fn)(void))
+{
+    const alloc_trace_site_t *best = NULL;
+    for (int i = 0; i < table.num_sites; i++) {
+        uintptr_t offset = table.sites[i].site - (uintptr_t)fn;
+        if (offset < SITE_REACH && (!best || table.sites[i].site < best->site))
+            best = &table.sites[i];
+    }
+    return best;
+}
+
+// ---------------------
+// Call sites with something to find: a block kept on purpose and a
+// block given back. Stored to globals so the calls stay calls.
+// ---------------------
+
+__attribute__((noinline)) static void leak_one(void)
+{
+    kept = malloc(24);
+}
+
+__attribute__((noinline)) static void borrow_one(void)
+{
+    void *p = calloc(4, 10);
+    held = p;
+    free(p);
+}
+
+// ---------------------
+
+void test_alloc_trace_keeps_live_bytes_per_site(void)
+{
+    restart();
+    leak_one();
+    borrow_one();
+    borrow_one();
+    drain_into_table();
+    void *leaked = kept;
+    leak_one(); // stopped: not recorded
+    free(kept);
+
+    TEST_ASSERT_FALSE(alloc_trace_enabled()); // no heap_caps_* to wrap here
+    const alloc_trace_site_t *leak = site_in(leak_one);
+    TEST_ASSERT_NOT_NULL(leak);
+    TEST_ASSERT_EQUAL_UINT32(1, leak->allocs);
+    TEST_ASSERT_EQUAL_UINT32(0, leak->frees);
+    TEST_ASSERT_EQUAL(24, leak->live_bytes);
+
+    // the free goes to the site that allocated, not to where it happened
+    const alloc_trace_site_t *borrow = site_in(borrow_one);
+    TEST_ASSERT_NOT_NULL(borrow);
+    TEST_ASSERT_EQUAL_UINT32(2, borrow->allocs);
+    TEST_ASSERT_EQUAL_UINT32(2, borrow->frees);
+    TEST_ASSERT_EQUAL(0, borrow->live_bytes);
+    TEST_ASSERT_EQUAL(40, borrow->peak_bytes);
+    TEST_ASSERT_EQUAL(80, borrow->total_bytes);
+
+    TEST_ASSERT_EQUAL_INT(2, table.num_sites);
+    TEST_ASSERT_EQUAL(24, alloc_trace_table_live_bytes(&table));
+    free(leaked);
+}
+
+void test_alloc_trace_catches_component_regressions(void)
+{
+    static const slab_class_config_t classes[] = {
+        {1024, 1}, {2048, 1}, {4096, 1}, {8192, 1}, {16384, 1}, // day06's
+    };
+    static const size_t sizes[5] = {1024, 2048, 4096, 8192, 16384};
+    slab_t slab;
+    slab_cache_t cache;
+    arena_t arena;
+    void *blocks[5];
+
+    // setup reaches the heap once per pool, teardown gives all of it back
+    restart();
+    TEST_ASSERT_EQUAL(ESP_OK, slab_init(&slab, classes, 5));
+    TEST_ASSERT_EQUAL(ESP_OK, arena_init(&arena, 1024, ARENA_CAPS_DRAM));
+    drain_into_table();
+    TEST_ASSERT_EQUAL_INT(2, table.num_sites); // block_pool_init, arena_init
+    TEST_ASSERT_EQUAL_UINT32(5, table.sites[0].live_blocks);
+    TEST_ASSERT_TRUE(table.sites[0].live_bytes >= 31 * 1024);
+
+    // day06's slab_task cycle: nothing at all once the slab is up
+    alloc_trace_start();
+    slab_cache_init(&cache, &slab);
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 5; i++)
+            blocks[i] = slab_cache_alloc(&cache, sizes[i]);
+        for (int i = 0; i < 5; i++)
+            slab_cache_free(&cache, blocks[i]);
+        arena_mark_t mark = arena_mark(&arena);
+        arena_alloc(&arena, 512);
+        arena_release(&arena, mark);
+    }
+    slab_cache_deinit(&cache);
+    drain_into_table();
+    TEST_ASSERT_EQUAL_INT(2, table.num_sites);
+    TEST_ASSERT_EQUAL_UINT32(5, table.sites[0].allocs);
+
+    alloc_trace_start();
+    arena_deinit(&arena);
+    slab_deinit(&slab);
+    drain_into_table();
+    TEST_ASSERT_EQUAL(0, alloc_trace_table_live_bytes(&table));
+    TEST_ASSERT_EQUAL_UINT32(0, table.unknown_frees);
+    TEST_ASSERT_EQUAL_UINT32(0, alloc_trace_dropped());
+}
+
+void test_alloc_trace_full_ring_drops(void)
+{
+    restart();
+    for (uintptr_t i = 1; i <= ALLOC_TRACE_RING_LEN + 5; i++)
+        alloc_trace_record(ALLOC_TRACE_ALLOC, (void *)(i * 16), 16, (void *)0x1001);
+    TEST_ASSERT_EQUAL_UINT32(5, alloc_trace_dropped());
+
+    drain_into_table();
+    TEST_ASSERT_EQUAL_UINT32(ALLOC_TRACE_RING_LEN, table.sites[0].allocs);
+    TEST_ASSERT_EQUAL_UINT32(0x1000, table.sites[0].site);
+
+    // freeing what the table never saw allocated is counted, not matched
+    alloc_trace_start();
+    alloc_trace_record(ALLOC_TRACE_FREE, (void *)16, 0, (void *)0x2001);
+    alloc_trace_record(ALLOC_TRACE_FREE, (void *)16, 0, (void *)0x2001);
+    alloc_trace_record(ALLOC_TRACE_FREE, (void *)0x999990, 0, (void *)0x2001);
+    drain_into_table();
+    TEST_ASSERT_EQUAL_UINT32(1, table.sites[0].frees);
+    TEST_ASSERT_EQUAL_UINT32(2, table.unknown_frees);
+
+    // a full table of live blocks stops matching and says so
+    alloc_trace_table_reset(&table);
+    for (uintptr_t i = 1; i <= ALLOC_TRACE_MAX_LIVE + 1; i++) {
+        alloc_trace_event_t e = {.kind = ALLOC_TRACE_ALLOC, .ptr = i * 8,
+                                 .size = 8, .depth = 1, .stack = {0x1000}};
+        alloc_trace_table_add(&e, &table);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, table.overflows);
+    TEST_ASSERT_EQUAL_UINT32(ALLOC_TRACE_MAX_LIVE, table.sites[0].live_blocks);
+}
+
+// ---------------------
+// Writers on every core against one reader: each writer's events come out
+// in order, and every event is either drained or counted as dropped
+// ---------------------
+
+static volatile int writers_done;
+
+static void *writer(void *arg)
+{
+    uintptr_t id = (uintptr_t)arg;
+    for (uintptr_t i = 1; i <= EVENTS_PER_WRITER; i++) {
+        alloc_trace_record(ALLOC_TRACE_ALLOC, (void *)(id << 24 | i), 1,
+                           (void *)(id + 1));
+        if ((i & 15) == 0)
+            usleep(1); // bursts, like tasks between their heap calls
+    }
+    __atomic_add_fetch(&writers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+typedef struct {
+    uintptr_t last[WRITERS];
+    uint32_t drained;
+    uint32_t out_of_order;
+} race_check_t;
+
+static void check_event(const alloc_trace_event_t *e, void *ctx)
+{
+    race_check_t *check = ctx;
+    uintptr_t id = e->ptr >> 24;
+    uintptr_t seq = e->ptr & 0xffffff;
+
+    if (id >= WRITERS || e->stack[0] != id)
+        return; // not one of the writers' events
+    if (seq <= check->last[id])
+        check->out_of_order++;
+    check->last[id] = seq;
+    check->drained++;
+}
+
+void test_alloc_trace_writers_race(void)
+{
+    pthread_t threads[WRITERS];
+    race_check_t check = {0};
+
+    restart();
+    writers_done = 0;
+    for (uintptr_t i = 0; i < WRITERS; i++)
+        pthread_create(&threads[i], NULL, writer, (void *)i);
+    while (__atomic_load_n(&writers_done, __ATOMIC_ACQUIRE) < WRITERS)
+        alloc_trace_drain(check_event, &check, 32);
+    for (int i = 0; i < WRITERS; i++)
+        pthread_join(threads[i], NULL);
+    alloc_trace_stop();
+    while (alloc_trace_drain(check_event, &check, ALLOC_TRACE_RING_LEN))
+        ;
+
+    printf("alloc_trace: %d writers x %d events, %u drained, %u dropped\n",
+           WRITERS, EVENTS_PER_WRITER, (unsigned)check.drained,
+           (unsigned)alloc_trace_dropped());
+    TEST_ASSERT_EQUAL_UINT32(0, check.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(WRITERS * EVENTS_PER_WRITER,
+                             check.drained + alloc_trace_dropped());
+
+    // what a traced malloc costs over a plain one, with the ring drained
+    // often enough never to drop
+    int64_t start = now_ns();
+    for (int i = 0; i < BENCH_OPS; i++) {
+        held = malloc(32);
+        free(held);
+    }
+    int64_t plain = now_ns() - start;
+
+    restart();
+    start = now_ns();
+    for (int i = 0; i < BENCH_OPS; i++) {
+        held = malloc(32);
+        free(held);
+        if ((i & 31) == 31)
+            alloc_trace_drain(alloc_trace_table_add, &table, ALLOC_TRACE_RING_LEN);
+    }
+    int64_t traced = now_ns() - start;
+    drain_into_table();
+
+    printf("alloc_trace: malloc+free %.0f ns plain, %.0f ns traced "
+           "(tallied per site)\n",
+           (double)plain / BENCH_OPS, (double)traced / BENCH_OPS);
+    TEST_ASSERT_EQUAL_UINT32(0, alloc_trace_dropped());
+    TEST_ASSERT_EQUAL(0, alloc_trace_table_live_bytes(&table));
+}
+
+// ---------------------
+
+void test_alloc_trace_flush_lines(void)
+{
+    char lines[4][80];
+    int num_lines = 0;
+
+    gpio_mock_reset();
+    restart();
+    gpio_mock_advance_us(1500);
+    alloc_trace_record(ALLOC_TRACE_ALLOC, (void *)0xbeef0, 48, (void *)0x4001);
+    gpio_mock_advance_us(500);
+    alloc_trace_record(ALLOC_TRACE_FREE, (void *)0xbeef0, 0, (void *)0x5001);
+    alloc_trace_stop();
+
+    // alloc_trace_flush() output, through a temporary file in place of stdout
+    FILE *tmp = tmpfile();
+    TEST_ASSERT_NOT_NULL(tmp);
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(tmp), STDOUT_FILENO);
+    alloc_trace_flush();
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    rewind(tmp);
+    while (num_lines < 4 && fgets(lines[num_lines], sizeof(lines[0]), tmp))
+        num_lines++;
+    fclose(tmp);
+
+    // the layout alloc_trace_report.py reads
+    TEST_ASSERT_EQUAL_INT(3, num_lines);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(lines[0], ALLOC_TRACE_PREFIX ",start,", 18));
+    TEST_ASSERT_EQUAL_STRING(ALLOC_TRACE_PREFIX ",a,1500,beef0,48,4000\n", lines[1]);
+    TEST_ASSERT_EQUAL_STRING(ALLOC_TRACE_PREFIX ",f,2000,beef0,0,5000\n", lines[2]);
+}
+
+void run_alloc_trace_tests(void)
+{
+    RUN_TEST(test_alloc_trace_keeps_live_bytes_per_site);
+    RUN_TEST(test_alloc_trace_catches_component_regressions);
+    RUN_TEST(test_alloc_trace_full_ring_drops);
+    RUN_TEST(test_alloc_trace_writers_race);
+    RUN_TEST(test_alloc_trace_flush_lines);
+}
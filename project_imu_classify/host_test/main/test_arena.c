@@ -0,0 +1,199 @@
+#include "unity.h"
+#include "arena.h"
+#include "feature_kernels.h"
+#include "motion_engine.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCRATCH_BYTES 1024 // one window of block features, with room to spare
+#define PAINT_BYTES (64 * 1024)
+#define PAINT 0xA5
+
+static arena_t arena;
+static motion_engine_t engine;
+static motion_features_t acc_out, gyro_out;
+
+// A window's worth of samples, more than one lap of the ring
+static void fill_engine(void)
+{
+    motion_engine_init(&engine, NULL);
+    for (int i = 0; i < MOTION_WINDOW_SIZE + 17; i++)
+        motion_engine_push_sample(&engine, 1.0f + 0.5f * sinf(i * 0.7f),
+                                  20.0f * cosf(i * 0.3f), i * 10);
+}
+
+// ---------------------
+// Block features of a window, copies on the stack vs in the arena
+// ---------------------
+
+// the copies on the task stack
+static void *features_on_stack(void *arg)
+{
+    float acc_buf[FEATURE_WINDOW_MAX];
+    float gyro_buf[FEATURE_WINDOW_MAX];
+
+    motion_block_features(acc_buf, feature_window_copy(&engine.acc_window, acc_buf),
+                          &acc_out);
+    motion_block_features(gyro_buf,
+                          feature_window_copy(&engine.gyro_window, gyro_buf),
+                          &gyro_out);
+    return NULL;
+}
+
+// the copies in the arena, released when the features are out
+static void *features_in_arena(void *arg)
+{
+    arena_mark_t mark = arena_mark(&arena);
+    float *acc_buf = arena_alloc(&arena, sizeof(float) * engine.acc_window.count);
+    float *gyro_buf = arena_alloc(&arena, sizeof(float) * engine.gyro_window.count);
+
+    if (acc_buf && gyro_buf) {
+        motion_block_features(acc_buf, feature_window_copy(&engine.acc_window, acc_buf),
+                              &acc_out);
+        motion_block_features(gyro_buf,
+                              feature_window_copy(&engine.gyro_window, gyro_buf),
+                              &gyro_out);
+    }
+    arena_release(&arena, mark);
+    return NULL;
+}
+
+static void *nothing(void *arg)
+{
+    return NULL;
+}
+
+// Stack bytes fn touches on a painted thread stack: the high-water mark
+// uxTaskGetStackHighWaterMark() reports on the chip, from the other side
+static size_t stack_used(void *(*fn)(void *))
+{
+    void *stack;
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (posix_memalign(&stack, 4096, PAINT_BYTES))
+        return 0;
+    memset(stack, PAINT, PAINT_BYTES);
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, PAINT_BYTES);
+    pthread_create(&thread, &attr, fn, NULL);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    // the stack grows down: count up to the first byte written
+    size_t untouched = 0;
+    while (untouched < PAINT_BYTES && ((uint8_t *)stack)[untouched] == PAINT)
+        untouched++;
+    free(stack);
+    return PAINT_BYTES - untouched;
+}
+
+// ---------------------
+
+void test_arena_bumps_and_releases(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, arena_init(&arena, 256, ARENA_CAPS_DRAM));
+
+    uint8_t *a = arena_alloc(&arena, 3);
+    uint8_t *b = arena_alloc(&arena, 16);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_EQUAL_PTR(a + ARENA_ALIGN, b); // next aligned address
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b % ARENA_ALIGN);
+    TEST_ASSERT_EQUAL(24, arena.used);
+
+    // everything after the mark goes at once, what came before stays
+    arena_mark_t mark = arena_mark(&arena);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100));
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100));
+    TEST_ASSERT_NULL(arena_alloc(&arena, 100));
+    TEST_ASSERT_EQUAL_UINT32(1, arena.fails);
+    arena_release(&arena, mark);
+    TEST_ASSERT_EQUAL(24, arena.used);
+    TEST_ASSERT_EQUAL(232, arena_remaining(&arena));
+    TEST_ASSERT_EQUAL(228, arena.peak); // 24, aligned 128, +100
+
+    // the same memory again, with nothing freed piece by piece
+    TEST_ASSERT_EQUAL_PTR(b + 16, arena_alloc(&arena, 232));
+    TEST_ASSERT_NULL(arena_alloc(&arena, 1));
+    arena_reset(&arena);
+    TEST_ASSERT_EQUAL_PTR(a, arena_alloc(&arena, 1));
+
+    // a mark above the top is not a way to grow
+    arena_release(&arena, 200);
+    TEST_ASSERT_EQUAL(1, arena.used);
+    arena_deinit(&arena);
+}
+
+void test_arena_static_buffer(void)
+{
+    static uint8_t buf[64] __attribute__((aligned(ARENA_ALIGN)));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, arena_init_static(&arena, NULL, 64));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, arena_init_static(&arena, buf, 0));
+
+    // an unaligned buffer still gives aligned blocks, a little less of them
+    TEST_ASSERT_EQUAL(ESP_OK, arena_init_static(&arena, buf + 1, 63));
+    uint8_t *p = arena_alloc(&arena, 8);
+    TEST_ASSERT_EQUAL_PTR(buf + 8, p);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 48));
+    TEST_ASSERT_NULL(arena_alloc(&arena, 1));
+    arena_deinit(&arena);
+    TEST_ASSERT_NULL(arena.base);
+}
+
+void test_arena_window_features_match_stack(void)
+{
+    motion_features_t acc_ref, gyro_ref;
+
+    fill_engine();
+    features_on_stack(NULL);
+    acc_ref = acc_out;
+    gyro_ref = gyro_out;
+    memset(&acc_out, 0, sizeof(acc_out));
+    memset(&gyro_out, 0, sizeof(gyro_out));
+
+    TEST_ASSERT_EQUAL(ESP_OK, arena_init(&arena, SCRATCH_BYTES, ARENA_CAPS_DRAM));
+    features_in_arena(NULL);
+    TEST_ASSERT_EQUAL(0, arena.used); // all given back
+    TEST_ASSERT_EQUAL(2 * sizeof(float) * MOTION_WINDOW_SIZE, arena.peak);
+    TEST_ASSERT_TRUE(memcmp(&acc_ref, &acc_out, sizeof(acc_ref)) == 0);
+    TEST_ASSERT_TRUE(memcmp(&gyro_ref, &gyro_out, sizeof(gyro_ref)) == 0);
+
+    // the copy is the window oldest first, the same one the O(1) sums see
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, feature_window_rms(&engine.acc_window),
+                             acc_out.rms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, feature_window_peak(&engine.gyro_window),
+                             gyro_out.peak);
+
+    arena_deinit(&arena);
+}
+
+void test_arena_keeps_scratch_off_the_stack(void)
+{
+    fill_engine();
+    arena_init(&arena, SCRATCH_BYTES, ARENA_CAPS_DRAM);
+
+    size_t base = stack_used(nothing); // thread start and TLS
+    size_t on_stack = stack_used(features_on_stack) - base;
+    size_t in_arena = stack_used(features_in_arena) - base;
+
+    printf("arena: window features take %u stack bytes with the copies on "
+           "the stack, %u with them in a %u-byte arena (peak %u)\n",
+           (unsigned)on_stack, (unsigned)in_arena, SCRATCH_BYTES,
+           (unsigned)arena.peak);
+
+    // at least the two windows' worth of copies moved out
+    TEST_ASSERT_TRUE(on_stack >= in_arena + 2 * sizeof(float) * MOTION_WINDOW_SIZE);
+    arena_deinit(&arena);
+}
+
+void run_arena_tests(void)
+{
+    RUN_TEST(test_arena_bumps_and_releases);
+    RUN_TEST(test_arena_static_buffer);
+    RUN_TEST(test_arena_window_features_match_stack);
+    RUN_TEST(test_arena_keeps_scratch_off_the_stack);
+}
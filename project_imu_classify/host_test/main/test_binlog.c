@@ -0,0 +1,252 @@
+#include "unity.h"
+#include "drivers/imu_driver.h"
+#include "tasks/binlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_RECORDS 1000
+#define TICK_US 100000 // main.c's fusion period
+#define STREAM_MAX (64 * 1024) // about 20 bytes per record
+
+static fused_msg_t records[NUM_RECORDS];
+static fused_msg_t decoded[NUM_RECORDS];
+static uint8_t stream[STREAM_MAX];
+static binlog_t binlog;
+static uint32_t rng = 1;
+
+static float uniform(float lo, float hi)
+{
+    rng = rng * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float)(rng >> 8) / (float)(1 << 24);
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Fused records as the aggregator makes them: every tick, the ultrasonic
+// sensor in two of three
+static void make_records(void)
+{
+    rng = 1;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        fused_msg_t *r = &records[i];
+        memset(r, 0, sizeof(*r));
+        r->timestamp = 1234567 + (int64_t)i * TICK_US;
+        r->valid = 1u << SENSOR_IMU;
+        r->data[SENSOR_IMU][IMU_AX] = uniform(-2.0f, 2.0f);
+        r->data[SENSOR_IMU][IMU_AY] = uniform(-2.0f, 2.0f);
+        r->data[SENSOR_IMU][IMU_AZ] = uniform(-2.0f, 2.0f);
+        r->data[SENSOR_IMU][IMU_TEMP] = uniform(20.0f, 40.0f);
+        r->data[SENSOR_IMU][IMU_GX] = uniform(-250.0f, 250.0f);
+        r->data[SENSOR_IMU][IMU_GY] = uniform(-250.0f, 250.0f);
+        r->data[SENSOR_IMU][IMU_GZ] = uniform(-250.0f, 250.0f);
+        if (i % 3) {
+            r->valid |= 1u << SENSOR_ULTRASONIC;
+            r->data[SENSOR_ULTRASONIC][0] = uniform(2.0f, 400.0f);
+        }
+    }
+}
+
+// Encode every record, batches back to back as the logger writes them
+static size_t encode_all(void)
+{
+    size_t len = 0;
+
+    binlog_init(&binlog);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        if (binlog_add(&binlog, &records[i]) || i == NUM_RECORDS - 1) {
+            size_t n = binlog_seal(&binlog);
+            memcpy(stream + len, binlog.batch, n);
+            len += n;
+        }
+    }
+    return len;
+}
+
+// Decode a capture the way tools/binlog2csv.py does: skip anything that is
+// not an intact batch
+static int decode_all(const uint8_t *buf, size_t len, int *batches)
+{
+    int total = 0;
+
+    *batches = 0;
+    for (size_t pos = 0; pos < len;) {
+        int n;
+        size_t used = binlog_decode(buf + pos, len - pos, decoded + total,
+                                    NUM_RECORDS - total, &n);
+        if (!used) {
+            pos++;
+            continue;
+        }
+        total += n;
+        pos += used;
+        (*batches)++;
+    }
+    return total;
+}
+
+// ---------------------
+// Format
+// ---------------------
+
+void test_binlog_round_trip_keeps_sensor_resolution(void)
+{
+    int batches;
+
+    make_records();
+    size_t len = encode_all();
+    TEST_ASSERT_EQUAL_INT(NUM_RECORDS, decode_all(stream, len, &batches));
+    TEST_ASSERT_EQUAL_UINT32(binlog.stats.batches, batches);
+    TEST_ASSERT_EQUAL_UINT32(len, binlog.stats.bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, binlog.stats.saturated);
+
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        // timestamps are exact, values within half a step of their scale
+        TEST_ASSERT_EQUAL_INT64(records[i].timestamp, decoded[i].timestamp);
+        TEST_ASSERT_EQUAL_HEX32(records[i].valid, decoded[i].valid);
+        for (int s = 0; s < NUM_SENSOR_LINKS; s++) {
+            if (!(records[i].valid & (1u << s)))
+                continue;
+            for (int v = 0; v < binlog_num_values[s]; v++)
+                TEST_ASSERT_FLOAT_WITHIN(0.5f / binlog_scales[s][v] + 1e-6f,
+                                         records[i].data[s][v],
+                                         decoded[i].data[s][v]);
+        }
+    }
+}
+
+void test_binlog_clamps_out_of_range_values(void)
+{
+    fused_msg_t msg = {.timestamp = 5, .valid = 1u << SENSOR_IMU};
+    int n;
+
+    msg.data[SENSOR_IMU][IMU_AX] = 3.0f;     // beyond +-2 g
+    msg.data[SENSOR_IMU][IMU_GX] = -1000.0f; // beyond +-250 deg/s
+    binlog_init(&binlog);
+    binlog_add(&binlog, &msg);
+    size_t len = binlog_seal(&binlog);
+
+    TEST_ASSERT_EQUAL_UINT32(2, binlog.stats.saturated);
+    TEST_ASSERT_EQUAL_UINT32(len, binlog_decode(binlog.batch, len, decoded, 1, &n));
+    TEST_ASSERT_EQUAL_INT(1, n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 2.0f, decoded[0].data[SENSOR_IMU][IMU_AX]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, INT16_MIN / 131.0f, decoded[0].data[SENSOR_IMU][IMU_GX]);
+}
+
+// ---------------------
+// Damaged and mixed streams
+// ---------------------
+
+void test_binlog_crc_rejects_damaged_batch(void)
+{
+    int n, batches;
+
+    make_records();
+    size_t len = encode_all();
+    int first_count = stream[3];
+    size_t first = binlog_decode(stream, len, decoded, NUM_RECORDS, &n);
+    TEST_ASSERT_EQUAL_INT(first_count, n);
+
+    // one flipped bit in the first batch's payload loses that batch only
+    stream[first / 2] ^= 0x10;
+    TEST_ASSERT_EQUAL_UINT32(0, binlog_decode(stream, len, decoded, NUM_RECORDS, &n));
+    TEST_ASSERT_EQUAL_INT(0, n);
+    TEST_ASSERT_EQUAL_INT(NUM_RECORDS - first_count, decode_all(stream, len, &batches));
+    TEST_ASSERT_EQUAL_INT(binlog.stats.batches - 1, batches);
+    TEST_ASSERT_EQUAL_INT64(records[first_count].timestamp, decoded[0].timestamp);
+}
+
+void test_binlog_found_between_text_logs(void)
+{
+    static uint8_t console[STREAM_MAX + 4096];
+    size_t len = 0;
+    int batches;
+
+    // boot messages and warnings interleaved with the batches, one of them
+    // holding the magic bytes "BL" by chance
+    make_records();
+    encode_all();
+    binlog_init(&binlog);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        if (binlog_add(&binlog, &records[i]) || i == NUM_RECORDS - 1) {
+            len += sprintf((char *)console + len,
+                           "W (%d) AGGREGATOR_TASK: BLogger queue full\n", i);
+            size_t n = binlog_seal(&binlog);
+            memcpy(console + len, binlog.batch, n);
+            len += n;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(NUM_RECORDS, decode_all(console, len, &batches));
+    TEST_ASSERT_EQUAL_UINT32(binlog.stats.batches, batches);
+    TEST_ASSERT_EQUAL_INT64(records[NUM_RECORDS - 1].timestamp,
+                            decoded[NUM_RECORDS - 1].timestamp);
+}
+
+// ---------------------
+// Against the ESP_LOGI lines it replaces
+// ---------------------
+
+// What the logger used to print for one record
+static int format_text(char *buf, size_t size, const fused_msg_t *msg)
+{
+    const float *imu = msg->data[SENSOR_IMU];
+    int n = 0;
+
+    if (msg->valid & (1u << SENSOR_IMU))
+        n += snprintf(buf + n, size - n,
+                      "I (%lld) LOGGER: [IMU] ts=%lld | ax=%.2f ay=%.2f az=%.2f g | "
+                      "t=%.1f C | gx=%.2f gy=%.2f gz=%.2f dps\n",
+                      (long long)msg->timestamp / 1000,
+                      (long long)msg->timestamp, imu[IMU_AX],
+                      imu[IMU_AY], imu[IMU_AZ], imu[IMU_TEMP], imu[IMU_GX],
+                      imu[IMU_GY], imu[IMU_GZ]);
+    if (msg->valid & (1u << SENSOR_ULTRASONIC))
+        n += snprintf(buf + n, size - n,
+                      "I (%lld) LOGGER: [ULTRA] ts=%lld | distance=%.2f cm\n",
+                      (long long)msg->timestamp / 1000,
+                      (long long)msg->timestamp, msg->data[SENSOR_ULTRASONIC][0]);
+    return n;
+}
+
+void test_binlog_bandwidth_and_cpu_against_text(void)
+{
+    const int passes = 20;
+    char line[256];
+    size_t text_bytes = 0, bin_bytes = 0;
+
+    make_records();
+
+    int64_t start = now_ns();
+    for (int p = 0; p < passes; p++)
+        for (int i = 0; i < NUM_RECORDS; i++)
+            text_bytes += format_text(line, sizeof(line), &records[i]);
+    int64_t text_ns = now_ns() - start;
+
+    start = now_ns();
+    for (int p = 0; p < passes; p++)
+        bin_bytes += encode_all();
+    int64_t bin_ns = now_ns() - start;
+
+    printf("binlog: %.1f bytes/record vs %.1f as text, %.0f ns/record vs %.0f\n",
+           (double)bin_bytes / (passes * NUM_RECORDS),
+           (double)text_bytes / (passes * NUM_RECORDS),
+           (double)bin_ns / (passes * NUM_RECORDS),
+           (double)text_ns / (passes * NUM_RECORDS));
+    TEST_ASSERT_LESS_THAN(text_bytes / 5, bin_bytes);
+    TEST_ASSERT_LESS_THAN(text_ns / 5, bin_ns);
+}
+
+void run_binlog_tests(void)
+{
+    RUN_TEST(test_binlog_round_trip_keeps_sensor_resolution);
+    RUN_TEST(test_binlog_clamps_out_of_range_values);
+    RUN_TEST(test_binlog_crc_rejects_damaged_batch);
+    RUN_TEST(test_binlog_found_between_text_logs);
+    RUN_TEST(test_binlog_bandwidth_and_cpu_against_text);
+}
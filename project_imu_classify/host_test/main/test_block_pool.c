@@ -0,0 +1,192 @@
+#include "unity.h"
+#include "block_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCK_SIZE 64 // day04's UART buffers
+#define MAX_BLOCKS 10000
+#define BENCH_OPS 200000
+
+static block_pool_t pool;
+static void *blocks[MAX_BLOCKS];
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------
+// day04's pool before, as the reference: a scan for a free flag on alloc,
+// a scan for the pointer on free
+// ---------------------
+
+static uint8_t scan_storage[MAX_BLOCKS][BLOCK_SIZE];
+static bool scan_used[MAX_BLOCKS];
+static int scan_blocks;
+
+static void *scan_alloc(void)
+{
+    for (int i = 0; i < scan_blocks; i++) {
+        if (!scan_used[i]) {
+            scan_used[i] = true;
+            return scan_storage[i];
+        }
+    }
+    return NULL;
+}
+
+static void scan_free(void *ptr)
+{
+    for (int i = 0; i < scan_blocks; i++) {
+        if (ptr == scan_storage[i]) {
+            scan_used[i] = false;
+            return;
+        }
+    }
+}
+
+// ---------------------
+
+void test_block_pool_hands_out_every_block_once(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, block_pool_init(&pool, 10, 100));
+    TEST_ASSERT_EQUAL(16, pool.stride); // rounded up to the alignment
+
+    for (int i = 0; i < 100; i++) {
+        blocks[i] = block_pool_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_EQUAL(0, (uintptr_t)blocks[i] % BLOCK_POOL_ALIGN);
+        TEST_ASSERT_EQUAL_INT32(i, block_pool_index(&pool, blocks[i]));
+        memset(blocks[i], 0xA5, 10); // the whole block is the caller's
+    }
+    TEST_ASSERT_NULL(block_pool_alloc(&pool));
+
+    block_pool_stats_t stats = block_pool_get_stats(&pool);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.allocs);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.alloc_fails);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.peak_in_use);
+
+    // the last block freed is the next one handed out
+    TEST_ASSERT_TRUE(block_pool_free(&pool, blocks[42]));
+    TEST_ASSERT_TRUE(block_pool_free(&pool, blocks[7]));
+    TEST_ASSERT_EQUAL_PTR(blocks[7], block_pool_alloc(&pool));
+    TEST_ASSERT_EQUAL_PTR(blocks[42], block_pool_alloc(&pool));
+
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(block_pool_free(&pool, blocks[i]));
+    stats = block_pool_get_stats(&pool);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.in_use);
+    TEST_ASSERT_EQUAL_UINT32(102, stats.frees);
+    block_pool_deinit(&pool);
+}
+
+void test_block_pool_refuses_bad_frees(void)
+{
+    int outside;
+
+    TEST_ASSERT_EQUAL(ESP_OK, block_pool_init(&pool, BLOCK_SIZE, 8));
+    uint8_t *a = block_pool_alloc(&pool);
+    uint8_t *b = block_pool_alloc(&pool);
+
+    TEST_ASSERT_FALSE(block_pool_free(&pool, a + 4));  // inside a block
+    TEST_ASSERT_FALSE(block_pool_free(&pool, &outside)); // another object
+    TEST_ASSERT_FALSE(block_pool_free(&pool, NULL));
+    TEST_ASSERT_FALSE(block_pool_free(&pool, a - pool.stride)); // before
+    TEST_ASSERT_FALSE(block_pool_free(&pool, a + 8 * pool.stride)); // after
+    TEST_ASSERT_FALSE(block_pool_free(&pool, a + 5 * pool.stride)); // never out
+
+    TEST_ASSERT_TRUE(block_pool_free(&pool, b));
+    TEST_ASSERT_FALSE(block_pool_free(&pool, b)); // double free
+
+    block_pool_stats_t stats = block_pool_get_stats(&pool);
+    TEST_ASSERT_EQUAL_UINT32(7, stats.bad_frees);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.in_use);
+
+    // the free list survived: every block still comes out exactly once
+    int n = 0;
+    while ((blocks[n] = block_pool_alloc(&pool)))
+        n++;
+    TEST_ASSERT_EQUAL_INT(7, n);
+    block_pool_deinit(&pool);
+}
+
+void test_block_pool_static_buffer(void)
+{
+    static uint8_t buf[BLOCK_POOL_BUF_SIZE(BLOCK_SIZE, 10)]
+        __attribute__((aligned(BLOCK_POOL_ALIGN)));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG,
+                      block_pool_init_static(&pool, buf, sizeof(buf) - 1,
+                                             BLOCK_SIZE, 10));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG,
+                      block_pool_init_static(&pool, buf + 1, sizeof(buf) - 1,
+                                             BLOCK_SIZE, 9));
+    TEST_ASSERT_EQUAL(ESP_OK, block_pool_init_static(&pool, buf, sizeof(buf),
+                                                     BLOCK_SIZE, 10));
+    for (int i = 0; i < 10; i++) {
+        uint8_t *block = block_pool_alloc(&pool);
+        TEST_ASSERT_TRUE(block >= buf && block + BLOCK_SIZE <= buf + sizeof(buf));
+    }
+    TEST_ASSERT_NULL(block_pool_alloc(&pool));
+    block_pool_deinit(&pool);
+}
+
+// Alloc and free one block with all but a few blocks in use, the worst
+// case for the scans: the free ones are at the end
+static double pair_ns(bool scan, int num_blocks)
+{
+    // fewer rounds for the long scans, the same total work
+    int ops = scan ? BENCH_OPS * 10 / num_blocks : BENCH_OPS;
+    int held = num_blocks - 4;
+    int64_t start, elapsed;
+
+    if (scan) {
+        scan_blocks = num_blocks;
+        memset(scan_used, 0, sizeof(scan_used));
+        for (int i = 0; i < held; i++)
+            blocks[i] = scan_alloc();
+        start = now_ns();
+        for (int i = 0; i < ops; i++)
+            scan_free(scan_alloc());
+        elapsed = now_ns() - start;
+    } else {
+        block_pool_init(&pool, BLOCK_SIZE, num_blocks);
+        for (int i = 0; i < held; i++)
+            blocks[i] = block_pool_alloc(&pool);
+        start = now_ns();
+        for (int i = 0; i < ops; i++)
+            block_pool_free(&pool, block_pool_alloc(&pool));
+        elapsed = now_ns() - start;
+        block_pool_deinit(&pool);
+    }
+    return (double)elapsed / ops;
+}
+
+void test_block_pool_cost_is_flat(void)
+{
+    static const int sizes[] = {10, 100, 1000, MAX_BLOCKS};
+    double pool_ns[4], scan_ns[4];
+
+    for (int i = 0; i < 4; i++) {
+        pool_ns[i] = pair_ns(false, sizes[i]);
+        scan_ns[i] = pair_ns(true, sizes[i]);
+        printf("block_pool: %5d blocks, %.1f ns per alloc+free, "
+               "linear scan %.0f ns\n",
+               sizes[i], pool_ns[i], scan_ns[i]);
+    }
+
+    // flat from 10 to 10k blocks, within cache effects
+    TEST_ASSERT_TRUE(pool_ns[3] < pool_ns[0] * 3 + 20);
+    TEST_ASSERT_TRUE(pool_ns[3] * 10 < scan_ns[3]);
+}
+
+void run_block_pool_tests(void)
+{
+    RUN_TEST(test_block_pool_hands_out_every_block_once);
+    RUN_TEST(test_block_pool_refuses_bad_frees);
+    RUN_TEST(test_block_pool_static_buffer);
+    RUN_TEST(test_block_pool_cost_is_flat);
+}
@@ -0,0 +1,108 @@
+#include "unity.h"
+#include "boot_trace.h"
+#include "gpio_mock.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static char dump[BOOT_TRACE_MAX + 2][80];
+static int num_dump_lines;
+
+// boot_trace_dump() output, through a temporary file in place of stdout
+static bool capture_dump(void)
+{
+    FILE *tmp = tmpfile();
+    if (!tmp)
+        return false;
+
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(tmp), STDOUT_FILENO);
+    bool dumped = boot_trace_dump();
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    rewind(tmp);
+    num_dump_lines = 0;
+    while (num_dump_lines < BOOT_TRACE_MAX + 2 &&
+           fgets(dump[num_dump_lines], sizeof(dump[0]), tmp))
+        num_dump_lines++;
+    fclose(tmp);
+    return dumped;
+}
+
+// ---------------------
+
+void test_boot_trace_marks_app_start_before_main(void)
+{
+    // the constructor ran before the test runner's main()
+    TEST_ASSERT_TRUE(boot_trace_count() >= 1);
+    TEST_ASSERT_EQUAL_STRING("app start", boot_trace_entry(0)->name);
+}
+
+void test_boot_trace_keeps_order_and_time(void)
+{
+    gpio_mock_reset();
+    boot_trace_reset();
+
+    boot_trace_mark("app_main");
+    gpio_mock_advance_us(1500);
+    boot_trace_mark("nvs ready");
+    gpio_mock_advance_us(250);
+    boot_trace_mark("drivers ready");
+
+    TEST_ASSERT_EQUAL_INT(3, boot_trace_count());
+    TEST_ASSERT_EQUAL_STRING("nvs ready", boot_trace_entry(1)->name);
+    TEST_ASSERT_EQUAL_INT64(1500, boot_trace_entry(1)->time_us -
+                                      boot_trace_entry(0)->time_us);
+    TEST_ASSERT_EQUAL_INT64(1750, boot_trace_entry(2)->time_us -
+                                      boot_trace_entry(0)->time_us);
+    TEST_ASSERT_NULL(boot_trace_entry(3));
+    TEST_ASSERT_NULL(boot_trace_entry(-1));
+}
+
+void test_boot_trace_full_buffer_counts_drops(void)
+{
+    boot_trace_reset();
+    for (int i = 0; i < BOOT_TRACE_MAX + 3; i++)
+        boot_trace_mark("tick");
+
+    TEST_ASSERT_EQUAL_INT(BOOT_TRACE_MAX, boot_trace_count());
+    TEST_ASSERT_EQUAL_UINT32(3, boot_trace_dropped());
+
+    TEST_ASSERT_TRUE(capture_dump());
+    TEST_ASSERT_EQUAL_INT(BOOT_TRACE_MAX + 1, num_dump_lines);
+    TEST_ASSERT_EQUAL_STRING(BOOT_TRACE_PREFIX ",dropped,3\n",
+                             dump[BOOT_TRACE_MAX]);
+}
+
+void test_boot_trace_dumps_once(void)
+{
+    gpio_mock_reset();
+    boot_trace_reset();
+    gpio_mock_advance_us(1000);
+    boot_trace_mark("app_main");
+    gpio_mock_advance_us(2500);
+    boot_trace_mark("tasks created");
+
+    // the layout boot_trace_diff.py reads: index, name, time, phase, cycles
+    TEST_ASSERT_TRUE(capture_dump());
+    TEST_ASSERT_EQUAL_INT(2, num_dump_lines);
+    TEST_ASSERT_EQUAL_STRING(BOOT_TRACE_PREFIX ",0,app_main,1000,0,0\n",
+                             dump[0]);
+    TEST_ASSERT_EQUAL_STRING(BOOT_TRACE_PREFIX ",1,tasks created,3500,2500,0\n",
+                             dump[1]);
+
+    boot_trace_mark("late");
+    TEST_ASSERT_FALSE(capture_dump());
+    TEST_ASSERT_EQUAL_INT(0, num_dump_lines);
+}
+
+void run_boot_trace_tests(void)
+{
+    RUN_TEST(test_boot_trace_marks_app_start_before_main);
+    RUN_TEST(test_boot_trace_keeps_order_and_time);
+    RUN_TEST(test_boot_trace_full_buffer_counts_drops);
+    RUN_TEST(test_boot_trace_dumps_once);
+}
@@ -0,0 +1,226 @@
+#include "unity.h"
+#include "common/burst.h"
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_WAKES 100
+#define SAMPLE_MS 1000 // app_config.sample_ms from NVS
+#define FLUSHED_MAX (NUM_WAKES * BURST_MAX_PER_WAKE)
+
+// Assumed ESP32 costs of one wake (ms, mA); only the ratios matter
+#define BOOT_MS 40.0         // ROM, bootloader, app start from deep sleep
+#define SENSOR_INIT_MS 5.0   // I2C, MPU6050 wake, echo capture
+#define IMU_READ_MS 1.0      // one 14-byte burst read
+#define ULTRASON_READ_MS 25.0 // trigger and echo, about 4 m
+#define NVS_MS 15.0          // nvs_flash_init() and load_config()
+#define PIPELINE_MS 2.0      // pools, links, task creation
+#define SETTLE_MS 170.0      // main.c waits period + latency + 20 ms
+#define LOG_MS_PER_SAMPLE 0.1 // fusion, binlog, fwrite
+#define ACTIVE_MA 40.0
+#define SLEEP_MA 0.01
+
+typedef struct {
+    int64_t now_us; // acquisition clock, keeps running through sleep
+    double active_ms;
+    int boots;
+    sensor_msg_t flushed[FLUSHED_MAX];
+    int num_flushed;
+    bool fail_ultrason;
+} burst_model_t;
+
+static burst_state_t state;
+static burst_model_t model;
+
+static void model_acquire(burst_state_t *s, void *ctx)
+{
+    burst_model_t *m = ctx;
+    sensor_msg_t msg = {.type = SENSOR_IMU, .timestamp = m->now_us};
+
+    msg.data[0] = (float)s->stats.wakes;
+    burst_add(s, &msg);
+    m->active_ms += IMU_READ_MS;
+
+    m->active_ms += ULTRASON_READ_MS;
+    if (m->fail_ultrason)
+        return;
+    msg.type = SENSOR_ULTRASONIC;
+    msg.timestamp = m->now_us + 1000;
+    burst_add(s, &msg);
+}
+
+static uint32_t model_start_pipeline(void *ctx)
+{
+    burst_model_t *m = ctx;
+
+    m->boots++;
+    m->active_ms += NVS_MS + PIPELINE_MS;
+    return SAMPLE_MS;
+}
+
+static void model_flush(burst_state_t *s, void *ctx)
+{
+    burst_model_t *m = ctx;
+    int n = burst_take(s, m->flushed + m->num_flushed,
+                       FLUSHED_MAX - m->num_flushed);
+
+    m->num_flushed += n;
+    m->active_ms += SETTLE_MS + n * LOG_MS_PER_SAMPLE;
+}
+
+static const burst_ops_t model_ops = {.acquire = model_acquire,
+                                      .start_pipeline = model_start_pipeline,
+                                      .flush = model_flush,
+                                      .ctx = &model};
+
+// One wake as app_main() runs it, then the deep sleep it asks for
+static void wake(bool warm, uint16_t flush_every)
+{
+    model.active_ms += BOOT_MS + SENSOR_INIT_MS;
+    uint32_t sleep_ms = burst_wake(&state, warm, flush_every, &model_ops);
+    model.now_us += (int64_t)sleep_ms * 1000;
+}
+
+static void reset_model(void)
+{
+    memset(&model, 0, sizeof(model));
+    memset(&state, 0, sizeof(state)); // RTC memory after power on
+}
+
+// A power-on boot, then NUM_WAKES - 1 timer wakes
+static void run_wakes(uint16_t flush_every)
+{
+    reset_model();
+    for (int i = 0; i < NUM_WAKES; i++)
+        wake(i > 0, flush_every);
+}
+
+// ---------------------
+
+void test_burst_boots_pipeline_every_n_wakes(void)
+{
+    run_wakes(10);
+
+    // the cold boot has no sample period yet, so it flushes at once
+    TEST_ASSERT_EQUAL_UINT32(NUM_WAKES, state.stats.wakes);
+    TEST_ASSERT_EQUAL_INT(1 + (NUM_WAKES - 1) / 10, model.boots);
+    TEST_ASSERT_EQUAL_UINT32(model.boots, state.stats.pipeline_boots);
+    TEST_ASSERT_EQUAL_UINT32(2 * NUM_WAKES, state.stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, state.stats.dropped);
+
+    // what the last wakes read waits in RTC memory for the next flush
+    TEST_ASSERT_EQUAL_UINT32(state.stats.samples,
+                             state.stats.flushed + state.count);
+    TEST_ASSERT_EQUAL_INT(state.stats.flushed, model.num_flushed);
+}
+
+void test_burst_flush_keeps_order(void)
+{
+    run_wakes(10);
+
+    // oldest first, each wake's IMU sample before its ultrasonic one
+    for (int i = 0; i < model.num_flushed; i++) {
+        const sensor_msg_t *m = &model.flushed[i];
+        TEST_ASSERT_EQUAL_INT(i % 2 ? SENSOR_ULTRASONIC : SENSOR_IMU, m->type);
+        if (i % 2 == 0)
+            TEST_ASSERT_TRUE(m->data[0] == (float)(i / 2 + 1));
+        if (i)
+            TEST_ASSERT_TRUE(m->timestamp > model.flushed[i - 1].timestamp);
+    }
+    // one sample period apart, the sleep in between included
+    TEST_ASSERT_EQUAL_INT64((int64_t)SAMPLE_MS * 1000,
+                            model.flushed[2].timestamp -
+                                model.flushed[0].timestamp);
+}
+
+void test_burst_cold_boot_starts_new_ring(void)
+{
+    run_wakes(10);
+    TEST_ASSERT_TRUE(state.count > 0);
+
+    // a reset keeps RTC memory but not its meaning
+    wake(false, 10);
+    TEST_ASSERT_EQUAL_UINT32(1, state.stats.wakes);
+    TEST_ASSERT_EQUAL_UINT32(1, state.stats.pipeline_boots);
+    TEST_ASSERT_EQUAL_UINT16(0, state.count);
+
+    // so does garbage in RTC memory after a timer wake
+    state.magic = 0xdeadbeef;
+    wake(true, 10);
+    TEST_ASSERT_EQUAL_UINT32(1, state.stats.wakes);
+
+    state.magic = BURST_MAGIC;
+    state.count = BURST_RING_LEN + 1;
+    TEST_ASSERT_FALSE(burst_valid(&state));
+}
+
+void test_burst_full_ring_flushes_early(void)
+{
+    // more wakes per flush than the ring holds
+    reset_model();
+    for (int i = 0; i < 40; i++)
+        wake(i > 0, 100);
+
+    TEST_ASSERT_EQUAL_UINT32(0, state.stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(3, state.stats.pipeline_boots);
+    TEST_ASSERT_TRUE(state.count <= BURST_RING_LEN - BURST_MAX_PER_WAKE);
+
+    // a wake that misses a sensor just has less to keep
+    reset_model();
+    model.fail_ultrason = true;
+    for (int i = 0; i < 20; i++)
+        wake(i > 0, 10);
+    TEST_ASSERT_EQUAL_UINT32(20, state.stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, state.stats.dropped);
+}
+
+void test_burst_overwrites_oldest(void)
+{
+    sensor_msg_t msg = {.type = SENSOR_IMU};
+    sensor_msg_t out[BURST_RING_LEN];
+
+    burst_reset(&state, 10);
+    for (int i = 0; i < BURST_RING_LEN + 8; i++) {
+        msg.timestamp = i;
+        burst_add(&state, &msg);
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, state.stats.dropped);
+    TEST_ASSERT_EQUAL_UINT16(BURST_RING_LEN, state.count);
+
+    TEST_ASSERT_EQUAL_INT(BURST_RING_LEN,
+                          burst_take(&state, out, BURST_RING_LEN));
+    for (int i = 0; i < BURST_RING_LEN; i++)
+        TEST_ASSERT_EQUAL_INT64(i + 8, out[i].timestamp);
+    TEST_ASSERT_EQUAL_INT(0, burst_take(&state, out, BURST_RING_LEN));
+}
+
+void test_burst_energy_per_sample(void)
+{
+    double ms_per_wake[2], uj_per_sample[2];
+    const uint16_t cycles[2] = {1, 10};
+
+    for (int i = 0; i < 2; i++) {
+        run_wakes(cycles[i]);
+        double sleep_ms = (double)(NUM_WAKES - 1) * SAMPLE_MS;
+        double mas = (model.active_ms * ACTIVE_MA + sleep_ms * SLEEP_MA) / 1000;
+        ms_per_wake[i] = model.active_ms / NUM_WAKES;
+        uj_per_sample[i] = mas * 3.3 * 1000 / state.stats.samples;
+    }
+    printf("burst: awake %.1f vs %.1f ms per wake, %.0f vs %.0f uJ per "
+           "sample at 3.3 V (BURST_CYCLES 1 vs 10)\n",
+           ms_per_wake[0], ms_per_wake[1], uj_per_sample[0],
+           uj_per_sample[1]);
+
+    // settling and NVS paid once per ten wakes instead of every wake
+    TEST_ASSERT_TRUE(ms_per_wake[1] * 2 < ms_per_wake[0]);
+    TEST_ASSERT_TRUE(uj_per_sample[1] * 2 < uj_per_sample[0]);
+}
+
+void run_burst_tests(void)
+{
+    RUN_TEST(test_burst_boots_pipeline_every_n_wakes);
+    RUN_TEST(test_burst_flush_keeps_order);
+    RUN_TEST(test_burst_cold_boot_starts_new_ring);
+    RUN_TEST(test_burst_full_ring_flushes_early);
+    RUN_TEST(test_burst_overwrites_oldest);
+    RUN_TEST(test_burst_energy_per_sample);
+}
@@ -0,0 +1,27 @@
+#include "test_bus.h"
+#include "i2c_mock.h"
+#include "mpu6050.h"
+
+void test_bus_init(uint32_t clk_hz)
+{
+    const i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .master.clk_speed = clk_hz,
+    };
+
+    i2c_mock_reset();
+    i2c_param_config(TEST_PORT, &conf);
+    i2c_driver_install(TEST_PORT, I2C_MODE_MASTER, 0, 0, 0);
+}
+
+void test_bus_attach_sim(mpu6050_sim_t *sim, uint8_t addr)
+{
+    mpu6050_sim_init(sim);
+    mpu6050_sim_attach(sim, TEST_PORT, addr);
+}
+
+void test_bus_with_sim(mpu6050_sim_t *sim)
+{
+    test_bus_init(TEST_BUS_CLK_HZ);
+    test_bus_attach_sim(sim, MPU6050_ADDR);
+}
@@ -0,0 +1,26 @@
+/**
+ * @file test_bus.h simulated I2C bus for the host tests
+ *
+ * Every I2C test starts from a fresh i2c_mock with the master driver
+ * installed on TEST_PORT and one or more MPU-6050 simulations attached.
+ */
+
+#ifndef TEST_BUS_H
+#define TEST_BUS_H
+
+#include "mpu6050_sim.h"
+#include <stdint.h>
+
+#define TEST_PORT I2C_NUM_0
+#define TEST_BUS_CLK_HZ 400000
+
+// Reset the mock and install the master driver on TEST_PORT at clk_hz
+void test_bus_init(uint32_t clk_hz);
+
+// Start sim from power-on and answer at addr on TEST_PORT
+void test_bus_attach_sim(mpu6050_sim_t *sim, uint8_t addr);
+
+// A fresh bus at TEST_BUS_CLK_HZ with sim at MPU6050_ADDR
+void test_bus_with_sim(mpu6050_sim_t *sim);
+
+#endif // TEST_BUS_H
@@ -0,0 +1,44 @@
+/**
+ * @file test_data.c loader for the motion_data recordings
+ */
+
+#include "test_data.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Tests are run from the host_test folder: ./build/host_test.elf
+#define DEFAULT_DATA_DIR "../motion_data"
+
+const char *const test_recordings[TEST_NUM_RECORDINGS] = {
+    "stationary.csv",
+    "slow.csv",
+    "vibration.csv",
+    "tap.csv",
+};
+
+void test_recording_path(const char *name, char *path, size_t size) {
+  const char *dir = getenv("MOTION_DATA_DIR");
+  snprintf(path, size, "%s/%s", dir ? dir : DEFAULT_DATA_DIR, name);
+}
+
+int test_load_recording(const char *name, motion_sample_t *out, int max) {
+  char path[256];
+
+  test_recording_path(name, path, sizeof(path));
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return -1;
+
+  int n = 0;
+  long long t;
+  float a, g;
+  while (n < max && fscanf(f, "%lld,%f,%f", &t, &a, &g) == 3) {
+    out[n].timestamp_ms = t;
+    out[n].accel_mag = a;
+    out[n].gyro_mag = g;
+    n++;
+  }
+
+  fclose(f);
+  return n;
+}
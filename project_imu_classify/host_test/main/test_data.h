@@ -0,0 +1,28 @@
+/**
+ * @file test_data.h access to the recorded motion sessions from host tests
+ */
+
+#ifndef TEST_DATA_H
+#define TEST_DATA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TEST_MAX_SAMPLES 4096
+#define TEST_NUM_RECORDINGS 4
+
+typedef struct {
+  int64_t timestamp_ms;
+  float accel_mag;
+  float gyro_mag;
+} motion_sample_t;
+
+extern const char *const test_recordings[TEST_NUM_RECORDINGS];
+
+// Full path of motion_data/<name>, MOTION_DATA_DIR overrides the folder
+void test_recording_path(const char *name, char *path, size_t size);
+
+// Load motion_data/<name>; returns the number of samples or -1
+int test_load_recording(const char *name, motion_sample_t *out, int max);
+
+#endif // TEST_DATA_H
@@ -0,0 +1,204 @@
+#include "unity.h"
+#include "dlog.h"
+#include "gpio_mock.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define RING_LEN 16
+#define BENCH_LOGS 100000
+
+static const char *TAG = "TEST";
+
+static char lines[RING_LEN * 2][160];
+static int num_lines;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void collect(const dlog_entry_t *entry, void *ctx)
+{
+    if (num_lines < RING_LEN * 2)
+        dlog_render(entry, lines[num_lines++], sizeof(lines[0]));
+}
+
+static void drain_lines(void)
+{
+    num_lines = 0;
+    dlog_drain(collect, NULL, RING_LEN * 2);
+}
+
+static void setup(void)
+{
+    gpio_mock_reset();
+    dlog_set_level(ESP_LOG_INFO);
+    TEST_ASSERT_EQUAL(ESP_OK, dlog_init(RING_LEN));
+}
+
+// ---------------------
+// Capture and rendering
+// ---------------------
+
+void test_dlog_renders_like_printf(void)
+{
+    char expected[160];
+    int16_t raw = -1234;
+    uint32_t big = 0xfffffff0u;
+    float temp = 36.53f;
+    int64_t ts = 123456789012LL;
+
+    setup();
+    gpio_mock_advance_us(2500000);
+    DLOGI(TAG, "no arguments");
+    DLOGW(TAG, "raw=%d big=%u hex=%08x", raw, big, big);
+    DLOGI(TAG, "t=%.1f C a=%+.3f g", temp, -0.25);
+    DLOGE(TAG, "ts=%lld src=%s c=%c %d%%", (long long)ts, "imu", 'x', 50);
+    drain_lines();
+
+    TEST_ASSERT_EQUAL_INT(4, num_lines);
+    TEST_ASSERT_EQUAL_STRING("I (2500) TEST: no arguments", lines[0]);
+    snprintf(expected, sizeof(expected), "W (2500) TEST: raw=%d big=%u hex=%08x",
+             raw, (unsigned)big, (unsigned)big);
+    TEST_ASSERT_EQUAL_STRING(expected, lines[1]);
+    snprintf(expected, sizeof(expected), "I (2500) TEST: t=%.1f C a=%+.3f g",
+             temp, -0.25);
+    TEST_ASSERT_EQUAL_STRING(expected, lines[2]);
+    TEST_ASSERT_EQUAL_STRING("E (2500) TEST: ts=123456789012 src=imu c=x 50%",
+                             lines[3]);
+}
+
+void test_dlog_level_filter(void)
+{
+    setup();
+    DLOGD(TAG, "not recorded %d", 1);
+    dlog_set_level(ESP_LOG_DEBUG);
+    DLOGD(TAG, "recorded %d", 2);
+    drain_lines();
+
+    TEST_ASSERT_EQUAL_INT(1, num_lines);
+    TEST_ASSERT_EQUAL_STRING("D (0) TEST: recorded 2", lines[0]);
+}
+
+// ---------------------
+// Full ring
+// ---------------------
+
+void test_dlog_full_ring_drops_and_reports(void)
+{
+    setup();
+    for (int i = 0; i < RING_LEN + 5; i++)
+        DLOGI(TAG, "entry %d", i);
+
+    dlog_stats_t stats = dlog_get_stats();
+    TEST_ASSERT_EQUAL_UINT32(RING_LEN, stats.written);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT16(RING_LEN, stats.peak_used);
+
+    // the drop comes first, then every entry that made it, in order
+    drain_lines();
+    TEST_ASSERT_EQUAL_INT(RING_LEN + 1, num_lines);
+    TEST_ASSERT_EQUAL_STRING("W (0) DLOG: 5 entries dropped, ring full", lines[0]);
+    TEST_ASSERT_EQUAL_STRING("I (0) TEST: entry 0", lines[1]);
+    TEST_ASSERT_EQUAL_STRING("I (0) TEST: entry 15", lines[RING_LEN]);
+
+    // reported once
+    DLOGI(TAG, "after");
+    drain_lines();
+    TEST_ASSERT_EQUAL_INT(1, num_lines);
+    dlog_deinit();
+}
+
+// ---------------------
+// Binary frames
+// ---------------------
+
+static uint8_t frame[DLOG_FRAME_MAX];
+static size_t frame_len;
+
+static void encode_one(const dlog_entry_t *entry, void *ctx)
+{
+    frame_len = dlog_encode(entry, frame);
+}
+
+void test_dlog_binary_frame_layout(void)
+{
+    const char *fmt = "d=%d f=%.2f";
+
+    setup();
+    gpio_mock_advance_us(0x01020304);
+    DLOGW(TAG, fmt, -2, 1.5f);
+    TEST_ASSERT_EQUAL_INT(1, dlog_drain(encode_one, NULL, 1));
+
+    TEST_ASSERT_EQUAL_UINT32(DLOG_FRAME_HEADER_LEN + 2 * 8, frame_len);
+    TEST_ASSERT_EQUAL_HEX8(0x44, frame[0]); // "DL", little endian
+    TEST_ASSERT_EQUAL_HEX8(0x4c, frame[1]);
+    TEST_ASSERT_EQUAL_UINT8(ESP_LOG_WARN, frame[2]);
+    TEST_ASSERT_EQUAL_UINT8(2, frame[3]);
+    TEST_ASSERT_EQUAL_HEX8(0x04, frame[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, frame[7]);
+
+    // the format ID is the string's address, low 32 bits
+    uint32_t id = frame[12] | frame[13] << 8 | frame[14] << 16 | (uint32_t)frame[15] << 24;
+    TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)fmt, id);
+
+    // -2 sign-extended, 1.5 as a double
+    int64_t d;
+    double f;
+    memcpy(&d, frame + 16, 8);
+    memcpy(&f, frame + 24, 8);
+    TEST_ASSERT_EQUAL_INT64(-2, d);
+    TEST_ASSERT_TRUE(f == 1.5);
+    dlog_deinit();
+}
+
+// ---------------------
+// Cost against formatting on the spot
+// ---------------------
+
+static void drop_entry(const dlog_entry_t *entry, void *ctx) {}
+
+void test_dlog_write_cost_against_snprintf(void)
+{
+    char line[160];
+    float ax = 0.01f, ay = -0.02f, az = 0.98f;
+    int64_t ts = 1000;
+
+    setup();
+    int64_t start = now_ns();
+    for (int i = 0; i < BENCH_LOGS; i++) {
+        snprintf(line, sizeof(line),
+                 "I (%lld) %s: ts=%lld ax=%.2f ay=%.2f az=%.2f g",
+                 (long long)ts / 1000, TAG, (long long)ts, ax, ay, az);
+        ts++;
+    }
+    int64_t text_ns = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < BENCH_LOGS; i++) {
+        DLOGI(TAG, "ts=%lld ax=%.2f ay=%.2f az=%.2f g", (long long)ts, ax, ay, az);
+        ts++;
+        if ((i & (RING_LEN - 1)) == RING_LEN - 1)
+            dlog_drain(drop_entry, NULL, RING_LEN); // not timed apart, cheap
+    }
+    int64_t dlog_ns = now_ns() - start;
+
+    dlog_stats_t stats = dlog_get_stats();
+    printf("dlog: %.0f ns per entry (drain included), formatting %.0f ns\n",
+           (double)dlog_ns / BENCH_LOGS, (double)text_ns / BENCH_LOGS);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    TEST_ASSERT_LESS_THAN(text_ns / 4, dlog_ns);
+    dlog_deinit();
+}
+
+void run_dlog_tests(void)
+{
+    RUN_TEST(test_dlog_renders_like_printf);
+    RUN_TEST(test_dlog_level_filter);
+    RUN_TEST(test_dlog_full_ring_drops_and_reports);
+    RUN_TEST(test_dlog_binary_frame_layout);
+    RUN_TEST(test_dlog_write_cost_against_snprintf);
+}
@@ -0,0 +1,97 @@
+#include "unity.h"
+#include "feature_kernels.h"
+#include "motion_engine.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define KERNEL_MAX_LEN 1000
+
+static float block[KERNEL_MAX_LEN + 1];
+
+static void fill_random(float *x, int n)
+{
+    for (int i = 0; i < n; i++) {
+        x[i] = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+        if (i % 17 == 0)
+            x[i] = 0.0f; // exercise the np.sign zero case
+    }
+}
+
+// ---------------------
+// Scalar reference values
+// ---------------------
+
+void test_scalar_kernels_on_known_block(void)
+{
+    const float x[] = {1.0f, -2.0f, 0.0f, 3.0f, -0.5f};
+    float mean, var, lo, hi;
+
+    TEST_ASSERT_TRUE(fk_set_backend(FK_BACKEND_SCALAR));
+
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, fk_sum(x, 5));
+    TEST_ASSERT_EQUAL_FLOAT(14.25f, fk_sum_sq(x, 5));
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, fk_peak_abs(x, 5));
+    fk_min_max(x, 5, &lo, &hi);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, lo);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, hi);
+    fk_mean_var(x, 5, &mean, &var);
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, mean);
+    TEST_ASSERT_EQUAL_FLOAT(14.25f / 5 - 0.09f, var);
+    // signs + - 0 + - : every pair changes
+    TEST_ASSERT_EQUAL(4, fk_crossings(x, 5, 0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(sqrtf(14.25f / 5), compute_rms(x, 5));
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, compute_peak(x, 5));
+}
+
+// ---------------------
+// SIMD backends against the scalar one
+// ---------------------
+
+static void check_backend(fk_backend_t backend)
+{
+    srand(42);
+
+    // odd lengths and a one-float offset cover tails and unaligned loads
+    for (int n = 1; n <= KERNEL_MAX_LEN; n += (n < 40) ? 1 : 37) {
+        float *x = block + (n & 1);
+        float level = (n % 3) ? 0.0f : 0.25f;
+        float lo_ref, hi_ref, lo, hi;
+
+        fill_random(x, n);
+
+        fk_set_backend(FK_BACKEND_SCALAR);
+        float sum_ref = fk_sum(x, n);
+        float sum_sq_ref = fk_sum_sq(x, n);
+        float peak_ref = fk_peak_abs(x, n);
+        int crossings_ref = fk_crossings(x, n, level);
+        fk_min_max(x, n, &lo_ref, &hi_ref);
+
+        TEST_ASSERT_TRUE(fk_set_backend(backend));
+        // summation order differs, the error grows with n
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f * n, sum_ref, fk_sum(x, n));
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f * n, sum_sq_ref, fk_sum_sq(x, n));
+        TEST_ASSERT_EQUAL_FLOAT(peak_ref, fk_peak_abs(x, n));
+        TEST_ASSERT_EQUAL(crossings_ref, fk_crossings(x, n, level));
+        fk_min_max(x, n, &lo, &hi);
+        TEST_ASSERT_EQUAL_FLOAT(lo_ref, lo);
+        TEST_ASSERT_EQUAL_FLOAT(hi_ref, hi);
+    }
+}
+
+void test_simd_backends_match_scalar(void)
+{
+    fk_backend_t initial = fk_get_backend();
+
+    for (int b = FK_BACKEND_SSE2; b < FK_NUM_BACKENDS; b++) {
+        if (fk_backend_available(b))
+            check_backend(b);
+    }
+
+    fk_set_backend(initial);
+}
+
+void run_feature_kernels_tests(void)
+{
+    RUN_TEST(test_scalar_kernels_on_known_block);
+    RUN_TEST(test_simd_backends_match_scalar);
+}
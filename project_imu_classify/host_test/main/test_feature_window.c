@@ -0,0 +1,62 @@
+#include "unity.h"
+#include "feature_window.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define NUM_SAMPLES 300
+
+static feature_window_t window;
+static float history[NUM_SAMPLES];
+
+// Peak of |x| over the last size samples, by rescanning them
+static float rescan_peak(int end, int size)
+{
+    float peak = 0;
+    for (int i = end - size + 1; i <= end; i++)
+        if (i >= 0 && fabsf(history[i]) > peak)
+            peak = fabsf(history[i]);
+    return peak;
+}
+
+// Pushes every sample and counts the pushes whose peak is not the rescan's
+static int peak_mismatches(int size)
+{
+    int mismatches = 0;
+
+    feature_window_init(&window, size);
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        feature_window_push(&window, history[i]);
+        if (feature_window_peak(&window) != rescan_peak(i, size))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+// ---------------------
+
+void test_feature_window_peak_at_max_size(void)
+{
+    // strictly decreasing: every sample stays a peak candidate, so the
+    // deque holds a whole window of them
+    for (int i = 0; i < NUM_SAMPLES; i++)
+        history[i] = 1000.0f - i;
+    TEST_ASSERT_EQUAL_INT(0, peak_mismatches(FEATURE_WINDOW_MAX - 1));
+    TEST_ASSERT_EQUAL_INT(0, peak_mismatches(FEATURE_WINDOW_MAX));
+    TEST_ASSERT_EQUAL_FLOAT(1000.0f - (NUM_SAMPLES - FEATURE_WINDOW_MAX),
+                            feature_window_peak(&window));
+
+    // alternating signs on a falling envelope, and noise
+    for (int i = 0; i < NUM_SAMPLES; i++)
+        history[i] = (i % 2 ? -1.0f : 1.0f) * (NUM_SAMPLES - i);
+    TEST_ASSERT_EQUAL_INT(0, peak_mismatches(FEATURE_WINDOW_MAX));
+    srand(7);
+    for (int i = 0; i < NUM_SAMPLES; i++)
+        history[i] = (float)(rand() % 2001 - 1000);
+    TEST_ASSERT_EQUAL_INT(0, peak_mismatches(FEATURE_WINDOW_MAX));
+    TEST_ASSERT_EQUAL_INT(0, peak_mismatches(1));
+}
+
+void run_feature_window_tests(void)
+{
+    RUN_TEST(test_feature_window_peak_at_max_size);
+}
@@ -0,0 +1,231 @@
+#include "unity.h"
+#include "tasks/fusion.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RUN_MS 1000
+#define IMU_PERIOD_US 10000   // 100 Hz
+#define ULTRA_PERIOD_US 60000 // HC-SR04 cycle
+#define MAX_SAMPLES 256
+#define MAX_RECORDS 128
+
+// Synthetic signals, linear in time so interpolation can be checked exactly
+static float imu_value(int64_t t_us) { return 0.5f + (float)t_us * 1e-6f; }
+static float ultra_value(int64_t t_us) { return 100.0f + (float)t_us * 2e-5f; }
+
+typedef struct {
+    sensor_msg_t msg;
+    int64_t arrival_us;
+} stream_sample_t;
+
+static stream_sample_t stream[MAX_SAMPLES];
+static int stream_len;
+static fused_msg_t records[MAX_RECORDS];
+static int num_records;
+static fusion_t fusion;
+static uint32_t rng = 1;
+
+static int64_t jitter(int64_t max_us)
+{
+    rng = rng * 1664525u + 1013904223u;
+    return max_us ? (int64_t)(rng >> 8) % (2 * max_us + 1) - max_us : 0;
+}
+
+static int64_t delay(int64_t max_us)
+{
+    rng = rng * 1664525u + 1013904223u;
+    return max_us ? (int64_t)(rng >> 8) % (max_us + 1) : 0;
+}
+
+// Periodic samples with timestamp jitter, delivered up to max_delay_us late
+static void add_stream(sensor_type_t type, int64_t period_us, int64_t jitter_us,
+                       int64_t max_delay_us)
+{
+    for (int64_t t = period_us; t < RUN_MS * 1000; t += period_us) {
+        stream_sample_t *s = &stream[stream_len++];
+        memset(s, 0, sizeof(*s));
+        s->msg.type = type;
+        s->msg.timestamp = t + jitter(jitter_us);
+        s->msg.data[0] = type == SENSOR_IMU ? imu_value(s->msg.timestamp)
+                                            : ultra_value(s->msg.timestamp);
+        s->arrival_us = s->msg.timestamp + delay(max_delay_us);
+    }
+}
+
+static int by_arrival(const void *a, const void *b)
+{
+    int64_t d = ((const stream_sample_t *)a)->arrival_us -
+                ((const stream_sample_t *)b)->arrival_us;
+    return (d > 0) - (d < 0);
+}
+
+// Feed the stream in arrival order, polling every simulated millisecond
+static void run_stream(const fusion_config_t *config)
+{
+    int next = 0;
+
+    TEST_ASSERT_TRUE(fusion_init(&fusion, config));
+    qsort(stream, stream_len, sizeof(stream[0]), by_arrival);
+    num_records = 0;
+
+    for (int64_t now = 0; now <= (RUN_MS + 300) * 1000; now += 1000) {
+        while (next < stream_len && stream[next].arrival_us <= now)
+            fusion_push(&fusion, &stream[next++].msg);
+        while (num_records < MAX_RECORDS &&
+               fusion_poll(&fusion, now, &records[num_records]))
+            num_records++;
+    }
+}
+
+static void reset_streams(void)
+{
+    stream_len = 0;
+    rng = 1;
+}
+
+// ---------------------
+// Alignment
+// ---------------------
+
+void test_fusion_linear_reconstructs_jittered_streams(void)
+{
+    // the 60 ms sensor needs 70 ms to reach both sides of every tick, and
+    // its later sample arrives up to 25 ms after that
+    const fusion_config_t config = {.period_us = 20000,
+                                    .tolerance_us = 70000,
+                                    .latency_us = 100000,
+                                    .mode = FUSION_LINEAR};
+
+    reset_streams();
+    add_stream(SENSOR_IMU, IMU_PERIOD_US, 2000, 5000);
+    add_stream(SENSOR_ULTRASONIC, ULTRA_PERIOD_US, 5000, 25000);
+    run_stream(&config);
+
+    // one record per tick, on the common timebase, none skipped
+    TEST_ASSERT_GREATER_OR_EQUAL(RUN_MS * 1000 / config.period_us - 1, num_records);
+    for (int i = 0; i < num_records; i++) {
+        const fused_msg_t *r = &records[i];
+        TEST_ASSERT_EQUAL_INT64(0, r->timestamp % config.period_us);
+        if (i > 0)
+            TEST_ASSERT_EQUAL_INT64(config.period_us,
+                                    r->timestamp - records[i - 1].timestamp);
+
+        // both signals are linear: between samples, interpolation gives
+        // them back exactly (past the ends it falls back to the nearest)
+        if (r->timestamp < 2 * ULTRA_PERIOD_US ||
+            r->timestamp > RUN_MS * 1000 - 2 * ULTRA_PERIOD_US)
+            continue;
+        if (r->valid & (1u << SENSOR_IMU))
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, imu_value(r->timestamp),
+                                     r->data[SENSOR_IMU][0]);
+        if (r->valid & (1u << SENSOR_ULTRASONIC))
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, ultra_value(r->timestamp),
+                                     r->data[SENSOR_ULTRASONIC][0]);
+    }
+
+    // inside the stream both sensors make every tick
+    for (int i = 2; i < num_records - 3; i++)
+        TEST_ASSERT_EQUAL_HEX32(0x3, records[i].valid);
+    TEST_ASSERT_EQUAL_UINT32(0, fusion.stats.late);
+}
+
+void test_fusion_nearest_stays_within_tolerance(void)
+{
+    const fusion_config_t config = {.period_us = 20000,
+                                    .tolerance_us = 8000,
+                                    .latency_us = 10000,
+                                    .mode = FUSION_NEAREST};
+
+    reset_streams();
+    add_stream(SENSOR_IMU, IMU_PERIOD_US, 2000, 5000);
+    add_stream(SENSOR_ULTRASONIC, ULTRA_PERIOD_US, 5000, 5000);
+    run_stream(&config);
+
+    int ultra_ticks = 0;
+    for (int i = 0; i < num_records; i++) {
+        const fused_msg_t *r = &records[i];
+        // a copied sample is at most tolerance_us away from its tick
+        if (r->valid & (1u << SENSOR_IMU))
+            TEST_ASSERT_FLOAT_WITHIN(config.tolerance_us * 1e-6f + 1e-5f,
+                                     imu_value(r->timestamp),
+                                     r->data[SENSOR_IMU][0]);
+        if (r->valid & (1u << SENSOR_ULTRASONIC)) {
+            ultra_ticks++;
+            TEST_ASSERT_FLOAT_WITHIN(config.tolerance_us * 2e-5f + 1e-3f,
+                                     ultra_value(r->timestamp),
+                                     r->data[SENSOR_ULTRASONIC][0]);
+        }
+    }
+
+    // the 60 ms sensor only reaches the ticks close to its samples
+    TEST_ASSERT_GREATER_THAN(0, ultra_ticks);
+    TEST_ASSERT_LESS_THAN(num_records, ultra_ticks);
+    TEST_ASSERT_GREATER_THAN(0, fusion.stats.missing);
+}
+
+// ---------------------
+// Late and out-of-order samples
+// ---------------------
+
+void test_fusion_waits_for_late_samples(void)
+{
+    const fusion_config_t config = {.period_us = 20000,
+                                    .tolerance_us = 10000,
+                                    .latency_us = 30000,
+                                    .mode = FUSION_NEAREST};
+    fused_msg_t out;
+    sensor_msg_t imu = {.type = SENSOR_IMU, .timestamp = 20000};
+    sensor_msg_t ultra = {.type = SENSOR_ULTRASONIC, .timestamp = 21000};
+
+    TEST_ASSERT_TRUE(fusion_init(&fusion, &config));
+    fusion_push(&fusion, &imu);
+
+    // tick 20 ms is not emitted before its late-sample window closes
+    TEST_ASSERT_EQUAL_INT64(50000, fusion_next_us(&fusion));
+    TEST_ASSERT_FALSE(fusion_poll(&fusion, 49999, &out));
+
+    // the echo of the same instant arrives 25 ms late and still counts
+    fusion_push(&fusion, &ultra);
+    TEST_ASSERT_TRUE(fusion_poll(&fusion, 50000, &out));
+    TEST_ASSERT_EQUAL_INT64(20000, out.timestamp);
+    TEST_ASSERT_EQUAL_HEX32(0x3, out.valid);
+
+    // too old for the next tick (40 ms): dropped and counted
+    ultra.timestamp = 25000;
+    fusion_push(&fusion, &ultra);
+    TEST_ASSERT_EQUAL_UINT32(1, fusion.stats.late);
+    TEST_ASSERT_FALSE(fusion_poll(&fusion, 200000, &out));
+}
+
+void test_fusion_order_of_arrival_does_not_matter(void)
+{
+    const fusion_config_t config = {.period_us = 20000,
+                                    .tolerance_us = 40000,
+                                    .latency_us = 90000, // tolerance + delay
+                                    .mode = FUSION_LINEAR};
+    static fused_msg_t in_order[MAX_RECORDS];
+
+    // delivered on time, then shuffled by up to 45 ms of delay
+    reset_streams();
+    add_stream(SENSOR_IMU, IMU_PERIOD_US, 2000, 0);
+    add_stream(SENSOR_ULTRASONIC, ULTRA_PERIOD_US, 5000, 0);
+    run_stream(&config);
+    int n = num_records;
+    memcpy(in_order, records, sizeof(records));
+
+    for (int i = 0; i < stream_len; i++)
+        stream[i].arrival_us = stream[i].msg.timestamp + delay(45000);
+    run_stream(&config);
+
+    TEST_ASSERT_EQUAL_INT(n, num_records);
+    TEST_ASSERT_EQUAL_MEMORY(in_order, records, n * sizeof(fused_msg_t));
+    TEST_ASSERT_EQUAL_UINT32(0, fusion.stats.late);
+}
+
+void run_fusion_tests(void)
+{
+    RUN_TEST(test_fusion_linear_reconstructs_jittered_streams);
+    RUN_TEST(test_fusion_nearest_stays_within_tolerance);
+    RUN_TEST(test_fusion_waits_for_late_samples);
+    RUN_TEST(test_fusion_order_of_arrival_does_not_matter);
+}
@@ -0,0 +1,267 @@
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "gpio_mock.h"
+#include "heap_telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+#define KB 1024
+#define SAMPLE_S 5 // day06's monitor period
+#define SLOT_S 60
+
+// ---------------------
+// A heap under day06's tasks: fragment_task holds 31 KB, then 21 KB, then
+// nothing over 9 s; alloc_task holds 10 KB for 3 s out of 6. On top of
+// that an optional leak, and a largest block the test can pin.
+// ---------------------
+
+typedef struct {
+    size_t total;
+    size_t used; // at boot
+    double leak_bytes_per_s;
+    size_t largest; // 0: most of the free memory in one piece
+    int probes;
+} fake_heap_t;
+
+static fake_heap_t heap;
+static heap_telemetry_t tm;
+static int64_t now_s;
+
+static uint8_t raised_alerts;
+static int num_alert_calls;
+static int64_t first_leak_s;
+
+static size_t day06_used(int64_t t)
+{
+    size_t used = 0;
+    if (t % 9 < 2)
+        used += 31 * KB;
+    else if (t % 9 < 4)
+        used += 21 * KB;
+    if (t % 6 < 3)
+        used += 10 * KB;
+    return used;
+}
+
+static void fake_probe(uint32_t caps, heap_telemetry_reading_t *out, void *ctx)
+{
+    fake_heap_t *h = ctx;
+
+    h->probes++;
+    memset(out, 0, sizeof(*out));
+    if (caps & MALLOC_CAP_SPIRAM)
+        return; // no PSRAM on this board
+    out->total = h->total;
+    out->free = h->total - h->used - day06_used(now_s) -
+                (size_t)(h->leak_bytes_per_s * now_s);
+    out->largest = h->largest ? h->largest : out->free - out->free / 8;
+    out->min_free = out->free;
+}
+
+static void on_alert(const heap_telemetry_trend_t *trend, uint8_t raised,
+                     void *ctx)
+{
+    raised_alerts |= raised;
+    num_alert_calls++;
+    if ((raised & HEAP_ALERT_LEAK) && !first_leak_s)
+        first_leak_s = now_s;
+}
+
+static heap_telemetry_config_t day06_config(void)
+{
+    return (heap_telemetry_config_t){
+        .slot_ms = SLOT_S * 1000,
+        .leak_bytes_per_min = 100,
+        .min_slots = 10,
+        .probe = fake_probe,
+        .probe_ctx = &heap,
+        .on_alert = on_alert,
+    };
+}
+
+static void reset(double leak_bytes_per_s)
+{
+    memset(&heap, 0, sizeof(heap));
+    heap.total = 300 * KB;
+    heap.used = 60 * KB;
+    heap.leak_bytes_per_s = leak_bytes_per_s;
+    raised_alerts = 0;
+    num_alert_calls = 0;
+    first_leak_s = 0;
+    now_s = 0;
+    gpio_mock_reset();
+}
+
+// day06's monitor loop: a sample, then SAMPLE_S of sleep
+static void run_for(int64_t seconds)
+{
+    for (int64_t end = now_s + seconds; now_s < end; now_s += SAMPLE_S) {
+        heap_telemetry_sample(&tm);
+        gpio_mock_advance_us(SAMPLE_S * 1000000LL);
+    }
+}
+
+// ---------------------
+
+void test_heap_telemetry_folds_samples_into_slots(void)
+{
+    heap_telemetry_config_t config = day06_config();
+
+    reset(0);
+    TEST_ASSERT_EQUAL(ESP_OK, heap_telemetry_init(&tm, &config));
+    TEST_ASSERT_EQUAL_INT(4, heap_telemetry_num_caps(&tm)); // SPIRAM dropped
+    TEST_ASSERT_EQUAL_UINT32(MALLOC_CAP_INTERNAL, heap_telemetry_trend(&tm, 3)->caps);
+    TEST_ASSERT_NULL(heap_telemetry_trend(&tm, 4));
+
+    run_for(SLOT_S);
+    TEST_ASSERT_EQUAL_INT(0, tm.count); // the slot closes on the next sample
+    run_for(SAMPLE_S);
+    TEST_ASSERT_EQUAL_INT(1, tm.count);
+
+    // the floor of the slot: both tasks holding memory at once (t = 0)
+    const heap_telemetry_trend_t *t = heap_telemetry_trend(&tm, 0);
+    TEST_ASSERT_EQUAL_UINT32(heap.total - heap.used - 41 * KB, t->last.free);
+    TEST_ASSERT_EQUAL_UINT32(heap.total, t->total);
+    TEST_ASSERT_EQUAL_UINT16(heap_telemetry_frag_permille(t->last.free,
+                                                          t->last.largest),
+                             t->last.frag_permille);
+
+    // the ring keeps the last RING_LEN slots, oldest first
+    run_for(2 * HEAP_TELEMETRY_RING_LEN * SLOT_S);
+    TEST_ASSERT_EQUAL_INT(HEAP_TELEMETRY_RING_LEN, tm.count);
+    const heap_telemetry_slot_t *oldest = &tm.ring[tm.head];
+    const heap_telemetry_slot_t *newest =
+        &tm.ring[(tm.head + tm.count - 1) % HEAP_TELEMETRY_RING_LEN];
+    TEST_ASSERT_EQUAL_UINT32((HEAP_TELEMETRY_RING_LEN - 1) * SLOT_S * 1000,
+                             newest->time_ms - oldest->time_ms);
+
+    TEST_ASSERT_EQUAL_UINT16(500, heap_telemetry_frag_permille(100, 50));
+    TEST_ASSERT_EQUAL_UINT16(0, heap_telemetry_frag_permille(0, 0));
+}
+
+void test_heap_telemetry_leak_slope(void)
+{
+    heap_telemetry_config_t config = day06_config();
+
+    // the same leak with and without day06's tasks around it
+    reset(2.0); // 120 bytes per minute
+    heap_telemetry_init(&tm, &config);
+    run_for(HEAP_TELEMETRY_RING_LEN * SLOT_S);
+    float slope = heap_telemetry_trend(&tm, 0)->slope_bytes_per_min;
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, -120.0f, slope);
+
+    reset(0);
+    heap_telemetry_init(&tm, &config);
+    run_for(HEAP_TELEMETRY_RING_LEN * SLOT_S);
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 0.0f,
+                             heap_telemetry_trend(&tm, 0)->slope_bytes_per_min);
+}
+
+void test_heap_telemetry_warns_of_slow_leak(void)
+{
+    heap_telemetry_config_t config = day06_config();
+
+    // two hours of day06 without a leak: the sawtooth never looks like one
+    reset(0);
+    heap_telemetry_init(&tm, &config);
+    run_for(2 * 3600);
+    TEST_ASSERT_EQUAL_UINT8(0, raised_alerts);
+
+    // 200 bytes a minute, a few KB an hour against 240 KB free
+    reset(200.0 / 60);
+    heap_telemetry_init(&tm, &config);
+    run_for(2 * 3600);
+    TEST_ASSERT_TRUE(raised_alerts & HEAP_ALERT_LEAK);
+    // raised once per capability (all four see the leak), then stays up
+    TEST_ASSERT_EQUAL_INT(heap_telemetry_num_caps(&tm), num_alert_calls);
+
+    const heap_telemetry_trend_t *t = heap_telemetry_trend(&tm, 0);
+    printf("heap_telemetry: 200 B/min leak under day06's tasks flagged after "
+           "%d min (%d slots), slope %.0f B/min, %u bytes leaked of %u KB free, "
+           "%d probes and no log lines\n",
+           (int)(first_leak_s / 60), config.min_slots, t->slope_bytes_per_min,
+           (unsigned)(first_leak_s * 200 / 60),
+           (unsigned)(heap.total - heap.used) / KB, heap.probes);
+    TEST_ASSERT_TRUE(first_leak_s <= (config.min_slots + 1) * SLOT_S + SAMPLE_S);
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, -200.0f, t->slope_bytes_per_min);
+}
+
+void test_heap_telemetry_alerts_on_edges(void)
+{
+    heap_telemetry_config_t config = day06_config();
+    config.leak_bytes_per_min = 0;
+    config.low_free_bytes = 150 * KB;
+    config.frag_permille = 600;
+
+    reset(0);
+    heap_telemetry_init(&tm, &config);
+    run_for(5 * SLOT_S);
+    TEST_ASSERT_EQUAL_INT(0, num_alert_calls);
+
+    // the largest block shrinks: once per capability, not once per slot
+    heap.largest = 40 * KB;
+    run_for(5 * SLOT_S);
+    TEST_ASSERT_EQUAL_INT(4, num_alert_calls);
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_FRAGMENTED, raised_alerts);
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_FRAGMENTED,
+                            heap_telemetry_trend(&tm, 0)->alerts);
+
+    // it clears on its own, and the next one is raised again
+    heap.largest = 0;
+    run_for(2 * SLOT_S);
+    TEST_ASSERT_EQUAL_UINT8(0, heap_telemetry_trend(&tm, 0)->alerts);
+    heap.used = 120 * KB; // 180 KB, minus day06's 41 KB at the floor
+    run_for(2 * SLOT_S);
+    TEST_ASSERT_EQUAL_INT(8, num_alert_calls);
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_LOW_FREE,
+                            heap_telemetry_trend(&tm, 0)->alerts);
+}
+
+void test_heap_telemetry_snapshot_layout(void)
+{
+    static uint8_t buf[HEAP_TELEMETRY_SNAPSHOT_MAX];
+    heap_telemetry_config_t config = day06_config();
+
+    reset(200.0 / 60);
+    config.caps[0] = MALLOC_CAP_DEFAULT;
+    config.caps[1] = MALLOC_CAP_SPIRAM;
+    config.num_caps = 2;
+    heap_telemetry_init(&tm, &config);
+    TEST_ASSERT_EQUAL_INT(1, heap_telemetry_num_caps(&tm));
+    run_for(20 * SLOT_S);
+
+    size_t len = heap_telemetry_snapshot(&tm, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(HEAP_TELEMETRY_HEADER_LEN + HEAP_TELEMETRY_CAP_LEN +
+                          tm.count * HEAP_TELEMETRY_SLOT_LEN(1),
+                      len);
+    TEST_ASSERT_EQUAL(0, heap_telemetry_snapshot(&tm, buf, len - 1));
+
+    // little endian: magic, version, caps, slot count, slot length in s
+    TEST_ASSERT_EQUAL_HEX8(0x48, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x54, buf[1]);
+    TEST_ASSERT_EQUAL_UINT8(HEAP_TELEMETRY_VERSION, buf[2]);
+    TEST_ASSERT_EQUAL_UINT8(1, buf[3]);
+    TEST_ASSERT_EQUAL_UINT16(tm.count, buf[4] | buf[5] << 8);
+    TEST_ASSERT_EQUAL_UINT16(SLOT_S, buf[6] | buf[7] << 8);
+
+    // the slope in bytes per hour, signed
+    const uint8_t *cap = buf + HEAP_TELEMETRY_HEADER_LEN;
+    int32_t slope = (int32_t)(cap[12] | cap[13] << 8 | cap[14] << 16 |
+                              (uint32_t)cap[15] << 24);
+    TEST_ASSERT_INT_WITHIN(300, -12000, slope);
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_LEAK, cap[18]);
+
+    printf("heap_telemetry: snapshot of %d slots x %d caps in %u bytes, "
+           "%u at most\n",
+           tm.count, heap_telemetry_num_caps(&tm), (unsigned)len,
+           (unsigned)HEAP_TELEMETRY_SNAPSHOT_MAX);
+}
+
+void run_heap_telemetry_tests(void)
+{
+    RUN_TEST(test_heap_telemetry_folds_samples_into_slots);
+    RUN_TEST(test_heap_telemetry_leak_slope);
+    RUN_TEST(test_heap_telemetry_warns_of_slow_leak);
+    RUN_TEST(test_heap_telemetry_alerts_on_edges);
+    RUN_TEST(test_heap_telemetry_snapshot_layout);
+}
@@ -0,0 +1,190 @@
+#include "unity.h"
+#include "i2c_async.h"
+#include "i2c_mock.h"
+#include "mpu6050.h"
+#include "mpu6050_sim.h"
+#include "test_bus.h"
+
+#define SECOND_ADDR 0x69 // AD0 high
+#define TXNS_PER_TASK 20
+
+static mpu6050_sim_t sim_a, sim_b;
+static i2c_async_t bus;
+static const uint8_t who_am_i_reg = MPU6050_REG_WHO_AM_I;
+
+static void bus_with_two_sims(void)
+{
+    test_bus_init(TEST_BUS_CLK_HZ);
+    test_bus_attach_sim(&sim_a, MPU6050_ADDR);
+    test_bus_attach_sim(&sim_b, SECOND_ADDR);
+
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_async_start(&bus, TEST_PORT, 8, 5));
+}
+
+// ---------------------
+// Completion
+// ---------------------
+
+static int callbacks;
+static esp_err_t callback_result;
+
+static void count_callback(i2c_async_txn_t *txn, void *arg)
+{
+    (void)arg;
+    callbacks++;
+    callback_result = txn->result;
+}
+
+void test_callback_and_notification_on_completion(void)
+{
+    uint8_t id = 0;
+    i2c_async_txn_t txn;
+
+    bus_with_two_sims();
+    callbacks = 0;
+
+    i2c_async_txn_read_regs(&txn, MPU6050_ADDR, &who_am_i_reg, &id, 1);
+    txn.callback = count_callback;
+    txn.notify = xTaskGetCurrentTaskHandle();
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_async_submit(&bus, &txn, portMAX_DELAY));
+
+    // free to do other work here while the bus task runs the transfer
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_async_wait(&txn, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(1, callbacks);
+    TEST_ASSERT_EQUAL(ESP_OK, callback_result);
+    TEST_ASSERT_EQUAL_HEX8(MPU6050_WHO_AM_I_VALUE, id);
+
+    i2c_async_stop(&bus);
+}
+
+void test_errors_reach_the_submitter(void)
+{
+    uint8_t id = 0;
+    i2c_async_txn_t txn;
+
+    bus_with_two_sims();
+    i2c_mock_inject_fault(TEST_PORT, SECOND_ADDR, I2C_MOCK_FAULT_NACK_ADDR, 0, 1);
+
+    i2c_async_txn_read_regs(&txn, SECOND_ADDR, &who_am_i_reg, &id, 1);
+    TEST_ASSERT_EQUAL(ESP_FAIL, i2c_async_transfer(&bus, &txn, portMAX_DELAY));
+
+    // the bus task carries on with the next transaction
+    i2c_async_txn_read_regs(&txn, SECOND_ADDR, &who_am_i_reg, &id, 1);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_async_transfer(&bus, &txn, portMAX_DELAY));
+
+    i2c_async_stop(&bus);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.completed);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.failed);
+}
+
+void test_prebuilt_link_runs_repeatedly(void)
+{
+    uint8_t frame[MPU6050_FRAME_LEN];
+    i2c_async_txn_t txn = {0};
+
+    bus_with_two_sims();
+    mpu6050_wake_up(&(mpu6050_t){.port = TEST_PORT, .addr = MPU6050_ADDR});
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, MPU6050_REG_ACCEL_XOUT_H, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, frame, sizeof(frame), I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+    txn.cmd = cmd;
+
+    for (int i = 0; i < 3; i++) {
+        mpu6050_sim_advance_us(&sim_a, 125);
+        TEST_ASSERT_EQUAL(ESP_OK, i2c_async_transfer(&bus, &txn, portMAX_DELAY));
+        TEST_ASSERT_EQUAL(i, (int16_t)((frame[0] << 8) | frame[1]));
+    }
+
+    i2c_async_stop(&bus);
+    i2c_cmd_link_delete(cmd);
+}
+
+// ---------------------
+// Two sensor tasks on one bus
+// ---------------------
+
+typedef struct {
+    uint8_t addr;
+    uint8_t other; // the sensor that submits next
+    TaskHandle_t parent;
+    int ok;
+} sensor_args_t;
+
+static uint8_t order[2 * TXNS_PER_TASK];
+static volatile int num_done;
+static volatile uint8_t turn; // address of the sensor allowed to submit
+
+static void record_order(i2c_async_txn_t *txn, void *arg)
+{
+    (void)arg;
+    order[num_done++] = txn->addr; // bus task only
+}
+
+static void sensor_task(void *arg)
+{
+    sensor_args_t *args = arg;
+    static uint8_t ids[2][TXNS_PER_TASK];
+    i2c_async_txn_t txns[TXNS_PER_TASK];
+    uint8_t *id = ids[args->addr == SECOND_ADDR];
+
+    // queue everything up front, then collect: transfers are pipelined.
+    // The sensors take turns submitting, so the arrival order is known.
+    for (int i = 0; i < TXNS_PER_TASK; i++) {
+        while (turn != args->addr)
+            vTaskDelay(1);
+        i2c_async_txn_read_regs(&txns[i], args->addr, &who_am_i_reg, &id[i], 1);
+        txns[i].callback = record_order;
+        txns[i].notify = xTaskGetCurrentTaskHandle();
+        i2c_async_submit(&bus, &txns[i], portMAX_DELAY);
+        turn = args->other;
+    }
+    for (int i = 0; i < TXNS_PER_TASK; i++)
+        args->ok += i2c_async_wait(&txns[i], portMAX_DELAY) == ESP_OK &&
+                    id[i] == MPU6050_WHO_AM_I_VALUE;
+
+    xTaskNotifyGive(args->parent);
+    vTaskDelete(NULL);
+}
+
+void test_two_devices_share_the_bus(void)
+{
+    sensor_args_t a = {.addr = MPU6050_ADDR, .other = SECOND_ADDR,
+                       .parent = xTaskGetCurrentTaskHandle()};
+    sensor_args_t b = {.addr = SECOND_ADDR, .other = MPU6050_ADDR,
+                       .parent = xTaskGetCurrentTaskHandle()};
+
+    bus_with_two_sims();
+    num_done = 0;
+    turn = MPU6050_ADDR;
+    // a completion the earlier tests did not wait for would count as finished
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    xTaskCreate(sensor_task, "sensor_a", 4096, &a, 4, NULL);
+    xTaskCreate(sensor_task, "sensor_b", 4096, &b, 4, NULL);
+    for (int finished = 0; finished < 2;)
+        finished += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    i2c_async_stop(&bus);
+    TEST_ASSERT_EQUAL(TXNS_PER_TASK, a.ok);
+    TEST_ASSERT_EQUAL(TXNS_PER_TASK, b.ok);
+    TEST_ASSERT_EQUAL(2 * TXNS_PER_TASK, num_done);
+    TEST_ASSERT_EQUAL_UINT32(2 * TXNS_PER_TASK, bus.completed);
+
+    // served in arrival order: neither device overtakes the other
+    for (int i = 0; i < 2 * TXNS_PER_TASK; i++)
+        TEST_ASSERT_EQUAL_HEX8(i % 2 ? SECOND_ADDR : MPU6050_ADDR, order[i]);
+}
+
+void run_i2c_async_tests(void)
+{
+    RUN_TEST(test_callback_and_notification_on_completion);
+    RUN_TEST(test_errors_reach_the_submitter);
+    RUN_TEST(test_prebuilt_link_runs_repeatedly);
+    RUN_TEST(test_two_devices_share_the_bus);
+}
@@ -0,0 +1,228 @@
+#include "unity.h"
+#include "i2c_mock.h"
+#include "imu_driver.h"
+#include "motion_engine.h"
+#include "mpu6050.h"
+#include "mpu6050_sim.h"
+#include "test_bus.h"
+#include "test_data.h"
+#include <math.h>
+
+
+static mpu6050_sim_t sim;
+static const mpu6050_t dev = {.port = TEST_PORT, .addr = MPU6050_ADDR};
+static imu_t day16_imu = {.i2c_addr = MPU6050_ADDR, .sda_pin = 21, .scl_pin = 22};
+
+// ---------------------
+// Bus behaviour
+// ---------------------
+
+void test_absent_address_is_nacked(void)
+{
+    uint8_t id;
+    const mpu6050_t missing = {.port = TEST_PORT, .addr = 0x69};
+
+    test_bus_with_sim(&sim);
+    TEST_ASSERT_EQUAL(ESP_FAIL, mpu6050_who_am_i(&missing, &id));
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_who_am_i(&dev, &id));
+}
+
+void test_driver_must_be_installed(void)
+{
+    uint8_t id;
+
+    test_bus_with_sim(&sim);
+    i2c_driver_delete(TEST_PORT);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, mpu6050_who_am_i(&dev, &id));
+}
+
+void test_injected_faults_hit_the_chosen_transactions(void)
+{
+    uint8_t id;
+    i2c_mock_stats_t stats;
+
+    test_bus_with_sim(&sim);
+
+    // one good transaction, then an address NACK, a data NACK and a timeout
+    i2c_mock_inject_fault(TEST_PORT, MPU6050_ADDR, I2C_MOCK_FAULT_NACK_ADDR, 1, 1);
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_who_am_i(&dev, &id));
+    TEST_ASSERT_EQUAL(ESP_FAIL, mpu6050_who_am_i(&dev, &id));
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_who_am_i(&dev, &id));
+
+    i2c_mock_inject_fault(TEST_PORT, MPU6050_ADDR, I2C_MOCK_FAULT_NACK_DATA, 0, 1);
+    TEST_ASSERT_EQUAL(ESP_FAIL, mpu6050_wake_up(&dev));
+
+    i2c_mock_inject_fault(TEST_PORT, MPU6050_ADDR, I2C_MOCK_FAULT_TIMEOUT, 0, 1);
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, mpu6050_who_am_i(&dev, &id));
+
+    // the failed write never reached the register file
+    uint8_t pwr = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_read_regs(&dev, MPU6050_REG_PWR_MGMT_1, &pwr, 1));
+    TEST_ASSERT_EQUAL_HEX8(MPU6050_PWR_SLEEP, pwr);
+
+    i2c_mock_get_stats(TEST_PORT, &stats);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.transactions);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.failed);
+}
+
+// ---------------------
+// Register model
+// ---------------------
+
+void test_output_registers_follow_the_source(void)
+{
+    uint8_t frame[MPU6050_FRAME_LEN];
+
+    test_bus_with_sim(&sim);
+    mpu6050_wake_up(&dev);
+    // DLPF off after reset: 8 kHz sample clock, samples 0, 1, 2
+    mpu6050_sim_advance_us(&sim, 375);
+
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_read_frame(&dev, frame));
+    TEST_ASSERT_EQUAL(2, (int16_t)((frame[0] << 8) | frame[1]));
+    TEST_ASSERT_EQUAL(MPU6050_SIM_TEMP_25C, (int16_t)((frame[6] << 8) | frame[7]));
+    TEST_ASSERT_EQUAL(-2, (int16_t)((frame[8] << 8) | frame[9]));
+
+    // PWR_MGMT_1 device reset puts the chip back to sleep
+    mpu6050_write_reg(&dev, MPU6050_REG_PWR_MGMT_1, 0x80);
+    uint8_t pwr = 0;
+    mpu6050_read_regs(&dev, MPU6050_REG_PWR_MGMT_1, &pwr, 1);
+    TEST_ASSERT_EQUAL_HEX8(MPU6050_PWR_SLEEP, pwr);
+}
+
+void test_recording_streams_through_fifo(void)
+{
+    static motion_sample_t samples[TEST_MAX_SAMPLES];
+    static uint8_t frames[MPU6050_FIFO_MAX_FRAMES][MPU6050_FRAME_LEN];
+    static motion_engine_t replayed, streamed;
+    mpu6050_sim_csv_t csv;
+    motion_decision_t a, b;
+    char path[256];
+    int decisions = 0;
+
+    test_recording_path("tap.csv", path, sizeof(path));
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_sim_csv_load(&csv, path));
+    int n = test_load_recording("tap.csv", samples, TEST_MAX_SAMPLES);
+    TEST_ASSERT_EQUAL(n, csv.num_rows);
+
+    test_bus_with_sim(&sim);
+    mpu6050_sim_set_source(&sim, mpu6050_sim_csv_source, &csv);
+    mpu6050_wake_up(&dev);
+    mpu6050_fifo_start(&dev, 100);
+    motion_engine_init(&replayed, NULL);
+    motion_engine_init(&streamed, NULL);
+
+    // the FIFO starts at the sample after the reset, skip the rows before it
+    int row = sim.samples;
+    while (row + 25 <= n) {
+        int count;
+        mpu6050_sim_advance_us(&sim, 250000);
+        TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_read(&dev, frames[0], MPU6050_FIFO_MAX_FRAMES, &count));
+        TEST_ASSERT_EQUAL(25, count);
+
+        for (int i = 0; i < count; i++, row++) {
+            bool ready = motion_engine_push_sample(&replayed, samples[row].accel_mag,
+                                                   samples[row].gyro_mag, 0);
+            TEST_ASSERT_EQUAL(ready, motion_engine_push_raw(&streamed, frames[i], 0));
+            if (!ready)
+                continue;
+
+            motion_engine_pop_decision(&replayed, &a);
+            motion_engine_pop_decision(&streamed, &b);
+            TEST_ASSERT_EQUAL(a.label, b.label);
+            TEST_ASSERT_FLOAT_WITHIN(2e-3f, a.acc_rms, b.acc_rms);
+            decisions++;
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN(20, decisions);
+    mpu6050_sim_csv_free(&csv);
+}
+
+// ---------------------
+// day16 IMU driver off-target
+// ---------------------
+
+void test_day16_imu_driver_runs_on_the_mock(void)
+{
+    float data[IMU_DATA_LEN];
+    i2c_mock_stats_t stats;
+
+    test_bus_with_sim(&sim);
+    TEST_ASSERT_TRUE(imu_init(&day16_imu));
+
+    uint8_t pwr = 0xFF;
+    mpu6050_read_regs(&dev, MPU6050_REG_PWR_MGMT_1, &pwr, 1);
+    TEST_ASSERT_EQUAL_HEX8(0x00, pwr);
+
+    mpu6050_sim_advance_us(&sim, 125); // day16 keeps the 8 kHz default
+    TEST_ASSERT_TRUE(imu_read_data(&day16_imu, data));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, data[IMU_AZ]); // counter source: 1 g on Z
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 25.0f, data[IMU_TEMP]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, data[IMU_GX]);
+
+    mpu6050_sim_advance_us(&sim, 500);
+    TEST_ASSERT_TRUE(imu_read_data(&day16_imu, data));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 4.0f / 16384.0f, data[IMU_AX]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -4.0f / 131.0f, data[IMU_GX]);
+
+    // the raw frame is what the motion engine decodes
+    uint8_t frame[IMU_FRAME_LEN];
+    float accel_mag, gyro_mag;
+    TEST_ASSERT_TRUE(imu_read_frame(&day16_imu, frame));
+    motion_decode_raw(frame, &accel_mag, &gyro_mag);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, accel_mag);
+
+    i2c_mock_inject_fault(TEST_PORT, MPU6050_ADDR, I2C_MOCK_FAULT_TIMEOUT, 0, 1);
+    TEST_ASSERT_FALSE(imu_read_data(&day16_imu, data));
+
+    i2c_mock_get_stats(TEST_PORT, &stats);
+    TEST_ASSERT_GREATER_THAN(0, stats.transactions);
+}
+
+void test_day16_imu_resume_skips_the_wake_sequence(void)
+{
+    float data[IMU_DATA_LEN];
+    i2c_mock_stats_t stats;
+
+    test_bus_with_sim(&sim);
+    i2c_mock_clear_stats(TEST_PORT);
+    TEST_ASSERT_TRUE(imu_init(&day16_imu));
+    i2c_mock_get_stats(TEST_PORT, &stats);
+    const uint32_t cold = stats.transactions;
+
+    // deep sleep: the ESP32 loses its I2C driver, the MPU6050 stays awake
+    i2c_driver_delete(TEST_PORT);
+    i2c_mock_clear_stats(TEST_PORT);
+    TEST_ASSERT_TRUE(imu_resume(&day16_imu));
+    i2c_mock_get_stats(TEST_PORT, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3, cold);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.transactions); // PWR_MGMT_1 check only
+
+    mpu6050_sim_advance_us(&sim, 125);
+    TEST_ASSERT_TRUE(imu_read_data(&day16_imu, data));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, data[IMU_AZ]);
+
+    // the sensor lost power during the sleep: back to its reset state
+    i2c_driver_delete(TEST_PORT);
+    mpu6050_sim_init(&sim);
+    i2c_mock_clear_stats(TEST_PORT);
+    TEST_ASSERT_TRUE(imu_resume(&day16_imu));
+    i2c_mock_get_stats(TEST_PORT, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1 + cold, stats.transactions);
+
+    uint8_t pwr = 0xFF;
+    mpu6050_read_regs(&dev, MPU6050_REG_PWR_MGMT_1, &pwr, 1);
+    TEST_ASSERT_EQUAL_HEX8(0x00, pwr);
+}
+
+void run_i2c_mock_tests(void)
+{
+    RUN_TEST(test_absent_address_is_nacked);
+    RUN_TEST(test_driver_must_be_installed);
+    RUN_TEST(test_injected_faults_hit_the_chosen_transactions);
+    RUN_TEST(test_output_registers_follow_the_source);
+    RUN_TEST(test_recording_streams_through_fifo);
+    RUN_TEST(test_day16_imu_driver_runs_on_the_mock);
+    RUN_TEST(test_day16_imu_resume_skips_the_wake_sequence);
+}
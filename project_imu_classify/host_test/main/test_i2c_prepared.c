@@ -0,0 +1,138 @@
+#include "unity.h"
+#include "i2c_mock.h"
+#include "i2c_prepared.h"
+#include "i2c_profiler.h"
+#include "imu_driver.h"
+#include "mpu6050.h"
+#include "mpu6050_sim.h"
+#include "test_alloc.h"
+#include "test_bus.h"
+#include <string.h>
+
+#define STEADY_STATE_SAMPLES 1000
+
+static mpu6050_sim_t sim;
+static const mpu6050_t dev = {.port = TEST_PORT, .addr = MPU6050_ADDR};
+static imu_t day16_imu = {.i2c_addr = MPU6050_ADDR, .sda_pin = 21, .scl_pin = 22};
+
+// prepared descriptors hold their link: keep them at a fixed address
+static i2c_prepared_t frame_read, probe;
+static uint8_t frame[MPU6050_FRAME_LEN];
+
+static void bus_with_sim(void)
+{
+    test_bus_with_sim(&sim);
+    mpu6050_wake_up(&dev);
+    i2c_prof_reset();
+}
+
+// ---------------------
+// Static links in the mock
+// ---------------------
+
+void test_static_link_stays_inside_its_buffer(void)
+{
+    _Alignas(16) uint8_t buf[2 * I2C_INTERNAL_STRUCT_SIZE];
+
+    TEST_ASSERT_NULL(i2c_cmd_link_create_static(buf, 8));
+
+    // room for the link header and one command
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(cmd);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_master_start(cmd));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, i2c_master_write_byte(cmd, 0xD0, true));
+    i2c_cmd_link_delete_static(cmd);
+}
+
+// ---------------------
+// Prepared transactions
+// ---------------------
+
+void test_prepared_read_reruns_into_the_same_buffer(void)
+{
+    uint8_t expected[MPU6050_FRAME_LEN];
+    i2c_prof_device_t p;
+
+    bus_with_sim();
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_prepare_frame_read(&dev, &frame_read, frame));
+    TEST_ASSERT_TRUE(i2c_prepared_ready(&frame_read));
+
+    for (int i = 0; i < 3; i++) {
+        mpu6050_sim_advance_us(&sim, 125);
+        TEST_ASSERT_EQUAL(ESP_OK, i2c_prepared_run(&frame_read, 10));
+        TEST_ASSERT_EQUAL(ESP_OK, mpu6050_read_frame(&dev, expected));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, MPU6050_FRAME_LEN);
+    }
+
+    // one link, three runs: the profiler still sees three full frame reads
+    TEST_ASSERT_TRUE(i2c_prof_get(TEST_PORT, MPU6050_ADDR, &p));
+    TEST_ASSERT_EQUAL_UINT32(6, p.transactions);
+    TEST_ASSERT_EQUAL_UINT32(6 * 14, p.bytes_read);
+
+    // a missing device NACKs the probe, the IMU ACKs it
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_prepared_probe(&probe, TEST_PORT, 0x69));
+    TEST_ASSERT_EQUAL(ESP_FAIL, i2c_prepared_run(&probe, 10));
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_prepared_probe(&probe, TEST_PORT, MPU6050_ADDR));
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_prepared_run(&probe, 10));
+
+    i2c_prepared_release(&probe);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, i2c_prepared_run(&probe, 10));
+}
+
+void test_failed_build_leaves_the_descriptor_unbuilt(void)
+{
+    i2c_prepared_t txn;
+
+    // a stack descriptor as day18 has it: the handle is garbage until built
+    bus_with_sim();
+    memset(&txn, 0xa5, sizeof(txn));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG,
+                      i2c_prepared_read_regs(&txn, TEST_PORT, MPU6050_ADDR, 0x75, frame, 0));
+    TEST_ASSERT_FALSE(i2c_prepared_ready(&txn));
+
+    memset(&txn, 0xa5, sizeof(txn));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG,
+                      i2c_prepared_read_regs(&txn, TEST_PORT, MPU6050_ADDR, 0x75, NULL, 1));
+    TEST_ASSERT_FALSE(i2c_prepared_ready(&txn));
+    i2c_prepared_release(&txn);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, i2c_prepared_run(&txn, 10));
+}
+
+void test_steady_state_sampling_does_not_allocate(void)
+{
+    float data[IMU_DATA_LEN];
+    int bytes;
+
+    bus_with_sim();
+    mpu6050_prepare_frame_read(&dev, &frame_read, frame);
+    i2c_prepared_probe(&probe, TEST_PORT, MPU6050_ADDR);
+    TEST_ASSERT_TRUE(imu_read_data(&day16_imu, data)); // builds day16's link
+
+    // the counter does see the heap-backed command links
+    uint32_t before = test_alloc_count();
+    i2c_cmd_link_delete(i2c_cmd_link_create());
+    TEST_ASSERT_GREATER_THAN_UINT32(before, test_alloc_count());
+
+    before = test_alloc_count();
+    for (int i = 0; i < STEADY_STATE_SAMPLES; i++) {
+        mpu6050_sim_advance_us(&sim, 10000);
+        TEST_ASSERT_EQUAL(ESP_OK, i2c_prepared_run(&frame_read, 10));
+        TEST_ASSERT_EQUAL(ESP_OK, i2c_prepared_run(&probe, 10));
+        TEST_ASSERT_TRUE(imu_read_data(&day16_imu, data));
+        // one-off register accesses build their link on the stack
+        TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_count(&dev, &bytes));
+    }
+    TEST_ASSERT_EQUAL_UINT32(before, test_alloc_count());
+
+    // both prepared reads saw the last sample
+    TEST_ASSERT_EQUAL_INT16((int16_t)((frame[0] << 8) | frame[1]),
+                            (int16_t)(data[IMU_AX] * 16384.0f));
+}
+
+void run_i2c_prepared_tests(void)
+{
+    RUN_TEST(test_static_link_stays_inside_its_buffer);
+    RUN_TEST(test_prepared_read_reruns_into_the_same_buffer);
+    RUN_TEST(test_failed_build_leaves_the_descriptor_unbuilt);
+    RUN_TEST(test_steady_state_sampling_does_not_allocate);
+}
@@ -0,0 +1,106 @@
+#include "unity.h"
+#include "i2c_mock.h"
+#include "i2c_profiler.h"
+#include "imu_driver.h"
+#include "mpu6050.h"
+#include "mpu6050_sim.h"
+#include "test_bus.h"
+
+
+static mpu6050_sim_t sim;
+static const mpu6050_t dev = {.port = TEST_PORT, .addr = MPU6050_ADDR};
+static imu_t day16_imu = {.i2c_addr = MPU6050_ADDR, .sda_pin = 21, .scl_pin = 22};
+
+static void bus_with_sim(uint32_t clk_hz)
+{
+    test_bus_init(clk_hz);
+    test_bus_attach_sim(&sim, MPU6050_ADDR);
+    i2c_prof_reset();
+}
+
+// ---------------------
+// Accounting
+// ---------------------
+
+void test_profiler_is_linked_in(void)
+{
+    TEST_ASSERT_TRUE(i2c_prof_enabled());
+}
+
+void test_repeated_start_frame_read(void)
+{
+    uint8_t frame[MPU6050_FRAME_LEN];
+    i2c_prof_device_t p;
+
+    bus_with_sim(400000);
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_read_frame(&dev, frame));
+
+    TEST_ASSERT_TRUE(i2c_prof_get(TEST_PORT, MPU6050_ADDR, &p));
+    TEST_ASSERT_EQUAL_UINT32(1, p.transactions);
+    TEST_ASSERT_EQUAL_UINT32(3, p.bytes_written); // addr W, register, addr R
+    TEST_ASSERT_EQUAL_UINT32(14, p.bytes_read);
+    // 2 START + 17 bytes * 9 + STOP = 156 clocks at 400 kHz
+    TEST_ASSERT_EQUAL_UINT32(156, (uint32_t)p.bus_clocks);
+    TEST_ASSERT_EQUAL_UINT32(390, (uint32_t)p.bus_time_us);
+}
+
+void test_day16_driver_cost(void)
+{
+    float data[IMU_DATA_LEN];
+    i2c_prof_device_t p;
+
+    bus_with_sim(100000);
+
+    // wake-up as select + read + write: three transactions
+    TEST_ASSERT_TRUE(imu_init(&day16_imu));
+    TEST_ASSERT_TRUE(i2c_prof_get(TEST_PORT, MPU6050_ADDR, &p));
+    TEST_ASSERT_EQUAL_UINT32(3, p.transactions);
+    TEST_ASSERT_EQUAL_UINT32(6, p.bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(1, p.bytes_read);
+    TEST_ASSERT_EQUAL_UINT32(690, (uint32_t)p.bus_time_us); // 69 clocks
+
+    // full accel/temp/gyro frame in one repeated-start transaction
+    i2c_prof_reset();
+    TEST_ASSERT_TRUE(imu_read_data(&day16_imu, data));
+    TEST_ASSERT_TRUE(i2c_prof_get(TEST_PORT, MPU6050_ADDR, &p));
+    TEST_ASSERT_EQUAL_UINT32(1, p.transactions);
+    TEST_ASSERT_EQUAL_UINT32(14, p.bytes_read);
+    TEST_ASSERT_EQUAL_UINT32(156, (uint32_t)p.bus_clocks);
+}
+
+void test_failures_and_helpers_are_counted(void)
+{
+    uint8_t reg = MPU6050_REG_WHO_AM_I;
+    uint8_t id = 0;
+    i2c_prof_device_t p;
+
+    bus_with_sim(400000);
+    i2c_mock_inject_fault(TEST_PORT, MPU6050_ADDR, I2C_MOCK_FAULT_TIMEOUT, 1, 1);
+
+    TEST_ASSERT_EQUAL(ESP_OK, i2c_master_write_read_device(TEST_PORT, MPU6050_ADDR, &reg, 1, &id, 1, 10));
+    TEST_ASSERT_EQUAL_HEX8(MPU6050_WHO_AM_I_VALUE, id);
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, mpu6050_who_am_i(&dev, &id));
+
+    TEST_ASSERT_TRUE(i2c_prof_get(TEST_PORT, MPU6050_ADDR, &p));
+    TEST_ASSERT_EQUAL_UINT32(2, p.transactions);
+    TEST_ASSERT_EQUAL_UINT32(1, p.failed);
+    TEST_ASSERT_EQUAL_UINT32(6, p.bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(2, p.bytes_read);
+    TEST_ASSERT_GREATER_OR_EQUAL(p.latency_us / p.transactions, p.max_latency_us);
+
+    // scanning addresses nobody answers still shows up per address
+    const mpu6050_t missing = {.port = TEST_PORT, .addr = 0x50};
+    TEST_ASSERT_EQUAL(ESP_FAIL, mpu6050_who_am_i(&missing, &id));
+    TEST_ASSERT_TRUE(i2c_prof_get(TEST_PORT, 0x50, &p));
+    TEST_ASSERT_EQUAL_UINT32(1, p.failed);
+
+    i2c_prof_dump();
+}
+
+void run_i2c_profiler_tests(void)
+{
+    RUN_TEST(test_profiler_is_linked_in);
+    RUN_TEST(test_repeated_start_frame_read);
+    RUN_TEST(test_day16_driver_cost);
+    RUN_TEST(test_failures_and_helpers_are_counted);
+}
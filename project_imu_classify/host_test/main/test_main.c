@@ -0,0 +1,54 @@
+#include "unity.h"
+
+void run_motion_fixed_tests(void);
+void run_feature_kernels_tests(void);
+void run_feature_window_tests(void);
+void run_mpu6050_fifo_tests(void);
+void run_i2c_mock_tests(void);
+void run_i2c_profiler_tests(void);
+void run_i2c_async_tests(void);
+void run_i2c_prepared_tests(void);
+void run_ultrason_capture_tests(void);
+void run_ultrason_ranging_tests(void);
+void run_msg_bus_tests(void);
+void run_spsc_ring_tests(void);
+void run_fusion_tests(void);
+void run_binlog_tests(void);
+void run_dlog_tests(void);
+void run_burst_tests(void);
+void run_boot_trace_tests(void);
+void run_block_pool_tests(void);
+void run_slab_tests(void);
+void run_arena_tests(void);
+void run_heap_telemetry_tests(void);
+void run_alloc_trace_tests(void);
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+
+    run_motion_fixed_tests();
+    run_feature_kernels_tests();
+    run_feature_window_tests();
+    run_mpu6050_fifo_tests();
+    run_i2c_mock_tests();
+    run_i2c_profiler_tests();
+    run_i2c_async_tests();
+    run_i2c_prepared_tests();
+    run_ultrason_capture_tests();
+    run_ultrason_ranging_tests();
+    run_msg_bus_tests();
+    run_spsc_ring_tests();
+    run_fusion_tests();
+    run_binlog_tests();
+    run_dlog_tests();
+    run_burst_tests();
+    run_boot_trace_tests();
+    run_block_pool_tests();
+    run_slab_tests();
+    run_arena_tests();
+    run_heap_telemetry_tests();
+    run_alloc_trace_tests();
+
+    UNITY_END();
+}
@@ -0,0 +1,176 @@
+#include "unity.h"
+#include "motion_engine.h"
+#include "motion_fixed.h"
+#include "test_data.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define EQUIV_HOP_SIZE 5 // same hop as the firmware
+
+static motion_sample_t samples[TEST_MAX_SAMPLES];
+static motion_engine_t float_engine;
+static motion_q_engine_t fixed_engine;
+
+// ---------------------
+// Integer square root
+// ---------------------
+
+void test_isqrt_matches_floor_sqrt(void)
+{
+    const uint32_t edges[] = {0, 1, 2, 3, 4, 15, 16, 17, 65535, 65536,
+                              3u * 32768u * 32768u, 0xFFFFFFFFu};
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        uint32_t expected = (uint32_t)floor(sqrt((double)edges[i]));
+        TEST_ASSERT_EQUAL_UINT32(expected, motion_q_isqrt(edges[i]));
+    }
+
+    srand(1234);
+    for (int i = 0; i < 100000; i++) {
+        uint32_t x = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        uint32_t expected = (uint32_t)floor(sqrt((double)x));
+        TEST_ASSERT_EQUAL_UINT32(expected, motion_q_isqrt(x));
+    }
+}
+
+void test_raw_frame_decodes_like_float_path(void)
+{
+    // ax = 1 g, ay = -0.5 g, az = 0, gx = 131 (1 dps), gy = -262, gz = 655
+    const uint8_t raw[MOTION_RAW_FRAME_LEN] = {
+        0x40, 0x00, 0xE0, 0x00, 0x00, 0x00, // accel
+        0x00, 0x00,                         // temperature
+        0x00, 0x83, 0xFE, 0xFA, 0x02, 0x8F, // gyro
+    };
+    const motion_engine_config_t config = {.window_size = 1, .hop_size = 1};
+    motion_q_decision_t q;
+    motion_decision_t converted;
+    float accel_mag, gyro_mag;
+
+    motion_decode_raw(raw, &accel_mag, &gyro_mag);
+    motion_q_engine_init(&fixed_engine, &config);
+    motion_q_engine_push_raw(&fixed_engine, raw, 0);
+    TEST_ASSERT_TRUE(motion_q_engine_pop_decision(&fixed_engine, &q));
+
+    // first output of the low-pass is alpha * input (gyro LSB is 7.6 mdps)
+    motion_q_decision_to_float(&q, &converted);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, MOTION_LPF_ALPHA * gyro_mag,
+                             converted.gyro_rms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, MOTION_LPF_ALPHA * fabsf(accel_mag - 1.0f),
+                             converted.acc_peak);
+}
+
+// ---------------------
+// Float vs fixed over the recordings
+// ---------------------
+
+static void check_recording(const char *name)
+{
+    const motion_engine_config_t config = {
+        .window_size = MOTION_WINDOW_SIZE,
+        .hop_size = EQUIV_HOP_SIZE,
+    };
+    motion_decision_t f;
+    motion_q_decision_t q;
+    motion_decision_t qf;
+    int decisions = 0;
+    int agree = 0;
+
+    int n = test_load_recording(name, samples, TEST_MAX_SAMPLES);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(MOTION_WINDOW_SIZE, n, name);
+
+    motion_engine_init(&float_engine, &config);
+    motion_q_engine_init(&fixed_engine, &config);
+
+    for (int i = 0; i < n; i++) {
+        int32_t accel_lsb = lroundf(samples[i].accel_mag * MOTION_Q_ACC_ONE_G);
+        int32_t gyro_lsb = lroundf(samples[i].gyro_mag * MOTION_Q_GYRO_ONE_DPS);
+
+        bool f_ready = motion_engine_push_sample(&float_engine,
+                                                 samples[i].accel_mag,
+                                                 samples[i].gyro_mag,
+                                                 samples[i].timestamp_ms);
+        bool q_ready = motion_q_engine_push_mag(&fixed_engine, accel_lsb,
+                                                gyro_lsb,
+                                                samples[i].timestamp_ms);
+        TEST_ASSERT_EQUAL_MESSAGE(f_ready, q_ready, name);
+        if (!f_ready)
+            continue;
+
+        motion_engine_pop_decision(&float_engine, &f);
+        motion_q_engine_pop_decision(&fixed_engine, &q);
+        motion_q_decision_to_float(&q, &qf);
+
+        // one accel LSB is 61 ug, one gyro LSB 7.6 mdps
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(2e-3f, f.acc_rms, qf.acc_rms, name);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(2e-3f, f.acc_peak, qf.acc_peak, name);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4f + 1e-2f * f.acc_var,
+                                         f.acc_var, qf.acc_var, name);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.05f, f.gyro_rms, qf.gyro_rms, name);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-2f + 1e-2f * f.gyro_var,
+                                         f.gyro_var, qf.gyro_var, name);
+        // quantization can move a sample sitting on zero to the other side
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.1f, f.acc_zcr, qf.acc_zcr, name);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.1f, f.gyro_zcr, qf.gyro_zcr, name);
+
+        decisions++;
+        agree += f.label == q.label;
+    }
+
+    // labels may only differ for windows sitting on a threshold
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, decisions, name);
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(decisions * 98 / 100, agree, name);
+}
+
+void test_fixed_matches_float_on_recordings(void)
+{
+    for (int i = 0; i < TEST_NUM_RECORDINGS; i++)
+        check_recording(test_recordings[i]);
+}
+
+// ---------------------
+// Q15 window peak against a rescan, at the largest window the API takes
+// ---------------------
+
+#define PEAK_SAMPLES 300
+
+static int32_t q_history[PEAK_SAMPLES];
+
+static int q_peak_mismatches(int size)
+{
+    static motion_q_window_t w;
+    int mismatches = 0;
+
+    motion_q_window_init(&w, size);
+    for (int i = 0; i < PEAK_SAMPLES; i++) {
+        motion_q_window_push(&w, q_history[i]);
+        int32_t peak = 0;
+        for (int j = i - size + 1; j <= i; j++)
+            if (j >= 0 && abs(q_history[j]) > peak)
+                peak = abs(q_history[j]);
+        if (PEAK_DEQUE_PEAK(&w.peak) != peak)
+            mismatches++;
+    }
+    return mismatches;
+}
+
+void test_q_window_peak_at_max_size(void)
+{
+    // strictly decreasing: the deque holds a whole window of candidates
+    for (int i = 0; i < PEAK_SAMPLES; i++)
+        q_history[i] = 16384 - 7 * i;
+    TEST_ASSERT_EQUAL_INT(0, q_peak_mismatches(FEATURE_WINDOW_MAX - 1));
+    TEST_ASSERT_EQUAL_INT(0, q_peak_mismatches(FEATURE_WINDOW_MAX));
+
+    srand(99);
+    for (int i = 0; i < PEAK_SAMPLES; i++)
+        q_history[i] = rand() % 65536 - 32768;
+    TEST_ASSERT_EQUAL_INT(0, q_peak_mismatches(FEATURE_WINDOW_MAX));
+}
+
+void run_motion_fixed_tests(void)
+{
+    RUN_TEST(test_isqrt_matches_floor_sqrt);
+    RUN_TEST(test_raw_frame_decodes_like_float_path);
+    RUN_TEST(test_fixed_matches_float_on_recordings);
+    RUN_TEST(test_q_window_peak_at_max_size);
+}
@@ -0,0 +1,162 @@
+#include "unity.h"
+#include "i2c_mock.h"
+#include "motion_engine.h"
+#include "mpu6050.h"
+#include "mpu6050_sim.h"
+#include "test_bus.h"
+
+#define TEST_RATE_HZ 100
+
+static mpu6050_sim_t sim;
+static const mpu6050_t dev = {.port = TEST_PORT, .addr = MPU6050_ADDR};
+static uint8_t frames[MPU6050_FIFO_MAX_FRAMES][MPU6050_FRAME_LEN];
+
+static int16_t frame_value(const uint8_t *frame, int offset)
+{
+    return (int16_t)((frame[offset] << 8) | frame[offset + 1]);
+}
+
+static void start_fifo(void)
+{
+    test_bus_with_sim(&sim);
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_wake_up(&dev));
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_start(&dev, TEST_RATE_HZ));
+    i2c_mock_clear_stats(TEST_PORT);
+}
+
+// ---------------------
+// Register access
+// ---------------------
+
+void test_who_am_i_and_wake_up(void)
+{
+    uint8_t id = 0;
+    uint8_t pwr = 0;
+
+    test_bus_with_sim(&sim);
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_who_am_i(&dev, &id));
+    TEST_ASSERT_EQUAL_HEX8(MPU6050_WHO_AM_I_VALUE, id);
+
+    // asleep after power-on: the clock runs but nothing reaches the FIFO
+    mpu6050_fifo_start(&dev, TEST_RATE_HZ);
+    mpu6050_sim_advance_us(&sim, 100000);
+    int bytes = -1;
+    mpu6050_fifo_count(&dev, &bytes);
+    TEST_ASSERT_EQUAL(0, bytes);
+
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_wake_up(&dev));
+    mpu6050_read_regs(&dev, MPU6050_REG_PWR_MGMT_1, &pwr, 1);
+    TEST_ASSERT_EQUAL_HEX8(0x00, pwr);
+}
+
+// ---------------------
+// FIFO burst reads
+// ---------------------
+
+void test_fifo_rate_follows_sample_divider(void)
+{
+    start_fifo();
+    TEST_ASSERT_EQUAL(1000000 / TEST_RATE_HZ, mpu6050_sim_sample_period_us(&sim));
+
+    int bytes;
+    mpu6050_sim_advance_us(&sim, 250000);
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_count(&dev, &bytes));
+    TEST_ASSERT_EQUAL(25 * MPU6050_FRAME_LEN, bytes);
+}
+
+void test_fifo_block_is_read_in_one_burst(void)
+{
+    i2c_mock_stats_t stats;
+    int count = 0;
+
+    start_fifo();
+    mpu6050_sim_advance_us(&sim, 250000);
+
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_read(&dev, frames[0], MPU6050_FIFO_MAX_FRAMES, &count));
+    TEST_ASSERT_EQUAL(25, count);
+
+    // frames come out in order with the register layout (accel X ramps, 1 g on Z)
+    int16_t first = frame_value(frames[0], 0);
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(first + i, frame_value(frames[i], 0));
+        TEST_ASSERT_EQUAL(16384, frame_value(frames[i], 4));
+        TEST_ASSERT_EQUAL(-(first + i), frame_value(frames[i], 8));
+    }
+
+    // count + burst, against 25 transactions in direct mode
+    i2c_mock_get_stats(TEST_PORT, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.transactions);
+}
+
+void test_fifo_read_leaves_remainder(void)
+{
+    int count = 0;
+    int bytes = 0;
+
+    start_fifo();
+    mpu6050_sim_advance_us(&sim, 100000);
+
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_read(&dev, frames[0], 4, &count));
+    TEST_ASSERT_EQUAL(4, count);
+    int16_t next = frame_value(frames[3], 0) + 1;
+
+    mpu6050_fifo_count(&dev, &bytes);
+    TEST_ASSERT_EQUAL(6 * MPU6050_FRAME_LEN, bytes);
+
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_read(&dev, frames[0], MPU6050_FIFO_MAX_FRAMES, &count));
+    TEST_ASSERT_EQUAL(6, count);
+    TEST_ASSERT_EQUAL(next, frame_value(frames[0], 0));
+}
+
+void test_fifo_overflow_resets_and_realigns(void)
+{
+    int count = -1;
+
+    start_fifo();
+    mpu6050_sim_advance_us(&sim, 1000000); // 1400 bytes into 1024
+
+    TEST_ASSERT_EQUAL_UINT32(1, sim.fifo_overflows);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE,
+                      mpu6050_fifo_read(&dev, frames[0], MPU6050_FIFO_MAX_FRAMES, &count));
+    TEST_ASSERT_EQUAL(0, count);
+
+    // after the reset whole frames line up again
+    mpu6050_sim_advance_us(&sim, 100000);
+    TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_read(&dev, frames[0], MPU6050_FIFO_MAX_FRAMES, &count));
+    TEST_ASSERT_EQUAL(10, count);
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_EQUAL(16384, frame_value(frames[i], 4));
+    TEST_ASSERT_EQUAL(frame_value(frames[0], 0) + 9, frame_value(frames[9], 0));
+}
+
+void test_fifo_blocks_feed_the_engine(void)
+{
+    static motion_engine_t engine;
+    motion_decision_t decision;
+    int decisions = 0;
+    int count;
+
+    start_fifo();
+    motion_engine_init(&engine, NULL);
+
+    // 2 s in 250 ms polls: 200 samples, 4 non-overlapping windows
+    for (int poll = 0; poll < 8; poll++) {
+        mpu6050_sim_advance_us(&sim, 250000);
+        TEST_ASSERT_EQUAL(ESP_OK, mpu6050_fifo_read(&dev, frames[0], MPU6050_FIFO_MAX_FRAMES, &count));
+        motion_engine_push_raw_block(&engine, frames[0], count, poll * 250, 1000 / TEST_RATE_HZ);
+        while (motion_engine_pop_decision(&engine, &decision))
+            decisions++;
+    }
+
+    TEST_ASSERT_EQUAL(4, decisions);
+}
+
+void run_mpu6050_fifo_tests(void)
+{
+    RUN_TEST(test_who_am_i_and_wake_up);
+    RUN_TEST(test_fifo_rate_follows_sample_divider);
+    RUN_TEST(test_fifo_block_is_read_in_one_burst);
+    RUN_TEST(test_fifo_read_leaves_remainder);
+    RUN_TEST(test_fifo_overflow_resets_and_realigns);
+    RUN_TEST(test_fifo_blocks_feed_the_engine);
+}
@@ -0,0 +1,275 @@
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "msg_bus.h"
+#include "test_alloc.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define POOL_BLOCKS 8
+#define BENCH_MSGS 20000
+#define BENCH_DEPTH 16
+#define BENCH_CONSUMERS 2 // logger and classifier
+
+static msg_pool_t pool;
+static msg_bus_t bus;
+
+typedef struct {
+    uint32_t seq;
+    float data[7];
+} sample_t;
+
+static void bus_with_subscribers(int n, UBaseType_t depth, QueueHandle_t queues[])
+{
+    TEST_ASSERT_EQUAL(ESP_OK, msg_pool_init(&pool, sizeof(sample_t), POOL_BLOCKS));
+    TEST_ASSERT_EQUAL(ESP_OK, msg_bus_init(&bus, &pool));
+    for (int i = 0; i < n; i++) {
+        queues[i] = msg_bus_subscribe(&bus, depth);
+        TEST_ASSERT_NOT_NULL(queues[i]);
+    }
+}
+
+static void bus_teardown(QueueHandle_t queues[])
+{
+    for (int i = 0; i < bus.num_subscribers; i++)
+        vQueueDelete(queues[i]);
+    msg_pool_deinit(&pool);
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------
+// Pool and reference counts
+// ---------------------
+
+void test_pool_hands_out_every_block_once(void)
+{
+    void *blocks[POOL_BLOCKS];
+
+    TEST_ASSERT_EQUAL(ESP_OK, msg_pool_init(&pool, sizeof(sample_t), POOL_BLOCKS));
+    for (int i = 0; i < POOL_BLOCKS; i++) {
+        blocks[i] = msg_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)blocks[i] % 8);
+        memset(blocks[i], 0xa5, sizeof(sample_t)); // must not hit a header
+        for (int j = 0; j < i; j++)
+            TEST_ASSERT_NOT_EQUAL(blocks[j], blocks[i]);
+    }
+    TEST_ASSERT_NULL(msg_alloc(&pool));
+    TEST_ASSERT_EQUAL_UINT32(1, msg_pool_get_stats(&pool).alloc_fails);
+
+    for (int i = 0; i < POOL_BLOCKS; i++)
+        msg_release(blocks[i]);
+    TEST_ASSERT_EQUAL_UINT32(0, msg_pool_get_stats(&pool).in_use);
+    TEST_ASSERT_EQUAL_UINT32(POOL_BLOCKS,
+                             msg_pool_get_stats(&pool).peak_in_use);
+    TEST_ASSERT_NOT_NULL(msg_alloc(&pool));
+    msg_pool_deinit(&pool);
+}
+
+void test_last_reader_returns_the_block(void)
+{
+    QueueHandle_t queues[3];
+    sample_t *got[3];
+
+    bus_with_subscribers(3, 4, queues);
+    sample_t *msg = msg_alloc(&pool);
+    msg->seq = 42;
+    TEST_ASSERT_EQUAL_INT(3, msg_bus_publish(&bus, msg, 0));
+    TEST_ASSERT_EQUAL_UINT16(3, msg_refs(msg));
+
+    // every subscriber sees the same block, no copy
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(msg_bus_receive(queues[i], (void **)&got[i], 0));
+        TEST_ASSERT_EQUAL_PTR(msg, got[i]);
+        TEST_ASSERT_EQUAL_UINT32(42, got[i]->seq);
+    }
+
+    msg_release(got[0]);
+    msg_release(got[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, msg_pool_get_stats(&pool).in_use);
+    msg_release(got[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, msg_pool_get_stats(&pool).in_use);
+    bus_teardown(queues);
+}
+
+void test_full_subscriber_only_drops_its_copy(void)
+{
+    QueueHandle_t queues[2];
+    void *msg;
+
+    bus_with_subscribers(2, 1, queues);
+    TEST_ASSERT_EQUAL_INT(2, msg_bus_publish(&bus, msg_alloc(&pool), 0));
+    TEST_ASSERT_TRUE(msg_bus_receive(queues[1], &msg, 0));
+    msg_release(msg);
+
+    // queue 0 is still full, queue 1 has room
+    TEST_ASSERT_EQUAL_INT(1, msg_bus_publish(&bus, msg_alloc(&pool), 0));
+    TEST_ASSERT_EQUAL_UINT32(1, bus.dropped);
+    TEST_ASSERT_EQUAL_UINT32(2, msg_pool_get_stats(&pool).in_use);
+
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_TRUE(msg_bus_receive(queues[i], &msg, 0));
+        msg_release(msg);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, msg_pool_get_stats(&pool).in_use);
+    bus_teardown(queues);
+}
+
+void test_publish_does_not_allocate(void)
+{
+    QueueHandle_t queues[2];
+    void *msg;
+
+    bus_with_subscribers(2, 4, queues);
+    uint32_t allocs = test_alloc_count();
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL_INT(2, msg_bus_publish(&bus, msg_alloc(&pool), 0));
+        for (int q = 0; q < 2; q++) {
+            TEST_ASSERT_TRUE(msg_bus_receive(queues[q], &msg, 0));
+            msg_release(msg);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(allocs, test_alloc_count());
+    bus_teardown(queues);
+}
+
+// ---------------------
+// Throughput: pointers through the bus vs copies through queues
+// ---------------------
+
+typedef struct {
+    QueueHandle_t queue;
+    size_t item_size; // 0: the queue carries msg_bus pointers
+    uint32_t checksum;
+    TaskHandle_t parent;
+} consumer_t;
+
+static void consumer_task(void *arg)
+{
+    consumer_t *c = arg;
+    uint8_t item[256];
+
+    for (int i = 0; i < BENCH_MSGS; i++) {
+        if (c->item_size) {
+            xQueueReceive(c->queue, item, portMAX_DELAY);
+            c->checksum += item[0];
+        } else {
+            uint8_t *msg;
+            msg_bus_receive(c->queue, (void **)&msg, portMAX_DELAY);
+            c->checksum += msg[0];
+            msg_release(msg);
+        }
+    }
+    xTaskNotifyGive(c->parent);
+    vTaskDelete(NULL);
+}
+
+static void start_consumers(consumer_t consumers[], size_t item_size)
+{
+    for (int i = 0; i < BENCH_CONSUMERS; i++) {
+        consumers[i].item_size = item_size;
+        consumers[i].checksum = 0;
+        consumers[i].parent = xTaskGetCurrentTaskHandle();
+        xTaskCreate(consumer_task, "consumer", 4096, &consumers[i], 5, NULL);
+    }
+}
+
+// Both consumers saw every message, in order or not
+static void wait_consumers(consumer_t consumers[])
+{
+    uint32_t expected = 0;
+
+    for (int n = 0; n < BENCH_MSGS; n++)
+        expected += (uint8_t)n;
+    for (int i = 0; i < BENCH_CONSUMERS; i++)
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    for (int i = 0; i < BENCH_CONSUMERS; i++)
+        TEST_ASSERT_EQUAL_UINT32(expected, consumers[i].checksum);
+}
+
+// Messages per second, one producer fanning out to both consumers
+static double bench_copy(size_t size)
+{
+    consumer_t consumers[BENCH_CONSUMERS];
+    uint8_t item[256] = {0};
+
+    for (int i = 0; i < BENCH_CONSUMERS; i++)
+        consumers[i].queue = xQueueCreate(BENCH_DEPTH, size);
+    start_consumers(consumers, size);
+
+    int64_t start = now_ns();
+    for (int n = 0; n < BENCH_MSGS; n++) {
+        item[0] = (uint8_t)n;
+        for (int i = 0; i < BENCH_CONSUMERS; i++)
+            xQueueSend(consumers[i].queue, item, portMAX_DELAY);
+    }
+    wait_consumers(consumers);
+    int64_t elapsed = now_ns() - start;
+
+    for (int i = 0; i < BENCH_CONSUMERS; i++)
+        vQueueDelete(consumers[i].queue);
+    return BENCH_MSGS * 1e9 / elapsed;
+}
+
+static double bench_bus(size_t size)
+{
+    consumer_t consumers[BENCH_CONSUMERS];
+
+    // every block in flight: both queues full, one being read by each
+    // consumer and the one being filled
+    TEST_ASSERT_EQUAL(ESP_OK,
+                      msg_pool_init(&pool, size,
+                                    BENCH_CONSUMERS * (BENCH_DEPTH + 1) + 1));
+    TEST_ASSERT_EQUAL(ESP_OK, msg_bus_init(&bus, &pool));
+    for (int i = 0; i < BENCH_CONSUMERS; i++)
+        consumers[i].queue = msg_bus_subscribe(&bus, BENCH_DEPTH);
+    start_consumers(consumers, 0);
+
+    int64_t start = now_ns();
+    for (int n = 0; n < BENCH_MSGS; n++) {
+        uint8_t *msg = msg_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(msg);
+        msg[0] = (uint8_t)n;
+        msg_bus_publish(&bus, msg, portMAX_DELAY);
+    }
+    wait_consumers(consumers);
+    int64_t elapsed = now_ns() - start;
+
+    TEST_ASSERT_EQUAL_UINT32(0, msg_pool_get_stats(&pool).in_use);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.dropped);
+    bus_teardown((QueueHandle_t[]){consumers[0].queue, consumers[1].queue});
+    return BENCH_MSGS * 1e9 / elapsed;
+}
+
+void test_bus_throughput_against_copying_queues(void)
+{
+    // a sensor_msg_t, a raw IMU frame batch
+    const size_t sizes[] = {sizeof(sample_t), 256};
+
+    for (int i = 0; i < 2; i++) {
+        double copy = bench_copy(sizes[i]);
+        double zero_copy = bench_bus(sizes[i]);
+        printf("msg_bus %3zu-byte payload, %d consumers: copy %.0f msg/s, "
+               "pointer %.0f msg/s, queue storage %zu vs %zu bytes\n",
+               sizes[i], BENCH_CONSUMERS, copy, zero_copy,
+               (size_t)BENCH_CONSUMERS * BENCH_DEPTH * sizes[i],
+               (size_t)BENCH_CONSUMERS * BENCH_DEPTH * sizeof(void *));
+    }
+}
+
+void run_msg_bus_tests(void)
+{
+    RUN_TEST(test_pool_hands_out_every_block_once);
+    RUN_TEST(test_last_reader_returns_the_block);
+    RUN_TEST(test_full_subscriber_only_drops_its_copy);
+    RUN_TEST(test_publish_does_not_allocate);
+    RUN_TEST(test_bus_throughput_against_copying_queues);
+}
@@ -0,0 +1,243 @@
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "spsc_ring.h"
+#include <stdio.h>
+#include <time.h>
+
+#define RING_LEN 16
+#define STRESS_ITEMS 200000
+#define LATENCY_SAMPLES 100
+#define HIST_BUCKETS 16 // bucket b: latency below 2^b µs
+
+static spsc_ring_t ring;
+static uint32_t slots[RING_LEN];
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------
+// Single task
+// ---------------------
+
+void test_ring_batches_wrap_around(void)
+{
+    uint32_t in[12], out[12];
+    uint32_t next_in = 0, next_out = 0;
+
+    TEST_ASSERT_TRUE(spsc_ring_init(&ring, slots, sizeof(uint32_t), RING_LEN));
+
+    // batches of 12 through 16 slots cross the end of the storage
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 12; i++)
+            in[i] = next_in++;
+        TEST_ASSERT_EQUAL_UINT32(12, spsc_ring_push(&ring, in, 12));
+        TEST_ASSERT_EQUAL_UINT32(12, spsc_ring_count(&ring));
+        TEST_ASSERT_EQUAL_UINT32(12, spsc_ring_pop(&ring, out, 12));
+        for (int i = 0; i < 12; i++)
+            TEST_ASSERT_EQUAL_UINT32(next_out++, out[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_pop(&ring, out, 12));
+}
+
+void test_ring_full_push_is_partial(void)
+{
+    uint32_t in[RING_LEN + 4] = {0};
+
+    TEST_ASSERT_TRUE(spsc_ring_init(&ring, slots, sizeof(uint32_t), RING_LEN));
+    TEST_ASSERT_EQUAL_UINT32(RING_LEN, spsc_ring_push(&ring, in, RING_LEN + 4));
+    TEST_ASSERT_EQUAL_UINT32(4, ring.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_push(&ring, in, 1));
+    TEST_ASSERT_EQUAL_UINT32(5, ring.dropped);
+
+    // nobody is sleeping on it: no notification
+    TEST_ASSERT_EQUAL_UINT32(0, ring.notifies);
+    TEST_ASSERT_FALSE(spsc_ring_init(&ring, slots, sizeof(uint32_t), 12));
+}
+
+// ---------------------
+// Producer task, consumer task
+// ---------------------
+
+static volatile int producer_batch;
+// the consumer's task notification belongs to the ring, not to us
+static volatile bool producer_done;
+
+static void wait_producer(void)
+{
+    while (!producer_done)
+        vTaskDelay(1);
+    producer_done = false;
+}
+
+static void stress_producer(void *arg)
+{
+    uint32_t batch[RING_LEN];
+    uint32_t next = 0;
+
+    while (next < STRESS_ITEMS) {
+        uint32_t n = 1 + next % producer_batch;
+        if (n > STRESS_ITEMS - next)
+            n = STRESS_ITEMS - next;
+        for (uint32_t i = 0; i < n; i++)
+            batch[i] = next + i;
+
+        // wait for room instead of dropping
+        while (RING_LEN - spsc_ring_count(&ring) < n)
+            taskYIELD();
+        TEST_ASSERT_EQUAL_UINT32(n, spsc_ring_push(&ring, batch, n));
+        next += n;
+    }
+    producer_done = true;
+    vTaskDelete(NULL);
+}
+
+void test_ring_stress_keeps_order(void)
+{
+    uint32_t out[RING_LEN];
+    uint32_t expected = 0;
+
+    TEST_ASSERT_TRUE(spsc_ring_init(&ring, slots, sizeof(uint32_t), RING_LEN));
+    producer_batch = 5;
+    int64_t start = now_ns();
+    xTaskCreate(stress_producer, "producer", 4096, NULL, 5, NULL);
+    while (expected < STRESS_ITEMS) {
+        uint32_t n = spsc_ring_pop_wait(&ring, out, RING_LEN, pdMS_TO_TICKS(1000));
+        for (uint32_t i = 0; i < n; i++)
+            TEST_ASSERT_EQUAL_UINT32(expected++, out[i]);
+    }
+    int64_t elapsed = now_ns() - start;
+    wait_producer();
+
+    TEST_ASSERT_EQUAL_UINT32(STRESS_ITEMS, ring.pushed);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.dropped);
+    printf("spsc_ring stress: %d items, %.0f ns/item, %u notifications\n",
+           STRESS_ITEMS, (double)elapsed / STRESS_ITEMS, (unsigned)ring.notifies);
+}
+
+// Cost of the transport itself: one send and one receive per sample, no
+// task switch, so only the kernel queue calls and the ring operations count
+void test_ring_per_item_cost_below_queue(void)
+{
+    uint32_t item, batch[8] = {0};
+
+    QueueHandle_t queue = xQueueCreate(RING_LEN, sizeof(uint32_t));
+    int64_t start = now_ns();
+    for (uint32_t i = 0; i < STRESS_ITEMS; i++) {
+        xQueueSend(queue, &i, 0);
+        xQueueReceive(queue, &item, 0);
+        TEST_ASSERT_EQUAL_UINT32(i, item);
+    }
+    int64_t queue_ns = now_ns() - start;
+    vQueueDelete(queue);
+
+    TEST_ASSERT_TRUE(spsc_ring_init(&ring, slots, sizeof(uint32_t), RING_LEN));
+    start = now_ns();
+    for (uint32_t i = 0; i < STRESS_ITEMS; i++) {
+        spsc_ring_push(&ring, &i, 1);
+        spsc_ring_pop(&ring, &item, 1);
+        TEST_ASSERT_EQUAL_UINT32(i, item);
+    }
+    int64_t ring_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < STRESS_ITEMS; i += 8) {
+        spsc_ring_push(&ring, batch, 8);
+        spsc_ring_pop(&ring, batch, 8);
+    }
+    int64_t batch_ns = now_ns() - start;
+
+    printf("per item: queue %.1f ns, spsc_ring %.1f ns, batches of 8 %.1f ns\n",
+           (double)queue_ns / STRESS_ITEMS, (double)ring_ns / STRESS_ITEMS,
+           (double)batch_ns / STRESS_ITEMS);
+    TEST_ASSERT_LESS_THAN(queue_ns, ring_ns);
+}
+
+// ---------------------
+// Latency histogram: one sample per tick, consumer asleep in between
+// ---------------------
+
+static QueueHandle_t queue;
+static uint32_t ring_hist[HIST_BUCKETS], queue_hist[HIST_BUCKETS];
+static int64_t stamps[RING_LEN];
+static spsc_ring_t stamp_ring;
+
+static void add_latency(uint32_t hist[], int64_t ns)
+{
+    int64_t us = ns / 1000;
+    int b = 0;
+    while (b < HIST_BUCKETS - 1 && us >= (1LL << b))
+        b++;
+    hist[b]++;
+}
+
+static void latency_producer(void *arg)
+{
+    bool use_queue = arg != NULL;
+
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        vTaskDelay(1);
+        int64_t t = now_ns();
+        if (use_queue)
+            xQueueSend(queue, &t, portMAX_DELAY);
+        else
+            spsc_ring_push(&stamp_ring, &t, 1);
+    }
+    producer_done = true;
+    vTaskDelete(NULL);
+}
+
+static void print_histogram(const char *name, const uint32_t hist[])
+{
+    printf("%-9s", name);
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        if (hist[b])
+            printf(" <%lldus:%u", 1LL << b, (unsigned)hist[b]);
+    }
+    printf("\n");
+}
+
+void test_ring_latency_histogram_against_queue(void)
+{
+    int64_t t;
+
+    TEST_ASSERT_TRUE(spsc_ring_init(&stamp_ring, stamps, sizeof(int64_t), RING_LEN));
+    xTaskCreate(latency_producer, "producer", 4096, NULL, 5, NULL);
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        while (spsc_ring_pop_wait(&stamp_ring, &t, 1, portMAX_DELAY) == 0)
+            ;
+        add_latency(ring_hist, now_ns() - t);
+    }
+    wait_producer();
+
+    queue = xQueueCreate(RING_LEN, sizeof(int64_t));
+    xTaskCreate(latency_producer, "producer", 4096, (void *)1, 5, NULL);
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        xQueueReceive(queue, &t, portMAX_DELAY);
+        add_latency(queue_hist, now_ns() - t);
+    }
+    wait_producer();
+    vQueueDelete(queue);
+
+    printf("push to pop latency, %d samples:\n", LATENCY_SAMPLES);
+    print_histogram("queue", queue_hist);
+    print_histogram("spsc_ring", ring_hist);
+
+    // a sleeping consumer is woken once per sample, never lost
+    TEST_ASSERT_EQUAL_UINT32(LATENCY_SAMPLES, stamp_ring.pushed);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LATENCY_SAMPLES, stamp_ring.notifies);
+}
+
+void run_spsc_ring_tests(void)
+{
+    RUN_TEST(test_ring_batches_wrap_around);
+    RUN_TEST(test_ring_full_push_is_partial);
+    RUN_TEST(test_ring_stress_keeps_order);
+    RUN_TEST(test_ring_per_item_cost_below_queue);
+    RUN_TEST(test_ring_latency_histogram_against_queue);
+}
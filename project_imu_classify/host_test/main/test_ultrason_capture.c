@@ -0,0 +1,165 @@
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "gpio_mock.h"
+#include "hcsr04_sim.h"
+#include "ultrason_driver.h"
+#include <stdio.h>
+#include <time.h>
+
+#define TRIG_PIN 16
+#define ECHO_PIN 17
+#define POLL_COST_US 1      // one busy-wait iteration of the polling driver
+#define EDGE_SOURCE_STEP_US 500 // simulated time per edge source tick
+
+static hcsr04_sim_t sim;
+static ultrason_t sensor = {.trig_pin = TRIG_PIN, .echo_pin = ECHO_PIN};
+
+static void sensor_with_sim(float distance_cm, bool capture)
+{
+    gpio_mock_reset();
+    hcsr04_sim_init(&sim, TRIG_PIN, ECHO_PIN, distance_cm);
+    hcsr04_sim_attach(&sim);
+
+    sensor.capture = false;
+    TEST_ASSERT_TRUE(ultrason_init(&sensor));
+    if (capture)
+        TEST_ASSERT_TRUE(ultrason_capture_init(&sensor));
+    else
+        gpio_mock_set_poll_cost_us(POLL_COST_US);
+    gpio_mock_clear_stats();
+}
+
+static int64_t thread_cpu_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ---------------------
+// Simulated echo pin: moves the clock while the reader sleeps
+// ---------------------
+
+static volatile bool source_running;
+static TaskHandle_t source_parent;
+
+static void edge_source_task(void *arg)
+{
+    (void)arg;
+    while (source_running) {
+        gpio_mock_advance_us(EDGE_SOURCE_STEP_US); // echo edges run the ISR here
+        vTaskDelay(1);
+    }
+    xTaskNotifyGive(source_parent);
+    vTaskDelete(NULL);
+}
+
+static void start_edge_source(void)
+{
+    source_running = true;
+    source_parent = xTaskGetCurrentTaskHandle();
+    xTaskCreate(edge_source_task, "edge_source", 4096, NULL, 5, NULL);
+}
+
+static void stop_edge_source(void)
+{
+    source_running = false;
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// ---------------------
+// Busy-wait reference
+// ---------------------
+
+void test_polling_read_spins_for_the_whole_echo(void)
+{
+    float distance = 0;
+    gpio_mock_stats_t stats;
+
+    sensor_with_sim(100.0f, false);
+    TEST_ASSERT_TRUE(ultrason_read_data(&sensor, &distance));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, distance);
+
+    // one poll per simulated microsecond from trigger to falling edge
+    gpio_mock_get_stats(&stats);
+    int64_t echo_end_us = HCSR04_SIM_LATENCY_US + hcsr04_sim_pulse_us(100.0f);
+    TEST_ASSERT_INT_WITHIN(2, echo_end_us / POLL_COST_US, stats.level_reads);
+}
+
+// ---------------------
+// Edge capture
+// ---------------------
+
+void test_capture_read_matches_distances(void)
+{
+    const float distances[] = {5.0f, 100.0f, 350.0f};
+    gpio_mock_stats_t stats;
+
+    for (int i = 0; i < 3; i++) {
+        float distance = 0;
+
+        sensor_with_sim(distances[i], true);
+        start_edge_source();
+        bool ok = ultrason_read_data(&sensor, &distance);
+        stop_edge_source();
+
+        TEST_ASSERT_TRUE(ok);
+        // edges are timestamped exactly, no poll quantisation
+        TEST_ASSERT_FLOAT_WITHIN(0.02f, distances[i], distance);
+
+        // the task never looked at the pin, the ISR ran once per edge
+        gpio_mock_get_stats(&stats);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.level_reads);
+        TEST_ASSERT_EQUAL_UINT32(2, stats.isr_calls);
+    }
+}
+
+void test_capture_read_times_out_without_echo(void)
+{
+    float distance = -1.0f;
+
+    sensor_with_sim(100.0f, true);
+    sim.no_echo = true;
+    start_edge_source();
+    TEST_ASSERT_FALSE(ultrason_read_data(&sensor, &distance));
+
+    // the next reading is not confused by the missed one
+    sim.no_echo = false;
+    TEST_ASSERT_TRUE(ultrason_read_data(&sensor, &distance));
+    stop_edge_source();
+
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 100.0f, distance);
+    TEST_ASSERT_EQUAL_UINT32(2, sim.pings);
+}
+
+void test_capture_uses_less_cpu_than_polling(void)
+{
+    float distance;
+    int64_t start;
+
+    // host CPU time of the reading task, the echo takes the same time in both
+    sensor_with_sim(300.0f, false);
+    start = thread_cpu_us();
+    TEST_ASSERT_TRUE(ultrason_read_data(&sensor, &distance));
+    int64_t polling_us = thread_cpu_us() - start;
+
+    sensor_with_sim(300.0f, true);
+    start_edge_source();
+    start = thread_cpu_us();
+    TEST_ASSERT_TRUE(ultrason_read_data(&sensor, &distance));
+    int64_t capture_us = thread_cpu_us() - start;
+    stop_edge_source();
+
+    printf("ultrason read CPU time: polling %lld us, capture %lld us\n",
+           (long long)polling_us, (long long)capture_us);
+    TEST_ASSERT_LESS_THAN(polling_us, capture_us);
+}
+
+void run_ultrason_capture_tests(void)
+{
+    RUN_TEST(test_polling_read_spins_for_the_whole_echo);
+    RUN_TEST(test_capture_read_matches_distances);
+    RUN_TEST(test_capture_read_times_out_without_echo);
+    RUN_TEST(test_capture_uses_less_cpu_than_polling);
+}
@@ -0,0 +1,145 @@
+#include "unity.h"
+#include "gpio_mock.h"
+#include "hcsr04_sim.h"
+#include "ultrason_driver.h"
+#include "ultrason_ranging.h"
+#include <stdio.h>
+
+#define STEP_US 100 // how often the test calls ultrason_ranging_service()
+#define RUN_US 1000000
+
+static const float distances[ULTRASON_RANGING_MAX_SENSORS] = {50.0f, 120.0f,
+                                                               200.0f, 300.0f};
+
+static hcsr04_sim_t sims[ULTRASON_RANGING_MAX_SENSORS];
+static ultrason_t sensors[ULTRASON_RANGING_MAX_SENSORS];
+static ultrason_ranging_t ranging;
+
+static void setup(int n, const ultrason_ranging_config_t *config)
+{
+    gpio_mock_reset();
+    for (int i = 0; i < n; i++) {
+        sensors[i] = (ultrason_t){.trig_pin = 16 + 2 * i, .echo_pin = 17 + 2 * i};
+        hcsr04_sim_init(&sims[i], sensors[i].trig_pin, sensors[i].echo_pin,
+                        distances[i]);
+        hcsr04_sim_attach(&sims[i]);
+        TEST_ASSERT_TRUE(ultrason_init(&sensors[i]));
+    }
+    TEST_ASSERT_TRUE(ultrason_ranging_init(&ranging, sensors, n, config));
+}
+
+// Advance the simulation, check every reading, return how many arrived
+static int run(int64_t duration_us, int per_sensor[])
+{
+    ultrason_range_t out[ULTRASON_RANGING_MAX_SENSORS];
+    int total = 0;
+
+    for (int64_t t = 0; t < duration_us; t += STEP_US) {
+        int n = ultrason_ranging_service(&ranging, out, ULTRASON_RANGING_MAX_SENSORS);
+        for (int k = 0; k < n; k++) {
+            TEST_ASSERT_FLOAT_WITHIN(0.05f, sims[out[k].sensor].distance_cm,
+                                     out[k].distance_cm);
+            if (per_sensor)
+                per_sensor[out[k].sensor]++;
+        }
+        total += n;
+        gpio_mock_advance_us(STEP_US);
+    }
+    return total;
+}
+
+// ---------------------
+// Readings
+// ---------------------
+
+void test_ranging_delivers_every_sensor(void)
+{
+    ultrason_ranging_config_t config = ULTRASON_RANGING_DEFAULT_CONFIG();
+    int per_sensor[ULTRASON_RANGING_MAX_SENSORS] = {0};
+
+    setup(4, &config);
+    run(RUN_US, per_sensor);
+
+    // one reading per sensor and cycle, give or take the last one
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_INT_WITHIN(1, RUN_US / config.cycle_us, per_sensor[i]);
+    TEST_ASSERT_EQUAL_UINT32(0, ranging.stats.timeouts);
+    TEST_ASSERT_EQUAL_UINT32(0, ranging.stats.crosstalk);
+}
+
+void test_ranging_triggers_are_staggered(void)
+{
+    ultrason_ranging_config_t config = ULTRASON_RANGING_DEFAULT_CONFIG();
+
+    setup(4, &config);
+    run(config.cycle_us, NULL);
+
+    // one trigger each, a quarter of a cycle apart
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1, sims[i].pings);
+        TEST_ASSERT_INT_WITHIN(STEP_US, i * config.cycle_us / 4,
+                               ranging.slots[i].trig_us);
+    }
+}
+
+void test_ranging_echo_delays_are_configurable(void)
+{
+    ultrason_ranging_config_t config = ULTRASON_RANGING_DEFAULT_CONFIG();
+
+    setup(4, &config);
+    sims[1].latency_us = 2000; // a slow module still measures the same range
+    sims[3].no_echo = true;    // nothing in front of this one
+
+    int per_sensor[ULTRASON_RANGING_MAX_SENSORS] = {0};
+    run(RUN_US, per_sensor);
+
+    TEST_ASSERT_INT_WITHIN(1, RUN_US / config.cycle_us, per_sensor[1]);
+    TEST_ASSERT_EQUAL_INT(0, per_sensor[3]);
+    TEST_ASSERT_INT_WITHIN(1, RUN_US / config.cycle_us, ranging.stats.timeouts);
+}
+
+// ---------------------
+// Throughput and crosstalk
+// ---------------------
+
+void test_ranging_throughput_scales_with_sensors(void)
+{
+    ultrason_ranging_config_t config = ULTRASON_RANGING_DEFAULT_CONFIG();
+
+    setup(1, &config);
+    int single = run(RUN_US, NULL);
+
+    setup(4, &config);
+    int four = run(RUN_US, NULL);
+
+    printf("ultrason ranging: %d readings/s with 1 sensor, %d with 4\n", single,
+           four);
+    TEST_ASSERT_GREATER_THAN(single * 35 / 10, four);
+}
+
+void test_ranging_drops_echoes_cut_by_crosstalk(void)
+{
+    ultrason_ranging_config_t config = ULTRASON_RANGING_DEFAULT_CONFIG();
+
+    // sensor 3 (300 cm, 17.5 ms echo) still listens when sensor 0 fires
+    // 15 ms after it, and hears that burst 300 µs later
+    setup(4, &config);
+    TEST_ASSERT_EQUAL(ESP_OK, hcsr04_sim_couple(&sims[3], &sims[0], 300));
+
+    int per_sensor[ULTRASON_RANGING_MAX_SENSORS] = {0};
+    run(RUN_US, per_sensor); // checks that no cut-short distance got through
+
+    TEST_ASSERT_GREATER_THAN(0, sims[3].crosstalk);
+    TEST_ASSERT_EQUAL_UINT32(sims[3].crosstalk, ranging.stats.crosstalk);
+    TEST_ASSERT_EQUAL_INT(0, per_sensor[3]);
+    TEST_ASSERT_INT_WITHIN(1, RUN_US / config.cycle_us, per_sensor[0]);
+}
+
+void run_ultrason_ranging_tests(void)
+{
+    RUN_TEST(test_ranging_delivers_every_sensor);
+    RUN_TEST(test_ranging_triggers_are_staggered);
+    RUN_TEST(test_ranging_echo_delays_are_configurable);
+    RUN_TEST(test_ranging_throughput_scales_with_sensors);
+    RUN_TEST(test_ranging_drops_echoes_cut_by_crosstalk);
+}
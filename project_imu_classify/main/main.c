@@ -1,11 +1,11 @@
 #include <stdio.h>
 #include "driver/i2c.h"
 #include "esp_log.h"
-#include <math.h>
 #include "esp_timer.h"
-#define FS 100
-#define WINDOW_SIZE 50
-#define LPF_ALPHA 0.38f   // for 10 Hz cutoff at 100 Hz sampling
+#include "i2c_prepared.h"
+#include "i2c_profiler.h"
+#include "motion_classifier.h"
+#include "mpu6050.h"
 
 
 #define I2C_MASTER_SCL_IO           22      // change to your GPIO
@@ -15,49 +15,22 @@
 #define I2C_MASTER_TX_BUF_DISABLE    0
 #define I2C_MASTER_RX_BUF_DISABLE    0
 
-#define WHO_AM_I_REG    0x75
 #define IMU_ADDR                    0x68      // 7-bit IMU address
-#define ACCEL_START_REG             0x3B      // Starting register for accelerometer (XH)
-#define READ_LEN                     14        // Read ACC Temp and Gyro data
-#define PWR_MGMT_1 0x6B
-#define GYRO_START_OFFSET 8  // gyro data starts at raw[8]
 
-static const char *TAG = "I2C_SCAN";
-
-esp_err_t imu_read_who_am_i(uint8_t *who_am_i)
-{
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-
-    // START
-    i2c_master_start(cmd);
-
-    // Address + Write
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_WRITE, true);
-
-    // Register address
-    i2c_master_write_byte(cmd, WHO_AM_I_REG, true);
-
-    // Repeated START
-    i2c_master_start(cmd);
+#define CLASSIFY_HOP_SIZE 5   // a decision every 50 ms over the 0.5 s window
 
-    // Address + Read
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_READ, true);
+// FIFO mode: the IMU samples on its own clock, we drain it in bursts
+#define IMU_USE_FIFO                1
+#define FIFO_POLL_MS                250       // 25 frames per read, FIFO holds 73
 
-    // Read 1 byte, then NACK
-    i2c_master_read_byte(cmd, who_am_i, I2C_MASTER_NACK);
+#define I2C_PROFILE_REPORT_S        0         // >0: print the I2C profile this often
 
-    // STOP
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(
-        I2C_MASTER_NUM,
-        cmd,
-        1000 / portTICK_PERIOD_MS
-    );
+static const char *TAG = "I2C_SCAN";
 
-    i2c_cmd_link_delete(cmd);
-    return ret;
-}
+static const mpu6050_t imu = {
+    .port = I2C_MASTER_NUM,
+    .addr = IMU_ADDR,
+};
 
 void i2c_master_init()
 {
@@ -77,173 +50,139 @@ void i2c_master_init()
 
 esp_err_t i2c_probe(uint8_t addr)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_stop(cmd);
+    i2c_prepared_t probe; // link on the stack, no heap
 
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+    esp_err_t ret = i2c_prepared_probe(&probe, I2C_MASTER_NUM, addr);
+    if (ret == ESP_OK)
+        ret = i2c_prepared_run(&probe, 1000 / portTICK_PERIOD_MS);
+    i2c_prepared_release(&probe);
     return ret;
 }
 
-esp_err_t imu_read_bytes(uint8_t start_reg, uint8_t *data, size_t len)
+static void print_label_changes(motion_classifier_t *engine, motion_class_t *last_label)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-
-    // START + write phase
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, start_reg, true);
+    motion_classifier_decision_t decision;
 
-    // Repeated START + read phase
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_READ, true);
-
-    // Read multiple bytes
-    if (len > 1) {
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
+    // overlapping windows decide every 50 ms, only print changes
+    while (motion_classifier_pop_decision(engine, &decision)) {
+        if (decision.label != *last_label) {
+            printf("%s\n", motion_class_to_str(decision.label));
+            *last_label = decision.label;
+        }
     }
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-
-    // STOP
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(
-        I2C_MASTER_NUM,
-        cmd,
-        1000 / portTICK_PERIOD_MS
-    );
-
-    i2c_cmd_link_delete(cmd);
-    return ret;
 }
 
-void imu_wake_up(void)
+static void report_i2c_profile(void)
 {
-    uint8_t data = 0x00; // clear sleep bit
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (IMU_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, PWR_MGMT_1, true);
-    i2c_master_write_byte(cmd, data, true);
-    i2c_master_stop(cmd);
-    i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
-}
-
-float lowpass_filter(float input, float prev_output, float alpha)
-{
-    return alpha * input + (1 - alpha) * prev_output;
+#if I2C_PROFILE_REPORT_S
+    static int64_t next_us;
+    int64_t now_us = esp_timer_get_time();
+
+    if (now_us >= next_us) {
+        if (next_us)
+            i2c_prof_dump();
+        next_us = now_us + I2C_PROFILE_REPORT_S * 1000000LL;
+    }
+#endif
 }
 
-float compute_rms(float *buffer, int size)
+#if IMU_USE_FIFO
+// Drain the FIFO in blocks, never returns
+static void fifo_loop(motion_classifier_t *engine, const motion_engine_config_t *config,
+                      motion_class_t *last_label)
 {
-    float sum = 0;
-    for (int i = 0; i < size; i++)
-        sum += buffer[i] * buffer[i];
+    static uint8_t frames[MPU6050_FIFO_MAX_FRAMES][MPU6050_FRAME_LEN];
+    const int period_ms = 1000 / MOTION_FS;
 
-    return sqrtf(sum / size);
-}
+    while (1) {
+        // one wakeup per block instead of one per sample
+        vTaskDelay(pdMS_TO_TICKS(FIFO_POLL_MS));
+
+        int count;
+        esp_err_t ret = mpu6050_fifo_read(&imu, frames[0], MPU6050_FIFO_MAX_FRAMES, &count);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            // overflow: samples are missing, start the windows over
+            ESP_LOGW(TAG, "IMU FIFO overflow");
+            motion_classifier_init(engine, config);
+            continue;
+        }
+        if (ret != ESP_OK || count == 0)
+            continue;
+
+        // the last frame was sampled just now, the rest are 10 ms apart
+        int64_t first_ms = esp_timer_get_time() / 1000 - (int64_t)(count - 1) * period_ms;
+
+        // -------- Classification --------
+        // feed hop-sized slices so the decision queue is drained in between
+        for (int i = 0; i < count; i += CLASSIFY_HOP_SIZE) {
+            int n = count - i < CLASSIFY_HOP_SIZE ? count - i : CLASSIFY_HOP_SIZE;
+            motion_classifier_push_raw_block(engine, frames[i], n,
+                                             first_ms + (int64_t)i * period_ms, period_ms);
+            print_label_changes(engine, last_label);
+        }
 
-float compute_peak(float *buffer, int size)
-{
-    float peak = 0;
-    for (int i = 0; i < size; i++) {
-        float val = fabsf(buffer[i]);
-        if (val > peak)
-            peak = val;
+        report_i2c_profile();
     }
-    return peak;
 }
+#endif
 
-void imu_logger_task(void *arg)
+// Read the output registers once per sample
+static void poll_loop(motion_classifier_t *engine, motion_class_t *last_label)
 {
-    uint8_t raw[READ_LEN];
+    static uint8_t raw[MPU6050_FRAME_LEN];
+    static i2c_prepared_t frame_read; // built once, run every sample
 
-    float acc_buffer[WINDOW_SIZE];
-    float gyro_buffer[WINDOW_SIZE];
-
-    float acc_filtered = 0;
-    float gyro_filtered = 0;
-
-    int sample_index = 0;
+    // without the prepared read every sample builds its own transaction
+    bool prepared = mpu6050_prepare_frame_read(&imu, &frame_read, raw) == ESP_OK;
+    if (!prepared)
+        ESP_LOGE(TAG, "Failed to build the IMU frame read");
 
     while (1) {
-
-        esp_err_t ret = imu_read_bytes(ACCEL_START_REG, raw, READ_LEN);
+        esp_err_t ret = prepared
+                            ? i2c_prepared_run(&frame_read, pdMS_TO_TICKS(MPU6050_TIMEOUT_MS))
+                            : mpu6050_read_frame(&imu, raw);
         if (ret == ESP_OK) {
+            int64_t timestamp_ms = esp_timer_get_time() / 1000;
 
-            // -------- Accelerometer --------
-            int16_t ax = (raw[0] << 8) | raw[1];
-            int16_t ay = (raw[2] << 8) | raw[3];
-            int16_t az = (raw[4] << 8) | raw[5];
-
-            float ax_g = ax / 16384.0f;
-            float ay_g = ay / 16384.0f;
-            float az_g = az / 16384.0f;
-
-            // -------- Gyroscope --------
-            int16_t gx = (raw[8]  << 8) | raw[9];
-            int16_t gy = (raw[10] << 8) | raw[11];
-            int16_t gz = (raw[12] << 8) | raw[13];
-
-            float gx_dps = gx / 131.0f;
-            float gy_dps = gy / 131.0f;
-            float gz_dps = gz / 131.0f;
-
-            float accel_mag = sqrtf(ax_g*ax_g + ay_g*ay_g + az_g*az_g);
-            float gyro_mag  = sqrtf(gx_dps*gx_dps + gy_dps*gy_dps + gz_dps*gz_dps);
-
-            // -------- Preprocessing --------
-
-            float acc_motion = accel_mag - 1.0f;   // remove gravity
+            motion_classifier_push_raw(engine, raw, timestamp_ms);
 
-            acc_filtered = lowpass_filter(acc_motion, acc_filtered, LPF_ALPHA);
-            gyro_filtered = lowpass_filter(gyro_mag, gyro_filtered, LPF_ALPHA);
-
-            // -------- Store in window --------
-
-            acc_buffer[sample_index] = acc_filtered;
-            gyro_buffer[sample_index] = gyro_filtered;
-
-            sample_index++;
-
-            if (sample_index >= WINDOW_SIZE) {
-
-                float acc_rms  = compute_rms(acc_buffer, WINDOW_SIZE);
-                float acc_peak = compute_peak(acc_buffer, WINDOW_SIZE);
-                float gyro_rms = compute_rms(gyro_buffer, WINDOW_SIZE);
-
-                // -------- Classification --------
-
-                if (acc_peak > 2.5f) {
-                    printf("Impact\n");
-                }
-                else if (acc_rms > 0.8f) {
-                    printf("Fast movement / Vibration\n");
-                }
-                else if (gyro_rms > 10.0f) {
-                    printf("Slow movement\n");
-                }
-                else {
-                    printf("Stationary\n");
-                }
-
-                sample_index = 0;
-            }
+            // -------- Classification --------
+            print_label_changes(engine, last_label);
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10)); // 100 Hz
+        report_i2c_profile();
+        vTaskDelay(pdMS_TO_TICKS(1000 / MOTION_FS)); // 100 Hz
     }
 }
 
+void imu_logger_task(void *arg)
+{
+    static motion_classifier_t engine; // ~2 KB of window state, keep it off the stack
+    motion_class_t last_label = MOTION_NUM_CLASSES;
+
+    const motion_engine_config_t config = {
+        .window_size = MOTION_WINDOW_SIZE,
+        .hop_size = CLASSIFY_HOP_SIZE,
+    };
+    motion_classifier_init(&engine, &config);
+
+#if IMU_USE_FIFO
+    // a FIFO that never started would read empty forever: poll instead
+    esp_err_t ret = mpu6050_fifo_start(&imu, MOTION_FS);
+    if (ret == ESP_OK)
+        fifo_loop(&engine, &config, &last_label);
+    ESP_LOGE(TAG, "IMU FIFO setup failed (%s), polling the registers",
+             esp_err_to_name(ret));
+    mpu6050_fifo_stop(&imu);
+#endif
+    poll_loop(&engine, &last_label);
+}
 
 
 void app_main(void)
 {
     i2c_master_init();
-    imu_wake_up();
+    mpu6050_wake_up(&imu);
 
     esp_log_level_set("*", ESP_LOG_NONE);
 